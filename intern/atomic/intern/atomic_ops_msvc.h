@@ -62,6 +62,11 @@ ATOMIC_INLINE uint64_t atomic_cas_uint64(uint64_t *v, uint64_t old, uint64_t _ne
   return InterlockedCompareExchange64((int64_t *)v, _new, old);
 }
 
+ATOMIC_INLINE uint64_t atomic_load_uint64(const uint64_t *v)
+{
+  return InterlockedCompareExchange64((int64_t *)v, 0, 0);
+}
+
 ATOMIC_INLINE uint64_t atomic_fetch_and_add_uint64(uint64_t *p, uint64_t x)
 {
   return InterlockedExchangeAdd64((int64_t *)p, (int64_t)x);
@@ -116,6 +121,11 @@ ATOMIC_INLINE uint32_t atomic_cas_uint32(uint32_t *v, uint32_t old, uint32_t _ne
   return InterlockedCompareExchange((long *)v, _new, old);
 }
 
+ATOMIC_INLINE uint32_t atomic_load_uint32(const uint32_t *v)
+{
+  return InterlockedCompareExchange((long *)v, 0, 0);
+}
+
 ATOMIC_INLINE uint32_t atomic_fetch_and_add_uint32(uint32_t *p, uint32_t x)
 {
   return InterlockedExchangeAdd(p, x);
@@ -143,6 +143,14 @@ TEST(atomic, atomic_cas_uint64)
   }
 }
 
+TEST(atomic, atomic_load_uint64)
+{
+  {
+    uint64_t value = 0x1234567890abcdef;
+    EXPECT_EQ(atomic_load_uint64(&value), 0x1234567890abcdef);
+  }
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -358,6 +366,14 @@ TEST(atomic, atomic_cas_uint32)
   }
 }
 
+TEST(atomic, atomic_load_uint32)
+{
+  {
+    uint32_t value = 0x12345678;
+    EXPECT_EQ(atomic_load_uint32(&value), 0x12345678);
+  }
+}
+
 TEST(atomic, atomic_fetch_and_add_uint32)
 {
   {
@@ -848,6 +864,14 @@ TEST(atomic, atomic_cas_ptr)
   }
 }
 
+TEST(atomic, atomic_load_ptr)
+{
+  {
+    void *value = INT_AS_PTR(0x7f);
+    EXPECT_EQ(atomic_load_ptr(&value), INT_AS_PTR(0x7f));
+  }
+}
+
 #undef INT_AS_PTR
 
 /** \} */
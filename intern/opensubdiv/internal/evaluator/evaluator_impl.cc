@@ -20,6 +20,7 @@
 
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 
 #ifdef _MSC_VER
 #  include <iso646.h>
@@ -32,6 +33,9 @@
 #include <opensubdiv/osd/cpuPatchTable.h>
 #include <opensubdiv/osd/cpuVertexBuffer.h>
 #include <opensubdiv/osd/mesh.h>
+#ifdef OPENSUBDIV_HAS_TBB
+#  include <opensubdiv/osd/tbbEvaluator.h>
+#endif
 #include <opensubdiv/osd/types.h>
 #include <opensubdiv/version.h>
 
@@ -52,6 +56,9 @@ using OpenSubdiv::Osd::CpuEvaluator;
 using OpenSubdiv::Osd::CpuPatchTable;
 using OpenSubdiv::Osd::CpuVertexBuffer;
 using OpenSubdiv::Osd::PatchCoord;
+#ifdef OPENSUBDIV_HAS_TBB
+using OpenSubdiv::Osd::TbbEvaluator;
+#endif
 
 namespace blender {
 namespace opensubdiv {
@@ -183,6 +190,30 @@ class ConstPatchCoordWrapperBuffer : public RawDataWrapperVertexBuffer<const Pat
   }
 };
 
+// Copy vertices which are `stride` bytes apart in the source buffer into the CPU storage of the
+// vertex buffer, as a single pass instead of an UpdateData() call per vertex.
+template<typename VERTEX_BUFFER>
+void updateVertexBufferFromStridedBuffer(VERTEX_BUFFER *vertex_buffer,
+                                         const void *buffer,
+                                         const int stride,
+                                         const int start_vertex,
+                                         const int num_vertices)
+{
+  const int num_elements = vertex_buffer->GetNumElements();
+  const int vertex_size = sizeof(float) * num_elements;
+  float *dst = vertex_buffer->BindCpuBuffer() + start_vertex * num_elements;
+  const unsigned char *src = static_cast<const unsigned char *>(buffer);
+  if (stride == vertex_size) {
+    memcpy(dst, src, static_cast<size_t>(vertex_size) * num_vertices);
+    return;
+  }
+  for (int i = 0; i < num_vertices; ++i) {
+    memcpy(dst, src, vertex_size);
+    dst += num_elements;
+    src += stride;
+  }
+}
+
 template<typename EVAL_VERTEX_BUFFER,
          typename STENCIL_TABLE,
          typename PATCH_TABLE,
@@ -225,6 +256,12 @@ class FaceVaryingVolatileEval {
     src_face_varying_data_->UpdateData(src, start_vertex, num_vertices, device_context_);
   }
 
+  void updateDataFromBuffer(const void *buffer, int stride, int start_vertex, int num_vertices)
+  {
+    updateVertexBufferFromStridedBuffer(
+        src_face_varying_data_, buffer, stride, start_vertex, num_vertices);
+  }
+
   void refine()
   {
     BufferDescriptor dst_face_varying_desc = src_face_varying_desc_;
@@ -294,6 +331,10 @@ class FaceVaryingVolatileEval {
 
 // Volatile evaluator which can be used from threads.
 //
+// Stencils are evaluated for all refined vertices at once on every refine() call, so they can
+// use a different (multi-threaded) evaluator than the patches, which are mostly evaluated a few
+// coordinates at a time from already threaded code.
+//
 // TODO(sergey): Make it possible to evaluate coordinates in chunks.
 // TODO(sergey): Make it possible to evaluate multiple face varying layers.
 //               (or maybe, it's cheap to create new evaluator for existing
@@ -303,10 +344,12 @@ template<typename SRC_VERTEX_BUFFER,
          typename STENCIL_TABLE,
          typename PATCH_TABLE,
          typename EVALUATOR,
-         typename DEVICE_CONTEXT = void>
+         typename DEVICE_CONTEXT = void,
+         typename STENCIL_EVALUATOR = EVALUATOR>
 class VolatileEvalOutput {
  public:
   typedef OpenSubdiv::Osd::EvaluatorCacheT<EVALUATOR> EvaluatorCache;
+  typedef OpenSubdiv::Osd::EvaluatorCacheT<STENCIL_EVALUATOR> StencilEvaluatorCache;
   typedef FaceVaryingVolatileEval<EVAL_VERTEX_BUFFER,
                                   STENCIL_TABLE,
                                   PATCH_TABLE,
@@ -325,6 +368,7 @@ class VolatileEvalOutput {
         src_varying_desc_(0, 3, 3),
         face_varying_width_(face_varying_width),
         evaluator_cache_(evaluator_cache),
+        stencil_evaluator_cache_(NULL),
         device_context_(device_context)
   {
     // Total number of vertices = coarse points + refined points + local points.
@@ -387,6 +431,32 @@ class VolatileEvalOutput {
     face_varying_evaluators[face_varying_channel]->updateData(src, start_vertex, num_vertices);
   }
 
+  void updateDataFromBuffer(const void *buffer, int stride, int start_vertex, int num_vertices)
+  {
+    updateVertexBufferFromStridedBuffer(src_data_, buffer, stride, start_vertex, num_vertices);
+  }
+
+  void updateVaryingDataFromBuffer(const void *buffer,
+                                   int stride,
+                                   int start_vertex,
+                                   int num_vertices)
+  {
+    updateVertexBufferFromStridedBuffer(
+        src_varying_data_, buffer, stride, start_vertex, num_vertices);
+  }
+
+  void updateFaceVaryingDataFromBuffer(const int face_varying_channel,
+                                       const void *buffer,
+                                       int stride,
+                                       int start_vertex,
+                                       int num_vertices)
+  {
+    assert(face_varying_channel >= 0);
+    assert(face_varying_channel < face_varying_evaluators.size());
+    face_varying_evaluators[face_varying_channel]->updateDataFromBuffer(
+        buffer, stride, start_vertex, num_vertices);
+  }
+
   bool hasVaryingData() const
   {
     // return varying_stencils_ != NULL;
@@ -404,28 +474,28 @@ class VolatileEvalOutput {
     // Evaluate vertex positions.
     BufferDescriptor dst_desc = src_desc_;
     dst_desc.offset += num_coarse_vertices_ * src_desc_.stride;
-    const EVALUATOR *eval_instance = OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(
-        evaluator_cache_, src_desc_, dst_desc, device_context_);
-    EVALUATOR::EvalStencils(src_data_,
-                            src_desc_,
-                            src_data_,
-                            dst_desc,
-                            vertex_stencils_,
-                            eval_instance,
-                            device_context_);
+    const STENCIL_EVALUATOR *eval_instance = OpenSubdiv::Osd::GetEvaluator<STENCIL_EVALUATOR>(
+        stencil_evaluator_cache_, src_desc_, dst_desc, device_context_);
+    STENCIL_EVALUATOR::EvalStencils(src_data_,
+                                    src_desc_,
+                                    src_data_,
+                                    dst_desc,
+                                    vertex_stencils_,
+                                    eval_instance,
+                                    device_context_);
     // Evaluate varying data.
     if (hasVaryingData()) {
       BufferDescriptor dst_varying_desc = src_varying_desc_;
       dst_varying_desc.offset += num_coarse_vertices_ * src_varying_desc_.stride;
-      eval_instance = OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(
-          evaluator_cache_, src_varying_desc_, dst_varying_desc, device_context_);
-      EVALUATOR::EvalStencils(src_varying_data_,
-                              src_varying_desc_,
-                              src_varying_data_,
-                              dst_varying_desc,
-                              varying_stencils_,
-                              eval_instance,
-                              device_context_);
+      eval_instance = OpenSubdiv::Osd::GetEvaluator<STENCIL_EVALUATOR>(
+          stencil_evaluator_cache_, src_varying_desc_, dst_varying_desc, device_context_);
+      STENCIL_EVALUATOR::EvalStencils(src_varying_data_,
+                                      src_varying_desc_,
+                                      src_varying_data_,
+                                      dst_varying_desc,
+                                      varying_stencils_,
+                                      eval_instance,
+                                      device_context_);
     }
     // Evaluate face-varying data.
     if (hasFaceVaryingData()) {
@@ -535,6 +605,7 @@ class VolatileEvalOutput {
   vector<FaceVaryingEval *> face_varying_evaluators;
 
   EvaluatorCache *evaluator_cache_;
+  StencilEvaluatorCache *stencil_evaluator_cache_;
   DEVICE_CONTEXT *device_context_;
 };
 
@@ -551,6 +622,14 @@ void convertPatchCoordsToArray(const OpenSubdiv_PatchCoord *patch_coords,
   }
 }
 
+// Refinement of all vertices on coarse positions update is multi-threaded when OpenSubdiv
+// is compiled with TBB support.
+#ifdef OPENSUBDIV_HAS_TBB
+typedef TbbEvaluator CpuStencilEvaluator;
+#else
+typedef CpuEvaluator CpuStencilEvaluator;
+#endif
+
 }  // namespace
 
 // Note: Define as a class instead of typedcef to make it possible
@@ -559,7 +638,9 @@ class CpuEvalOutput : public VolatileEvalOutput<CpuVertexBuffer,
                                                 CpuVertexBuffer,
                                                 StencilTable,
                                                 CpuPatchTable,
-                                                CpuEvaluator> {
+                                                CpuEvaluator,
+                                                void,
+                                                CpuStencilEvaluator> {
  public:
   CpuEvalOutput(const StencilTable *vertex_stencils,
                 const StencilTable *varying_stencils,
@@ -571,12 +652,14 @@ class CpuEvalOutput : public VolatileEvalOutput<CpuVertexBuffer,
                            CpuVertexBuffer,
                            StencilTable,
                            CpuPatchTable,
-                           CpuEvaluator>(vertex_stencils,
-                                         varying_stencils,
-                                         all_face_varying_stencils,
-                                         face_varying_width,
-                                         patch_table,
-                                         evaluator_cache)
+                           CpuEvaluator,
+                           void,
+                           CpuStencilEvaluator>(vertex_stencils,
+                                                varying_stencils,
+                                                all_face_varying_stencils,
+                                                face_varying_width,
+                                                patch_table,
+                                                evaluator_cache)
   {
   }
 };
@@ -630,12 +713,7 @@ void CpuEvalOutputAPI::setCoarsePositionsFromBuffer(const void *buffer,
   // TODO(sergey): Add sanity check on indices.
   const unsigned char *current_buffer = (unsigned char *)buffer;
   current_buffer += start_offset;
-  for (int i = 0; i < num_vertices; ++i) {
-    const int current_vertex_index = start_vertex_index + i;
-    implementation_->updateData(
-        reinterpret_cast<const float *>(current_buffer), current_vertex_index, 1);
-    current_buffer += stride;
-  }
+  implementation_->updateDataFromBuffer(current_buffer, stride, start_vertex_index, num_vertices);
 }
 
 void CpuEvalOutputAPI::setVaryingDataFromBuffer(const void *buffer,
@@ -647,12 +725,8 @@ void CpuEvalOutputAPI::setVaryingDataFromBuffer(const void *buffer,
   // TODO(sergey): Add sanity check on indices.
   const unsigned char *current_buffer = (unsigned char *)buffer;
   current_buffer += start_offset;
-  for (int i = 0; i < num_vertices; ++i) {
-    const int current_vertex_index = start_vertex_index + i;
-    implementation_->updateVaryingData(
-        reinterpret_cast<const float *>(current_buffer), current_vertex_index, 1);
-    current_buffer += stride;
-  }
+  implementation_->updateVaryingDataFromBuffer(
+      current_buffer, stride, start_vertex_index, num_vertices);
 }
 
 void CpuEvalOutputAPI::setFaceVaryingDataFromBuffer(const int face_varying_channel,
@@ -665,14 +739,8 @@ void CpuEvalOutputAPI::setFaceVaryingDataFromBuffer(const int face_varying_chann
   // TODO(sergey): Add sanity check on indices.
   const unsigned char *current_buffer = (unsigned char *)buffer;
   current_buffer += start_offset;
-  for (int i = 0; i < num_vertices; ++i) {
-    const int current_vertex_index = start_vertex_index + i;
-    implementation_->updateFaceVaryingData(face_varying_channel,
-                                           reinterpret_cast<const float *>(current_buffer),
-                                           current_vertex_index,
-                                           1);
-    current_buffer += stride;
-  }
+  implementation_->updateFaceVaryingDataFromBuffer(
+      face_varying_channel, current_buffer, stride, start_vertex_index, num_vertices);
 }
 
 void CpuEvalOutputAPI::refine()
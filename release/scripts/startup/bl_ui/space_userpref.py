@@ -2189,6 +2189,9 @@ class USERPREF_PT_experimental_new_features(ExperimentalPanel, Panel):
                 ({"property": "use_switch_object_operator"}, "T80402"),
                 ({"property": "use_sculpt_tools_tilt"}, "T00000"),
                 ({"property": "use_object_add_tool"}, "T57210"),
+                ({"property": "use_display_lut"}, None),
+                ({"property": "use_async_image_loading"}, None),
+                ({"property": "use_async_render_write"}, None),
             ),
         )
 
@@ -27,6 +27,7 @@
 extern "C" {
 #endif
 
+struct ArmatureDeformWeights;
 struct BMEditMesh;
 struct Bone;
 struct Depsgraph;
@@ -449,6 +450,17 @@ void BKE_armature_deform_coords_with_mesh(const struct Object *ob_arm,
                                           const char *defgrp_name,
                                           const struct Mesh *me_target);
 
+void BKE_armature_deform_coords_with_mesh_ex(const struct Object *ob_arm,
+                                             const struct Object *ob_target,
+                                             float (*vert_coords)[3],
+                                             float (*vert_deform_mats)[3][3],
+                                             int vert_coords_len,
+                                             int deformflag,
+                                             float (*vert_coords_prev)[3],
+                                             const char *defgrp_name,
+                                             const struct Mesh *me_target,
+                                             struct ArmatureDeformWeights **weights_cache);
+
 void BKE_armature_deform_coords_with_editmesh(const struct Object *ob_arm,
                                               const struct Object *ob_target,
                                               float (*vert_coords)[3],
@@ -459,6 +471,8 @@ void BKE_armature_deform_coords_with_editmesh(const struct Object *ob_arm,
                                               const char *defgrp_name,
                                               struct BMEditMesh *em_target);
 
+void BKE_armature_deform_weights_free(struct ArmatureDeformWeights *weights);
+
 /** \} */
 
 #ifdef __cplusplus
@@ -91,6 +91,9 @@ typedef enum BVHCacheType {
   BVHTREE_FROM_FACES,
   BVHTREE_FROM_LOOPTRI,
   BVHTREE_FROM_LOOPTRI_NO_HIDDEN,
+  /** Same as #BVHTREE_FROM_LOOPTRI, balanced with the slower #BVH_BALANCE_SAH build
+   * for callers doing many ray-casts on the same tree. */
+  BVHTREE_FROM_LOOPTRI_SAH,
 
   BVHTREE_FROM_LOOSEVERTS,
   BVHTREE_FROM_LOOSEEDGES,
@@ -258,6 +261,7 @@ float bvhtree_sphereray_tri_intersection(const BVHTreeRay *ray,
 bool bvhcache_has_tree(const struct BVHCache *bvh_cache, const BVHTree *tree);
 struct BVHCache *bvhcache_init(void);
 void bvhcache_free(struct BVHCache *bvh_cache);
+void bvhcache_shared_exit(void);
 
 #ifdef __cplusplus
 }
@@ -79,6 +79,7 @@ void BKE_callback_exec_id_depsgraph(struct Main *bmain,
                                     struct ID *id,
                                     struct Depsgraph *depsgraph,
                                     eCbEvent evt);
+bool BKE_callback_has_handlers(eCbEvent evt);
 void BKE_callback_add(bCallbackFuncStore *funcstore, eCbEvent evt);
 
 void BKE_callback_global_init(void);
@@ -74,6 +74,13 @@ typedef enum eCDAllocType {
   CD_REFERENCE = 3,
   /** Do a full copy of all layers, only allowed if source has same number of elements. */
   CD_DUPLICATE = 4,
+  /**
+   * Share data of layers which support it with the source, other layers are duplicated.
+   * Shared layers are flagged NOFREE like referenced ones, but keep the data alive as long as
+   * any layer uses it. Both the source and the new layers must use
+   * #CustomData_duplicate_referenced_layer or #CustomData_layer_ensure_unshared before writing.
+   */
+  CD_SHARE = 5,
 } eCDAllocType;
 
 #define CD_TYPE_AS_MASK(_type) (CustomDataMask)((CustomDataMask)1 << (CustomDataMask)(_type))
@@ -232,6 +239,9 @@ void *CustomData_duplicate_referenced_layer_named(struct CustomData *data,
                                                   const char *name,
                                                   const int totelem);
 bool CustomData_is_referenced_layer(struct CustomData *data, int type);
+/* copy data of a layer shared with other layers (see CD_SHARE), so it can be written to.
+ * returns true when the layer data pointer changed */
+bool CustomData_layer_ensure_unshared(struct CustomDataLayer *layer);
 
 /* set the CD_FLAG_NOCOPY flag in custom data layers where the mask is
  * zero for the layer type, so only layer types specified by the mask
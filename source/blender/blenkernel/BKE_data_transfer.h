@@ -29,6 +29,7 @@
 extern "C" {
 #endif
 
+struct DataTransferMapCache;
 struct Depsgraph;
 struct Object;
 struct ReportList;
@@ -175,8 +176,18 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
                                  const float mix_factor,
                                  const char *vgroup_name,
                                  const bool invert_vgroup,
+                                 struct DataTransferMapCache **map_cache,
                                  struct ReportList *reports);
 
+typedef struct DataTransferMapCacheStats {
+  /* Mappings which were reused or had to be computed. */
+  size_t hits, misses;
+} DataTransferMapCacheStats;
+
+void BKE_object_data_transfer_map_cache_get_stats(const struct DataTransferMapCache *map_cache,
+                                                  DataTransferMapCacheStats *r_stats);
+void BKE_object_data_transfer_map_cache_free(struct DataTransferMapCache *map_cache);
+
 #ifdef __cplusplus
 }
 #endif
@@ -373,6 +373,7 @@ struct GPUTexture *BKE_image_create_gpu_texture_from_ibuf(struct Image *image, s
 struct GPUTexture *BKE_image_get_gpu_texture(struct Image *image,
                                              struct ImageUser *iuser,
                                              struct ImBuf *ibuf);
+struct GPUTexture *BKE_image_get_gpu_texture_async(struct Image *image, struct ImageUser *iuser);
 struct GPUTexture *BKE_image_get_gpu_tiles(struct Image *image,
                                            struct ImageUser *iuser,
                                            struct ImBuf *ibuf);
@@ -387,6 +388,13 @@ void BKE_image_paint_set_mipmap(struct Main *bmain, bool mipmap);
 /* Delayed free of OpenGL buffers by main thread */
 void BKE_image_free_unused_gpu_textures(void);
 
+/* Background loading of image files for drawing. */
+bool BKE_image_async_load_begin(struct Image *ima, struct ImageUser *iuser);
+bool BKE_image_async_load_wait(struct Image *ima);
+void BKE_image_async_load_cancel(struct Image *ima);
+int BKE_image_async_load_poll(void (*done_fn)(struct Image *ima, void *userdata), void *userdata);
+void BKE_image_async_load_exit(void);
+
 struct RenderSlot *BKE_image_add_renderslot(struct Image *ima, const char *name);
 bool BKE_image_remove_renderslot(struct Image *ima, struct ImageUser *iuser, int slot);
 struct RenderSlot *BKE_image_get_renderslot(struct Image *ima, int index);
@@ -32,6 +32,7 @@ extern "C" {
 #endif
 
 struct Mesh;
+struct MeshRemeshVoxelCache;
 
 /* OpenVDB Voxel Remesher */
 #ifdef WITH_OPENVDB
@@ -48,6 +49,15 @@ struct Mesh *BKE_mesh_remesh_voxel_to_mesh_nomain(struct Mesh *mesh,
                                                   float voxel_size,
                                                   float adaptivity,
                                                   float isovalue);
+
+/* Voxel remesh reusing the level set of the previous call when only meshing settings changed. */
+struct MeshRemeshVoxelCache *BKE_mesh_remesh_voxel_cache_create(void);
+void BKE_mesh_remesh_voxel_cache_free(struct MeshRemeshVoxelCache *cache);
+struct Mesh *BKE_mesh_remesh_voxel_to_mesh_nomain_cached(struct Mesh *mesh,
+                                                         float voxel_size,
+                                                         float adaptivity,
+                                                         float isovalue,
+                                                         struct MeshRemeshVoxelCache *cache);
 struct Mesh *BKE_mesh_remesh_quadriflow_to_mesh_nomain(struct Mesh *mesh,
                                                        int target_faces,
                                                        int seed,
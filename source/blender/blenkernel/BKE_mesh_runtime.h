@@ -51,6 +51,11 @@ bool BKE_mesh_runtime_clear_edit_data(struct Mesh *mesh);
 bool BKE_mesh_runtime_reset_edit_data(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_geometry(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_cache(struct Mesh *mesh);
+void BKE_mesh_runtime_tag_coords_changed(struct Mesh *mesh);
+void BKE_mesh_runtime_tag_deform_verts_changed(struct Mesh *mesh);
+bool BKE_mesh_runtime_minmax(const struct Mesh *mesh, float r_min[3], float r_max[3]);
+const float (*BKE_mesh_runtime_vert_normals_ensure(const struct Mesh *mesh,
+                                                    float (**r_vert_normals_free)[3]))[3];
 
 void BKE_mesh_runtime_verttri_from_looptri(struct MVertTri *r_verttri,
                                            const struct MLoop *mloop,
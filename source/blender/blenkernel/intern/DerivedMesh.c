@@ -1753,7 +1753,7 @@ static void mesh_build_extra_data(struct Depsgraph *depsgraph, Object *ob, Mesh
 static void mesh_runtime_check_normals_valid(const Mesh *mesh)
 {
   UNUSED_VARS_NDEBUG(mesh);
-  BLI_assert(!(mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL));
+  BLI_assert(!(mesh->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY));
   BLI_assert(!(mesh->runtime.cd_dirty_loop & CD_MASK_NORMAL));
   BLI_assert(!(mesh->runtime.cd_dirty_poly & CD_MASK_NORMAL));
 }
@@ -1958,7 +1958,7 @@ Mesh *mesh_get_eval_final(struct Depsgraph *depsgraph,
   }
 
   if (mesh_eval != NULL) {
-    BLI_assert(!(mesh_eval->runtime.cd_dirty_vert & CD_MASK_NORMAL));
+    BLI_assert(!(mesh_eval->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY));
   }
   return mesh_eval;
 }
@@ -2067,7 +2067,7 @@ Mesh *editbmesh_get_eval_cage_and_final(Depsgraph *depsgraph,
 
   *r_final = em->mesh_eval_final;
   if (em->mesh_eval_final) {
-    BLI_assert(!(em->mesh_eval_final->runtime.cd_dirty_vert & DM_DIRTY_NORMALS));
+    BLI_assert(!(em->mesh_eval_final->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY));
   }
   return em->mesh_eval_cage;
 }
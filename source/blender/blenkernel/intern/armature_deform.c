@@ -55,6 +55,10 @@
 
 #include "CLG_log.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 static CLG_LogRef LOG = {"bke.armature_deform"};
 
 /* -------------------------------------------------------------------- */
@@ -231,6 +235,207 @@ static void pchan_bone_deform(bPoseChannel *pchan,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Compiled Deform Weights
+ *
+ * Vertex group weights of a mesh resolved to deforming groups and packed in compressed rows,
+ * so deforming a vertex only walks the weights that matter. The armature modifier keeps them
+ * across evaluations, they are compiled again when the deform-verts are edited, see
+ * #Mesh_Runtime.deform_verts_edit_count, or a different set of groups deforms.
+ *
+ * Weights are kept in the vertex group order, accumulating them gives the same result as
+ * reading the vertex groups directly.
+ * \{ */
+
+typedef struct ArmatureDeformWeights {
+  /* What the weights were compiled from, see #armature_deform_weights_is_valid. */
+  const MDeformVert *dverts;
+  int dverts_len;
+  int deform_verts_edit_count;
+  int armature_def_nr;
+  int defbase_len;
+  /** Per vertex group, whether it has a deforming bone. */
+  bool *defgroup_is_deform;
+
+  /** Range of weights of vertex `i` is `[offsets[i], offsets[i + 1])`. */
+  int *offsets;
+  /** Vertex group index of each weight, only non-zero weights of deforming groups are kept. */
+  int *def_nrs;
+  float *weights;
+  /**
+   * Per vertex, whether it's in any deforming group, even with a zero weight.
+   * Other vertices are deformed by envelopes, when enabled.
+   */
+  bool *vert_is_deformed;
+  /** Per vertex weight in the modifier's vertex group, NULL without one. */
+  float *armature_weights;
+} ArmatureDeformWeights;
+
+typedef struct ArmatureDeformWeightsData {
+  const MDeformVert *dverts;
+  bPoseChannel **pchan_from_defbase;
+  int defbase_len;
+  ArmatureDeformWeights *table;
+} ArmatureDeformWeightsData;
+
+static void armature_deform_weights_count_task(void *__restrict userdata,
+                                               const int i,
+                                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ArmatureDeformWeightsData *data = userdata;
+  ArmatureDeformWeights *table = data->table;
+  const MDeformVert *dvert = &data->dverts[i];
+  const MDeformWeight *dw = dvert->dw;
+  bool is_deformed = false;
+  int count = 0;
+
+  for (int j = dvert->totweight; j != 0; j--, dw++) {
+    const uint index = dw->def_nr;
+    if (index < data->defbase_len && data->pchan_from_defbase[index]) {
+      is_deformed = true;
+      if (dw->weight != 0.0f) {
+        count++;
+      }
+    }
+  }
+
+  /* Shifted by one, offsets are accumulated afterwards. */
+  table->offsets[i + 1] = count;
+  table->vert_is_deformed[i] = is_deformed;
+  if (table->armature_weights) {
+    table->armature_weights[i] = BKE_defvert_find_weight(dvert, table->armature_def_nr);
+  }
+}
+
+static void armature_deform_weights_fill_task(void *__restrict userdata,
+                                              const int i,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ArmatureDeformWeightsData *data = userdata;
+  ArmatureDeformWeights *table = data->table;
+  const MDeformVert *dvert = &data->dverts[i];
+  int offset = table->offsets[i];
+
+  if (offset == table->offsets[i + 1]) {
+    return;
+  }
+
+  const MDeformWeight *dw = dvert->dw;
+  for (int j = dvert->totweight; j != 0; j--, dw++) {
+    const uint index = dw->def_nr;
+    if (index < data->defbase_len && data->pchan_from_defbase[index] && dw->weight != 0.0f) {
+      table->def_nrs[offset] = (int)index;
+      table->weights[offset] = dw->weight;
+      offset++;
+    }
+  }
+}
+
+static ArmatureDeformWeights *armature_deform_weights_create(const Mesh *me,
+                                                             bPoseChannel **pchan_from_defbase,
+                                                             const int defbase_len,
+                                                             const int armature_def_nr)
+{
+  const int verts_len = me->totvert;
+  ArmatureDeformWeights *table = MEM_callocN(sizeof(*table), __func__);
+  table->dverts = me->dvert;
+  table->dverts_len = verts_len;
+  table->deform_verts_edit_count = me->runtime.deform_verts_edit_count;
+  table->armature_def_nr = armature_def_nr;
+  table->defbase_len = defbase_len;
+  table->defgroup_is_deform = MEM_malloc_arrayN((size_t)defbase_len, sizeof(bool), __func__);
+  for (int i = 0; i < defbase_len; i++) {
+    table->defgroup_is_deform[i] = (pchan_from_defbase[i] != NULL);
+  }
+
+  table->offsets = MEM_malloc_arrayN((size_t)verts_len + 1, sizeof(int), __func__);
+  table->offsets[0] = 0;
+  table->vert_is_deformed = MEM_malloc_arrayN((size_t)verts_len, sizeof(bool), __func__);
+  if (armature_def_nr != -1) {
+    table->armature_weights = MEM_malloc_arrayN((size_t)verts_len, sizeof(float), __func__);
+  }
+
+  ArmatureDeformWeightsData data = {
+      .dverts = me->dvert,
+      .pchan_from_defbase = pchan_from_defbase,
+      .defbase_len = defbase_len,
+      .table = table,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, verts_len, &data, armature_deform_weights_count_task, &settings);
+
+  for (int i = 0; i < verts_len; i++) {
+    table->offsets[i + 1] += table->offsets[i];
+  }
+
+  const int weights_len = table->offsets[verts_len];
+  table->def_nrs = MEM_malloc_arrayN((size_t)weights_len, sizeof(int), __func__);
+  table->weights = MEM_malloc_arrayN((size_t)weights_len, sizeof(float), __func__);
+
+  BLI_task_parallel_range(0, verts_len, &data, armature_deform_weights_fill_task, &settings);
+
+  return table;
+}
+
+static bool armature_deform_weights_is_valid(const ArmatureDeformWeights *table,
+                                             const Mesh *me,
+                                             bPoseChannel **pchan_from_defbase,
+                                             const int defbase_len,
+                                             const int armature_def_nr)
+{
+  if ((table->dverts != me->dvert) || (table->dverts_len != me->totvert) ||
+      (table->deform_verts_edit_count != me->runtime.deform_verts_edit_count) ||
+      (table->armature_def_nr != armature_def_nr) || (table->defbase_len != defbase_len)) {
+    return false;
+  }
+  /* Bones may be renamed, added or have deformation disabled. */
+  for (int i = 0; i < defbase_len; i++) {
+    if (table->defgroup_is_deform[i] != (pchan_from_defbase[i] != NULL)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * \return the weights cached in \a weights_p, compiled again when they are out of date.
+ */
+static const ArmatureDeformWeights *armature_deform_weights_ensure(
+    ArmatureDeformWeights **weights_p,
+    const Mesh *me,
+    bPoseChannel **pchan_from_defbase,
+    const int defbase_len,
+    const int armature_def_nr)
+{
+  ArmatureDeformWeights *table = *weights_p;
+  if (table != NULL) {
+    if (armature_deform_weights_is_valid(
+            table, me, pchan_from_defbase, defbase_len, armature_def_nr)) {
+      return table;
+    }
+    BKE_armature_deform_weights_free(table);
+  }
+  table = armature_deform_weights_create(me, pchan_from_defbase, defbase_len, armature_def_nr);
+  *weights_p = table;
+  return table;
+}
+
+void BKE_armature_deform_weights_free(ArmatureDeformWeights *weights)
+{
+  MEM_freeN(weights->defgroup_is_deform);
+  MEM_freeN(weights->offsets);
+  MEM_freeN(weights->def_nrs);
+  MEM_freeN(weights->weights);
+  MEM_freeN(weights->vert_is_deformed);
+  MEM_SAFE_FREE(weights->armature_weights);
+  MEM_freeN(weights);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Armature Deform #BKE_armature_deform_coords API
  *
@@ -258,6 +463,19 @@ typedef struct ArmatureUserdata {
   bPoseChannel **pchan_from_defbase;
   int defbase_len;
 
+  /** Compiled weights of the target mesh, NULL when vertex groups are read directly. */
+  const ArmatureDeformWeights *weights;
+  /**
+   * Deformation of the bone of each vertex group used with compiled weights, packed in separate
+   * arrays so the weights of a vertex don't have to visit the pose channels.
+   */
+  struct {
+    /** The bone deformation depends on the vertex position (B-Bones, envelope multiply). */
+    bool *use_pchan;
+    float (*mats)[4][4];
+    DualQuat *dquats;
+  } bones;
+
   float premat[4][4];
   float postmat[4][4];
 
@@ -267,6 +485,93 @@ typedef struct ArmatureUserdata {
   } bmesh;
 } ArmatureUserdata;
 
+/**
+ * Set the weight of the vertex in the modifier's vertex group, it's used to blend with the
+ * previous coordinates in multi-modifier mode.
+ */
+static void armature_vert_weight_set(const ArmatureUserdata *data,
+                                     float weight,
+                                     float *r_armature_weight,
+                                     float *r_prevco_weight)
+{
+  if (data->invert_vgroup) {
+    weight = 1.0f - weight;
+  }
+
+  /* hackish: the blending factor can be used for blending with vert_coords_prev too */
+  if (data->vert_coords_prev) {
+    *r_prevco_weight = weight;
+    *r_armature_weight = 1.0f;
+  }
+  else {
+    *r_armature_weight = weight;
+  }
+}
+
+/* Apply the accumulated deformation to `co`, which is in armature space. */
+static void armature_vert_deform_apply(const ArmatureUserdata *data,
+                                       const int i,
+                                       float co[3],
+                                       const float contrib,
+                                       DualQuat *dq,
+                                       float vec[3],
+                                       float summat[3][3],
+                                       const float armature_weight,
+                                       const float prevco_weight)
+{
+  float(*const vert_coords)[3] = data->vert_coords;
+  float(*const vert_deform_mats)[3][3] = data->vert_deform_mats;
+  const bool use_quaternion = data->use_quaternion;
+  float dco[3];
+
+  /* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
+  if (contrib > 0.0001f) {
+    if (use_quaternion) {
+      normalize_dq(dq, contrib);
+
+      if (armature_weight != 1.0f) {
+        copy_v3_v3(dco, co);
+        mul_v3m3_dq(dco, (vert_deform_mats) ? summat : NULL, dq);
+        sub_v3_v3(dco, co);
+        mul_v3_fl(dco, armature_weight);
+        add_v3_v3(co, dco);
+      }
+      else {
+        mul_v3m3_dq(co, (vert_deform_mats) ? summat : NULL, dq);
+      }
+    }
+    else {
+      mul_v3_fl(vec, armature_weight / contrib);
+      add_v3_v3v3(co, vec, co);
+    }
+
+    if (vert_deform_mats) {
+      float pre[3][3], post[3][3], tmpmat[3][3];
+
+      copy_m3_m4(pre, data->premat);
+      copy_m3_m4(post, data->postmat);
+      copy_m3_m3(tmpmat, vert_deform_mats[i]);
+
+      if (!use_quaternion) { /* quaternion already is scale corrected */
+        mul_m3_fl(summat, armature_weight / contrib);
+      }
+
+      mul_m3_series(vert_deform_mats[i], post, summat, pre, tmpmat);
+    }
+  }
+
+  /* always, check above code */
+  mul_m4_v3(data->postmat, co);
+
+  /* interpolate with previous modifier position using weight group */
+  if (data->vert_coords_prev) {
+    float mw = 1.0f - prevco_weight;
+    vert_coords[i][0] = prevco_weight * vert_coords[i][0] + mw * co[0];
+    vert_coords[i][1] = prevco_weight * vert_coords[i][1] + mw * co[1];
+    vert_coords[i][2] = prevco_weight * vert_coords[i][2] + mw * co[2];
+  }
+}
+
 static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
                                           const int i,
                                           const MDeformVert *dvert)
@@ -281,7 +586,7 @@ static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
 
   DualQuat sumdq, *dq = NULL;
   bPoseChannel *pchan;
-  float *co, dco[3];
+  float *co;
   float sumvec[3], summat[3][3];
   float *vec = NULL, (*smat)[3] = NULL;
   float contrib = 0.0f;
@@ -303,17 +608,10 @@ static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
   }
 
   if (armature_def_nr != -1 && dvert) {
-    armature_weight = BKE_defvert_find_weight(dvert, armature_def_nr);
-
-    if (data->invert_vgroup) {
-      armature_weight = 1.0f - armature_weight;
-    }
-
-    /* hackish: the blending factor can be used for blending with vert_coords_prev too */
-    if (vert_coords_prev) {
-      prevco_weight = armature_weight;
-      armature_weight = 1.0f;
-    }
+    armature_vert_weight_set(data,
+                             BKE_defvert_find_weight(dvert, armature_def_nr),
+                             &armature_weight,
+                             &prevco_weight);
   }
 
   /* check if there's any  point in calculating for this vert */
@@ -364,54 +662,8 @@ static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
     }
   }
 
-  /* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
-  if (contrib > 0.0001f) {
-    if (use_quaternion) {
-      normalize_dq(dq, contrib);
-
-      if (armature_weight != 1.0f) {
-        copy_v3_v3(dco, co);
-        mul_v3m3_dq(dco, (vert_deform_mats) ? summat : NULL, dq);
-        sub_v3_v3(dco, co);
-        mul_v3_fl(dco, armature_weight);
-        add_v3_v3(co, dco);
-      }
-      else {
-        mul_v3m3_dq(co, (vert_deform_mats) ? summat : NULL, dq);
-      }
-
-      smat = summat;
-    }
-    else {
-      mul_v3_fl(vec, armature_weight / contrib);
-      add_v3_v3v3(co, vec, co);
-    }
-
-    if (vert_deform_mats) {
-      float pre[3][3], post[3][3], tmpmat[3][3];
-
-      copy_m3_m4(pre, data->premat);
-      copy_m3_m4(post, data->postmat);
-      copy_m3_m3(tmpmat, vert_deform_mats[i]);
-
-      if (!use_quaternion) { /* quaternion already is scale corrected */
-        mul_m3_fl(smat, armature_weight / contrib);
-      }
-
-      mul_m3_series(vert_deform_mats[i], post, smat, pre, tmpmat);
-    }
-  }
-
-  /* always, check above code */
-  mul_m4_v3(data->postmat, co);
-
-  /* interpolate with previous modifier position using weight group */
-  if (vert_coords_prev) {
-    float mw = 1.0f - prevco_weight;
-    vert_coords[i][0] = prevco_weight * vert_coords[i][0] + mw * co[0];
-    vert_coords[i][1] = prevco_weight * vert_coords[i][1] + mw * co[1];
-    vert_coords[i][2] = prevco_weight * vert_coords[i][2] + mw * co[2];
-  }
+  armature_vert_deform_apply(
+      data, i, co, contrib, dq, vec, summat, armature_weight, prevco_weight);
 }
 
 static void armature_vert_task(void *__restrict userdata,
@@ -444,6 +696,159 @@ static void armature_vert_task(void *__restrict userdata,
   armature_vert_task_with_dvert(data, i, dvert);
 }
 
+/**
+ * Same as #pchan_deform_accumulate with a matrix. The vectorized version does the same floating
+ * point operations on the columns of the matrix, the results are identical.
+ */
+BLI_INLINE void armature_accumulate_mat(
+    const float mat[4][4], const float co[3], const float weight, float vec[4], float smat[3][3])
+{
+#ifdef __SSE2__
+  const __m128 weight_vec = _mm_set1_ps(weight);
+  const __m128 co_vec = _mm_setr_ps(co[0], co[1], co[2], 0.0f);
+  __m128 tmp_vec = _mm_mul_ps(_mm_loadu_ps(mat[0]), _mm_set1_ps(co[0]));
+  tmp_vec = _mm_add_ps(tmp_vec, _mm_mul_ps(_mm_loadu_ps(mat[1]), _mm_set1_ps(co[1])));
+  tmp_vec = _mm_add_ps(tmp_vec, _mm_mul_ps(_mm_loadu_ps(mat[2]), _mm_set1_ps(co[2])));
+  tmp_vec = _mm_add_ps(tmp_vec, _mm_loadu_ps(mat[3]));
+  tmp_vec = _mm_sub_ps(tmp_vec, co_vec);
+  _mm_storeu_ps(vec, _mm_add_ps(_mm_loadu_ps(vec), _mm_mul_ps(tmp_vec, weight_vec)));
+#else
+  float tmp[3];
+  mul_v3_m4v3(tmp, mat, co);
+  sub_v3_v3(tmp, co);
+  madd_v3_v3fl(vec, tmp, weight);
+#endif
+
+  if (smat) {
+    float tmpmat[3][3];
+    copy_m3_m4(tmpmat, mat);
+    madd_m3_m3m3fl(smat, smat, tmpmat, weight);
+  }
+}
+
+/**
+ * Same as #add_weighted_dq_dq. The vectorized version does the same floating point operations
+ * on the components of the quaternions and columns of the scale matrix, the results are
+ * identical.
+ */
+BLI_INLINE void armature_accumulate_dq(const DualQuat *dq, float weight, DualQuat *dq_sum)
+{
+#ifdef __SSE2__
+  bool flipped = false;
+
+  /* make sure we interpolate quats in the right direction */
+  if (dot_qtqt(dq->quat, dq_sum->quat) < 0) {
+    flipped = true;
+    weight = -weight;
+  }
+
+  __m128 weight_vec = _mm_set1_ps(weight);
+  _mm_storeu_ps(dq_sum->quat,
+                _mm_add_ps(_mm_loadu_ps(dq_sum->quat),
+                           _mm_mul_ps(weight_vec, _mm_loadu_ps(dq->quat))));
+  _mm_storeu_ps(dq_sum->trans,
+                _mm_add_ps(_mm_loadu_ps(dq_sum->trans),
+                           _mm_mul_ps(weight_vec, _mm_loadu_ps(dq->trans))));
+
+  if (dq->scale_weight) {
+    if (flipped) {
+      /* we don't want negative weights for scaling */
+      weight = -weight;
+      weight_vec = _mm_set1_ps(weight);
+    }
+
+    for (int i = 0; i < 4; i++) {
+      _mm_storeu_ps(dq_sum->scale[i],
+                    _mm_add_ps(_mm_loadu_ps(dq_sum->scale[i]),
+                               _mm_mul_ps(_mm_loadu_ps(dq->scale[i]), weight_vec)));
+    }
+    dq_sum->scale_weight += weight;
+  }
+#else
+  add_weighted_dq_dq(dq_sum, dq, weight);
+#endif
+}
+
+/**
+ * Deform a vertex from its compiled weights, same as #armature_vert_task_with_dvert.
+ */
+static void armature_vert_task_compiled(void *__restrict userdata,
+                                        const int i,
+                                        const TaskParallelTLS *__restrict tls)
+{
+  const ArmatureUserdata *data = userdata;
+  const ArmatureDeformWeights *weights = data->weights;
+
+  /* Vertices without deforming groups may use envelopes. */
+  if (!weights->vert_is_deformed[i]) {
+    armature_vert_task(userdata, i, tls);
+    return;
+  }
+
+  float(*const vert_coords_prev)[3] = data->vert_coords_prev;
+  const bool use_quaternion = data->use_quaternion;
+  DualQuat sumdq, *dq = NULL;
+  float sumvec[4], summat[3][3];
+  float(*smat)[3] = NULL;
+  float contrib = 0.0f;
+  float armature_weight = 1.0f;
+  float prevco_weight = 1.0f;
+
+  if (use_quaternion) {
+    memset(&sumdq, 0, sizeof(DualQuat));
+    dq = &sumdq;
+  }
+  else {
+    zero_v4(sumvec);
+    if (data->vert_deform_mats) {
+      zero_m3(summat);
+      smat = summat;
+    }
+  }
+
+  if (weights->armature_weights) {
+    armature_vert_weight_set(
+        data, weights->armature_weights[i], &armature_weight, &prevco_weight);
+  }
+
+  if (armature_weight == 0.0f) {
+    return;
+  }
+
+  float *co = vert_coords_prev ? vert_coords_prev[i] : data->vert_coords[i];
+  mul_m4_v3(data->premat, co);
+
+  const int offset_end = weights->offsets[i + 1];
+  for (int j = weights->offsets[i]; j < offset_end; j++) {
+    const int def_nr = weights->def_nrs[j];
+    float weight = weights->weights[j];
+
+    if (data->bones.use_pchan[def_nr]) {
+      bPoseChannel *pchan = data->pchan_from_defbase[def_nr];
+      Bone *bone = pchan->bone;
+
+      if (bone->flag & BONE_MULT_VG_ENV) {
+        weight *= distfactor_to_bone(
+            co, bone->arm_head, bone->arm_tail, bone->rad_head, bone->rad_tail, bone->dist);
+      }
+
+      pchan_bone_deform(pchan, weight, use_quaternion ? NULL : sumvec, dq, smat, co, &contrib);
+    }
+    else {
+      if (use_quaternion) {
+        armature_accumulate_dq(&data->bones.dquats[def_nr], weight, dq);
+      }
+      else {
+        armature_accumulate_mat(data->bones.mats[def_nr], co, weight, sumvec, smat);
+      }
+      contrib += weight;
+    }
+  }
+
+  armature_vert_deform_apply(
+      data, i, co, contrib, dq, sumvec, summat, armature_weight, prevco_weight);
+}
+
 static void armature_vert_task_editmesh(void *__restrict userdata, MempoolIterData *iter)
 {
   const ArmatureUserdata *data = userdata;
@@ -459,6 +864,39 @@ static void armature_vert_task_editmesh_no_dvert(void *__restrict userdata, Memp
   armature_vert_task_with_dvert(data, BM_elem_index_get(v), NULL);
 }
 
+/**
+ * Copy the deformation of the bone of each vertex group out of the pose channels,
+ * for #armature_vert_task_compiled.
+ */
+static void armature_deform_bones_pack(ArmatureUserdata *data)
+{
+  const int defbase_len = data->defbase_len;
+  data->bones.use_pchan = MEM_calloc_arrayN((size_t)defbase_len, sizeof(bool), __func__);
+  if (data->use_quaternion) {
+    data->bones.dquats = MEM_malloc_arrayN((size_t)defbase_len, sizeof(DualQuat), __func__);
+  }
+  else {
+    data->bones.mats = MEM_malloc_arrayN((size_t)defbase_len, sizeof(float[4][4]), __func__);
+  }
+
+  for (int i = 0; i < defbase_len; i++) {
+    const bPoseChannel *pchan = data->pchan_from_defbase[i];
+    if (pchan == NULL) {
+      continue;
+    }
+    const Bone *bone = pchan->bone;
+    data->bones.use_pchan[i] = (bone->flag & BONE_MULT_VG_ENV) ||
+                               (bone->segments > 1 &&
+                                pchan->runtime.bbone_segments == bone->segments);
+    if (data->use_quaternion) {
+      data->bones.dquats[i] = pchan->runtime.deform_dual_quat;
+    }
+    else {
+      copy_m4_m4(data->bones.mats[i], pchan->chan_mat);
+    }
+  }
+}
+
 static void armature_deform_coords_impl(const Object *ob_arm,
                                         const Object *ob_target,
                                         float (*vert_coords)[3],
@@ -469,7 +907,8 @@ static void armature_deform_coords_impl(const Object *ob_arm,
                                         const char *defgrp_name,
                                         const Mesh *me_target,
                                         BMEditMesh *em_target,
-                                        bGPDstroke *gps_target)
+                                        bGPDstroke *gps_target,
+                                        ArmatureDeformWeights **weights_cache)
 {
   bArmature *arm = ob_arm->data;
   bPoseChannel **pchan_from_defbase = NULL;
@@ -560,6 +999,16 @@ static void armature_deform_coords_impl(const Object *ob_arm,
     }
   }
 
+  /* Edit-mesh vertices are deformed in memory pool order, their groups are read directly. */
+  const ArmatureDeformWeights *weights = NULL;
+  if (use_dverts && weights_cache && ob_target->type == OB_MESH && em_target == NULL) {
+    const Mesh *me = me_target ? me_target : ob_target->data;
+    if (me->totvert == vert_coords_len) {
+      weights = armature_deform_weights_ensure(
+          weights_cache, me, pchan_from_defbase, defbase_len, armature_def_nr);
+    }
+  }
+
   ArmatureUserdata data = {
       .ob_arm = ob_arm,
       .ob_target = ob_target,
@@ -576,6 +1025,7 @@ static void armature_deform_coords_impl(const Object *ob_arm,
       .dverts_len = dverts_len,
       .pchan_from_defbase = pchan_from_defbase,
       .defbase_len = defbase_len,
+      .weights = weights,
       .bmesh =
           {
               .cd_dvert_offset = cd_dvert_offset,
@@ -605,7 +1055,16 @@ static void armature_deform_coords_impl(const Object *ob_arm,
     TaskParallelSettings settings;
     BLI_parallel_range_settings_defaults(&settings);
     settings.min_iter_per_thread = 32;
-    BLI_task_parallel_range(0, vert_coords_len, &data, armature_vert_task, &settings);
+    if (weights) {
+      armature_deform_bones_pack(&data);
+      BLI_task_parallel_range(0, vert_coords_len, &data, armature_vert_task_compiled, &settings);
+      MEM_freeN(data.bones.use_pchan);
+      MEM_SAFE_FREE(data.bones.mats);
+      MEM_SAFE_FREE(data.bones.dquats);
+    }
+    else {
+      BLI_task_parallel_range(0, vert_coords_len, &data, armature_vert_task, &settings);
+    }
   }
 
   if (pchan_from_defbase) {
@@ -633,7 +1092,8 @@ void BKE_armature_deform_coords_with_gpencil_stroke(const Object *ob_arm,
                               defgrp_name,
                               NULL,
                               NULL,
-                              gps_target);
+                              gps_target,
+                              NULL);
 }
 
 void BKE_armature_deform_coords_with_mesh(const Object *ob_arm,
@@ -656,9 +1116,40 @@ void BKE_armature_deform_coords_with_mesh(const Object *ob_arm,
                               defgrp_name,
                               me_target,
                               NULL,
+                              NULL,
                               NULL);
 }
 
+/**
+ * Same as #BKE_armature_deform_coords_with_mesh, the vertex group weights of the mesh are
+ * compiled once and kept in \a weights_cache for the next evaluations.
+ * Free with #BKE_armature_deform_weights_free.
+ */
+void BKE_armature_deform_coords_with_mesh_ex(const Object *ob_arm,
+                                             const Object *ob_target,
+                                             float (*vert_coords)[3],
+                                             float (*vert_deform_mats)[3][3],
+                                             int vert_coords_len,
+                                             int deformflag,
+                                             float (*vert_coords_prev)[3],
+                                             const char *defgrp_name,
+                                             const Mesh *me_target,
+                                             ArmatureDeformWeights **weights_cache)
+{
+  armature_deform_coords_impl(ob_arm,
+                              ob_target,
+                              vert_coords,
+                              vert_deform_mats,
+                              vert_coords_len,
+                              deformflag,
+                              vert_coords_prev,
+                              defgrp_name,
+                              me_target,
+                              NULL,
+                              NULL,
+                              weights_cache);
+}
+
 void BKE_armature_deform_coords_with_editmesh(const Object *ob_arm,
                                               const Object *ob_target,
                                               float (*vert_coords)[3],
@@ -679,6 +1170,7 @@ void BKE_armature_deform_coords_with_editmesh(const Object *ob_arm,
                               defgrp_name,
                               NULL,
                               em_target,
+                              NULL,
                               NULL);
 }
 
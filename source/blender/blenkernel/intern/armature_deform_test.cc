@@ -0,0 +1,351 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+
+#include "testing/testing.h"
+
+#include <cstdio>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_string.h"
+
+#include "DNA_action_types.h"
+#include "DNA_armature_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+
+#include "BKE_armature.h"
+#include "BKE_customdata.h"
+#include "BKE_deform.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
+#include "BKE_object.h"
+
+#include "PIL_time.h"
+
+namespace blender::bke::tests {
+
+class ArmatureDeformWeightsTest : public testing::Test {
+ protected:
+  Main *bmain_ = nullptr;
+  Object *ob_ = nullptr;
+  Mesh *me_ = nullptr;
+  Object ob_arm_;
+  bArmature arm_;
+  bPose pose_;
+  ArmatureDeformWeights *weights_ = nullptr;
+
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+
+  void SetUp() override
+  {
+    bmain_ = BKE_main_new();
+    ob_ = BKE_object_add_only_object(bmain_, OB_MESH, "Mesh");
+    ob_->obmat[3][1] = -0.25f;
+
+    memset(&ob_arm_, 0, sizeof(ob_arm_));
+    memset(&arm_, 0, sizeof(arm_));
+    memset(&pose_, 0, sizeof(pose_));
+    ob_arm_.type = OB_ARMATURE;
+    ob_arm_.data = &arm_;
+    ob_arm_.pose = &pose_;
+    unit_m4(ob_arm_.obmat);
+    ob_arm_.obmat[3][0] = 0.5f;
+  }
+
+  void TearDown() override
+  {
+    BKE_armature_deform_weights_free(weights_);
+    LISTBASE_FOREACH (bPoseChannel *, pchan, &pose_.chanbase) {
+      MEM_freeN(pchan->bone);
+    }
+    BLI_freelistN(&pose_.chanbase);
+    if (me_) {
+      ob_->data = nullptr;
+      BKE_id_free(nullptr, me_);
+    }
+    BKE_main_free(bmain_);
+  }
+
+  /* Randomly posed bones each deforming the vertex group of the same name. With `special`
+   * some bones are scaled, don't deform or multiply with their envelope, and vertices have
+   * no weights, zero weights or weights in groups without a bone. */
+  void build(const int bones_num,
+             const int verts_num,
+             const int weights_per_vert,
+             const bool special)
+  {
+    RNG *rng = BLI_rng_new(1);
+    const int groups_num = special ? bones_num + 2 : bones_num;
+    for (int i = 0; i < groups_num; i++) {
+      char name[MAX_NAME];
+      BLI_snprintf(name, sizeof(name), "Group%d", i);
+      BKE_object_defgroup_new(ob_, name);
+    }
+
+    for (int i = 0; i < bones_num; i++) {
+      bPoseChannel *pchan = (bPoseChannel *)MEM_callocN(sizeof(*pchan), __func__);
+      Bone *bone = (Bone *)MEM_callocN(sizeof(*bone), __func__);
+      BLI_snprintf(pchan->name, sizeof(pchan->name), "Group%d", i);
+      pchan->bone = bone;
+      bone->length = 1.0f;
+      bone->weight = 1.0f;
+      bone->arm_tail[1] = 1.0f;
+      bone->rad_head = 0.3f;
+      bone->rad_tail = 0.3f;
+      bone->dist = 0.5f;
+      unit_m4(bone->arm_mat);
+
+      const float loc[3] = {BLI_rng_get_float(rng), BLI_rng_get_float(rng), 0.0f};
+      const float eul[3] = {BLI_rng_get_float(rng), BLI_rng_get_float(rng), 0.0f};
+      const float scale = (special && i % 5 == 1) ? 1.5f : 1.0f;
+      const float size[3] = {scale, 1.0f, 1.0f};
+      loc_eul_size_to_mat4(pchan->chan_mat, loc, eul, size);
+      mat4_to_dquat(&pchan->runtime.deform_dual_quat, bone->arm_mat, pchan->chan_mat);
+
+      if (special && i % 7 == 3) {
+        bone->flag |= BONE_NO_DEFORM;
+      }
+      if (special && i % 11 == 5) {
+        bone->flag |= BONE_MULT_VG_ENV;
+      }
+      BLI_addtail(&pose_.chanbase, pchan);
+    }
+
+    me_ = BKE_mesh_new_nomain(verts_num, 0, 0, 0, 0);
+    me_->dvert = (MDeformVert *)CustomData_add_layer(
+        &me_->vdata, CD_MDEFORMVERT, CD_CALLOC, nullptr, verts_num);
+    for (int v = 0; v < verts_num; v++) {
+      const int weights_num = (special && v % 13 == 0) ? 0 : weights_per_vert;
+      for (int j = 0; j < weights_num; j++) {
+        const float weight = (special && j == 1 && v % 3 == 0) ? 0.0f : BLI_rng_get_float(rng);
+        BKE_defvert_add_index_notest(
+            &me_->dvert[v], BLI_rng_get_int(rng) % groups_num, weight);
+      }
+    }
+    ob_->data = me_;
+    BLI_rng_free(rng);
+  }
+
+  static float (*coords_new(const int verts_num, const int seed))[3]
+  {
+    RNG *rng = BLI_rng_new(seed);
+    float(*coords)[3] = (float(*)[3])MEM_malloc_arrayN(verts_num, sizeof(float[3]), __func__);
+    for (int v = 0; v < verts_num; v++) {
+      coords[v][0] = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+      coords[v][1] = BLI_rng_get_float(rng) * 2.0f;
+      coords[v][2] = BLI_rng_get_float(rng) - 0.5f;
+    }
+    BLI_rng_free(rng);
+    return coords;
+  }
+
+  /* Deform with and without the compiled weights, returns whether the results are the same. */
+  bool deform_matches(const int deformflag,
+                      const char *defgrp_name = "",
+                      const bool use_deform_mats = false,
+                      const bool use_coords_prev = false)
+  {
+    const int verts_num = me_->totvert;
+    float(*coords_direct)[3] = coords_new(verts_num, 7);
+    float(*coords)[3] = (float(*)[3])MEM_dupallocN(coords_direct);
+    float(*coords_prev)[3] = use_coords_prev ? coords_new(verts_num, 8) : nullptr;
+    float(*mats_direct)[3][3] = nullptr, (*mats)[3][3] = nullptr;
+    if (use_deform_mats) {
+      mats_direct = (float(*)[3][3])MEM_malloc_arrayN(verts_num, sizeof(float[3][3]), __func__);
+      for (int v = 0; v < verts_num; v++) {
+        unit_m3(mats_direct[v]);
+      }
+      mats = (float(*)[3][3])MEM_dupallocN(mats_direct);
+    }
+
+    BKE_armature_deform_coords_with_mesh(&ob_arm_,
+                                         ob_,
+                                         coords_direct,
+                                         mats_direct,
+                                         verts_num,
+                                         deformflag,
+                                         coords_prev,
+                                         defgrp_name,
+                                         nullptr);
+    BKE_armature_deform_coords_with_mesh_ex(&ob_arm_,
+                                            ob_,
+                                            coords,
+                                            mats,
+                                            verts_num,
+                                            deformflag,
+                                            coords_prev,
+                                            defgrp_name,
+                                            nullptr,
+                                            &weights_);
+    EXPECT_NE(weights_, nullptr);
+
+    bool match = memcmp(coords, coords_direct, sizeof(float[3]) * verts_num) == 0;
+    if (use_deform_mats) {
+      match &= memcmp(mats, mats_direct, sizeof(float[3][3]) * verts_num) == 0;
+    }
+
+    MEM_freeN(coords_direct);
+    MEM_freeN(coords);
+    MEM_SAFE_FREE(coords_prev);
+    MEM_SAFE_FREE(mats_direct);
+    MEM_SAFE_FREE(mats);
+    return match;
+  }
+};
+
+/* The compiled kernel does the same operations in the same order, results are identical. */
+TEST_F(ArmatureDeformWeightsTest, MatchesDirectDeform)
+{
+  build(24, 2000, 4, true);
+  const int deformflags[] = {
+      ARM_DEF_VGROUP,
+      ARM_DEF_VGROUP | ARM_DEF_ENVELOPE,
+      ARM_DEF_VGROUP | ARM_DEF_QUATERNION,
+      ARM_DEF_VGROUP | ARM_DEF_QUATERNION | ARM_DEF_ENVELOPE | ARM_DEF_INVERT_VGROUP,
+  };
+  for (const int deformflag : deformflags) {
+    EXPECT_TRUE(deform_matches(deformflag));
+    EXPECT_TRUE(deform_matches(deformflag, "", true));
+    /* Modifier vertex group, with and without blending to previous coordinates. */
+    EXPECT_TRUE(deform_matches(deformflag, "Group2"));
+    EXPECT_TRUE(deform_matches(deformflag, "Group2", true));
+    EXPECT_TRUE(deform_matches(deformflag, "Group2", false, true));
+  }
+}
+
+TEST_F(ArmatureDeformWeightsTest, WeightPaintInvalidates)
+{
+  build(8, 64, 2, false);
+  MDeformWeight *dw = me_->dvert[0].dw;
+  dw[0].def_nr = 0;
+  dw[0].weight = 1.0f;
+  dw[1].def_nr = 1;
+  dw[1].weight = 0.0f;
+  EXPECT_TRUE(deform_matches(ARM_DEF_VGROUP));
+  const ArmatureDeformWeights *weights = weights_;
+
+  /* Weights edited without tagging keep using the compiled weights. */
+  me_->dvert[0].dw[0].weight = 0.0f;
+  me_->dvert[0].dw[1].weight = 1.0f;
+  EXPECT_FALSE(deform_matches(ARM_DEF_VGROUP));
+  EXPECT_EQ(weights_, weights);
+
+  /* Once tagged the weights are compiled again. */
+  BKE_mesh_runtime_tag_deform_verts_changed(me_);
+  EXPECT_TRUE(deform_matches(ARM_DEF_VGROUP));
+}
+
+TEST_F(ArmatureDeformWeightsTest, BoneDeformFlagInvalidates)
+{
+  build(8, 64, 2, false);
+  EXPECT_TRUE(deform_matches(ARM_DEF_VGROUP));
+
+  /* Groups of bones that don't deform are left out of the compiled weights. */
+  ((bPoseChannel *)pose_.chanbase.first)->bone->flag |= BONE_NO_DEFORM;
+  EXPECT_TRUE(deform_matches(ARM_DEF_VGROUP));
+  ((bPoseChannel *)pose_.chanbase.first)->bone->flag &= ~BONE_NO_DEFORM;
+  EXPECT_TRUE(deform_matches(ARM_DEF_VGROUP));
+
+  /* The modifier vertex group changes which weights are compiled. */
+  EXPECT_TRUE(deform_matches(ARM_DEF_VGROUP, "Group3"));
+  EXPECT_TRUE(deform_matches(ARM_DEF_VGROUP, "Group4"));
+}
+
+TEST_F(ArmatureDeformWeightsTest, CopyInvalidates)
+{
+  build(8, 64, 2, false);
+  EXPECT_TRUE(deform_matches(ARM_DEF_VGROUP));
+
+  /* A copy can be edited independently, it never shares the key of the source. */
+  Mesh *me_copy = BKE_mesh_copy_for_eval(me_, false);
+  EXPECT_NE(me_copy->runtime.deform_verts_edit_count, me_->runtime.deform_verts_edit_count);
+  const int edit_count = me_->runtime.deform_verts_edit_count;
+  BKE_mesh_runtime_tag_deform_verts_changed(me_);
+  EXPECT_NE(me_->runtime.deform_verts_edit_count, edit_count);
+  EXPECT_NE(me_->runtime.deform_verts_edit_count, me_copy->runtime.deform_verts_edit_count);
+  BKE_id_free(nullptr, me_copy);
+}
+
+/* Crowd of characters sharing one rig, 4 weights per vertex. */
+TEST_F(ArmatureDeformWeightsTest, performance_crowd)
+{
+  const int characters_num = 20, verts_num = 10000, frames_num = 3;
+  build(60, verts_num, 4, false);
+  float(*coords)[3] = coords_new(verts_num, 3);
+  ArmatureDeformWeights **weights = (ArmatureDeformWeights **)MEM_callocN(
+      sizeof(*weights) * characters_num, __func__);
+
+  const int deformflags[] = {ARM_DEF_VGROUP, ARM_DEF_VGROUP | ARM_DEF_QUATERNION};
+  for (const int deformflag : deformflags) {
+    double time = PIL_check_seconds_timer();
+    for (int frame = 0; frame < frames_num; frame++) {
+      for (int c = 0; c < characters_num; c++) {
+        BKE_armature_deform_coords_with_mesh(
+            &ob_arm_, ob_, coords, nullptr, verts_num, deformflag, nullptr, "", nullptr);
+      }
+    }
+    const double time_direct = PIL_check_seconds_timer() - time;
+
+    /* The first frame compiles the weights. */
+    for (int c = 0; c < characters_num; c++) {
+      BKE_armature_deform_coords_with_mesh_ex(
+          &ob_arm_, ob_, coords, nullptr, verts_num, deformflag, nullptr, "", nullptr, &weights[c]);
+    }
+    time = PIL_check_seconds_timer();
+    for (int frame = 0; frame < frames_num; frame++) {
+      for (int c = 0; c < characters_num; c++) {
+        BKE_armature_deform_coords_with_mesh_ex(&ob_arm_,
+                                                ob_,
+                                                coords,
+                                                nullptr,
+                                                verts_num,
+                                                deformflag,
+                                                nullptr,
+                                                "",
+                                                nullptr,
+                                                &weights[c]);
+      }
+    }
+    const double time_compiled = PIL_check_seconds_timer() - time;
+
+    printf("%s: direct %.3fs, compiled %.3fs per frame\n",
+           (deformflag & ARM_DEF_QUATERNION) ? "Dual quaternion" : "Linear blend",
+           time_direct / frames_num,
+           time_compiled / frames_num);
+    for (int c = 0; c < characters_num; c++) {
+      BKE_armature_deform_weights_free(weights[c]);
+      weights[c] = nullptr;
+    }
+  }
+
+  MEM_freeN(weights);
+  MEM_freeN(coords);
+}
+
+}  // namespace blender::bke::tests
@@ -28,7 +28,9 @@
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
 
+#include "BLI_ghash.h"
 #include "BLI_linklist.h"
+#include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
@@ -40,24 +42,29 @@
 
 #include "MEM_guardedalloc.h"
 
+static void bvhtree_shared_release(BVHTree *tree);
+
 /* -------------------------------------------------------------------- */
 /** \name BVHCache
  * \{ */
 
 typedef struct BVHCacheItem {
   bool is_filled;
+  /** The tree is owned by the shared trees, see #bvhtree_shared_balance. */
+  bool is_shared;
   BVHTree *tree;
+  /** Locked while the tree is being built, so other types can be built at the same time. */
+  ThreadMutex mutex;
 } BVHCacheItem;
 
 typedef struct BVHCache {
   BVHCacheItem items[BVHTREE_MAX_ITEM];
-  ThreadMutex mutex;
 } BVHCache;
 
 /**
  * Queries a bvhcache for the cache bvhtree of the request type
  *
- * When the `r_locked` is filled and the tree could not be found the caches mutex will be
+ * When the `r_locked` is filled and the tree could not be found the mutex of the item will be
  * locked. This mutex can be unlocked by calling `bvhcache_unlock`.
  *
  * When `r_locked` is used the `mesh_eval_mutex` must contain the `Mesh_Runtime.eval_mutex`.
@@ -91,10 +98,10 @@ static bool bvhcache_find(BVHCache **bvh_cache_p,
     return true;
   }
   if (do_lock) {
-    BLI_mutex_lock(&bvh_cache->mutex);
+    BLI_mutex_lock(&bvh_cache->items[type].mutex);
     bool in_cache = bvhcache_find(bvh_cache_p, type, r_tree, NULL, NULL);
     if (in_cache) {
-      BLI_mutex_unlock(&bvh_cache->mutex);
+      BLI_mutex_unlock(&bvh_cache->items[type].mutex);
       return in_cache;
     }
     *r_locked = true;
@@ -102,10 +109,10 @@ static bool bvhcache_find(BVHCache **bvh_cache_p,
   return false;
 }
 
-static void bvhcache_unlock(BVHCache *bvh_cache, bool lock_started)
+static void bvhcache_unlock(BVHCache *bvh_cache, BVHCacheType type, bool lock_started)
 {
   if (lock_started) {
-    BLI_mutex_unlock(&bvh_cache->mutex);
+    BLI_mutex_unlock(&bvh_cache->items[type].mutex);
   }
 }
 
@@ -126,7 +133,9 @@ bool bvhcache_has_tree(const BVHCache *bvh_cache, const BVHTree *tree)
 BVHCache *bvhcache_init(void)
 {
   BVHCache *cache = MEM_callocN(sizeof(BVHCache), __func__);
-  BLI_mutex_init(&cache->mutex);
+  for (BVHCacheType i = 0; i < BVHTREE_MAX_ITEM; i++) {
+    BLI_mutex_init(&cache->items[i].mutex);
+  }
   return cache;
 }
 /**
@@ -137,11 +146,15 @@ BVHCache *bvhcache_init(void)
  * A call to this assumes that there was no previous cached tree of the given type
  * \warning The #BVHTree can be NULL.
  */
-static void bvhcache_insert(BVHCache *bvh_cache, BVHTree *tree, BVHCacheType type)
+static void bvhcache_insert(BVHCache *bvh_cache,
+                            BVHTree *tree,
+                            BVHCacheType type,
+                            const bool is_shared)
 {
   BVHCacheItem *item = &bvh_cache->items[type];
   BLI_assert(!item->is_filled);
   item->tree = tree;
+  item->is_shared = is_shared;
   item->is_filled = true;
 }
 
@@ -152,14 +165,285 @@ void bvhcache_free(BVHCache *bvh_cache)
 {
   for (BVHCacheType index = 0; index < BVHTREE_MAX_ITEM; index++) {
     BVHCacheItem *item = &bvh_cache->items[index];
-    BLI_bvhtree_free(item->tree);
+    if (item->is_shared) {
+      bvhtree_shared_release(item->tree);
+    }
+    else {
+      BLI_bvhtree_free(item->tree);
+    }
     item->tree = NULL;
+    BLI_mutex_end(&item->mutex);
   }
-  BLI_mutex_end(&bvh_cache->mutex);
   MEM_freeN(bvh_cache);
 }
 
 /** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Shared BVH Trees
+ *
+ * Trees cached on meshes are shared between all meshes with the same content, like the
+ * copy-on-write copies of a mesh which are evaluated in different dependency graphs.
+ *
+ * The key of a tree are its leafs before balancing: element indices and bounds. Inserting the
+ * leafs is cheap compared to balancing, so a new tree is always filled and then either replaced
+ * by an identical shared tree or balanced and shared.
+ *
+ * Trees without users are kept for a while, when a tree with the same leafs but different
+ * bounds is requested (a deformed mesh) the unused tree is refit instead of building a new one.
+ * Refit trees are balanced again once their bounds degraded too much.
+ *
+ * Trees in use are looked up by their leafs and by the tree itself, unused trees are kept in a
+ * short list ordered by their last use.
+ *
+ * The lock of the shared trees is never held while balancing or refitting: balancing runs tasks,
+ * and a thread waiting for that lock may run other tasks that need it. Balancing does run while
+ * the #BVHCacheItem lock of the requesting mesh is held, as it does for trees that are not
+ * shared. That lock only blocks threads requesting the same tree of the same mesh, which would
+ * otherwise build it again.
+ * \{ */
+
+/* Number of trees without users kept for refitting. */
+#define BVH_SHARED_UNUSED_MAX 4
+/* Number of refits after which a tree is balanced again. */
+#define BVH_SHARED_REFIT_MAX 16
+/* Growth of #BLI_bvhtree_branches_extent_ratio since balancing, after which a refit tree is
+ * balanced again. */
+#define BVH_SHARED_REFIT_EXTENT_GROWTH_MAX 1.5f
+
+typedef struct BVHSharedTree {
+  /** Link in #bvh_shared.unused. */
+  struct BVHSharedTree *next, *prev;
+  BVHTree *tree;
+  /** #BLI_bvhtree_leafs_hash with and without bounds. */
+  uint hash;
+  uint hash_topology;
+  int balance_flag;
+  int users;
+  /** Number of refits since the tree was balanced. */
+  int refit_len;
+  /** #BLI_bvhtree_branches_extent_ratio right after balancing. */
+  float extent_ratio_balanced;
+} BVHSharedTree;
+
+static struct {
+  /** Trees with users, a set of #BVHSharedTree keyed on leafs and bounds. */
+  GSet *used;
+  /** Trees with users, #BVHTree to #BVHSharedTree. */
+  GHash *used_by_tree;
+  /** Trees without users, the most recently released first. */
+  ListBase unused;
+  int unused_len;
+  /** Protects the lists and user counts. */
+  ThreadMutex mutex;
+} bvh_shared = {NULL, NULL, {NULL}, 0, BLI_MUTEX_INITIALIZER};
+
+static uint bvhtree_shared_hash(const void *key)
+{
+  const BVHSharedTree *shared = key;
+  return BLI_ghashutil_combine_hash(shared->hash, (uint)shared->balance_flag);
+}
+
+static bool bvhtree_shared_cmp(const void *a, const void *b)
+{
+  const BVHSharedTree *shared_a = a;
+  const BVHSharedTree *shared_b = b;
+  return !(shared_a->hash == shared_b->hash && shared_a->balance_flag == shared_b->balance_flag &&
+           BLI_bvhtree_leafs_equal(shared_a->tree, shared_b->tree, true));
+}
+
+static void bvhtree_shared_free(BVHSharedTree *shared)
+{
+  BLI_bvhtree_free(shared->tree);
+  MEM_freeN(shared);
+}
+
+/**
+ * Add a tree to the trees in use.
+ * Must be called with #bvh_shared.mutex locked.
+ */
+static void bvhtree_shared_add_used(BVHSharedTree *shared)
+{
+  if (bvh_shared.used == NULL) {
+    bvh_shared.used = BLI_gset_new(bvhtree_shared_hash, bvhtree_shared_cmp, __func__);
+    bvh_shared.used_by_tree = BLI_ghash_ptr_new(__func__);
+  }
+  BLI_gset_insert(bvh_shared.used, shared);
+  BLI_ghash_insert(bvh_shared.used_by_tree, shared->tree, shared);
+}
+
+/**
+ * Find a tree in use with the same leafs and bounds as \a tree, adding a user to it.
+ * Must be called with #bvh_shared.mutex locked.
+ */
+static BVHSharedTree *bvhtree_shared_find_used(const BVHTree *tree,
+                                               const uint hash,
+                                               const int balance_flag)
+{
+  if (bvh_shared.used == NULL) {
+    return NULL;
+  }
+  BVHSharedTree key = {NULL};
+  key.tree = (BVHTree *)tree;
+  key.hash = hash;
+  key.balance_flag = balance_flag;
+  BVHSharedTree *shared = BLI_gset_lookup(bvh_shared.used, &key);
+  if (shared) {
+    shared->users++;
+  }
+  return shared;
+}
+
+/**
+ * Refit an unused tree to the bounds of \a tree.
+ * \return False when the refit tree degraded too much and should be balanced again.
+ */
+static bool bvhtree_shared_refit(BVHSharedTree *shared, const BVHTree *tree)
+{
+  if (shared->refit_len >= BVH_SHARED_REFIT_MAX) {
+    return false;
+  }
+  BLI_bvhtree_refit_from_leafs(shared->tree, tree);
+  shared->refit_len++;
+  return BLI_bvhtree_branches_extent_ratio(shared->tree) <=
+         shared->extent_ratio_balanced * BVH_SHARED_REFIT_EXTENT_GROWTH_MAX;
+}
+
+/**
+ * Balance a tree with all leafs inserted, or replace it with an equal shared tree.
+ * The returned tree must be released with #bvhtree_shared_release.
+ */
+static BVHTree *bvhtree_shared_balance(BVHTree *tree, const int balance_flag)
+{
+  const uint hash = BLI_bvhtree_leafs_hash(tree, true);
+  const uint hash_topology = BLI_bvhtree_leafs_hash(tree, false);
+
+  BLI_mutex_lock(&bvh_shared.mutex);
+
+  BVHSharedTree *shared = bvhtree_shared_find_used(tree, hash, balance_flag);
+  if (shared) {
+    BLI_mutex_unlock(&bvh_shared.mutex);
+    BLI_bvhtree_free(tree);
+    return shared->tree;
+  }
+
+  /* An unused tree with the same leafs, the bounds may differ. */
+  LISTBASE_FOREACH (BVHSharedTree *, shared_iter, &bvh_shared.unused) {
+    if (shared_iter->hash_topology == hash_topology && shared_iter->balance_flag == balance_flag &&
+        BLI_bvhtree_leafs_equal(shared_iter->tree, tree, false)) {
+      shared = shared_iter;
+      break;
+    }
+  }
+  if (shared) {
+    BLI_remlink(&bvh_shared.unused, shared);
+    bvh_shared.unused_len--;
+  }
+
+  BLI_mutex_unlock(&bvh_shared.mutex);
+
+  if (shared) {
+    if (bvhtree_shared_refit(shared, tree)) {
+      BLI_bvhtree_free(tree);
+    }
+    else {
+      bvhtree_shared_free(shared);
+      shared = NULL;
+    }
+  }
+  if (shared == NULL) {
+    BLI_bvhtree_balance_ex(tree, balance_flag);
+    shared = MEM_callocN(sizeof(*shared), __func__);
+    shared->tree = tree;
+    shared->balance_flag = balance_flag;
+    shared->extent_ratio_balanced = BLI_bvhtree_branches_extent_ratio(tree);
+  }
+  shared->hash = hash;
+  shared->hash_topology = hash_topology;
+  shared->users = 1;
+
+  BLI_mutex_lock(&bvh_shared.mutex);
+
+  /* Another thread may have built an equal tree in the meantime. */
+  BVHSharedTree *shared_other = bvhtree_shared_find_used(shared->tree, hash, balance_flag);
+  if (shared_other) {
+    BLI_mutex_unlock(&bvh_shared.mutex);
+    bvhtree_shared_free(shared);
+    return shared_other->tree;
+  }
+  bvhtree_shared_add_used(shared);
+
+  BLI_mutex_unlock(&bvh_shared.mutex);
+
+  return shared->tree;
+}
+
+static void bvhtree_shared_release(BVHTree *tree)
+{
+  if (tree == NULL) {
+    return;
+  }
+
+  BVHSharedTree *shared_free = NULL;
+
+  BLI_mutex_lock(&bvh_shared.mutex);
+  BVHSharedTree *shared = BLI_ghash_lookup(bvh_shared.used_by_tree, tree);
+  BLI_assert(shared && shared->users > 0);
+  if (--shared->users == 0) {
+    BLI_gset_remove(bvh_shared.used, shared, NULL);
+    BLI_ghash_remove(bvh_shared.used_by_tree, tree, NULL, NULL);
+    BLI_addhead(&bvh_shared.unused, shared);
+    if (++bvh_shared.unused_len > BVH_SHARED_UNUSED_MAX) {
+      shared_free = bvh_shared.unused.last;
+      BLI_remlink(&bvh_shared.unused, shared_free);
+      bvh_shared.unused_len--;
+    }
+  }
+  BLI_mutex_unlock(&bvh_shared.mutex);
+
+  if (shared_free) {
+    bvhtree_shared_free(shared_free);
+  }
+}
+
+/**
+ * Free the trees kept for refitting, trees in use are freed by the last #BVHCache using them.
+ */
+void bvhcache_shared_exit(void)
+{
+  BLI_mutex_lock(&bvh_shared.mutex);
+  LISTBASE_FOREACH_MUTABLE (BVHSharedTree *, shared, &bvh_shared.unused) {
+    bvhtree_shared_free(shared);
+  }
+  BLI_listbase_clear(&bvh_shared.unused);
+  bvh_shared.unused_len = 0;
+  if (bvh_shared.used && BLI_gset_len(bvh_shared.used) == 0) {
+    BLI_gset_free(bvh_shared.used, NULL);
+    BLI_ghash_free(bvh_shared.used_by_tree, NULL, NULL);
+    bvh_shared.used = NULL;
+    bvh_shared.used_by_tree = NULL;
+  }
+  BLI_mutex_unlock(&bvh_shared.mutex);
+}
+
+/**
+ * Balance a tree with all leafs inserted.
+ * \param use_shared: The tree is stored in a #BVHCache, share it with equal trees.
+ */
+static BVHTree *bvhtree_balance(BVHTree *tree, const int balance_flag, const bool use_shared)
+{
+  if (tree == NULL) {
+    return NULL;
+  }
+  if (use_shared) {
+    return bvhtree_shared_balance(tree, balance_flag);
+  }
+  BLI_bvhtree_balance_ex(tree, balance_flag);
+  return tree;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Local Callbacks
  * \{ */
@@ -599,7 +883,6 @@ static BVHTree *bvhtree_from_mesh_verts_create_tree(float epsilon,
         BLI_bvhtree_insert(tree, i, vert[i].co, 1);
       }
       BLI_assert(BLI_bvhtree_get_len(tree) == verts_num_active);
-      BLI_bvhtree_balance(tree);
     }
   }
 
@@ -651,10 +934,10 @@ BVHTree *bvhtree_from_editmesh_verts_ex(BVHTreeFromEditMesh *data,
 
       /* Save on cache for later use */
       /* printf("BVHTree built and saved on cache\n"); */
-      bvhcache_insert(*bvh_cache_p, tree, bvh_cache_type);
+      bvhcache_insert(*bvh_cache_p, tree, bvh_cache_type, false);
       data->cached = true;
     }
-    bvhcache_unlock(*bvh_cache_p, lock_started);
+    bvhcache_unlock(*bvh_cache_p, bvh_cache_type, lock_started);
   }
   else {
     tree = bvhtree_from_editmesh_verts_create_tree(
@@ -710,18 +993,19 @@ BVHTree *bvhtree_from_mesh_verts_ex(BVHTreeFromMesh *data,
   if (in_cache == false) {
     tree = bvhtree_from_mesh_verts_create_tree(
         epsilon, tree_type, axis, vert, verts_num, verts_mask, verts_num_active);
+    tree = bvhtree_balance(tree, 0, bvh_cache_p != NULL);
 
     if (bvh_cache_p) {
       /* Save on cache for later use */
       /* printf("BVHTree built and saved on cache\n"); */
       BVHCache *bvh_cache = *bvh_cache_p;
-      bvhcache_insert(bvh_cache, tree, bvh_cache_type);
+      bvhcache_insert(bvh_cache, tree, bvh_cache_type, true);
       in_cache = true;
     }
   }
 
   if (bvh_cache_p) {
-    bvhcache_unlock(*bvh_cache_p, lock_started);
+    bvhcache_unlock(*bvh_cache_p, bvh_cache_type, lock_started);
   }
 
   /* Setup BVHTreeFromMesh */
@@ -808,7 +1092,6 @@ static BVHTree *bvhtree_from_mesh_edges_create_tree(const MVert *vert,
 
         BLI_bvhtree_insert(tree, i, co[0], 2);
       }
-      BLI_bvhtree_balance(tree);
     }
   }
 
@@ -863,10 +1146,10 @@ BVHTree *bvhtree_from_editmesh_edges_ex(BVHTreeFromEditMesh *data,
 
       /* Save on cache for later use */
       /* printf("BVHTree built and saved on cache\n"); */
-      bvhcache_insert(bvh_cache, tree, bvh_cache_type);
+      bvhcache_insert(bvh_cache, tree, bvh_cache_type, false);
       data->cached = true;
     }
-    bvhcache_unlock(bvh_cache, lock_started);
+    bvhcache_unlock(bvh_cache, bvh_cache_type, lock_started);
   }
   else {
     tree = bvhtree_from_editmesh_edges_create_tree(
@@ -925,18 +1208,19 @@ BVHTree *bvhtree_from_mesh_edges_ex(BVHTreeFromMesh *data,
   if (in_cache == false) {
     tree = bvhtree_from_mesh_edges_create_tree(
         vert, edge, edges_num, edges_mask, edges_num_active, epsilon, tree_type, axis);
+    tree = bvhtree_balance(tree, 0, bvh_cache_p != NULL);
 
     if (bvh_cache_p) {
       BVHCache *bvh_cache = *bvh_cache_p;
       /* Save on cache for later use */
       /* printf("BVHTree built and saved on cache\n"); */
-      bvhcache_insert(bvh_cache, tree, bvh_cache_type);
+      bvhcache_insert(bvh_cache, tree, bvh_cache_type, true);
       in_cache = true;
     }
   }
 
   if (bvh_cache_p) {
-    bvhcache_unlock(*bvh_cache_p, lock_started);
+    bvhcache_unlock(*bvh_cache_p, bvh_cache_type, lock_started);
   }
 
   /* Setup BVHTreeFromMesh */
@@ -993,7 +1277,6 @@ static BVHTree *bvhtree_from_mesh_faces_create_tree(float epsilon,
         }
       }
       BLI_assert(BLI_bvhtree_get_len(tree) == faces_num_active);
-      BLI_bvhtree_balance(tree);
     }
   }
 
@@ -1056,18 +1339,19 @@ BVHTree *bvhtree_from_mesh_faces_ex(BVHTreeFromMesh *data,
   if (in_cache == false) {
     tree = bvhtree_from_mesh_faces_create_tree(
         epsilon, tree_type, axis, vert, face, numFaces, faces_mask, faces_num_active);
+    tree = bvhtree_balance(tree, 0, bvh_cache_p != NULL);
 
     if (bvh_cache_p) {
       /* Save on cache for later use */
       /* printf("BVHTree built and saved on cache\n"); */
       BVHCache *bvh_cache = *bvh_cache_p;
-      bvhcache_insert(bvh_cache, tree, bvh_cache_type);
+      bvhcache_insert(bvh_cache, tree, bvh_cache_type, true);
       in_cache = true;
     }
   }
 
   if (bvh_cache_p) {
-    bvhcache_unlock(*bvh_cache_p, lock_started);
+    bvhcache_unlock(*bvh_cache_p, bvh_cache_type, lock_started);
   }
 
   /* Setup BVHTreeFromMesh */
@@ -1172,7 +1456,6 @@ static BVHTree *bvhtree_from_mesh_looptri_create_tree(float epsilon,
         }
       }
       BLI_assert(BLI_bvhtree_get_len(tree) == looptri_num_active);
-      BLI_bvhtree_balance(tree);
     }
   }
 
@@ -1235,9 +1518,9 @@ BVHTree *bvhtree_from_editmesh_looptri_ex(BVHTreeFromEditMesh *data,
 
       /* Save on cache for later use */
       /* printf("BVHTree built and saved on cache\n"); */
-      bvhcache_insert(bvh_cache, tree, bvh_cache_type);
+      bvhcache_insert(bvh_cache, tree, bvh_cache_type, false);
     }
-    bvhcache_unlock(bvh_cache, lock_started);
+    bvhcache_unlock(bvh_cache, bvh_cache_type, lock_started);
   }
   else {
     tree = bvhtree_from_editmesh_looptri_create_tree(
@@ -1301,16 +1584,19 @@ BVHTree *bvhtree_from_mesh_looptri_ex(BVHTreeFromMesh *data,
                                                  looptri_num,
                                                  looptri_mask,
                                                  looptri_num_active);
+    tree = bvhtree_balance(tree,
+                           (bvh_cache_type == BVHTREE_FROM_LOOPTRI_SAH) ? BVH_BALANCE_SAH : 0,
+                           bvh_cache_p != NULL);
 
     if (bvh_cache_p) {
       BVHCache *bvh_cache = *bvh_cache_p;
-      bvhcache_insert(bvh_cache, tree, bvh_cache_type);
+      bvhcache_insert(bvh_cache, tree, bvh_cache_type, true);
       in_cache = true;
     }
   }
 
   if (bvh_cache_p) {
-    bvhcache_unlock(*bvh_cache_p, lock_started);
+    bvhcache_unlock(*bvh_cache_p, bvh_cache_type, lock_started);
   }
 
   /* Setup BVHTreeFromMesh */
@@ -1527,6 +1813,7 @@ BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
 
     case BVHTREE_FROM_LOOPTRI:
     case BVHTREE_FROM_LOOPTRI_NO_HIDDEN:
+    case BVHTREE_FROM_LOOPTRI_SAH:
       if (is_cached == false) {
         const MLoopTri *mlooptri = BKE_mesh_runtime_looptri_ensure(mesh);
         int looptri_len = BKE_mesh_runtime_looptri_len(mesh);
@@ -1654,6 +1941,7 @@ BVHTree *BKE_bvhtree_from_editmesh_get(BVHTreeFromEditMesh *data,
     case BVHTREE_FROM_FACES:
     case BVHTREE_FROM_LOOPTRI:
     case BVHTREE_FROM_LOOPTRI_NO_HIDDEN:
+    case BVHTREE_FROM_LOOPTRI_SAH:
     case BVHTREE_FROM_LOOSEVERTS:
     case BVHTREE_FROM_LOOSEEDGES:
     case BVHTREE_MAX_ITEM:
@@ -74,6 +74,11 @@ void BKE_callback_exec_id_depsgraph(struct Main *bmain,
   BKE_callback_exec(bmain, pointers, 2, evt);
 }
 
+bool BKE_callback_has_handlers(eCbEvent evt)
+{
+  return !BLI_listbase_is_empty(&callback_slots[evt]);
+}
+
 void BKE_callback_add(bCallbackFuncStore *funcstore, eCbEvent evt)
 {
   ListBase *lb = &callback_slots[evt];
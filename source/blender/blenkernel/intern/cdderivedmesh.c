@@ -286,7 +286,7 @@ static DerivedMesh *cdDM_from_mesh_ex(Mesh *mesh,
   dm->deformedOnly = 1;
   dm->cd_flag = mesh->cd_flag;
 
-  if (mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) {
+  if (mesh->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY) {
     dm->dirty |= DM_DIRTY_NORMALS;
   }
   /* TODO DM_DIRTY_TESS_CDLAYERS ? Maybe not though,
@@ -28,7 +28,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "MEM_guardedalloc.h"
+
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_curve_types.h"
@@ -275,6 +278,103 @@ static bool calc_curve_deform(
  * #BKE_curve_deform and related functions.
  * \{ */
 
+typedef struct CurveDeformUserdata {
+  const Object *ob_curve;
+  CurveDeform *cd;
+  float (*vert_coords)[3];
+  /** Vertex group weight of each vertex, NULL when all vertices are fully deformed. */
+  float *weights;
+  const MDeformVert *dvert;
+  int defgrp_index;
+  bool invert_vgroup;
+  short defaxis;
+  /** Coordinates were already converted to curve space when calculating the bounds. */
+  bool use_curve_space;
+
+  /** Specific data types. */
+  struct {
+    int cd_dvert_offset;
+  } bmesh;
+} CurveDeformUserdata;
+
+static float curve_deform_vert_weight(const CurveDeformUserdata *data, const MDeformVert *dvert)
+{
+  const float weight = BKE_defvert_find_weight(dvert, data->defgrp_index);
+  return data->invert_vgroup ? 1.0f - weight : weight;
+}
+
+static void curve_deform_weight_task(void *__restrict userdata,
+                                     const int a,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const CurveDeformUserdata *data = userdata;
+  data->weights[a] = curve_deform_vert_weight(data, &data->dvert[a]);
+}
+
+static void curve_deform_weight_task_editmesh(void *__restrict userdata, MempoolIterData *iter)
+{
+  const CurveDeformUserdata *data = userdata;
+  BMVert *v = (BMVert *)iter;
+  const MDeformVert *dvert = BM_ELEM_CD_GET_VOID_P(v, data->bmesh.cd_dvert_offset);
+  data->weights[BM_elem_index_get(v)] = curve_deform_vert_weight(data, dvert);
+}
+
+typedef struct CurveDeformBounds {
+  float min[3], max[3];
+} CurveDeformBounds;
+
+static void curve_deform_bounds_task(void *__restrict userdata,
+                                     const int a,
+                                     const TaskParallelTLS *__restrict tls)
+{
+  const CurveDeformUserdata *data = userdata;
+  CurveDeformBounds *bounds = tls->userdata_chunk;
+  if (data->weights && !(data->weights[a] > 0.0f)) {
+    return;
+  }
+  mul_m4_v3(data->cd->curvespace, data->vert_coords[a]);
+  minmax_v3v3_v3(bounds->min, bounds->max, data->vert_coords[a]);
+}
+
+static void curve_deform_bounds_reduce(const void *__restrict UNUSED(userdata),
+                                       void *__restrict chunk_join,
+                                       void *__restrict chunk)
+{
+  CurveDeformBounds *join = chunk_join;
+  const CurveDeformBounds *bounds = chunk;
+  minmax_v3v3_v3(join->min, join->max, bounds->min);
+  minmax_v3v3_v3(join->min, join->max, bounds->max);
+}
+
+static void curve_deform_vert_task(void *__restrict userdata,
+                                   const int a,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const CurveDeformUserdata *data = userdata;
+  float *co = data->vert_coords[a];
+
+  if (data->weights) {
+    const float weight = data->weights[a];
+    if (weight > 0.0f) {
+      float vec[3];
+      if (!data->use_curve_space) {
+        mul_m4_v3(data->cd->curvespace, co);
+      }
+      copy_v3_v3(vec, co);
+      calc_curve_deform(data->ob_curve, vec, data->defaxis, data->cd, NULL);
+      interp_v3_v3v3(co, co, vec, weight);
+      mul_m4_v3(data->cd->objectspace, co);
+    }
+  }
+  else {
+    if (!data->use_curve_space) {
+      mul_m4_v3(data->cd->curvespace, co);
+    }
+    calc_curve_deform(data->ob_curve, co, data->defaxis, data->cd, NULL);
+    mul_m4_v3(data->cd->objectspace, co);
+  }
+}
+
 static void curve_deform_coords_impl(const Object *ob_curve,
                                      const Object *ob_target,
                                      float (*vert_coords)[3],
@@ -286,12 +386,11 @@ static void curve_deform_coords_impl(const Object *ob_curve,
                                      BMEditMesh *em_target)
 {
   Curve *cu;
-  int a;
   CurveDeform cd;
   const bool is_neg_axis = (defaxis > 2);
   const bool invert_vgroup = (flag & MOD_CURVE_INVERT_VGROUP) != 0;
   bool use_dverts = false;
-  int cd_dvert_offset;
+  int cd_dvert_offset = -1;
 
   if (ob_curve->type != OB_CURVE) {
     return;
@@ -330,116 +429,60 @@ static void curve_deform_coords_impl(const Object *ob_curve,
     }
   }
 
+  CurveDeformUserdata data = {
+      .ob_curve = ob_curve,
+      .cd = &cd,
+      .vert_coords = vert_coords,
+      .weights = NULL,
+      .dvert = dvert,
+      .defgrp_index = defgrp_index,
+      .invert_vgroup = invert_vgroup,
+      .defaxis = defaxis,
+      .use_curve_space = false,
+      .bmesh =
+          {
+              .cd_dvert_offset = cd_dvert_offset,
+          },
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 512;
+
+  /* Vertex group weights are needed by both passes, look them up once. */
   if (use_dverts) {
-    if (cu->flag & CU_DEFORM_BOUNDS_OFF) {
-
-#define DEFORM_OP(dvert) \
-  { \
-    const float weight = invert_vgroup ? 1.0f - BKE_defvert_find_weight(dvert, defgrp_index) : \
-                                         BKE_defvert_find_weight(dvert, defgrp_index); \
-    if (weight > 0.0f) { \
-      float vec[3]; \
-      mul_m4_v3(cd.curvespace, vert_coords[a]); \
-      copy_v3_v3(vec, vert_coords[a]); \
-      calc_curve_deform(ob_curve, vec, defaxis, &cd, NULL); \
-      interp_v3_v3v3(vert_coords[a], vert_coords[a], vec, weight); \
-      mul_m4_v3(cd.objectspace, vert_coords[a]); \
-    } \
-  } \
-  ((void)0)
-
-      if (em_target != NULL) {
-        BMIter iter;
-        BMVert *v;
-        BM_ITER_MESH_INDEX (v, &iter, em_target->bm, BM_VERTS_OF_MESH, a) {
-          dvert = BM_ELEM_CD_GET_VOID_P(v, cd_dvert_offset);
-          DEFORM_OP(dvert);
-        }
-      }
-      else {
-        for (a = 0; a < vert_coords_len; a++) {
-          DEFORM_OP(&dvert[a]);
-        }
-      }
-
-#undef DEFORM_OP
+    data.weights = MEM_malloc_arrayN(vert_coords_len, sizeof(float), __func__);
+    if (em_target != NULL) {
+      BM_mesh_elem_index_ensure(em_target->bm, BM_VERT);
+      BLI_task_parallel_mempool(
+          em_target->bm->vpool, &data, curve_deform_weight_task_editmesh, true);
     }
     else {
-
-#define DEFORM_OP_MINMAX(dvert) \
-  { \
-    const float weight = invert_vgroup ? 1.0f - BKE_defvert_find_weight(dvert, defgrp_index) : \
-                                         BKE_defvert_find_weight(dvert, defgrp_index); \
-    if (weight > 0.0f) { \
-      mul_m4_v3(cd.curvespace, vert_coords[a]); \
-      minmax_v3v3_v3(cd.dmin, cd.dmax, vert_coords[a]); \
-    } \
-  } \
-  ((void)0)
-
-      /* already in 'cd.curvespace', prev for loop */
-#define DEFORM_OP_CLAMPED(dvert) \
-  { \
-    const float weight = invert_vgroup ? 1.0f - BKE_defvert_find_weight(dvert, defgrp_index) : \
-                                         BKE_defvert_find_weight(dvert, defgrp_index); \
-    if (weight > 0.0f) { \
-      float vec[3]; \
-      copy_v3_v3(vec, vert_coords[a]); \
-      calc_curve_deform(ob_curve, vec, defaxis, &cd, NULL); \
-      interp_v3_v3v3(vert_coords[a], vert_coords[a], vec, weight); \
-      mul_m4_v3(cd.objectspace, vert_coords[a]); \
-    } \
-  } \
-  ((void)0)
-
-      if (em_target != NULL) {
-        BMIter iter;
-        BMVert *v;
-        BM_ITER_MESH_INDEX (v, &iter, em_target->bm, BM_VERTS_OF_MESH, a) {
-          dvert = BM_ELEM_CD_GET_VOID_P(v, cd_dvert_offset);
-          DEFORM_OP_MINMAX(dvert);
-        }
-
-        BM_ITER_MESH_INDEX (v, &iter, em_target->bm, BM_VERTS_OF_MESH, a) {
-          dvert = BM_ELEM_CD_GET_VOID_P(v, cd_dvert_offset);
-          DEFORM_OP_CLAMPED(dvert);
-        }
-      }
-      else {
-
-        for (a = 0; a < vert_coords_len; a++) {
-          DEFORM_OP_MINMAX(&dvert[a]);
-        }
-
-        for (a = 0; a < vert_coords_len; a++) {
-          DEFORM_OP_CLAMPED(&dvert[a]);
-        }
-      }
+      BLI_task_parallel_range(0, vert_coords_len, &data, curve_deform_weight_task, &settings);
     }
+  }
 
-#undef DEFORM_OP_MINMAX
-#undef DEFORM_OP_CLAMPED
+  if ((cu->flag & CU_DEFORM_BOUNDS_OFF) == 0) {
+    CurveDeformBounds bounds;
+    INIT_MINMAX(bounds.min, bounds.max);
+
+    TaskParallelSettings settings_bounds = settings;
+    settings_bounds.userdata_chunk = &bounds;
+    settings_bounds.userdata_chunk_size = sizeof(bounds);
+    settings_bounds.func_reduce = curve_deform_bounds_reduce;
+    BLI_task_parallel_range(
+        0, vert_coords_len, &data, curve_deform_bounds_task, &settings_bounds);
+
+    copy_v3_v3(cd.dmin, bounds.min);
+    copy_v3_v3(cd.dmax, bounds.max);
+    /* already in 'cd.curvespace', prev for loop */
+    data.use_curve_space = true;
   }
-  else {
-    if (cu->flag & CU_DEFORM_BOUNDS_OFF) {
-      for (a = 0; a < vert_coords_len; a++) {
-        mul_m4_v3(cd.curvespace, vert_coords[a]);
-        calc_curve_deform(ob_curve, vert_coords[a], defaxis, &cd, NULL);
-        mul_m4_v3(cd.objectspace, vert_coords[a]);
-      }
-    }
-    else {
-      for (a = 0; a < vert_coords_len; a++) {
-        mul_m4_v3(cd.curvespace, vert_coords[a]);
-        minmax_v3v3_v3(cd.dmin, cd.dmax, vert_coords[a]);
-      }
 
-      for (a = 0; a < vert_coords_len; a++) {
-        /* already in 'cd.curvespace', prev for loop */
-        calc_curve_deform(ob_curve, vert_coords[a], defaxis, &cd, NULL);
-        mul_m4_v3(cd.objectspace, vert_coords[a]);
-      }
-    }
+  BLI_task_parallel_range(0, vert_coords_len, &data, curve_deform_vert_task, &settings);
+
+  if (data.weights) {
+    MEM_freeN(data.weights);
   }
 }
 
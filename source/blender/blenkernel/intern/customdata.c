@@ -26,6 +26,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 /* Since we have versioning code here (CustomData_verify_versions()). */
 #define DNA_DEPRECATED_ALLOW
 
@@ -2046,6 +2048,103 @@ static CustomDataLayer *customData_add_layer__internal(CustomData *data,
                                                        int totelem,
                                                        const char *name);
 
+/* -------------------------------------------------------------------- */
+/** \name Layer Data Sharing
+ *
+ * Layers added with #CD_SHARE use the data of their source layer instead of a copy, the data is
+ * freed once the last layer using it is freed. Copies are flagged #CD_FLAG_NOFREE, so like
+ * referenced layers they get their own data from #CustomData_duplicate_referenced_layer.
+ *
+ * Shared data is copied on write from either side: the source layer isn't allowed to write to
+ * it in-place either, while other layers use it. Writers of both get their own copy through
+ * #CustomData_duplicate_referenced_layer or #CustomData_layer_ensure_unshared first.
+ *
+ * Only plain data layers are shared, so a plain copy is enough. Core geometry layers are
+ * excluded, as they are written to in-place by too much code (normals, selection flags).
+ * \{ */
+
+typedef struct CustomDataLayerSharing {
+  int users;
+} CustomDataLayerSharing;
+
+static bool customData_layer_can_share(const CustomDataLayer *layer)
+{
+  if (ELEM(layer->type, CD_MVERT, CD_MEDGE, CD_MPOLY, CD_MLOOP)) {
+    return false;
+  }
+  /* Referenced data isn't owned by the layer, its life-time can't be extended. */
+  if ((layer->flag & CD_FLAG_NOFREE) && (layer->sharing_info == NULL)) {
+    return false;
+  }
+  const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
+  return (typeInfo->copy == NULL) && (typeInfo->free == NULL) && (layer->data != NULL);
+}
+
+/**
+ * Add a user to the data of \a layer, the layer itself isn't changed otherwise.
+ * Thread safe, as long as \a layer isn't freed meanwhile.
+ */
+static void customData_layer_share(CustomDataLayer *layer)
+{
+  CustomDataLayerSharing *sharing = layer->sharing_info;
+  if (sharing == NULL) {
+    CustomDataLayerSharing *sharing_new = MEM_mallocN(sizeof(*sharing_new), __func__);
+    sharing_new->users = 1;
+    sharing = atomic_cas_ptr(&layer->sharing_info, NULL, sharing_new);
+    if (sharing == NULL) {
+      sharing = sharing_new;
+    }
+    else {
+      MEM_freeN(sharing_new);
+    }
+  }
+  atomic_add_and_fetch_int32(&sharing->users, 1);
+}
+
+/**
+ * Remove \a layer from the users of its data.
+ * \return true when it was the last user, the caller is then responsible for freeing the data.
+ */
+static bool customData_layer_unshare(CustomDataLayer *layer)
+{
+  CustomDataLayerSharing *sharing = layer->sharing_info;
+  layer->sharing_info = NULL;
+  if (atomic_sub_and_fetch_int32(&sharing->users, 1) == 0) {
+    MEM_freeN(sharing);
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Ensure the data of \a layer isn't used by any other layer, so it can be modified or freed.
+ * \return true when the data was copied, pointers to the old data must be updated then.
+ */
+bool CustomData_layer_ensure_unshared(CustomDataLayer *layer)
+{
+  CustomDataLayerSharing *sharing = layer->sharing_info;
+  if (sharing == NULL) {
+    return false;
+  }
+  bool is_copied = false;
+  /* The only user can't be shared by another thread meanwhile, take over the data. */
+  if (sharing->users == 1) {
+    customData_layer_unshare(layer);
+  }
+  else {
+    void *data_old = layer->data;
+    layer->data = MEM_dupallocN(data_old);
+    is_copied = true;
+    if (customData_layer_unshare(layer)) {
+      MEM_freeN(data_old);
+    }
+  }
+  layer->flag &= ~CD_FLAG_NOFREE;
+  return is_copied;
+}
+
+/** \} */
+
 void CustomData_update_typemap(CustomData *data)
 {
   int i, lasttype = -1;
@@ -2124,6 +2223,7 @@ bool CustomData_merge(const struct CustomData *source,
       case CD_ASSIGN:
       case CD_REFERENCE:
       case CD_DUPLICATE:
+      case CD_SHARE:
         data = layer->data;
         break;
       default:
@@ -2131,14 +2231,32 @@ bool CustomData_merge(const struct CustomData *source,
         break;
     }
 
+    const bool use_share = (alloctype == CD_SHARE) && customData_layer_can_share(layer);
+
     if ((alloctype == CD_ASSIGN) && (flag & CD_FLAG_NOFREE)) {
       newlayer = customData_add_layer__internal(
           dest, type, CD_REFERENCE, data, totelem, layer->name);
     }
+    else if (alloctype == CD_SHARE) {
+      newlayer = customData_add_layer__internal(
+          dest, type, use_share ? CD_REFERENCE : CD_DUPLICATE, data, totelem, layer->name);
+    }
     else {
       newlayer = customData_add_layer__internal(dest, type, alloctype, data, totelem, layer->name);
     }
 
+    /* A layer with no default name may already exist, in that case its data is kept. */
+    if (newlayer && (newlayer->data == data)) {
+      if (use_share) {
+        customData_layer_share(layer);
+        newlayer->sharing_info = layer->sharing_info;
+      }
+      else if (alloctype == CD_ASSIGN) {
+        /* Ownership moves to the new layer, including the share of the data. */
+        newlayer->sharing_info = layer->sharing_info;
+      }
+    }
+
     if (newlayer) {
       newlayer->uid = layer->uid;
 
@@ -2164,6 +2282,7 @@ void CustomData_realloc(CustomData *data, int totelem)
     if (layer->flag & CD_FLAG_NOFREE) {
       continue;
     }
+    CustomData_layer_ensure_unshared(layer);
     typeInfo = layerType_getInfo(layer->type);
     layer->data = MEM_reallocN(layer->data, (size_t)totelem * typeInfo->size);
   }
@@ -2188,6 +2307,14 @@ static void customData_free_layer__internal(CustomDataLayer *layer, int totelem)
 {
   const LayerTypeInfo *typeInfo;
 
+  if (layer->sharing_info != NULL) {
+    /* The last user frees shared data, whether it's the original layer or not. */
+    if (!customData_layer_unshare(layer)) {
+      return;
+    }
+    layer->flag &= ~CD_FLAG_NOFREE;
+  }
+
   if (!(layer->flag & CD_FLAG_NOFREE) && layer->data) {
     typeInfo = layerType_getInfo(layer->type);
 
@@ -2563,6 +2690,7 @@ static CustomDataLayer *customData_add_layer__internal(CustomData *data,
   data->layers[index].type = type;
   data->layers[index].flag = flag;
   data->layers[index].data = newlayerdata;
+  data->layers[index].sharing_info = NULL;
 
   /* Set default name if none exists. Note we only call DATA_()  once
    * we know there is a default name, to avoid overhead of locale lookups
@@ -2744,7 +2872,11 @@ static void *customData_duplicate_referenced_layer_index(CustomData *data,
 
   CustomDataLayer *layer = &data->layers[layer_index];
 
-  if (layer->flag & CD_FLAG_NOFREE) {
+  if (layer->sharing_info != NULL) {
+    /* Other users must not see the changes, whether this is the original layer or not. */
+    CustomData_layer_ensure_unshared(layer);
+  }
+  else if (layer->flag & CD_FLAG_NOFREE) {
     /* MEM_dupallocN won't work in case of complex layers, like e.g.
      * CD_MDEFORMVERT, which has pointers to allocated data...
      * So in case a custom copy function is defined, use it!
@@ -5174,6 +5306,7 @@ void CustomData_blend_read(BlendDataReader *reader, CustomData *data, int count)
     }
 
     layer->flag &= ~CD_FLAG_NOFREE;
+    layer->sharing_info = NULL;
 
     if (CustomData_verify_versions(data, i)) {
       BLO_read_data_address(reader, &layer->data);
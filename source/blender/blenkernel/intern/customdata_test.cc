@@ -0,0 +1,196 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_customdata_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_customdata.h"
+
+namespace blender::bke::tests {
+
+#define TOTELEM 64
+
+static float *float_layer_create(CustomData *data)
+{
+  CustomData_reset(data);
+  float *values = (float *)CustomData_add_layer(data, CD_PAINT_MASK, CD_CALLOC, nullptr, TOTELEM);
+  for (int i = 0; i < TOTELEM; i++) {
+    values[i] = (float)i;
+  }
+  return values;
+}
+
+static void float_layer_share(const CustomData *source, CustomData *dest)
+{
+  CustomData_reset(dest);
+  CustomData_copy(source, dest, CD_MASK_PAINT_MASK, CD_SHARE, TOTELEM);
+}
+
+static void expect_float_layer_values(const float *values)
+{
+  for (int i = 0; i < TOTELEM; i++) {
+    EXPECT_EQ(values[i], (float)i);
+  }
+}
+
+TEST(customdata, ShareCopy)
+{
+  CustomData source, dest;
+  float *values = float_layer_create(&source);
+  float_layer_share(&source, &dest);
+
+  EXPECT_EQ(CustomData_get_layer(&dest, CD_PAINT_MASK), values);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&source, CD_PAINT_MASK));
+  EXPECT_TRUE(CustomData_is_referenced_layer(&dest, CD_PAINT_MASK));
+
+  /* Core geometry layers are never shared. */
+  CustomData_add_layer(&source, CD_MVERT, CD_CALLOC, nullptr, TOTELEM);
+  CustomData copy;
+  CustomData_reset(&copy);
+  CustomData_copy(&source, &copy, CD_MASK_MVERT | CD_MASK_PAINT_MASK, CD_SHARE, TOTELEM);
+  EXPECT_EQ(CustomData_get_layer(&copy, CD_PAINT_MASK), values);
+  EXPECT_NE(CustomData_get_layer(&copy, CD_MVERT), CustomData_get_layer(&source, CD_MVERT));
+  EXPECT_FALSE(CustomData_is_referenced_layer(&copy, CD_MVERT));
+
+  CustomData_free(&copy, TOTELEM);
+  CustomData_free(&dest, TOTELEM);
+  CustomData_free(&source, TOTELEM);
+}
+
+TEST(customdata, ShareWriteSource)
+{
+  CustomData source, dest;
+  float *values = float_layer_create(&source);
+  float_layer_share(&source, &dest);
+
+  float *values_source = (float *)CustomData_duplicate_referenced_layer(
+      &source, CD_PAINT_MASK, TOTELEM);
+  EXPECT_NE(values_source, values);
+  EXPECT_EQ(CustomData_get_layer(&dest, CD_PAINT_MASK), values);
+  values_source[0] = -1.0f;
+  expect_float_layer_values(values);
+
+  /* The copy is the last user of the old data now, it takes it over without copying. */
+  EXPECT_EQ(CustomData_duplicate_referenced_layer(&dest, CD_PAINT_MASK, TOTELEM), values);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&dest, CD_PAINT_MASK));
+
+  CustomData_free(&source, TOTELEM);
+  CustomData_free(&dest, TOTELEM);
+}
+
+TEST(customdata, ShareWriteSourceLayerN)
+{
+  /* Writing to one layer of a type, like resetting a UV map, only copies that one. */
+  CustomData source, dest;
+  CustomData_reset(&source);
+  MLoopUV *uvs[2];
+  for (int n = 0; n < 2; n++) {
+    uvs[n] = (MLoopUV *)CustomData_add_layer(&source, CD_MLOOPUV, CD_CALLOC, nullptr, TOTELEM);
+  }
+  CustomData_reset(&dest);
+  CustomData_copy(&source, &dest, CD_MASK_MLOOPUV, CD_SHARE, TOTELEM);
+
+  MLoopUV *uvs_source = (MLoopUV *)CustomData_duplicate_referenced_layer_n(
+      &source, CD_MLOOPUV, 1, TOTELEM);
+  EXPECT_NE(uvs_source, uvs[1]);
+  uvs_source[0].uv[0] = -1.0f;
+  EXPECT_EQ(uvs[1][0].uv[0], 0.0f);
+  EXPECT_EQ(CustomData_get_layer_n(&dest, CD_MLOOPUV, 1), uvs[1]);
+
+  /* The other layer is still shared. */
+  EXPECT_EQ(CustomData_get_layer_n(&source, CD_MLOOPUV, 0), uvs[0]);
+  EXPECT_EQ(CustomData_get_layer_n(&dest, CD_MLOOPUV, 0), uvs[0]);
+
+  CustomData_free(&source, TOTELEM);
+  CustomData_free(&dest, TOTELEM);
+}
+
+TEST(customdata, ShareWriteCopy)
+{
+  CustomData source, dest;
+  float *values = float_layer_create(&source);
+  float_layer_share(&source, &dest);
+
+  float *values_dest = (float *)CustomData_duplicate_referenced_layer(
+      &dest, CD_PAINT_MASK, TOTELEM);
+  EXPECT_NE(values_dest, values);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&dest, CD_PAINT_MASK));
+  values_dest[0] = -1.0f;
+  expect_float_layer_values(values);
+
+  /* Nothing shares the source data anymore. */
+  CustomDataLayer *layer = &source.layers[CustomData_get_layer_index(&source, CD_PAINT_MASK)];
+  EXPECT_FALSE(CustomData_layer_ensure_unshared(layer));
+  EXPECT_EQ(layer->data, values);
+
+  CustomData_free(&dest, TOTELEM);
+  CustomData_free(&source, TOTELEM);
+}
+
+TEST(customdata, ShareRealloc)
+{
+  CustomData source, dest;
+  float *values = float_layer_create(&source);
+  float_layer_share(&source, &dest);
+
+  CustomData_realloc(&source, TOTELEM * 2);
+  EXPECT_EQ(CustomData_get_layer(&dest, CD_PAINT_MASK), values);
+  expect_float_layer_values((float *)CustomData_get_layer(&source, CD_PAINT_MASK));
+  expect_float_layer_values(values);
+
+  CustomData_free(&source, TOTELEM * 2);
+  CustomData_free(&dest, TOTELEM);
+}
+
+TEST(customdata, ShareFreeSourceFirst)
+{
+  CustomData source, dest, dest_other;
+  float *values = float_layer_create(&source);
+  float_layer_share(&source, &dest);
+  float_layer_share(&dest, &dest_other);
+  EXPECT_EQ(CustomData_get_layer(&dest_other, CD_PAINT_MASK), values);
+
+  CustomData_free(&source, TOTELEM);
+  expect_float_layer_values((float *)CustomData_get_layer(&dest, CD_PAINT_MASK));
+
+  CustomData_free(&dest, TOTELEM);
+  expect_float_layer_values((float *)CustomData_get_layer(&dest_other, CD_PAINT_MASK));
+
+  CustomData_free(&dest_other, TOTELEM);
+}
+
+TEST(customdata, ShareFreeCopyFirst)
+{
+  CustomData source, dest;
+  float *values = float_layer_create(&source);
+  float_layer_share(&source, &dest);
+
+  CustomData_free(&dest, TOTELEM);
+  expect_float_layer_values(values);
+
+  /* The source is the only user again, it writes in-place. */
+  EXPECT_EQ(CustomData_duplicate_referenced_layer(&source, CD_PAINT_MASK, TOTELEM), values);
+
+  CustomData_free(&source, TOTELEM);
+}
+
+}  // namespace blender::bke::tests
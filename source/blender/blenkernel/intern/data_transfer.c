@@ -1371,6 +1371,267 @@ void BKE_object_data_transfer_layout(struct Depsgraph *depsgraph,
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Mapping Cache
+ *
+ * Mappings only depend on the geometry of both meshes and on the mapping settings, which often
+ * remain the same between evaluations of the Data Transfer modifier (e.g. while painting the
+ * transferred data on the source, or tweaking mixing options), so they can be kept around.
+ *
+ * Evaluated meshes are created again on every evaluation, nothing tells whether their geometry
+ * changed. Copies of the geometry the mappings were computed from are kept and compared exactly
+ * instead, the relative transform of the objects is part of the mapping settings.
+ * \{ */
+
+/** Copy of the mesh data mappings depend on. */
+typedef struct DataTransferMeshCopy {
+  int totvert, totedge, totloop, totpoly;
+  /** Vertex positions and normals, other vertex data (e.g. bevel weights) can be transferred. */
+  float (*vert_cos)[3];
+  short (*vert_nos)[3];
+  /* Flags of edges and faces are copied as well, they are used by normals computation. */
+  MEdge *medge;
+  MLoop *mloop;
+  MPoly *mpoly;
+  /** Normals given by the source, custom normals and auto-smooth settings of the destination. */
+  void *loop_nors;
+  size_t loop_nors_size;
+  void *poly_nors;
+  size_t poly_nors_size;
+  short flag;
+  float smoothresh;
+} DataTransferMeshCopy;
+
+/** Settings a mapping was computed with. */
+typedef struct DataTransferMapSettings {
+  int map_mode;
+  float max_distance;
+  float ray_radius;
+  float islands_precision;
+  bool use_islands;
+  bool use_space_transform;
+  SpaceTransform space_transform;
+} DataTransferMapSettings;
+
+typedef struct DataTransferMapCache {
+  /** One mapping per element type: vertices, edges, loops and polygons. */
+  MeshPairRemap geom_map[4];
+  DataTransferMapSettings settings[4];
+  DataTransferMeshCopy mesh_src;
+  DataTransferMeshCopy mesh_dst;
+  DataTransferMapCacheStats stats;
+} DataTransferMapCache;
+
+static void data_transfer_mesh_normals_get(const Mesh *me,
+                                           const bool is_source,
+                                           DataTransferMeshCopy *r_nors)
+{
+  if (is_source) {
+    /* Normals of the source are given,
+     * see #BKE_mesh_remap_calc_source_cddata_masks_from_map_modes. */
+    r_nors->loop_nors = CustomData_get_layer(&me->ldata, CD_NORMAL);
+    r_nors->poly_nors = CustomData_get_layer(&me->pdata, CD_NORMAL);
+    r_nors->loop_nors_size = r_nors->loop_nors ? sizeof(float[3]) * (size_t)me->totloop : 0;
+    r_nors->poly_nors_size = r_nors->poly_nors ? sizeof(float[3]) * (size_t)me->totpoly : 0;
+  }
+  else {
+    /* Normals of the destination are computed from its geometry and these. */
+    r_nors->loop_nors = CustomData_get_layer(&me->ldata, CD_CUSTOMLOOPNORMAL);
+    r_nors->poly_nors = NULL;
+    r_nors->loop_nors_size = r_nors->loop_nors ? sizeof(short[2]) * (size_t)me->totloop : 0;
+    r_nors->poly_nors_size = 0;
+  }
+  r_nors->flag = me->flag & ME_AUTOSMOOTH;
+  r_nors->smoothresh = me->smoothresh;
+}
+
+static void *data_transfer_array_dup(const void *data, const size_t size)
+{
+  if (size == 0) {
+    return NULL;
+  }
+  void *copy = MEM_mallocN(size, __func__);
+  memcpy(copy, data, size);
+  return copy;
+}
+
+static bool data_transfer_array_equals(const void *copy, const void *data, const size_t size)
+{
+  return (size == 0) || (memcmp(copy, data, size) == 0);
+}
+
+static void data_transfer_mesh_copy_free(DataTransferMeshCopy *copy)
+{
+  MEM_SAFE_FREE(copy->vert_cos);
+  MEM_SAFE_FREE(copy->vert_nos);
+  MEM_SAFE_FREE(copy->medge);
+  MEM_SAFE_FREE(copy->mloop);
+  MEM_SAFE_FREE(copy->mpoly);
+  MEM_SAFE_FREE(copy->loop_nors);
+  MEM_SAFE_FREE(copy->poly_nors);
+}
+
+static void data_transfer_mesh_copy_update(DataTransferMeshCopy *copy,
+                                           const Mesh *me,
+                                           const bool is_source)
+{
+  data_transfer_mesh_copy_free(copy);
+
+  copy->totvert = me->totvert;
+  copy->totedge = me->totedge;
+  copy->totloop = me->totloop;
+  copy->totpoly = me->totpoly;
+
+  if (me->totvert) {
+    copy->vert_cos = MEM_malloc_arrayN((size_t)me->totvert, sizeof(*copy->vert_cos), __func__);
+    copy->vert_nos = MEM_malloc_arrayN((size_t)me->totvert, sizeof(*copy->vert_nos), __func__);
+    const MVert *mv = me->mvert;
+    for (int i = 0; i < me->totvert; i++, mv++) {
+      copy_v3_v3(copy->vert_cos[i], mv->co);
+      copy_v3_v3_short(copy->vert_nos[i], mv->no);
+    }
+  }
+  copy->medge = data_transfer_array_dup(me->medge, sizeof(*me->medge) * (size_t)me->totedge);
+  copy->mloop = data_transfer_array_dup(me->mloop, sizeof(*me->mloop) * (size_t)me->totloop);
+  copy->mpoly = data_transfer_array_dup(me->mpoly, sizeof(*me->mpoly) * (size_t)me->totpoly);
+
+  DataTransferMeshCopy nors;
+  data_transfer_mesh_normals_get(me, is_source, &nors);
+  copy->loop_nors = data_transfer_array_dup(nors.loop_nors, nors.loop_nors_size);
+  copy->loop_nors_size = nors.loop_nors_size;
+  copy->poly_nors = data_transfer_array_dup(nors.poly_nors, nors.poly_nors_size);
+  copy->poly_nors_size = nors.poly_nors_size;
+  copy->flag = nors.flag;
+  copy->smoothresh = nors.smoothresh;
+}
+
+static bool data_transfer_mesh_copy_matches(const DataTransferMeshCopy *copy,
+                                            const Mesh *me,
+                                            const bool is_source)
+{
+  if ((copy->totvert != me->totvert) || (copy->totedge != me->totedge) ||
+      (copy->totloop != me->totloop) || (copy->totpoly != me->totpoly)) {
+    return false;
+  }
+
+  const MVert *mv = me->mvert;
+  for (int i = 0; i < me->totvert; i++, mv++) {
+    if (!equals_v3v3(copy->vert_cos[i], mv->co) ||
+        !data_transfer_array_equals(copy->vert_nos[i], mv->no, sizeof(mv->no))) {
+      return false;
+    }
+  }
+  if (!data_transfer_array_equals(
+          copy->medge, me->medge, sizeof(*me->medge) * (size_t)me->totedge) ||
+      !data_transfer_array_equals(
+          copy->mloop, me->mloop, sizeof(*me->mloop) * (size_t)me->totloop) ||
+      !data_transfer_array_equals(
+          copy->mpoly, me->mpoly, sizeof(*me->mpoly) * (size_t)me->totpoly)) {
+    return false;
+  }
+
+  DataTransferMeshCopy nors;
+  data_transfer_mesh_normals_get(me, is_source, &nors);
+  return (copy->loop_nors_size == nors.loop_nors_size) &&
+         (copy->poly_nors_size == nors.poly_nors_size) &&
+         data_transfer_array_equals(copy->loop_nors, nors.loop_nors, nors.loop_nors_size) &&
+         data_transfer_array_equals(copy->poly_nors, nors.poly_nors, nors.poly_nors_size) &&
+         (copy->flag == nors.flag) && (copy->smoothresh == nors.smoothresh);
+}
+
+/**
+ * Free all cached mappings when the geometry of either mesh changed since they were computed.
+ */
+static void data_transfer_map_cache_validate(DataTransferMapCache *map_cache,
+                                             const Mesh *me_src,
+                                             const Mesh *me_dst)
+{
+  if (data_transfer_mesh_copy_matches(&map_cache->mesh_src, me_src, true) &&
+      data_transfer_mesh_copy_matches(&map_cache->mesh_dst, me_dst, false)) {
+    return;
+  }
+
+  for (int i = 0; i < ARRAY_SIZE(map_cache->geom_map); i++) {
+    BKE_mesh_remap_free(&map_cache->geom_map[i]);
+  }
+  data_transfer_mesh_copy_update(&map_cache->mesh_src, me_src, true);
+  data_transfer_mesh_copy_update(&map_cache->mesh_dst, me_dst, false);
+}
+
+static bool data_transfer_map_settings_equals(const DataTransferMapSettings *a,
+                                              const DataTransferMapSettings *b)
+{
+  return (a->map_mode == b->map_mode) && (a->max_distance == b->max_distance) &&
+         (a->ray_radius == b->ray_radius) && (a->islands_precision == b->islands_precision) &&
+         (a->use_islands == b->use_islands) &&
+         (a->use_space_transform == b->use_space_transform) &&
+         (!a->use_space_transform ||
+          (memcmp(&a->space_transform, &b->space_transform, sizeof(a->space_transform)) == 0));
+}
+
+/**
+ * \return True when the cached mapping at \a index is still valid. Otherwise its settings are
+ * updated, the caller is expected to compute the mapping again.
+ *
+ * \note Geometry changes are handled by #data_transfer_map_cache_validate.
+ */
+static bool data_transfer_map_cache_check(DataTransferMapCache *map_cache,
+                                          const int index,
+                                          const SpaceTransform *space_transform,
+                                          const int map_mode,
+                                          const float max_distance,
+                                          const float ray_radius,
+                                          const float islands_precision,
+                                          const bool use_islands)
+{
+  if (map_cache == NULL) {
+    return false;
+  }
+
+  DataTransferMapSettings settings = {
+      .map_mode = map_mode,
+      .max_distance = max_distance,
+      .ray_radius = ray_radius,
+      .islands_precision = islands_precision,
+      .use_islands = use_islands,
+      .use_space_transform = (space_transform != NULL),
+  };
+  if (space_transform) {
+    settings.space_transform = *space_transform;
+  }
+
+  if (map_cache->geom_map[index].items &&
+      data_transfer_map_settings_equals(&map_cache->settings[index], &settings)) {
+    map_cache->stats.hits++;
+    return true;
+  }
+  map_cache->settings[index] = settings;
+  map_cache->stats.misses++;
+  return false;
+}
+
+void BKE_object_data_transfer_map_cache_get_stats(const DataTransferMapCache *map_cache,
+                                                  DataTransferMapCacheStats *r_stats)
+{
+  *r_stats = map_cache->stats;
+}
+
+void BKE_object_data_transfer_map_cache_free(DataTransferMapCache *map_cache)
+{
+  for (int i = 0; i < ARRAY_SIZE(map_cache->geom_map); i++) {
+    BKE_mesh_remap_free(&map_cache->geom_map[i]);
+  }
+  data_transfer_mesh_copy_free(&map_cache->mesh_src);
+  data_transfer_mesh_copy_free(&map_cache->mesh_dst);
+  MEM_freeN(map_cache);
+}
+
+/** \} */
+
+/**
+ * \param map_cache: When not NULL, mappings are kept there for the next call
+ * (allocated if `*map_cache` is NULL, to be freed with #BKE_object_data_transfer_map_cache_free).
+ */
 bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
                                  Scene *scene,
                                  Object *ob_src,
@@ -1393,6 +1654,7 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
                                  const float mix_factor,
                                  const char *vgroup_name,
                                  const bool invert_vgroup,
+                                 DataTransferMapCache **map_cache,
                                  ReportList *reports)
 {
 #define VDATA 0
@@ -1411,7 +1673,8 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
   int vg_idx = -1;
   float *weights[DATAMAX] = {NULL};
 
-  MeshPairRemap geom_map[DATAMAX] = {{0}};
+  MeshPairRemap geom_map_local[DATAMAX] = {{0}};
+  MeshPairRemap *geom_map = geom_map_local;
   bool geom_map_init[DATAMAX] = {0};
   ListBase lay_map = {NULL};
   bool changed = false;
@@ -1424,7 +1687,7 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
   BLI_assert((ob_src != ob_dst) && (ob_src->type == OB_MESH) && (ob_dst->type == OB_MESH));
 
   if (me_dst) {
-    dirty_nors_dst = (me_dst->runtime.cd_dirty_vert & CD_NORMAL) != 0;
+    dirty_nors_dst = (me_dst->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY) != 0;
     /* Never create needed custom layers on passed destination mesh
      * (assumed to *not* be ob_dst->data, aka modifier case). */
     use_create = false;
@@ -1462,6 +1725,15 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
   }
   BKE_mesh_wrapper_ensure_mdata(me_src);
 
+  if (map_cache) {
+    if (*map_cache == NULL) {
+      *map_cache = MEM_callocN(sizeof(**map_cache), __func__);
+    }
+    BLI_assert(ARRAY_SIZE((*map_cache)->geom_map) == DATAMAX);
+    data_transfer_map_cache_validate(*map_cache, me_src, me_dst);
+    geom_map = (*map_cache)->geom_map;
+  }
+
   if (auto_transform) {
     if (space_transform == NULL) {
       space_transform = &auto_space_transform;
@@ -1531,15 +1803,24 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
           continue;
         }
 
-        BKE_mesh_remap_calc_verts_from_mesh(map_vert_mode,
-                                            space_transform,
-                                            max_distance,
-                                            ray_radius,
-                                            verts_dst,
-                                            num_verts_dst,
-                                            dirty_nors_dst,
-                                            me_src,
-                                            &geom_map[VDATA]);
+        if (!data_transfer_map_cache_check(map_cache ? *map_cache : NULL,
+                                           VDATA,
+                                           space_transform,
+                                           map_vert_mode,
+                                           max_distance,
+                                           ray_radius,
+                                           0.0f,
+                                           false)) {
+          BKE_mesh_remap_calc_verts_from_mesh(map_vert_mode,
+                                              space_transform,
+                                              max_distance,
+                                              ray_radius,
+                                              verts_dst,
+                                              num_verts_dst,
+                                              dirty_nors_dst,
+                                              me_src,
+                                              &geom_map[VDATA]);
+        }
         geom_map_init[VDATA] = true;
       }
 
@@ -1607,17 +1888,26 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
           continue;
         }
 
-        BKE_mesh_remap_calc_edges_from_mesh(map_edge_mode,
-                                            space_transform,
-                                            max_distance,
-                                            ray_radius,
-                                            verts_dst,
-                                            num_verts_dst,
-                                            edges_dst,
-                                            num_edges_dst,
-                                            dirty_nors_dst,
-                                            me_src,
-                                            &geom_map[EDATA]);
+        if (!data_transfer_map_cache_check(map_cache ? *map_cache : NULL,
+                                           EDATA,
+                                           space_transform,
+                                           map_edge_mode,
+                                           max_distance,
+                                           ray_radius,
+                                           0.0f,
+                                           false)) {
+          BKE_mesh_remap_calc_edges_from_mesh(map_edge_mode,
+                                              space_transform,
+                                              max_distance,
+                                              ray_radius,
+                                              verts_dst,
+                                              num_verts_dst,
+                                              edges_dst,
+                                              num_edges_dst,
+                                              dirty_nors_dst,
+                                              me_src,
+                                              &geom_map[EDATA]);
+        }
         geom_map_init[EDATA] = true;
       }
 
@@ -1693,27 +1983,36 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
           continue;
         }
 
-        BKE_mesh_remap_calc_loops_from_mesh(map_loop_mode,
-                                            space_transform,
-                                            max_distance,
-                                            ray_radius,
-                                            verts_dst,
-                                            num_verts_dst,
-                                            edges_dst,
-                                            num_edges_dst,
-                                            loops_dst,
-                                            num_loops_dst,
-                                            polys_dst,
-                                            num_polys_dst,
-                                            ldata_dst,
-                                            pdata_dst,
-                                            (me_dst->flag & ME_AUTOSMOOTH) != 0,
-                                            me_dst->smoothresh,
-                                            dirty_nors_dst,
-                                            me_src,
-                                            island_callback,
-                                            islands_handling_precision,
-                                            &geom_map[LDATA]);
+        if (!data_transfer_map_cache_check(map_cache ? *map_cache : NULL,
+                                           LDATA,
+                                           space_transform,
+                                           map_loop_mode,
+                                           max_distance,
+                                           ray_radius,
+                                           islands_handling_precision,
+                                           island_callback != NULL)) {
+          BKE_mesh_remap_calc_loops_from_mesh(map_loop_mode,
+                                              space_transform,
+                                              max_distance,
+                                              ray_radius,
+                                              verts_dst,
+                                              num_verts_dst,
+                                              edges_dst,
+                                              num_edges_dst,
+                                              loops_dst,
+                                              num_loops_dst,
+                                              polys_dst,
+                                              num_polys_dst,
+                                              ldata_dst,
+                                              pdata_dst,
+                                              (me_dst->flag & ME_AUTOSMOOTH) != 0,
+                                              me_dst->smoothresh,
+                                              dirty_nors_dst,
+                                              me_src,
+                                              island_callback,
+                                              islands_handling_precision,
+                                              &geom_map[LDATA]);
+        }
         geom_map_init[LDATA] = true;
       }
 
@@ -1784,20 +2083,29 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
           continue;
         }
 
-        BKE_mesh_remap_calc_polys_from_mesh(map_poly_mode,
-                                            space_transform,
-                                            max_distance,
-                                            ray_radius,
-                                            verts_dst,
-                                            num_verts_dst,
-                                            loops_dst,
-                                            num_loops_dst,
-                                            polys_dst,
-                                            num_polys_dst,
-                                            pdata_dst,
-                                            dirty_nors_dst,
-                                            me_src,
-                                            &geom_map[PDATA]);
+        if (!data_transfer_map_cache_check(map_cache ? *map_cache : NULL,
+                                           PDATA,
+                                           space_transform,
+                                           map_poly_mode,
+                                           max_distance,
+                                           ray_radius,
+                                           0.0f,
+                                           false)) {
+          BKE_mesh_remap_calc_polys_from_mesh(map_poly_mode,
+                                              space_transform,
+                                              max_distance,
+                                              ray_radius,
+                                              verts_dst,
+                                              num_verts_dst,
+                                              loops_dst,
+                                              num_loops_dst,
+                                              polys_dst,
+                                              num_polys_dst,
+                                              pdata_dst,
+                                              dirty_nors_dst,
+                                              me_src,
+                                              &geom_map[PDATA]);
+        }
         geom_map_init[PDATA] = true;
       }
 
@@ -1846,7 +2154,7 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
   }
 
   for (int i = 0; i < DATAMAX; i++) {
-    BKE_mesh_remap_free(&geom_map[i]);
+    BKE_mesh_remap_free(&geom_map_local[i]);
     MEM_SAFE_FREE(weights[i]);
   }
 
@@ -1904,5 +2212,6 @@ bool BKE_object_data_transfer_mesh(struct Depsgraph *depsgraph,
                                      mix_factor,
                                      vgroup_name,
                                      invert_vgroup,
+                                     NULL,
                                      reports);
 }
@@ -0,0 +1,205 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+
+#include "testing/testing.h"
+
+#include <cstring>
+
+#include "BLI_math.h"
+#include "BLI_space_transform.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_data_transfer.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_remap.h"
+#include "BKE_object.h"
+
+namespace blender::bke::tests {
+
+#define VERTS_NUM 8
+
+class DataTransferMapCacheTest : public testing::Test {
+ protected:
+  Main *bmain_ = nullptr;
+  Object *ob_src_ = nullptr;
+  Object *ob_dst_ = nullptr;
+  Mesh *me_src_ = nullptr;
+  Mesh *me_dst_ = nullptr;
+  DataTransferMapCache *map_cache_ = nullptr;
+
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+
+  /* Vertices along X, the destination ones slightly offset from the source ones. Each source
+   * vertex has its index as bevel weight. */
+  void SetUp() override
+  {
+    bmain_ = BKE_main_new();
+    ob_src_ = BKE_object_add_only_object(bmain_, OB_MESH, "Source");
+    ob_dst_ = BKE_object_add_only_object(bmain_, OB_MESH, "Destination");
+
+    me_src_ = BKE_mesh_new_nomain(VERTS_NUM, 0, 0, 0, 0);
+    me_dst_ = BKE_mesh_new_nomain(VERTS_NUM, 0, 0, 0, 0);
+    for (int i = 0; i < VERTS_NUM; i++) {
+      copy_v3_fl3(me_src_->mvert[i].co, (float)i, 0.0f, 0.0f);
+      copy_v3_fl3(me_dst_->mvert[i].co, (float)i + 0.1f, 0.0f, 0.0f);
+      me_src_->mvert[i].bweight = (char)i;
+    }
+    me_src_->cd_flag |= ME_CDFLAG_VERT_BWEIGHT;
+
+    /* Evaluated source mesh, as used by the modifier. */
+    ob_src_->runtime.data_eval = &me_src_->id;
+    memset(&ob_src_->runtime.last_data_mask, 0xff, sizeof(ob_src_->runtime.last_data_mask));
+  }
+
+  void TearDown() override
+  {
+    if (map_cache_) {
+      BKE_object_data_transfer_map_cache_free(map_cache_);
+    }
+    ob_src_->runtime.data_eval = nullptr;
+    BKE_id_free(nullptr, me_src_);
+    BKE_id_free(nullptr, me_dst_);
+    BKE_main_free(bmain_);
+  }
+
+  bool transfer(const float max_distance = FLT_MAX, SpaceTransform *space_transform = nullptr)
+  {
+    const int layers_select[DT_MULTILAYER_INDEX_MAX] = {0};
+    return BKE_object_data_transfer_ex(nullptr,
+                                       nullptr,
+                                       ob_src_,
+                                       ob_dst_,
+                                       me_dst_,
+                                       DT_TYPE_BWEIGHT_VERT,
+                                       false,
+                                       MREMAP_MODE_VERT_NEAREST,
+                                       0,
+                                       0,
+                                       0,
+                                       space_transform,
+                                       false,
+                                       max_distance,
+                                       0.0f,
+                                       0.0f,
+                                       layers_select,
+                                       layers_select,
+                                       CDT_MIX_TRANSFER,
+                                       1.0f,
+                                       nullptr,
+                                       false,
+                                       &map_cache_,
+                                       nullptr);
+  }
+
+  DataTransferMapCacheStats stats()
+  {
+    DataTransferMapCacheStats stats;
+    BKE_object_data_transfer_map_cache_get_stats(map_cache_, &stats);
+    return stats;
+  }
+};
+
+TEST_F(DataTransferMapCacheTest, HitWithSameGeometry)
+{
+  EXPECT_TRUE(transfer());
+  ASSERT_NE(map_cache_, nullptr);
+  EXPECT_EQ(stats().hits, 0u);
+  EXPECT_EQ(stats().misses, 1u);
+  EXPECT_EQ(me_dst_->mvert[3].bweight, 3);
+
+  /* Editing the transferred data on the source reuses the mapping. */
+  for (int i = 0; i < VERTS_NUM; i++) {
+    me_src_->mvert[i].bweight = (char)(i * 2);
+  }
+  EXPECT_TRUE(transfer());
+  EXPECT_EQ(stats().hits, 1u);
+  EXPECT_EQ(stats().misses, 1u);
+  for (int i = 0; i < VERTS_NUM; i++) {
+    EXPECT_EQ(me_dst_->mvert[i].bweight, i * 2);
+  }
+}
+
+TEST_F(DataTransferMapCacheTest, MissWithOtherSettings)
+{
+  EXPECT_TRUE(transfer());
+  EXPECT_TRUE(transfer(1.0f));
+  EXPECT_EQ(stats().hits, 0u);
+  EXPECT_EQ(stats().misses, 2u);
+
+  /* A transform of the objects relative to each other, the destination is now closest to the
+   * next source vertex. */
+  float src_mat[4][4], dst_mat[4][4];
+  unit_m4(src_mat);
+  unit_m4(dst_mat);
+  dst_mat[3][0] = 0.8f;
+  SpaceTransform space_transform;
+  BLI_space_transform_from_matrices(&space_transform, dst_mat, src_mat);
+  EXPECT_TRUE(transfer(1.0f, &space_transform));
+  EXPECT_EQ(stats().misses, 3u);
+  EXPECT_EQ(me_dst_->mvert[3].bweight, 4);
+
+  EXPECT_TRUE(transfer(1.0f, &space_transform));
+  EXPECT_EQ(stats().hits, 1u);
+  EXPECT_EQ(stats().misses, 3u);
+}
+
+TEST_F(DataTransferMapCacheTest, InvalidatedByGeometry)
+{
+  EXPECT_TRUE(transfer());
+
+  /* Swap the positions of two source vertices. */
+  swap_v3_v3(me_src_->mvert[0].co, me_src_->mvert[1].co);
+  EXPECT_TRUE(transfer());
+  EXPECT_EQ(stats().hits, 0u);
+  EXPECT_EQ(stats().misses, 2u);
+  EXPECT_EQ(me_dst_->mvert[0].bweight, 1);
+  EXPECT_EQ(me_dst_->mvert[1].bweight, 0);
+
+  /* Moving the destination vertices. */
+  me_dst_->mvert[2].co[0] = 5.0f;
+  EXPECT_TRUE(transfer());
+  EXPECT_EQ(stats().misses, 3u);
+  EXPECT_EQ(me_dst_->mvert[2].bweight, 5);
+
+  /* A different topology with the same positions. */
+  Mesh *me_src = BKE_mesh_new_nomain_from_template(me_src_, VERTS_NUM, 1, 0, 0, 0);
+  memcpy(me_src->mvert, me_src_->mvert, sizeof(MVert) * VERTS_NUM);
+  me_src->cd_flag |= ME_CDFLAG_VERT_BWEIGHT;
+  me_src->medge[0].v1 = 0;
+  me_src->medge[0].v2 = 1;
+  ob_src_->runtime.data_eval = &me_src->id;
+  EXPECT_TRUE(transfer());
+  EXPECT_EQ(stats().hits, 0u);
+  EXPECT_EQ(stats().misses, 4u);
+
+  EXPECT_TRUE(transfer());
+  EXPECT_EQ(stats().hits, 1u);
+  BKE_id_free(nullptr, me_src);
+}
+
+}  // namespace blender::bke::tests
@@ -2065,7 +2065,7 @@ static Mesh *dynamicPaint_Modifier_apply(DynamicPaintModifierData *pmd, Object *
     }
 
     if (update_normals) {
-      result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+      result->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
     }
   }
   /* make a copy of mesh to use as brush data */
@@ -3571,7 +3571,7 @@ static Mesh *create_smoke_geometry(FluidDomainSettings *fds, Mesh *orgmesh, Obje
   }
 
   BKE_mesh_calc_edges(result, false, false);
-  result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  result->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
   return result;
 }
 
@@ -156,6 +156,7 @@ static void image_copy_data(Main *UNUSED(bmain), ID *id_dst, const ID *id_src, c
       image_dst->gputexture[i][eye] = NULL;
     }
   }
+  image_dst->gpu_async_load = false;
 
   if ((flag & LIB_ID_COPY_NO_PREVIEW) == 0) {
     BKE_previewimg_id_copy(&image_dst->id, &image_src->id);
@@ -169,6 +170,8 @@ static void image_free_data(ID *id)
 {
   Image *image = (Image *)id;
 
+  BKE_image_async_load_cancel(image);
+
   /* Also frees animdata. */
   BKE_image_free_buffers(image);
 
@@ -284,6 +287,7 @@ static void image_blend_read_data(BlendDataReader *reader, ID *id)
   }
 
   BLI_listbase_clear(&ima->anims);
+  ima->gpu_async_load = false;
   BLO_read_data_address(reader, &ima->preview);
   BKE_previewimg_blend_read(reader, ima->preview);
   BLO_read_data_address(reader, &ima->stereo3d_format);
@@ -4015,8 +4019,69 @@ static void image_create_multilayer(Image *ima, ImBuf *ibuf, int framenr)
   /* set proper views */
   image_init_multilayer_multiview(ima, ima->rr);
 }
+
+/* Open a multilayer EXR file without decoding any pixels, passes are decoded on first access
+ * by #image_multilayer_pass_get. Returns false if the file is not a multilayer EXR.
+ *
+ * Done for images known to be multilayer and for the first load of other images, which only
+ * reads the file headers. Once buffers of a single layer image are cached its files are not
+ * checked again, so they are not opened twice on every load. */
+static bool image_load_multilayer_lazy(Image *ima, const char *filepath, int framenr)
+{
+  if (!BLI_path_extension_check(filepath, ".exr")) {
+    return false;
+  }
+  if (ima->type != IMA_TYPE_MULTILAYER && (ima->type != IMA_TYPE_IMAGE || ima->cache != NULL)) {
+    return false;
+  }
+
+  void *exrhandle = IMB_exr_get_handle();
+  int width, height;
+
+  if (!IMB_exr_begin_read_multilayer(exrhandle, filepath, &width, &height)) {
+    IMB_exr_close(exrhandle);
+    return false;
+  }
+
+  /* only load rr once for multiview */
+  if (ima->rr == NULL) {
+    const char *colorspace = ima->colorspace_settings.name;
+    const bool predivide = (ima->alpha_mode == IMA_ALPHA_PREMUL);
+    ima->rr = RE_MultilayerConvertLazy(
+        exrhandle, filepath, colorspace, predivide, width, height);
+
+    /* Stamp info from the file metadata, like #image_create_multilayer does. */
+    ImBuf *ibuf = IMB_allocImBuf(width, height, 32, 0);
+    IMB_exr_metadata_get(exrhandle, &ibuf->metadata);
+    BKE_stamp_info_from_imbuf(ima->rr, ibuf);
+    IMB_freeImBuf(ibuf);
+  }
+  else {
+    IMB_exr_close(exrhandle);
+  }
+
+  ima->rr->framenr = framenr;
+  ima->type = IMA_TYPE_MULTILAYER;
+
+  /* set proper views */
+  image_init_multilayer_multiview(ima, ima->rr);
+
+  return true;
+}
 #endif /* WITH_OPENEXR */
 
+/* Get the pass for the image user from the multilayer render result, with its pixels loaded. */
+static RenderPass *image_multilayer_pass_get(Image *ima, ImageUser *iuser)
+{
+  RenderPass *rpass = BKE_image_multilayer_index(ima->rr, iuser);
+
+  if (rpass && !RE_pass_ensure_loaded(ima->rr, rpass)) {
+    return NULL;
+  }
+
+  return rpass;
+}
+
 /* common stuff to do with images after loading */
 static void image_init_after_load(Image *ima, ImageUser *iuser, ImBuf *UNUSED(ibuf))
 {
@@ -4095,6 +4160,12 @@ static ImBuf *load_sequence_single(
   flag = IB_rect | IB_multilayer | IB_metadata;
   flag |= imbuf_alpha_flags_for_image(ima);
 
+#ifdef WITH_OPENEXR
+  if (image_load_multilayer_lazy(ima, name, frame)) {
+    return NULL;
+  }
+#endif
+
   /* read ibuf */
   ibuf = IMB_loadiffname(name, flag, ima->colorspace_settings.name);
 
@@ -4215,7 +4286,7 @@ static ImBuf *image_load_sequence_multilayer(Image *ima, ImageUser *iuser, int e
     }
   }
   if (ima->rr) {
-    RenderPass *rpass = BKE_image_multilayer_index(ima->rr, iuser);
+    RenderPass *rpass = image_multilayer_pass_get(ima, iuser);
 
     if (rpass) {
       // printf("load from pass %s\n", rpass->name);
@@ -4417,6 +4488,12 @@ static ImBuf *load_image_single(Image *ima,
 
     BKE_image_user_file_path(&iuser_t, ima, filepath);
 
+#ifdef WITH_OPENEXR
+    if (image_load_multilayer_lazy(ima, filepath, cfra)) {
+      return NULL;
+    }
+#endif
+
     /* read ibuf */
     ibuf = IMB_loadiffname(filepath, flag, ima->colorspace_settings.name);
   }
@@ -4544,7 +4621,7 @@ static ImBuf *image_get_ibuf_multilayer(Image *ima, ImageUser *iuser)
     }
   }
   if (ima->rr) {
-    RenderPass *rpass = BKE_image_multilayer_index(ima->rr, iuser);
+    RenderPass *rpass = image_multilayer_pass_get(ima, iuser);
 
     if (rpass) {
       ibuf = IMB_allocImBuf(ima->rr->rectx, ima->rr->recty, 32, 0);
@@ -26,6 +26,7 @@
 #include "BLI_boxpack_2d.h"
 #include "BLI_linklist.h"
 #include "BLI_listbase.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "DNA_image_types.h"
@@ -250,6 +251,252 @@ static GPUTexture *gpu_texture_create_tile_array(Image *ima, ImBuf *main_ibuf)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Asynchronous Loading
+ *
+ * Image files requested by the viewport are decoded by a background task pool, so opening files
+ * with many large textures does not block drawing. Until the buffer is loaded a placeholder
+ * texture is used. The main thread polls for finished loads with #BKE_image_async_load_poll and
+ * redraws with the full texture.
+ *
+ * #Image.gpu_async_load is set while the image has an entry in the queue, so images which are not
+ * loaded in the background are drawn without taking the queue lock.
+ * \{ */
+
+typedef struct ImageAsyncLoad {
+  struct ImageAsyncLoad *next, *prev;
+  /* NULL when the load was canceled before it started. */
+  Image *ima;
+  ImageUser iuser;
+  bool use_iuser;
+  bool is_running;
+  bool is_done;
+} ImageAsyncLoad;
+
+static ListBase async_load_queue = {NULL, NULL};
+static ThreadMutex async_load_mutex = BLI_MUTEX_INITIALIZER;
+static ThreadCondition async_load_condition;
+static TaskPool *async_load_pool = NULL;
+
+static ImageAsyncLoad *image_async_load_find(Image *ima)
+{
+  LISTBASE_FOREACH (ImageAsyncLoad *, load, &async_load_queue) {
+    if (load->ima == ima) {
+      return load;
+    }
+  }
+  return NULL;
+}
+
+static void image_async_load_task(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  ImageAsyncLoad *load = (ImageAsyncLoad *)taskdata;
+
+  BLI_mutex_lock(&async_load_mutex);
+  if (load->ima == NULL) {
+    BLI_remlink(&async_load_queue, load);
+    MEM_freeN(load);
+    BLI_mutex_unlock(&async_load_mutex);
+    return;
+  }
+  load->is_running = true;
+  BLI_mutex_unlock(&async_load_mutex);
+
+  /* Loading puts the buffer into the image cache, where drawing will find it. */
+  ImageUser *iuser = load->use_iuser ? &load->iuser : NULL;
+  ImBuf *ibuf = BKE_image_acquire_ibuf(load->ima, iuser, NULL);
+  BKE_image_release_ibuf(load->ima, ibuf, NULL);
+
+  BLI_mutex_lock(&async_load_mutex);
+  load->is_running = false;
+  load->is_done = true;
+  BLI_condition_notify_all(&async_load_condition);
+  BLI_mutex_unlock(&async_load_mutex);
+}
+
+static bool image_async_load_supported(Image *ima)
+{
+  return USER_EXPERIMENTAL_TEST(&U, use_async_image_loading) && BLI_thread_is_main() &&
+         ima->source == IMA_SRC_FILE && ima->type == IMA_TYPE_IMAGE;
+}
+
+/* Returns true when the buffer is being loaded in the background, in which case a placeholder
+ * has to be used for drawing. */
+bool BKE_image_async_load_begin(Image *ima, ImageUser *iuser)
+{
+  if (!image_async_load_supported(ima) || BKE_image_has_loaded_ibuf(ima)) {
+    return false;
+  }
+
+  BLI_mutex_lock(&async_load_mutex);
+
+  ImageAsyncLoad *load = image_async_load_find(ima);
+  if (load != NULL) {
+    /* A finished load which did not produce a buffer falls back to regular loading, which will
+     * report the error. */
+    const bool is_pending = !load->is_done;
+    BLI_mutex_unlock(&async_load_mutex);
+    return is_pending;
+  }
+
+  if (async_load_pool == NULL) {
+    BLI_condition_init(&async_load_condition);
+    async_load_pool = BLI_task_pool_create_background(NULL, TASK_PRIORITY_LOW);
+  }
+
+  load = MEM_callocN(sizeof(ImageAsyncLoad), __func__);
+  load->ima = ima;
+  if (iuser) {
+    load->iuser = *iuser;
+    /* Only used for frame number, which does not apply to single images. */
+    load->iuser.scene = NULL;
+    load->use_iuser = true;
+  }
+  BLI_addtail(&async_load_queue, load);
+  ima->gpu_async_load = true;
+
+  BLI_mutex_unlock(&async_load_mutex);
+
+  BLI_task_pool_push(async_load_pool, image_async_load_task, load, false, NULL);
+
+  return true;
+}
+
+/* Cancel or wait for loads of the image, must be called with #async_load_mutex locked.
+ * Returns true if there was a load which finished. */
+static bool image_async_load_end_locked(Image *ima)
+{
+  ImageAsyncLoad *load;
+  bool found = false;
+
+  while ((load = image_async_load_find(ima))) {
+    if (load->is_running) {
+      /* Search again after waiting, the queue may have changed. */
+      BLI_condition_wait(&async_load_condition, &async_load_mutex);
+    }
+    else if (load->is_done) {
+      BLI_remlink(&async_load_queue, load);
+      MEM_freeN(load);
+      found = true;
+    }
+    else {
+      /* Not started yet, the task frees it. */
+      load->ima = NULL;
+    }
+  }
+
+  ima->gpu_async_load = false;
+
+  return found;
+}
+
+/* Wait for a pending load, so that a full texture is available. Used when drawing final renders
+ * after the viewport requested the image. Returns true if there was a pending load. */
+bool BKE_image_async_load_wait(Image *ima)
+{
+  /* Only images queued for loading need the lock, the flag is only set and cleared while holding
+   * it and checked again below. */
+  if (!ima->gpu_async_load) {
+    return false;
+  }
+
+  BLI_mutex_lock(&async_load_mutex);
+
+  bool found = false;
+  ImageAsyncLoad *load = image_async_load_find(ima);
+  if (load != NULL) {
+    if (!load->is_running && !load->is_done) {
+      /* Load right away instead of waiting for the task. */
+      load->ima = NULL;
+    }
+    image_async_load_end_locked(ima);
+    found = true;
+  }
+
+  BLI_mutex_unlock(&async_load_mutex);
+
+  return found;
+}
+
+/* Stop loading an image which is about to be freed. */
+void BKE_image_async_load_cancel(Image *ima)
+{
+  if (!ima->gpu_async_load) {
+    return;
+  }
+
+  BLI_mutex_lock(&async_load_mutex);
+  image_async_load_end_locked(ima);
+  BLI_mutex_unlock(&async_load_mutex);
+}
+
+/* Handle finished loads on the main thread: tag textures for refresh and call `done_fn` for every
+ * image so the caller can redraw. Returns the number of finished loads. */
+int BKE_image_async_load_poll(void (*done_fn)(Image *ima, void *userdata), void *userdata)
+{
+  if (async_load_pool == NULL) {
+    return 0;
+  }
+
+  LinkNode *done_images = NULL;
+  int done_len = 0;
+
+  BLI_mutex_lock(&async_load_mutex);
+  LISTBASE_FOREACH_MUTABLE (ImageAsyncLoad *, load, &async_load_queue) {
+    if (load->is_done) {
+      load->ima->gpuflag |= IMA_GPU_REFRESH;
+      load->ima->gpu_async_load = false;
+      BLI_linklist_prepend(&done_images, load->ima);
+      BLI_remlink(&async_load_queue, load);
+      MEM_freeN(load);
+      done_len++;
+    }
+  }
+  BLI_mutex_unlock(&async_load_mutex);
+
+  if (done_fn) {
+    for (LinkNode *link = done_images; link; link = link->next) {
+      done_fn(link->link, userdata);
+    }
+  }
+  BLI_linklist_free(done_images, NULL);
+
+  return done_len;
+}
+
+void BKE_image_async_load_exit(void)
+{
+  if (async_load_pool == NULL) {
+    return;
+  }
+
+  BLI_mutex_lock(&async_load_mutex);
+  LISTBASE_FOREACH (ImageAsyncLoad *, load, &async_load_queue) {
+    if (load->ima) {
+      load->ima->gpu_async_load = false;
+    }
+    if (!load->is_running && !load->is_done) {
+      load->ima = NULL;
+    }
+  }
+  BLI_mutex_unlock(&async_load_mutex);
+
+  BLI_task_pool_work_and_wait(async_load_pool);
+  BLI_task_pool_free(async_load_pool);
+  async_load_pool = NULL;
+
+  BLI_freelistN(&async_load_queue);
+  BLI_condition_end(&async_load_condition);
+}
+
+static GPUTexture *image_gpu_texture_placeholder_create(void)
+{
+  const float color[4] = {0.5f, 0.5f, 0.5f, 1.0f};
+  return GPU_texture_create_2d("placeholder", 1, 1, 1, GPU_RGBA8, color);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Regular gpu texture
  * \{ */
@@ -284,12 +531,18 @@ static GPUTexture *image_gpu_texture_error_create(eGPUTextureTarget textarget)
 static GPUTexture *image_get_gpu_texture(Image *ima,
                                          ImageUser *iuser,
                                          ImBuf *ibuf,
-                                         eGPUTextureTarget textarget)
+                                         eGPUTextureTarget textarget,
+                                         const bool use_async)
 {
   if (ima == NULL) {
     return NULL;
   }
 
+  /* Replace the placeholder texture when the image is needed right away. */
+  if (!use_async && BKE_image_async_load_wait(ima)) {
+    ima->gpuflag |= IMA_GPU_REFRESH;
+  }
+
   /* Free any unused GPU textures, since we know we are in a thread with OpenGL
    * context and might as well ensure we have as much space free as possible. */
   gpu_free_unused_buffers();
@@ -334,6 +587,12 @@ static GPUTexture *image_get_gpu_texture(Image *ima,
     return *tex;
   }
 
+  if (use_async && ibuf == NULL && textarget == TEXTARGET_2D &&
+      BKE_image_async_load_begin(ima, iuser)) {
+    *tex = image_gpu_texture_placeholder_create();
+    return *tex;
+  }
+
   /* check if we have a valid image buffer */
   ImBuf *ibuf_intern = ibuf;
   if (ibuf_intern == NULL) {
@@ -384,17 +643,25 @@ static GPUTexture *image_get_gpu_texture(Image *ima,
 
 GPUTexture *BKE_image_get_gpu_texture(Image *image, ImageUser *iuser, ImBuf *ibuf)
 {
-  return image_get_gpu_texture(image, iuser, ibuf, TEXTARGET_2D);
+  return image_get_gpu_texture(image, iuser, ibuf, TEXTARGET_2D, false);
+}
+
+/* Same as #BKE_image_get_gpu_texture, but image files which are not loaded yet may be loaded in
+ * the background, returning a placeholder texture in the meantime. Only for interactive drawing
+ * on the main thread. */
+GPUTexture *BKE_image_get_gpu_texture_async(Image *image, ImageUser *iuser)
+{
+  return image_get_gpu_texture(image, iuser, NULL, TEXTARGET_2D, true);
 }
 
 GPUTexture *BKE_image_get_gpu_tiles(Image *image, ImageUser *iuser, ImBuf *ibuf)
 {
-  return image_get_gpu_texture(image, iuser, ibuf, TEXTARGET_2D_ARRAY);
+  return image_get_gpu_texture(image, iuser, ibuf, TEXTARGET_2D_ARRAY, false);
 }
 
 GPUTexture *BKE_image_get_gpu_tilemap(Image *image, ImageUser *iuser, ImBuf *ibuf)
 {
-  return image_get_gpu_texture(image, iuser, ibuf, TEXTARGET_TILE_MAPPING);
+  return image_get_gpu_texture(image, iuser, ibuf, TEXTARGET_TILE_MAPPING, false);
 }
 
 /** \} */
@@ -0,0 +1,161 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+
+#include "testing/testing.h"
+
+#include "DNA_image_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_threads.h"
+
+#include "BKE_appdir.h"
+#include "BKE_idtype.h"
+#include "BKE_image.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "PIL_time.h"
+
+namespace blender::bke::tests {
+
+class ImageAsyncLoadTest : public testing::Test {
+ protected:
+  char filepath_[FILE_MAX];
+  Main *bmain_ = nullptr;
+  Image *ima_ = nullptr;
+
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+    BKE_appdir_init();
+    BKE_tempdir_init(nullptr);
+    BKE_idtype_init();
+    IMB_init();
+    BKE_images_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BKE_image_async_load_exit();
+    BKE_images_exit();
+    IMB_exit();
+    BKE_tempdir_session_purge();
+    BLI_threadapi_exit();
+  }
+
+  void SetUp() override
+  {
+    U.experimental.use_async_image_loading = true;
+
+    BLI_join_dirfile(filepath_, sizeof(filepath_), BKE_tempdir_session(), "image.png");
+    ImBuf *ibuf = IMB_allocImBuf(32, 32, 32, IB_rect);
+    ibuf->ftype = IMB_FTYPE_PNG;
+    ASSERT_TRUE(IMB_saveiff(ibuf, filepath_, IB_rect));
+    IMB_freeImBuf(ibuf);
+
+    bmain_ = BKE_main_new();
+    ima_ = BKE_image_load(bmain_, filepath_);
+    ASSERT_NE(ima_, nullptr);
+  }
+
+  void TearDown() override
+  {
+    BKE_main_free(bmain_);
+    BLI_delete(filepath_, false, false);
+    U.experimental.use_async_image_loading = false;
+  }
+
+  /* Poll until the background load of the image finished, returns the number of finished loads
+   * reported for the image. */
+  int poll_until_done()
+  {
+    int done_len = 0;
+    for (int i = 0; i < 10000 && ima_->gpu_async_load; i++) {
+      BKE_image_async_load_poll(count_done_cb, &done_len);
+      PIL_sleep_ms(1);
+    }
+    return done_len;
+  }
+
+  static void count_done_cb(Image * /*ima*/, void *userdata)
+  {
+    (*(int *)userdata)++;
+  }
+};
+
+TEST_F(ImageAsyncLoadTest, SynchronousWithoutPendingLoad)
+{
+  EXPECT_FALSE(ima_->gpu_async_load);
+  EXPECT_FALSE(BKE_image_async_load_wait(ima_));
+
+  /* Cancelling without a pending load does nothing. */
+  BKE_image_async_load_cancel(ima_);
+  EXPECT_FALSE(BKE_image_has_loaded_ibuf(ima_));
+}
+
+TEST_F(ImageAsyncLoadTest, WaitForPendingLoad)
+{
+  EXPECT_TRUE(BKE_image_async_load_begin(ima_, nullptr));
+  EXPECT_TRUE(ima_->gpu_async_load);
+
+  /* Requesting again while pending does not queue another load. */
+  EXPECT_TRUE(BKE_image_async_load_begin(ima_, nullptr));
+
+  EXPECT_TRUE(BKE_image_async_load_wait(ima_));
+  EXPECT_FALSE(ima_->gpu_async_load);
+  EXPECT_FALSE(BKE_image_async_load_wait(ima_));
+}
+
+TEST_F(ImageAsyncLoadTest, PollFinishedLoad)
+{
+  EXPECT_TRUE(BKE_image_async_load_begin(ima_, nullptr));
+  EXPECT_EQ(poll_until_done(), 1);
+
+  EXPECT_FALSE(ima_->gpu_async_load);
+  EXPECT_TRUE(ima_->gpuflag & IMA_GPU_REFRESH);
+  EXPECT_TRUE(BKE_image_has_loaded_ibuf(ima_));
+
+  /* Loaded images are drawn right away. */
+  EXPECT_FALSE(BKE_image_async_load_begin(ima_, nullptr));
+  EXPECT_FALSE(ima_->gpu_async_load);
+}
+
+TEST_F(ImageAsyncLoadTest, CancelPendingLoad)
+{
+  EXPECT_TRUE(BKE_image_async_load_begin(ima_, nullptr));
+  BKE_image_async_load_cancel(ima_);
+  EXPECT_FALSE(ima_->gpu_async_load);
+  EXPECT_FALSE(BKE_image_async_load_wait(ima_));
+}
+
+TEST_F(ImageAsyncLoadTest, CopyIsNotPending)
+{
+  EXPECT_TRUE(BKE_image_async_load_begin(ima_, nullptr));
+
+  Image *ima_copy = (Image *)BKE_id_copy(bmain_, &ima_->id);
+  EXPECT_FALSE(ima_copy->gpu_async_load);
+
+  EXPECT_TRUE(BKE_image_async_load_wait(ima_));
+}
+
+}  // namespace blender::bke::tests
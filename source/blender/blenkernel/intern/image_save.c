@@ -187,6 +187,11 @@ static bool image_save_single(ReportList *reports,
   bool is_multilayer = is_exr_rr && (imf->imtype == R_IMF_IMTYPE_MULTILAYER);
   int layer = (iuser && !is_multilayer) ? iuser->layer : -1;
 
+  if (is_exr_rr) {
+    /* Passes of multilayer images may not have been read from disk yet. */
+    RE_passes_ensure_loaded(rr);
+  }
+
   /* error handling */
   if (!rr) {
     if (imf->imtype == R_IMF_IMTYPE_MULTILAYER) {
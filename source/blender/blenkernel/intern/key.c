@@ -27,10 +27,13 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_blenlib.h"
 #include "BLI_endian_switch.h"
 #include "BLI_math_vector.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -61,10 +64,16 @@
 #include "BKE_mesh.h"
 #include "BKE_scene.h"
 
+#include "DEG_depsgraph_query.h"
+
 #include "RNA_access.h"
 
 #include "BLO_read_write.h"
 
+#include "key_intern.h"
+
+static void key_runtime_free(Key *key);
+
 static void shapekey_copy_data(Main *UNUSED(bmain),
                                ID *id_dst,
                                const ID *id_src,
@@ -73,6 +82,7 @@ static void shapekey_copy_data(Main *UNUSED(bmain),
   Key *key_dst = (Key *)id_dst;
   const Key *key_src = (const Key *)id_src;
   BLI_duplicatelist(&key_dst->block, &key_src->block);
+  key_dst->runtime = NULL;
 
   KeyBlock *kb_dst, *kb_src;
   for (kb_src = key_src->block.first, kb_dst = key_dst->block.first; kb_dst;
@@ -91,6 +101,8 @@ static void shapekey_free_data(ID *id)
   Key *key = (Key *)id;
   KeyBlock *kb;
 
+  key_runtime_free(key);
+
   while ((kb = BLI_pophead(&key->block))) {
     if (kb->data) {
       MEM_freeN(kb->data);
@@ -168,6 +180,7 @@ static void shapekey_blend_read_data(BlendDataReader *reader, ID *id)
   BKE_animdata_blend_read_data(reader, key->adt);
 
   BLO_read_data_address(reader, &key->refkey);
+  key->runtime = NULL;
 
   LISTBASE_FOREACH (KeyBlock *, kb, &key->block) {
     BLO_read_data_address(reader, &kb->data);
@@ -218,10 +231,6 @@ IDTypeInfo IDType_ID_KE = {
     .blend_read_undo_preserve = NULL,
 };
 
-#define KEY_MODE_DUMMY 0 /* use where mode isn't checked for */
-#define KEY_MODE_BPOINT 1
-#define KEY_MODE_BEZTRIPLE 2
-
 /* Internal use only. */
 typedef struct WeightsArrayCache {
   int num_defgroup_weights;
@@ -861,14 +870,346 @@ static void cp_cu_key(Curve *cu,
   }
 }
 
-static void key_evaluate_relative(const int start,
-                                  int end,
-                                  const int tot,
+/* -------------------------------------------------------------------- */
+/** \name Relative Coordinate Keys
+ *
+ * Fast path of #key_evaluate_relative for meshes and lattices: elements are split in blocks
+ * evaluated in parallel, each block applying all keys in order like the generic code does.
+ *
+ * Evaluated keys cache which elements each key block moves relative to its reference, keys that
+ * only move a few elements then only visit those. The elements are compared on the first
+ * evaluation of a key block with a value, so muted and unused keys never pay for it. The cache
+ * of a key block is only used with the data it was computed from.
+ * \{ */
+
+#define KEY_RELATIVE_BLOCK_SIZE 1024
+
+typedef struct KeyBlockSparse {
+  /** Data of the key block and of its reference the elements were compared from. */
+  const void *data;
+  const void *refdata;
+  /** Sorted indices of moved elements, NULL when the key block is stored dense. */
+  int *index;
+  int index_len;
+} KeyBlockSparse;
+
+typedef struct Key_Runtime {
+  /** Per key block in the order of #Key.block, NULL until the key block is evaluated. */
+  KeyBlockSparse **sparse;
+  int sparse_len;
+} Key_Runtime;
+
+static void key_block_sparse_free(KeyBlockSparse *sparse)
+{
+  MEM_SAFE_FREE(sparse->index);
+  MEM_freeN(sparse);
+}
+
+static void key_runtime_data_free(Key_Runtime *runtime)
+{
+  for (int i = 0; i < runtime->sparse_len; i++) {
+    if (runtime->sparse[i]) {
+      key_block_sparse_free(runtime->sparse[i]);
+    }
+  }
+  MEM_freeN(runtime->sparse);
+  MEM_freeN(runtime);
+}
+
+static void key_runtime_free(Key *key)
+{
+  if (key->runtime == NULL) {
+    return;
+  }
+  key_runtime_data_free(key->runtime);
+  key->runtime = NULL;
+}
+
+/**
+ * Objects sharing the key may be evaluated at the same time. The runtime data and the cache of
+ * each key block are built without any lock and published atomically, a thread losing the race
+ * frees its copy.
+ */
+static Key_Runtime *key_runtime_ensure(Key *key)
+{
+  Key_Runtime *runtime = key->runtime;
+  if (runtime != NULL) {
+    return runtime;
+  }
+
+  runtime = MEM_callocN(sizeof(*runtime), __func__);
+  runtime->sparse_len = key->totkey;
+  runtime->sparse = MEM_calloc_arrayN(key->totkey, sizeof(*runtime->sparse), __func__);
+  Key_Runtime *runtime_prev = atomic_cas_ptr((void **)&key->runtime, NULL, runtime);
+  if (runtime_prev != NULL) {
+    key_runtime_data_free(runtime);
+    return runtime_prev;
+  }
+  return runtime;
+}
+
+typedef struct KeyRelativeLayer {
+  const float (*from)[3];
+  const float (*reffrom)[3];
+  /** Per element weights of the key block vertex group, may be NULL. */
+  const float *weights;
+  float icuval;
+  const KeyBlockSparse *sparse;
+  int keyblock_index;
+} KeyRelativeLayer;
+
+typedef struct KeyRelativeData {
+  float (*out)[3];
+  const float (*basis)[3];
+  int tot;
+  const KeyRelativeLayer *layers;
+  int layers_len;
+} KeyRelativeData;
+
+static void key_evaluate_relative_coords_task(void *__restrict userdata,
+                                              const int block,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KeyRelativeData *data = userdata;
+  const int start = block * KEY_RELATIVE_BLOCK_SIZE;
+  const int end = min_ii(start + KEY_RELATIVE_BLOCK_SIZE, data->tot);
+  float(*out)[3] = data->out;
+
+  memcpy(out[start], data->basis[start], sizeof(float[3]) * (end - start));
+
+  for (int i = 0; i < data->layers_len; i++) {
+    const KeyRelativeLayer *layer = &data->layers[i];
+    const float(*from)[3] = layer->from;
+    const float(*reffrom)[3] = layer->reffrom;
+    const float *weights = layer->weights;
+    const float icuval = layer->icuval;
+
+    if (layer->sparse && layer->sparse->index) {
+      const int *index = layer->sparse->index;
+      const int index_len = layer->sparse->index_len;
+      /* Find the first moved element of the block. */
+      int lo = 0, hi = index_len;
+      while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (index[mid] < start) {
+          lo = mid + 1;
+        }
+        else {
+          hi = mid;
+        }
+      }
+      for (int j = lo; j < index_len && index[j] < end; j++) {
+        const int a = index[j];
+        const float weight = weights ? (weights[a] * icuval) : icuval;
+        rel_flerp(KEYELEM_FLOAT_LEN_COORD, out[a], reffrom[a], from[a], weight);
+      }
+    }
+    else {
+      for (int a = start; a < end; a++) {
+        const float weight = weights ? (weights[a] * icuval) : icuval;
+        rel_flerp(KEYELEM_FLOAT_LEN_COORD, out[a], reffrom[a], from[a], weight);
+      }
+    }
+  }
+}
+
+typedef struct KeySparseBuildData {
+  const KeyRelativeLayer *layers;
+  /** Layers without cached indices yet. */
+  const int *build_layers;
+  int tot;
+  int blocks_len;
+  /** Per build layer #tot indices, each element block stores its moved elements at its start. */
+  int *moved;
+  /** Per build layer and element block. */
+  int *moved_len;
+} KeySparseBuildData;
+
+static void key_sparse_build_task(void *__restrict userdata,
+                                  const int iter,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KeySparseBuildData *data = userdata;
+  const int build_index = iter / data->blocks_len;
+  const int start = (iter % data->blocks_len) * KEY_RELATIVE_BLOCK_SIZE;
+  const int end = min_ii(start + KEY_RELATIVE_BLOCK_SIZE, data->tot);
+  const KeyRelativeLayer *layer = &data->layers[data->build_layers[build_index]];
+  int *moved = &data->moved[(size_t)build_index * data->tot + start];
+
+  int moved_len = 0;
+  for (int a = start; a < end; a++) {
+    if (!equals_v3v3(layer->from[a], layer->reffrom[a])) {
+      moved[moved_len++] = a;
+    }
+  }
+  data->moved_len[iter] = moved_len;
+}
+
+/**
+ * Compare the elements of the layers that have no cached indices yet, all layers and element
+ * blocks in parallel, and publish the result in the key runtime.
+ */
+static void key_sparse_build(Key_Runtime *runtime,
+                             KeyRelativeLayer *layers,
+                             const int *build_layers,
+                             const int build_len,
+                             const int tot)
+{
+  KeySparseBuildData data = {
+      .layers = layers,
+      .build_layers = build_layers,
+      .tot = tot,
+      .blocks_len = (tot + KEY_RELATIVE_BLOCK_SIZE - 1) / KEY_RELATIVE_BLOCK_SIZE,
+  };
+  data.moved = MEM_malloc_arrayN((size_t)build_len * tot, sizeof(int), __func__);
+  data.moved_len = MEM_malloc_arrayN(
+      (size_t)build_len * data.blocks_len, sizeof(int), __func__);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (size_t)build_len * tot > KEY_RELATIVE_BLOCK_SIZE;
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(
+      0, build_len * data.blocks_len, &data, key_sparse_build_task, &settings);
+
+  for (int i = 0; i < build_len; i++) {
+    KeyRelativeLayer *layer = &layers[build_layers[i]];
+    const int *moved_len = &data.moved_len[i * data.blocks_len];
+    int index_len = 0;
+    for (int block = 0; block < data.blocks_len; block++) {
+      index_len += moved_len[block];
+    }
+
+    KeyBlockSparse *sparse = MEM_callocN(sizeof(*sparse), __func__);
+    sparse->data = layer->from;
+    sparse->refdata = layer->reffrom;
+    /* Walking indices is only worth it when most elements are skipped. */
+    if (index_len < tot / 4) {
+      sparse->index = MEM_malloc_arrayN(max_ii(index_len, 1), sizeof(int), __func__);
+      sparse->index_len = 0;
+      for (int block = 0; block < data.blocks_len; block++) {
+        memcpy(&sparse->index[sparse->index_len],
+               &data.moved[(size_t)i * tot + block * KEY_RELATIVE_BLOCK_SIZE],
+               sizeof(int) * moved_len[block]);
+        sparse->index_len += moved_len[block];
+      }
+    }
+
+    KeyBlockSparse *sparse_prev = atomic_cas_ptr(
+        (void **)&runtime->sparse[layer->keyblock_index], NULL, sparse);
+    if (sparse_prev != NULL) {
+      key_block_sparse_free(sparse);
+      sparse = sparse_prev;
+    }
+    if (sparse->data == layer->from && sparse->refdata == layer->reffrom) {
+      layer->sparse = sparse;
+    }
+  }
+
+  MEM_freeN(data.moved);
+  MEM_freeN(data.moved_len);
+}
+
+/**
+ * Evaluate relative keys of meshes and lattices.
+ * \return false when #key_evaluate_relative has to be used instead.
+ */
+bool key_evaluate_relative_coords(const int tot,
                                   char *basispoin,
                                   Key *key,
                                   KeyBlock *actkb,
-                                  float **per_keyblock_weights,
-                                  const int mode)
+                                  float **per_keyblock_weights)
+{
+  if (key->from == NULL || !ELEM(GS(key->from->name), ID_ME, ID_LT)) {
+    return false;
+  }
+  if (key->refkey == NULL || key->refkey->totelem != tot || tot == 0) {
+    return false;
+  }
+
+  Key_Runtime *runtime = DEG_is_evaluated_id(&key->id) ? key_runtime_ensure(key) : NULL;
+
+  KeyRelativeLayer *layers = MEM_malloc_arrayN(key->totkey, sizeof(*layers), __func__);
+  int *build_layers = MEM_malloc_arrayN(key->totkey, sizeof(*build_layers), __func__);
+  char **freedata = MEM_calloc_arrayN(key->totkey + 1, sizeof(*freedata), __func__);
+  int layers_len = 0, build_len = 0;
+
+  KeyBlock *kb;
+  int keyblock_index;
+  for (kb = key->block.first, keyblock_index = 0; kb; kb = kb->next, keyblock_index++) {
+    /* only with value, and no difference allowed */
+    if (kb == key->refkey || (kb->flag & KEYBLOCK_MUTE) || kb->curval == 0.0f ||
+        kb->totelem != tot) {
+      continue;
+    }
+    /* reference now can be any block */
+    KeyBlock *refb = BLI_findlink(&key->block, kb->relative);
+    if (refb == NULL || refb->totelem != tot) {
+      continue;
+    }
+
+    KeyRelativeLayer *layer = &layers[layers_len++];
+    layer->from = (const float(*)[3])key_block_get_data(
+        key, actkb, kb, &freedata[keyblock_index]);
+    /* For meshes, use the original values instead of the bmesh values to
+     * maintain a constant offset. */
+    layer->reffrom = refb->data;
+    layer->weights = per_keyblock_weights ? per_keyblock_weights[keyblock_index] : NULL;
+    layer->icuval = kb->curval;
+    layer->sparse = NULL;
+    layer->keyblock_index = keyblock_index;
+    /* Edit-mode coordinates of the active key are not cached. */
+    if (runtime && freedata[keyblock_index] == NULL && keyblock_index < runtime->sparse_len) {
+      const KeyBlockSparse *sparse = runtime->sparse[keyblock_index];
+      if (sparse == NULL) {
+        build_layers[build_len++] = layers_len - 1;
+      }
+      else if (sparse->data == layer->from && sparse->refdata == layer->reffrom) {
+        layer->sparse = sparse;
+      }
+    }
+  }
+
+  if (build_len != 0) {
+    key_sparse_build(runtime, layers, build_layers, build_len, tot);
+  }
+
+  char *freebasis;
+  KeyRelativeData data = {
+      .out = (float(*)[3])basispoin,
+      .basis = (const float(*)[3])key_block_get_data(key, actkb, key->refkey, &freebasis),
+      .tot = tot,
+      .layers = layers,
+      .layers_len = layers_len,
+  };
+  freedata[key->totkey] = freebasis;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = tot > KEY_RELATIVE_BLOCK_SIZE;
+  settings.min_iter_per_thread = 1;
+  const int blocks_len = (tot + KEY_RELATIVE_BLOCK_SIZE - 1) / KEY_RELATIVE_BLOCK_SIZE;
+  BLI_task_parallel_range(0, blocks_len, &data, key_evaluate_relative_coords_task, &settings);
+
+  for (int i = 0; i <= key->totkey; i++) {
+    MEM_SAFE_FREE(freedata[i]);
+  }
+  MEM_freeN(freedata);
+  MEM_freeN(build_layers);
+  MEM_freeN(layers);
+  return true;
+}
+
+/** \} */
+
+void key_evaluate_relative(const int start,
+                           int end,
+                           const int tot,
+                           char *basispoin,
+                           Key *key,
+                           KeyBlock *actkb,
+                           float **per_keyblock_weights,
+                           const int mode)
 {
   KeyBlock *kb;
   int *ofsp, ofs[3], elemsize, b, step;
@@ -1391,8 +1732,10 @@ static void do_mesh_key(Object *ob, Key *key, char *out, const int tot)
     WeightsArrayCache cache = {0, NULL};
     float **per_keyblock_weights;
     per_keyblock_weights = keyblock_get_per_block_weights(ob, key, &cache);
-    key_evaluate_relative(
-        0, tot, tot, (char *)out, key, actkb, per_keyblock_weights, KEY_MODE_DUMMY);
+    if (!key_evaluate_relative_coords(tot, out, key, actkb, per_keyblock_weights)) {
+      key_evaluate_relative(
+          0, tot, tot, (char *)out, key, actkb, per_keyblock_weights, KEY_MODE_DUMMY);
+    }
     keyblock_free_per_block_weights(key, per_keyblock_weights, &cache);
   }
   else {
@@ -1484,8 +1827,10 @@ static void do_latt_key(Object *ob, Key *key, char *out, const int tot)
   if (key->type == KEY_RELATIVE) {
     float **per_keyblock_weights;
     per_keyblock_weights = keyblock_get_per_block_weights(ob, key, NULL);
-    key_evaluate_relative(
-        0, tot, tot, (char *)out, key, actkb, per_keyblock_weights, KEY_MODE_DUMMY);
+    if (!key_evaluate_relative_coords(tot, out, key, actkb, per_keyblock_weights)) {
+      key_evaluate_relative(
+          0, tot, tot, (char *)out, key, actkb, per_keyblock_weights, KEY_MODE_DUMMY);
+    }
     keyblock_free_per_block_weights(key, per_keyblock_weights, NULL);
   }
   else {
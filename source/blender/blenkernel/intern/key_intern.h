@@ -0,0 +1,54 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup bke
+ */
+
+#pragma once
+
+struct Key;
+struct KeyBlock;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KEY_MODE_DUMMY 0 /* use where mode isn't checked for */
+#define KEY_MODE_BPOINT 1
+#define KEY_MODE_BEZTRIPLE 2
+
+void key_evaluate_relative(const int start,
+                           int end,
+                           const int tot,
+                           char *basispoin,
+                           struct Key *key,
+                           struct KeyBlock *actkb,
+                           float **per_keyblock_weights,
+                           const int mode);
+
+bool key_evaluate_relative_coords(const int tot,
+                                  char *basispoin,
+                                  struct Key *key,
+                                  struct KeyBlock *actkb,
+                                  float **per_keyblock_weights);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,190 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math.h"
+#include "BLI_rand.h"
+
+#include "DNA_ID.h"
+#include "DNA_key_types.h"
+#include "DNA_mesh_types.h"
+
+#include "BKE_idtype.h"
+#include "BKE_key.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+
+#include "key_intern.h"
+
+namespace blender::bke::tests {
+
+/* More than one block of elements, so blocks are evaluated in parallel. */
+#define ELEMS_NUM 3000
+
+class KeyRelativeTest : public testing::Test {
+ protected:
+  Main *bmain_ = nullptr;
+  Mesh *me_ = nullptr;
+  Key *key_ = nullptr;
+  KeyBlock *basis_ = nullptr;
+  /* Moves a few elements, weighted by a vertex group. */
+  KeyBlock *sparse_ = nullptr;
+  /* Moves all elements. */
+  KeyBlock *dense_ = nullptr;
+  KeyBlock *muted_ = nullptr;
+  /* Moves a few elements relative to #sparse_, weighted by a vertex group. */
+  KeyBlock *relative_ = nullptr;
+  float *weights_[5] = {nullptr};
+
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+
+  /* Shape keys as evaluated by the depsgraph, which cache the moved elements. */
+  void SetUp() override
+  {
+    bmain_ = BKE_main_new();
+    me_ = BKE_mesh_new_nomain(ELEMS_NUM, 0, 0, 0, 0);
+    key_ = BKE_key_add(bmain_, &me_->id);
+    key_->type = KEY_RELATIVE;
+    key_->id.tag |= LIB_TAG_COPIED_ON_WRITE;
+
+    RNG *rng = BLI_rng_new(1);
+    basis_ = keyblock_add("Basis", nullptr, 0.0f, rng, 1);
+    sparse_ = keyblock_add("Sparse", basis_, 0.7f, rng, 97);
+    dense_ = keyblock_add("Dense", basis_, 0.3f, rng, 1);
+    muted_ = keyblock_add("Muted", basis_, 1.0f, rng, 1);
+    muted_->flag |= KEYBLOCK_MUTE;
+    relative_ = keyblock_add("Relative", sparse_, 0.5f, rng, 61);
+    relative_->relative = 1;
+
+    for (const int keyblock_index : {1, 4}) {
+      weights_[keyblock_index] = (float *)MEM_malloc_arrayN(ELEMS_NUM, sizeof(float), __func__);
+      for (int a = 0; a < ELEMS_NUM; a++) {
+        weights_[keyblock_index][a] = BLI_rng_get_float(rng);
+      }
+    }
+    BLI_rng_free(rng);
+  }
+
+  void TearDown() override
+  {
+    for (float *weights : weights_) {
+      MEM_SAFE_FREE(weights);
+    }
+    BKE_main_free(bmain_);
+    BKE_id_free(nullptr, me_);
+  }
+
+  /* A key block moving every `step`th element of its reference by a random offset, the basis
+   * has random coordinates. */
+  KeyBlock *keyblock_add(
+      const char *name, const KeyBlock *refb, const float curval, RNG *rng, const int step)
+  {
+    KeyBlock *kb = BKE_keyblock_add(key_, name);
+    kb->totelem = ELEMS_NUM;
+    kb->curval = curval;
+    float(*data)[3] = (float(*)[3])MEM_malloc_arrayN(ELEMS_NUM, sizeof(float[3]), __func__);
+    for (int a = 0; a < ELEMS_NUM; a++) {
+      if (refb) {
+        copy_v3_v3(data[a], ((const float(*)[3])refb->data)[a]);
+      }
+      else {
+        zero_v3(data[a]);
+      }
+      if (a % step == 0) {
+        data[a][0] += BLI_rng_get_float(rng);
+        data[a][1] += BLI_rng_get_float(rng);
+        data[a][2] += BLI_rng_get_float(rng);
+      }
+    }
+    kb->data = data;
+    return kb;
+  }
+
+  /* Evaluate with the fast path and the generic code, returns whether the results match. */
+  bool evaluate_matches()
+  {
+    float(*out)[3] = (float(*)[3])MEM_calloc_arrayN(ELEMS_NUM, sizeof(float[3]), __func__);
+    float(*out_generic)[3] = (float(*)[3])MEM_calloc_arrayN(
+        ELEMS_NUM, sizeof(float[3]), __func__);
+
+    EXPECT_TRUE(key_evaluate_relative_coords(ELEMS_NUM, (char *)out, key_, nullptr, weights_));
+    key_evaluate_relative(
+        0, ELEMS_NUM, ELEMS_NUM, (char *)out_generic, key_, nullptr, weights_, KEY_MODE_DUMMY);
+
+    const bool match = memcmp(out, out_generic, sizeof(float[3]) * ELEMS_NUM) == 0;
+    MEM_freeN(out);
+    MEM_freeN(out_generic);
+    return match;
+  }
+};
+
+TEST_F(KeyRelativeTest, MatchesGeneric)
+{
+  EXPECT_TRUE(evaluate_matches());
+  EXPECT_NE(key_->runtime, nullptr);
+
+  /* Again with the cached elements. */
+  EXPECT_TRUE(evaluate_matches());
+}
+
+TEST_F(KeyRelativeTest, KeysEnabledLater)
+{
+  EXPECT_TRUE(evaluate_matches());
+
+  /* Muted keys and keys without value are compared on their first evaluation. */
+  muted_->flag &= ~KEYBLOCK_MUTE;
+  dense_->curval = 0.0f;
+  EXPECT_TRUE(evaluate_matches());
+  dense_->curval = 1.0f;
+  relative_->curval = 1.0f;
+  EXPECT_TRUE(evaluate_matches());
+}
+
+TEST_F(KeyRelativeTest, DataReplaced)
+{
+  EXPECT_TRUE(evaluate_matches());
+
+  /* The cached elements belong to the data they were compared from. */
+  float(*data)[3] = (float(*)[3])MEM_dupallocN(sparse_->data);
+  for (int a = 0; a < ELEMS_NUM; a++) {
+    data[a][2] += 1.0f;
+  }
+  MEM_freeN(sparse_->data);
+  sparse_->data = data;
+  EXPECT_TRUE(evaluate_matches());
+
+  /* Other reference data of a key relative to a non-basis key. */
+  relative_->relative = 2;
+  EXPECT_TRUE(evaluate_matches());
+}
+
+TEST_F(KeyRelativeTest, OriginalKeyIsNotCached)
+{
+  key_->id.tag &= ~LIB_TAG_COPIED_ON_WRITE;
+  EXPECT_TRUE(evaluate_matches());
+  EXPECT_EQ(key_->runtime, nullptr);
+}
+
+}  // namespace blender::bke::tests
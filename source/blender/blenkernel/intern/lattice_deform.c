@@ -222,14 +222,25 @@ void BKE_lattice_deform_data_eval_co(LatticeDeformData *lattice_deform_data,
   const int idx_v_max = (lt->pntsv - 1) * lt->pntsu;
   const int idx_u_max = (lt->pntsu - 1);
 
+  /* Points without influence are skipped, linear interpolation and axes with a single point
+   * only use a few of the 4x4x4 points. */
   for (ww = wi - 1; ww <= wi + 2; ww++) {
     w = weight * tw[ww - wi + 1];
+    if (w == 0.0f) {
+      continue;
+    }
     idx_w = CLAMPIS(ww * w_stride, 0, idx_w_max);
     for (vv = vi - 1; vv <= vi + 2; vv++) {
       v = w * tv[vv - vi + 1];
+      if (v == 0.0f) {
+        continue;
+      }
       idx_v = CLAMPIS(vv * v_stride, 0, idx_v_max);
       for (uu = ui - 1; uu <= ui + 2; uu++) {
         u = v * tu[uu - ui + 1];
+        if (u == 0.0f) {
+          continue;
+        }
         idx_u = CLAMPIS(uu, 0, idx_u_max);
         const int idx = idx_w + idx_v + idx_u;
 #ifdef __SSE2__
@@ -272,6 +283,9 @@ void BKE_lattice_deform_data_destroy(LatticeDeformData *lattice_deform_data)
   if (lattice_deform_data->latticedata) {
     MEM_freeN(lattice_deform_data->latticedata);
   }
+  if (lattice_deform_data->lattice_weights) {
+    MEM_freeN(lattice_deform_data->lattice_weights);
+  }
 
   MEM_freeN(lattice_deform_data);
 }
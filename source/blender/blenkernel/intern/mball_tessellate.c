@@ -34,10 +34,13 @@
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 
+#include "BLI_bitmap.h"
+#include "BLI_ghash.h"
 #include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_memarena.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_global.h"
@@ -58,32 +61,9 @@
 /* Data types */
 
 typedef struct corner { /* corner of a cube */
-  int i, j, k;          /* (i, j, k) is index within lattice */
   float co[3], value;   /* location and function value */
-  struct corner *next;
 } CORNER;
 
-typedef struct cube { /* partitioning cell (cube) */
-  int i, j, k;        /* lattice location of cube */
-  CORNER *corners[8]; /* eight corners */
-} CUBE;
-
-typedef struct cubes { /* linked list of cubes acting as stack */
-  CUBE cube;           /* a single cube */
-  struct cubes *next;  /* remaining elements */
-} CUBES;
-
-typedef struct centerlist { /* list of cube locations */
-  int i, j, k;              /* cube location */
-  struct centerlist *next;  /* remaining elements */
-} CENTERLIST;
-
-typedef struct edgelist {     /* list of edges */
-  int i1, j1, k1, i2, j2, k2; /* edge corner ids */
-  int vid;                    /* vertex id */
-  struct edgelist *next;      /* remaining elements */
-} EDGELIST;
-
 typedef struct intlist { /* list of integers */
   int i;                 /* an integer */
   struct intlist *next;  /* remaining elements */
@@ -104,6 +84,36 @@ typedef struct MetaballBVHNode { /* BVH node */
   struct MetaballBVHNode *child[2];
 } MetaballBVHNode;
 
+/**
+ * Part of the lattice, #MB_BLOCK_SIZE cubes along each axis, polygonized by a single thread.
+ * Vertices on edges shared with neighbor blocks are merged once all blocks are done.
+ */
+typedef struct MetaballBlock {
+  int key[4]; /* location in units of blocks, last item is unused (key of blocks hash) */
+  int lbn[3]; /* lattice location of the left bottom near cube */
+
+  float *corner_values;   /* corner value cache, #MB_CORNER_UNSET when not computed yet */
+  BLI_bitmap *cubes_done; /* cubes which have been put on the stack */
+  int *edges;             /* vertex id of each lattice edge (local to the block), -1 if not set */
+
+  int *cubes;            /* stack of cubes waiting for polygonization */
+  unsigned int curcube;  /* number of cubes on the stack */
+  int (*exits)[3];       /* cubes of neighbor blocks reached by the surface */
+  unsigned int totexit;  /* size of memory allocated for exits */
+  unsigned int curexit;  /* number of currently added exits */
+
+  int (*indices)[4];     /* faces, using vertex ids local to the block */
+  unsigned int totindex; /* size of memory allocated for indices */
+  unsigned int curindex; /* number of currently added indices */
+
+  float (*co)[3], (*no)[3]; /* surface vertices - positions and normals */
+  int *vert_edges;          /* lattice edge of each vertex, index into edges */
+  unsigned int totvertex;   /* memory size */
+  unsigned int curvertex;   /* currently added vertices */
+
+  bool in_queue;
+} MetaballBlock;
+
 typedef struct process {     /* parameters, storage */
   float thresh, size;        /* mball threshold, single cube size */
   float delta;               /* small delta for calculating normals */
@@ -115,31 +125,39 @@ typedef struct process {     /* parameters, storage */
   MetaballBVHNode metaball_bvh; /* The simplest bvh */
   Box allbb;                    /* Bounding box of all metaelems */
 
-  MetaballBVHNode **bvh_queue; /* Queue used during bvh traversal */
-  unsigned int bvh_queue_size;
+  unsigned int bvh_queue_size; /* Size of the queues used during bvh traversal */
 
-  CUBES *cubes;         /* stack of cubes waiting for polygonization */
-  CENTERLIST **centers; /* cube center hash table */
-  CORNER **corners;     /* corner value hash table */
-  EDGELIST **edges;     /* edge and vertex id hash table */
+  GHash *blocks_hash;      /* blocks by location */
+  MetaballBlock **blocks;  /* all blocks, in order of creation */
+  unsigned int totblock;   /* size of memory allocated for blocks (and queue) */
+  unsigned int curblock;   /* number of blocks */
+  MetaballBlock **queue;   /* blocks with cubes waiting for polygonization */
+  unsigned int queue_len;
 
   int (*indices)[4];     /* output indices */
-  unsigned int totindex; /* size of memory allocated for indices */
-  unsigned int curindex; /* number of currently added indices */
+  unsigned int curindex; /* number of added indices */
 
   float (*co)[3], (*no)[3]; /* surface vertices - positions and normals */
-  unsigned int totvertex;   /* memory size */
-  unsigned int curvertex;   /* currently added vertices */
+  unsigned int curvertex;   /* number of added vertices */
 
   /* memory allocation from common pool */
   MemArena *pgn_elements;
 } PROCESS;
 
 /* Forward declarations */
-static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2);
-static void add_cube(PROCESS *process, int i, int j, int k);
-static void make_face(PROCESS *process, int i1, int i2, int i3, int i4);
-static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float r_p[3]);
+static int vertid(const PROCESS *process,
+                  MetaballBlock *block,
+                  const MetaballBVHNode **bvh_queue,
+                  const int cube[3],
+                  int c1,
+                  int c2);
+static void add_cube(MetaballBlock *block, int i, int j, int k);
+static void make_face(MetaballBlock *block, int i1, int i2, int i3, int i4);
+static void converge(const PROCESS *process,
+                     const MetaballBVHNode **bvh_queue,
+                     const CORNER *c1,
+                     const CORNER *c2,
+                     float r_p[3]);
 
 /* ******************* SIMPLE BVH ********************* */
 
@@ -292,10 +310,19 @@ static void build_bvh_spatial(PROCESS *process,
  * (i-0.5)*size, (j-0.5)*size, (k-0.5)*size)
  */
 
-#define HASHBIT (5)
-#define HASHSIZE (size_t)(1 << (3 * HASHBIT)) /*! < hash table size (32768) */
+/* Number of cubes along each axis of a #MetaballBlock. */
+#define MB_BLOCK_SIZE 8
+#define MB_BLOCK_CORNERS (MB_BLOCK_SIZE + 1)
+#define MB_BLOCK_CUBES_NUM (MB_BLOCK_SIZE * MB_BLOCK_SIZE * MB_BLOCK_SIZE)
+#define MB_BLOCK_CORNERS_NUM (MB_BLOCK_CORNERS * MB_BLOCK_CORNERS * MB_BLOCK_CORNERS)
+
+#define MB_BLOCK_CUBE_INDEX(i, j, k) ((((i)*MB_BLOCK_SIZE) + (j)) * MB_BLOCK_SIZE + (k))
+#define MB_BLOCK_CORNER_INDEX(i, j, k) ((((i)*MB_BLOCK_CORNERS) + (j)) * MB_BLOCK_CORNERS + (k))
+/* Lattice edges are stored at their lower corner, one for each axis. */
+#define MB_BLOCK_EDGE_INDEX(i, j, k, axis) (MB_BLOCK_CORNER_INDEX(i, j, k) * 3 + (axis))
 
-#define HASH(i, j, k) ((((((i)&31) << 5) | ((j)&31)) << 5) | ((k)&31))
+/* Density is never this large, marks corners which have not been computed yet. */
+#define MB_CORNER_UNSET FLT_MAX
 
 #define MB_BIT(i, bit) (((i) >> (bit)) & 1)
 // #define FLIP(i, bit) ((i) ^ 1 << (bit)) /* flip the given bit of i */
@@ -406,24 +433,25 @@ static float densfunc(const MetaElem *ball, float x, float y, float z)
 
 /**
  * Computes density at given position form all meta-balls which contain this point in their box.
- * Traverses BVH using a queue.
+ * Traverses BVH using a queue, each thread uses its own queue.
  */
-static float metaball(PROCESS *process, float x, float y, float z)
+static float metaball(
+    const PROCESS *process, const MetaballBVHNode **bvh_queue, float x, float y, float z)
 {
   float dens = 0.0f;
   unsigned int front = 0, back = 0;
-  MetaballBVHNode *node;
+  const MetaballBVHNode *node;
 
-  process->bvh_queue[front++] = &process->metaball_bvh;
+  bvh_queue[front++] = &process->metaball_bvh;
 
   while (front != back) {
-    node = process->bvh_queue[back++];
+    node = bvh_queue[back++];
 
     for (int i = 0; i < 2; i++) {
       if ((node->bb[i].min[0] <= x) && (node->bb[i].max[0] >= x) && (node->bb[i].min[1] <= y) &&
           (node->bb[i].max[1] >= y) && (node->bb[i].min[2] <= z) && (node->bb[i].max[2] >= z)) {
         if (node->child[i]) {
-          process->bvh_queue[front++] = node->child[i];
+          bvh_queue[front++] = node->child[i];
         }
         else {
           dens += densfunc(node->bb[i].ml, x, y, z);
@@ -436,22 +464,18 @@ static float metaball(PROCESS *process, float x, float y, float z)
 }
 
 /**
- * Adds face to indices, expands memory if needed.
+ * Adds face to indices of the block, expands memory if needed.
  */
-static void make_face(PROCESS *process, int i1, int i2, int i3, int i4)
+static void make_face(MetaballBlock *block, int i1, int i2, int i3, int i4)
 {
   int *cur;
 
-#ifdef USE_ACCUM_NORMAL
-  float n[3];
-#endif
-
-  if (UNLIKELY(process->totindex == process->curindex)) {
-    process->totindex += 4096;
-    process->indices = MEM_reallocN(process->indices, sizeof(int[4]) * process->totindex);
+  if (UNLIKELY(block->totindex == block->curindex)) {
+    block->totindex += 256;
+    block->indices = MEM_reallocN(block->indices, sizeof(int[4]) * block->totindex);
   }
 
-  cur = process->indices[process->curindex++];
+  cur = block->indices[block->curindex++];
 
   /* displists now support array drawing, we treat tri's as fake quad */
 
@@ -459,8 +483,14 @@ static void make_face(PROCESS *process, int i1, int i2, int i3, int i4)
   cur[1] = i2;
   cur[2] = i3;
   cur[3] = i4;
+}
 
 #ifdef USE_ACCUM_NORMAL
+static void accumulate_face_normal(PROCESS *process, const int face[4])
+{
+  const int i1 = face[0], i2 = face[1], i3 = face[2], i4 = face[3];
+  float n[3];
+
   if (i4 == i3) {
     normal_tri_v3(n, process->co[i1], process->co[i2], process->co[i3]);
     accumulate_vertex_normals_v3(process->no[i1],
@@ -485,27 +515,32 @@ static void make_face(PROCESS *process, int i1, int i2, int i3, int i4)
                                  process->co[i3],
                                  process->co[i4]);
   }
-#endif
 }
+#endif
 
 /* Frees allocated memory */
 static void freepolygonize(PROCESS *process)
 {
-  if (process->corners) {
-    MEM_freeN(process->corners);
+  for (uint i = 0; i < process->curblock; i++) {
+    MetaballBlock *block = process->blocks[i];
+    MEM_SAFE_FREE(block->exits);
+    MEM_SAFE_FREE(block->indices);
+    MEM_SAFE_FREE(block->co);
+    MEM_SAFE_FREE(block->no);
+    MEM_SAFE_FREE(block->vert_edges);
+  }
+  if (process->blocks) {
+    MEM_freeN(process->blocks);
   }
-  if (process->edges) {
-    MEM_freeN(process->edges);
+  if (process->queue) {
+    MEM_freeN(process->queue);
   }
-  if (process->centers) {
-    MEM_freeN(process->centers);
+  if (process->blocks_hash) {
+    BLI_ghash_free(process->blocks_hash, NULL, NULL);
   }
   if (process->mainb) {
     MEM_freeN(process->mainb);
   }
-  if (process->bvh_queue) {
-    MEM_freeN(process->bvh_queue);
-  }
   if (process->pgn_elements) {
     BLI_memarena_free(process->pgn_elements);
   }
@@ -591,40 +626,76 @@ static int rightface[12] = {
 };
 /* face on right when going corner1 to corner2 */
 
+/**
+ * return the function value of the corner at the given lattice location (relative to the block),
+ * computing it if it wasn't cached yet
+ */
+static float corner_value(const PROCESS *process,
+                          MetaballBlock *block,
+                          const MetaballBVHNode **bvh_queue,
+                          const int i,
+                          const int j,
+                          const int k)
+{
+  float *value = &block->corner_values[MB_BLOCK_CORNER_INDEX(i, j, k)];
+
+  if (*value == MB_CORNER_UNSET) {
+    const float x = ((float)(block->lbn[0] + i) - 0.5f) * process->size;
+    const float y = ((float)(block->lbn[1] + j) - 0.5f) * process->size;
+    const float z = ((float)(block->lbn[2] + k) - 0.5f) * process->size;
+
+    *value = metaball(process, bvh_queue, x, y, z);
+  }
+
+  return *value;
+}
+
 /**
  * triangulate the cube directly, without decomposition
  */
-static void docube(PROCESS *process, CUBE *cube)
+static void docube(const PROCESS *process,
+                   MetaballBlock *block,
+                   const MetaballBVHNode **bvh_queue,
+                   const int cube_index)
 {
   INTLISTS *polys;
-  CORNER *c1, *c2;
   int i, index = 0, count, indexar[8];
+  int cube[3];
+
+  cube[0] = cube_index / (MB_BLOCK_SIZE * MB_BLOCK_SIZE);
+  cube[1] = (cube_index / MB_BLOCK_SIZE) % MB_BLOCK_SIZE;
+  cube[2] = cube_index % MB_BLOCK_SIZE;
 
   /* Determine which case cube falls into. */
   for (i = 0; i < 8; i++) {
-    if (cube->corners[i]->value > 0.0f) {
+    if (corner_value(process,
+                     block,
+                     bvh_queue,
+                     cube[0] + MB_BIT(i, 2),
+                     cube[1] + MB_BIT(i, 1),
+                     cube[2] + MB_BIT(i, 0)) > 0.0f) {
       index += (1 << i);
     }
   }
 
   /* Using faces[] table, adds neighboring cube if surface intersects face in this direction. */
   if (MB_BIT(faces[index], 0)) {
-    add_cube(process, cube->i - 1, cube->j, cube->k);
+    add_cube(block, cube[0] - 1, cube[1], cube[2]);
   }
   if (MB_BIT(faces[index], 1)) {
-    add_cube(process, cube->i + 1, cube->j, cube->k);
+    add_cube(block, cube[0] + 1, cube[1], cube[2]);
   }
   if (MB_BIT(faces[index], 2)) {
-    add_cube(process, cube->i, cube->j - 1, cube->k);
+    add_cube(block, cube[0], cube[1] - 1, cube[2]);
   }
   if (MB_BIT(faces[index], 3)) {
-    add_cube(process, cube->i, cube->j + 1, cube->k);
+    add_cube(block, cube[0], cube[1] + 1, cube[2]);
   }
   if (MB_BIT(faces[index], 4)) {
-    add_cube(process, cube->i, cube->j, cube->k - 1);
+    add_cube(block, cube[0], cube[1], cube[2] - 1);
   }
   if (MB_BIT(faces[index], 5)) {
-    add_cube(process, cube->i, cube->j, cube->k + 1);
+    add_cube(block, cube[0], cube[1], cube[2] + 1);
   }
 
   /* Using cubetable[], determines polygons for output. */
@@ -634,10 +705,8 @@ static void docube(PROCESS *process, CUBE *cube)
     count = 0;
     /* Sets needed vertex id's lying on the edges. */
     for (edges = polys->list; edges; edges = edges->next) {
-      c1 = cube->corners[corner1[edges->i]];
-      c2 = cube->corners[corner2[edges->i]];
-
-      indexar[count] = vertid(process, c1, c2);
+      indexar[count] = vertid(
+          process, block, bvh_queue, cube, corner1[edges->i], corner2[edges->i]);
       count++;
     }
 
@@ -645,66 +714,29 @@ static void docube(PROCESS *process, CUBE *cube)
     if (count > 2) {
       switch (count) {
         case 3:
-          make_face(process, indexar[2], indexar[1], indexar[0], indexar[0]); /* triangle */
+          make_face(block, indexar[2], indexar[1], indexar[0], indexar[0]); /* triangle */
           break;
         case 4:
-          make_face(process, indexar[3], indexar[2], indexar[1], indexar[0]);
+          make_face(block, indexar[3], indexar[2], indexar[1], indexar[0]);
           break;
         case 5:
-          make_face(process, indexar[3], indexar[2], indexar[1], indexar[0]);
-          make_face(process, indexar[4], indexar[3], indexar[0], indexar[0]); /* triangle */
+          make_face(block, indexar[3], indexar[2], indexar[1], indexar[0]);
+          make_face(block, indexar[4], indexar[3], indexar[0], indexar[0]); /* triangle */
           break;
         case 6:
-          make_face(process, indexar[3], indexar[2], indexar[1], indexar[0]);
-          make_face(process, indexar[5], indexar[4], indexar[3], indexar[0]);
+          make_face(block, indexar[3], indexar[2], indexar[1], indexar[0]);
+          make_face(block, indexar[5], indexar[4], indexar[3], indexar[0]);
           break;
         case 7:
-          make_face(process, indexar[3], indexar[2], indexar[1], indexar[0]);
-          make_face(process, indexar[5], indexar[4], indexar[3], indexar[0]);
-          make_face(process, indexar[6], indexar[5], indexar[0], indexar[0]); /* triangle */
+          make_face(block, indexar[3], indexar[2], indexar[1], indexar[0]);
+          make_face(block, indexar[5], indexar[4], indexar[3], indexar[0]);
+          make_face(block, indexar[6], indexar[5], indexar[0], indexar[0]); /* triangle */
           break;
       }
     }
   }
 }
 
-/**
- * return corner with the given lattice location
- * set (and cache) its function value
- */
-static CORNER *setcorner(PROCESS *process, int i, int j, int k)
-{
-  /* for speed, do corner value caching here */
-  CORNER *c;
-  int index;
-
-  /* does corner exist? */
-  index = HASH(i, j, k);
-  c = process->corners[index];
-
-  for (; c != NULL; c = c->next) {
-    if (c->i == i && c->j == j && c->k == k) {
-      return c;
-    }
-  }
-
-  c = BLI_memarena_alloc(process->pgn_elements, sizeof(CORNER));
-
-  c->i = i;
-  c->co[0] = ((float)i - 0.5f) * process->size;
-  c->j = j;
-  c->co[1] = ((float)j - 0.5f) * process->size;
-  c->k = k;
-  c->co[2] = ((float)k - 0.5f) * process->size;
-
-  c->value = metaball(process, c->co[0], c->co[1], c->co[2]);
-
-  c->next = process->corners[index];
-  process->corners[index] = c;
-
-  return c;
-}
-
 /**
  * return next clockwise edge from given edge around given face
  */
@@ -854,107 +886,120 @@ void BKE_mball_cubeTable_free(void)
 /**** Storage ****/
 
 /**
- * Inserts cube at lattice i, j, k into hash table, marking it as "done"
+ * Floor division of a lattice location by #MB_BLOCK_SIZE.
  */
-static int setcenter(PROCESS *process, CENTERLIST *table[], const int i, const int j, const int k)
+BLI_INLINE int lattice_to_block(const int i)
 {
-  int index;
-  CENTERLIST *newc, *l, *q;
+  return (i >= 0) ? (i / MB_BLOCK_SIZE) : ((i + 1) / MB_BLOCK_SIZE - 1);
+}
 
-  index = HASH(i, j, k);
-  q = table[index];
+/**
+ * \return the block containing cube at lattice i, j, k, creating it if needed.
+ */
+static MetaballBlock *block_ensure(PROCESS *process, const int i, const int j, const int k)
+{
+  const int key[4] = {lattice_to_block(i), lattice_to_block(j), lattice_to_block(k), 0};
+  MetaballBlock *block = BLI_ghash_lookup(process->blocks_hash, key);
 
-  for (l = q; l != NULL; l = l->next) {
-    if (l->i == i && l->j == j && l->k == k) {
-      return 1;
-    }
+  if (block) {
+    return block;
   }
 
-  newc = BLI_memarena_alloc(process->pgn_elements, sizeof(CENTERLIST));
-  newc->i = i;
-  newc->j = j;
-  newc->k = k;
-  newc->next = q;
-  table[index] = newc;
+  block = BLI_memarena_calloc(process->pgn_elements, sizeof(MetaballBlock));
+  copy_v4_v4_int(block->key, key);
+  block->lbn[0] = key[0] * MB_BLOCK_SIZE;
+  block->lbn[1] = key[1] * MB_BLOCK_SIZE;
+  block->lbn[2] = key[2] * MB_BLOCK_SIZE;
+
+  block->corner_values = BLI_memarena_alloc(process->pgn_elements,
+                                            sizeof(float) * MB_BLOCK_CORNERS_NUM);
+  copy_vn_fl(block->corner_values, MB_BLOCK_CORNERS_NUM, MB_CORNER_UNSET);
+  block->edges = BLI_memarena_alloc(process->pgn_elements, sizeof(int[3]) * MB_BLOCK_CORNERS_NUM);
+  copy_vn_i(block->edges, MB_BLOCK_CORNERS_NUM * 3, -1);
+  block->cubes_done = BLI_memarena_calloc(process->pgn_elements,
+                                          BLI_BITMAP_SIZE(MB_BLOCK_CUBES_NUM));
+  /* Every cube is put on the stack once at most. */
+  block->cubes = BLI_memarena_alloc(process->pgn_elements, sizeof(int) * MB_BLOCK_CUBES_NUM);
+
+  if (UNLIKELY(process->curblock == process->totblock)) {
+    process->totblock += 256;
+    process->blocks = MEM_reallocN(process->blocks, sizeof(MetaballBlock *) * process->totblock);
+    process->queue = MEM_reallocN(process->queue, sizeof(MetaballBlock *) * process->totblock);
+  }
+  process->blocks[process->curblock++] = block;
 
-  return 0;
+  BLI_ghash_insert(process->blocks_hash, block->key, block);
+
+  return block;
 }
 
 /**
- * Sets vid of vertex lying on given edge.
+ * Puts cube (local to the block) on the stack of the block, unless it has been found before.
  */
-static void setedge(PROCESS *process, int i1, int j1, int k1, int i2, int j2, int k2, int vid)
+static bool block_push_cube(MetaballBlock *block, const int cube_index)
 {
-  int index;
-  EDGELIST *newe;
-
-  if (i1 > i2 || (i1 == i2 && (j1 > j2 || (j1 == j2 && k1 > k2)))) {
-    int t = i1;
-    i1 = i2;
-    i2 = t;
-    t = j1;
-    j1 = j2;
-    j2 = t;
-    t = k1;
-    k1 = k2;
-    k2 = t;
-  }
-  index = HASH(i1, j1, k1) + HASH(i2, j2, k2);
-  newe = BLI_memarena_alloc(process->pgn_elements, sizeof(EDGELIST));
-
-  newe->i1 = i1;
-  newe->j1 = j1;
-  newe->k1 = k1;
-  newe->i2 = i2;
-  newe->j2 = j2;
-  newe->k2 = k2;
-  newe->vid = vid;
-  newe->next = process->edges[index];
-  process->edges[index] = newe;
+  if (BLI_BITMAP_TEST(block->cubes_done, cube_index)) {
+    return false;
+  }
+  BLI_BITMAP_ENABLE(block->cubes_done, cube_index);
+  block->cubes[block->curcube++] = cube_index;
+  return true;
 }
 
 /**
- * \return vertex id for edge; return -1 if not set
+ * Adds cube at lattice i, j, k to the stack of its block and queues the block.
  */
-static int getedge(EDGELIST *table[], int i1, int j1, int k1, int i2, int j2, int k2)
+static void process_add_cube(PROCESS *process, const int i, const int j, const int k)
 {
-  EDGELIST *q;
-
-  if (i1 > i2 || (i1 == i2 && (j1 > j2 || (j1 == j2 && k1 > k2)))) {
-    int t = i1;
-    i1 = i2;
-    i2 = t;
-    t = j1;
-    j1 = j2;
-    j2 = t;
-    t = k1;
-    k1 = k2;
-    k2 = t;
-  }
-  q = table[HASH(i1, j1, k1) + HASH(i2, j2, k2)];
-  for (; q != NULL; q = q->next) {
-    if (q->i1 == i1 && q->j1 == j1 && q->k1 == k1 && q->i2 == i2 && q->j2 == j2 && q->k2 == k2) {
-      return q->vid;
-    }
+  MetaballBlock *block = block_ensure(process, i, j, k);
+  const int cube_index = MB_BLOCK_CUBE_INDEX(
+      i - block->lbn[0], j - block->lbn[1], k - block->lbn[2]);
+
+  if (block_push_cube(block, cube_index) && !block->in_queue) {
+    block->in_queue = true;
+    process->queue[process->queue_len++] = block;
   }
-  return -1;
+}
+
+/**
+ * Adds cube at lattice location i, j, k (relative to the block) to the cube stack of the block.
+ * Cubes outside of the block are stored as exits, they're added to their own block afterwards.
+ */
+static void add_cube(MetaballBlock *block, int i, int j, int k)
+{
+  if (i >= 0 && i < MB_BLOCK_SIZE && j >= 0 && j < MB_BLOCK_SIZE && k >= 0 && k < MB_BLOCK_SIZE) {
+    block_push_cube(block, MB_BLOCK_CUBE_INDEX(i, j, k));
+    return;
+  }
+
+  if (UNLIKELY(block->totexit == block->curexit)) {
+    block->totexit += 64;
+    block->exits = MEM_reallocN(block->exits, sizeof(int[3]) * block->totexit);
+  }
+
+  block->exits[block->curexit][0] = block->lbn[0] + i;
+  block->exits[block->curexit][1] = block->lbn[1] + j;
+  block->exits[block->curexit][2] = block->lbn[2] + k;
+  block->curexit++;
 }
 
 /**
  * Adds a vertex, expands memory if needed.
  */
-static void addtovertices(PROCESS *process, const float v[3], const float no[3])
+static int addtovertices(MetaballBlock *block, const float v[3], const float no[3], const int edge)
 {
-  if (process->curvertex == process->totvertex) {
-    process->totvertex += 4096;
-    process->co = MEM_reallocN(process->co, process->totvertex * sizeof(float[3]));
-    process->no = MEM_reallocN(process->no, process->totvertex * sizeof(float[3]));
+  if (block->curvertex == block->totvertex) {
+    block->totvertex += 256;
+    block->co = MEM_reallocN(block->co, block->totvertex * sizeof(float[3]));
+    block->no = MEM_reallocN(block->no, block->totvertex * sizeof(float[3]));
+    block->vert_edges = MEM_reallocN(block->vert_edges, block->totvertex * sizeof(int));
   }
 
-  copy_v3_v3(process->co[process->curvertex], v);
-  copy_v3_v3(process->no[process->curvertex], no);
+  copy_v3_v3(block->co[block->curvertex], v);
+  copy_v3_v3(block->no[block->curvertex], no);
+  block->vert_edges[block->curvertex] = edge;
 
-  process->curvertex++;
+  return (int)block->curvertex++;
 }
 
 #ifndef USE_ACCUM_NORMAL
@@ -963,42 +1008,63 @@ static void addtovertices(PROCESS *process, const float v[3], const float no[3])
  *
  * \note Doesn't do normalization!
  */
-static void vnormal(PROCESS *process, const float point[3], float r_no[3])
+static void vnormal(const PROCESS *process,
+                    const MetaballBVHNode **bvh_queue,
+                    const float point[3],
+                    float r_no[3])
 {
   const float delta = process->delta;
-  const float f = metaball(process, point[0], point[1], point[2]);
+  const float f = metaball(process, bvh_queue, point[0], point[1], point[2]);
 
-  r_no[0] = metaball(process, point[0] + delta, point[1], point[2]) - f;
-  r_no[1] = metaball(process, point[0], point[1] + delta, point[2]) - f;
-  r_no[2] = metaball(process, point[0], point[1], point[2] + delta) - f;
+  r_no[0] = metaball(process, bvh_queue, point[0] + delta, point[1], point[2]) - f;
+  r_no[1] = metaball(process, bvh_queue, point[0], point[1] + delta, point[2]) - f;
+  r_no[2] = metaball(process, bvh_queue, point[0], point[1], point[2] + delta) - f;
 }
 #endif /* USE_ACCUM_NORMAL */
 
 /**
- * \return the id of vertex between two corners.
+ * \return the id (local to the block) of vertex between corners c1 and c2 of the cube.
  *
- * If it wasn't previously computed, does #converge() and adds vertex to process.
+ * If it wasn't previously computed, does #converge() and adds vertex to the block.
  */
-static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2)
+static int vertid(const PROCESS *process,
+                  MetaballBlock *block,
+                  const MetaballBVHNode **bvh_queue,
+                  const int cube[3],
+                  int c1,
+                  int c2)
 {
+  const int co1[3] = {cube[0] + MB_BIT(c1, 2), cube[1] + MB_BIT(c1, 1), cube[2] + MB_BIT(c1, 0)};
+  const int co2[3] = {cube[0] + MB_BIT(c2, 2), cube[1] + MB_BIT(c2, 1), cube[2] + MB_BIT(c2, 0)};
+  /* Corners of an edge differ in a single bit, the lower corner has the lower id. */
+  const int *lower = (c1 < c2) ? co1 : co2;
+  const int axis = (co1[0] != co2[0]) ? 0 : ((co1[1] != co2[1]) ? 1 : 2);
+  const int edge = MB_BLOCK_EDGE_INDEX(lower[0], lower[1], lower[2], axis);
+  CORNER corner_a, corner_b;
   float v[3], no[3];
-  int vid = getedge(process->edges, c1->i, c1->j, c1->k, c2->i, c2->j, c2->k);
+  int vid = block->edges[edge];
 
   if (vid != -1) {
     return vid; /* previously computed */
   }
 
-  converge(process, c1, c2, v); /* position */
+  for (int i = 0; i < 3; i++) {
+    corner_a.co[i] = ((float)(block->lbn[i] + co1[i]) - 0.5f) * process->size;
+    corner_b.co[i] = ((float)(block->lbn[i] + co2[i]) - 0.5f) * process->size;
+  }
+  corner_a.value = block->corner_values[MB_BLOCK_CORNER_INDEX(co1[0], co1[1], co1[2])];
+  corner_b.value = block->corner_values[MB_BLOCK_CORNER_INDEX(co2[0], co2[1], co2[2])];
+
+  converge(process, bvh_queue, &corner_a, &corner_b, v); /* position */
 
 #ifdef USE_ACCUM_NORMAL
   zero_v3(no);
 #else
-  vnormal(process, v, no);
+  vnormal(process, bvh_queue, v, no);
 #endif
 
-  addtovertices(process, v, no); /* save vertex */
-  vid = (int)process->curvertex - 1;
-  setedge(process, c1->i, c1->j, c1->k, c2->i, c2->j, c2->k, vid);
+  vid = addtovertices(block, v, no, edge); /* save vertex */
+  block->edges[edge] = vid;
 
   return vid;
 }
@@ -1007,7 +1073,11 @@ static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2)
  * Given two corners, computes approximation of surface intersection point between them.
  * In case of small threshold, do bisection.
  */
-static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float r_p[3])
+static void converge(const PROCESS *process,
+                     const MetaballBVHNode **bvh_queue,
+                     const CORNER *c1,
+                     const CORNER *c2,
+                     float r_p[3])
 {
   float c1_value, c1_co[3];
   float c2_value, c2_co[3];
@@ -1027,7 +1097,7 @@ static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float
 
   for (uint i = 0; i < process->converge_res; i++) {
     interp_v3_v3v3(r_p, c1_co, c2_co, 0.5f);
-    float dens = metaball(process, r_p[0], r_p[1], r_p[2]);
+    float dens = metaball(process, bvh_queue, r_p[0], r_p[1], r_p[2]);
 
     if (dens > 0.0f) {
       c1_value = dens;
@@ -1043,33 +1113,6 @@ static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float
   interp_v3_v3v3(r_p, c1_co, c2_co, tmp);
 }
 
-/**
- * Adds cube at given lattice position to cube stack of process.
- */
-static void add_cube(PROCESS *process, int i, int j, int k)
-{
-  CUBES *ncube;
-  int n;
-
-  /* test if cube has been found before */
-  if (setcenter(process, process->centers, i, j, k) == 0) {
-    /* push cube on stack: */
-    ncube = BLI_memarena_alloc(process->pgn_elements, sizeof(CUBES));
-    ncube->next = process->cubes;
-    process->cubes = ncube;
-
-    ncube->cube.i = i;
-    ncube->cube.j = j;
-    ncube->cube.k = k;
-
-    /* set corners of initial cube: */
-    for (n = 0; n < 8; n++) {
-      ncube->cube.corners[n] = setcorner(
-          process, i + MB_BIT(n, 2), j + MB_BIT(n, 1), k + MB_BIT(n, 0));
-    }
-  }
-}
-
 static void next_lattice(int r[3], const float pos[3], const float size)
 {
   r[0] = (int)ceil((pos[0] / size) + 0.5f);
@@ -1090,14 +1133,33 @@ static void closest_latice(int r[3], const float pos[3], const float size)
   r[2] = (int)floorf(pos[2] / size + 1.0f);
 }
 
+static float lattice_value(const PROCESS *process,
+                           const MetaballBVHNode **bvh_queue,
+                           const int i,
+                           const int j,
+                           const int k)
+{
+  return metaball(process,
+                  bvh_queue,
+                  ((float)i - 0.5f) * process->size,
+                  ((float)j - 0.5f) * process->size,
+                  ((float)k - 0.5f) * process->size);
+}
+
 /**
  * Find at most 26 cubes to start polygonization from.
+ *
+ * \return the number of cubes written to \a r_cubes.
  */
-static void find_first_points(PROCESS *process, const unsigned int em)
+static int find_first_points(const PROCESS *process,
+                             const MetaballBVHNode **bvh_queue,
+                             const unsigned int em,
+                             int r_cubes[26][3])
 {
   const MetaElem *ml;
   int center[3], lbn[3], rtf[3], it[3], dir[3], add[3];
-  float tmp[3], a, b;
+  float tmp[3], a, b, center_value;
+  int cubes_len = 0;
 
   ml = process->mainb[em];
 
@@ -1106,6 +1168,8 @@ static void find_first_points(PROCESS *process, const unsigned int em)
   prev_lattice(lbn, ml->bb->vec[0], process->size);
   next_lattice(rtf, ml->bb->vec[6], process->size);
 
+  center_value = lattice_value(process, bvh_queue, center[0], center[1], center[2]);
+
   for (dir[0] = -1; dir[0] <= 1; dir[0]++) {
     for (dir[1] = -1; dir[1] <= 1; dir[1]++) {
       for (dir[2] = -1; dir[2] <= 1; dir[2]++) {
@@ -1115,20 +1179,20 @@ static void find_first_points(PROCESS *process, const unsigned int em)
 
         copy_v3_v3_int(it, center);
 
-        b = setcorner(process, it[0], it[1], it[2])->value;
+        b = center_value;
         do {
           it[0] += dir[0];
           it[1] += dir[1];
           it[2] += dir[2];
           a = b;
-          b = setcorner(process, it[0], it[1], it[2])->value;
+          b = lattice_value(process, bvh_queue, it[0], it[1], it[2]);
 
           if (a * b < 0.0f) {
             add[0] = it[0] - dir[0];
             add[1] = it[1] - dir[1];
             add[2] = it[2] - dir[2];
             DO_MIN(it, add);
-            add_cube(process, add[0], add[1], add[2]);
+            copy_v3_v3_int(r_cubes[cubes_len++], add);
             break;
           }
         } while ((it[0] > lbn[0]) && (it[1] > lbn[1]) && (it[2] > lbn[2]) && (it[0] < rtf[0]) &&
@@ -1136,36 +1200,247 @@ static void find_first_points(PROCESS *process, const unsigned int em)
       }
     }
   }
+
+  return cubes_len;
+}
+
+/**** Threading ****/
+
+typedef struct PolygonizeData {
+  const PROCESS *process;
+
+  /* Used when finding first points. */
+  int (*first_cubes)[26][3];
+  int *first_cubes_len;
+
+  /* Used when polygonizing blocks. */
+  MetaballBlock **blocks;
+} PolygonizeData;
+
+typedef struct PolygonizeTLS {
+  const MetaballBVHNode **bvh_queue;
+} PolygonizeTLS;
+
+static const MetaballBVHNode **polygonize_bvh_queue_ensure(const PROCESS *process,
+                                                           PolygonizeTLS *tls)
+{
+  if (tls->bvh_queue == NULL) {
+    tls->bvh_queue = MEM_mallocN(sizeof(MetaballBVHNode *) * process->bvh_queue_size,
+                                 "Metaball BVH Queue");
+  }
+  return tls->bvh_queue;
+}
+
+static void polygonize_tls_free(const void *__restrict UNUSED(userdata), void *__restrict chunk)
+{
+  PolygonizeTLS *tls = chunk;
+  MEM_SAFE_FREE(tls->bvh_queue);
+}
+
+static void find_first_points_cb(void *__restrict userdata,
+                                 const int em,
+                                 const TaskParallelTLS *__restrict tls)
+{
+  PolygonizeData *data = userdata;
+  const MetaballBVHNode **bvh_queue = polygonize_bvh_queue_ensure(data->process,
+                                                                  tls->userdata_chunk);
+
+  data->first_cubes_len[em] = find_first_points(
+      data->process, bvh_queue, (unsigned int)em, data->first_cubes[em]);
+}
+
+static void polygonize_block_cb(void *__restrict userdata,
+                                const int index,
+                                const TaskParallelTLS *__restrict tls)
+{
+  PolygonizeData *data = userdata;
+  MetaballBlock *block = data->blocks[index];
+  const MetaballBVHNode **bvh_queue = polygonize_bvh_queue_ensure(data->process,
+                                                                  tls->userdata_chunk);
+
+  while (block->curcube != 0) {
+    docube(data->process, block, bvh_queue, block->cubes[--block->curcube]);
+  }
 }
 
 /**
- * The main polygonization proc.
- * Allocates memory, makes cubetable,
- * finds starting surface points
- * and processes cubes on the stack until none left.
+ * Finds starting surface points of all elements in parallel and puts their cubes on the stacks.
  */
-static void polygonize(PROCESS *process)
+static void polygonize_first_points(PROCESS *process)
 {
-  CUBE c;
+  PolygonizeData data = {
+      .process = process,
+      .first_cubes = MEM_mallocN(sizeof(int[26][3]) * process->totelem, __func__),
+      .first_cubes_len = MEM_mallocN(sizeof(int) * process->totelem, __func__),
+  };
+  PolygonizeTLS tls = {NULL};
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 16;
+  settings.userdata_chunk = &tls;
+  settings.userdata_chunk_size = sizeof(tls);
+  settings.func_free = polygonize_tls_free;
+  BLI_task_parallel_range(0, (int)process->totelem, &data, find_first_points_cb, &settings);
+
+  /* Add cubes in order, so the result doesn't depend on threading. */
+  for (uint em = 0; em < process->totelem; em++) {
+    for (int i = 0; i < data.first_cubes_len[em]; i++) {
+      const int *cube = data.first_cubes[em][i];
+      process_add_cube(process, cube[0], cube[1], cube[2]);
+    }
+  }
 
-  process->centers = MEM_callocN(HASHSIZE * sizeof(CENTERLIST *), "mbproc->centers");
-  process->corners = MEM_callocN(HASHSIZE * sizeof(CORNER *), "mbproc->corners");
-  process->edges = MEM_callocN(2 * HASHSIZE * sizeof(EDGELIST *), "mbproc->edges");
-  process->bvh_queue = MEM_callocN(sizeof(MetaballBVHNode *) * process->bvh_queue_size,
-                                   "Metaball BVH Queue");
+  MEM_freeN(data.first_cubes);
+  MEM_freeN(data.first_cubes_len);
+}
 
-  makecubetable();
+/**
+ * Polygonizes all queued blocks in parallel, until the surface doesn't reach any more cubes.
+ *
+ * Each block only follows the surface within its own cubes, cubes reached in neighbor blocks
+ * are added to their block (which is queued again) once all blocks of a pass are done.
+ */
+static void polygonize_blocks(PROCESS *process)
+{
+  PolygonizeData data = {.process = process};
+  PolygonizeTLS tls = {NULL};
+
+  while (process->queue_len != 0) {
+    const unsigned int blocks_len = process->queue_len;
+    data.blocks = MEM_mallocN(sizeof(MetaballBlock *) * blocks_len, __func__);
+    memcpy(data.blocks, process->queue, sizeof(MetaballBlock *) * blocks_len);
+    process->queue_len = 0;
 
-  for (uint i = 0; i < process->totelem; i++) {
-    find_first_points(process, i);
+    for (uint i = 0; i < blocks_len; i++) {
+      data.blocks[i]->in_queue = false;
+    }
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 1;
+    settings.userdata_chunk = &tls;
+    settings.userdata_chunk_size = sizeof(tls);
+    settings.func_free = polygonize_tls_free;
+    BLI_task_parallel_range(0, (int)blocks_len, &data, polygonize_block_cb, &settings);
+
+    for (uint i = 0; i < blocks_len; i++) {
+      MetaballBlock *block = data.blocks[i];
+      for (uint e = 0; e < block->curexit; e++) {
+        process_add_cube(process, block->exits[e][0], block->exits[e][1], block->exits[e][2]);
+      }
+      block->curexit = 0;
+    }
+
+    MEM_freeN(data.blocks);
   }
+}
+
+/**
+ * Joins the vertices and faces of all blocks into the output arrays.
+ * Vertices on the faces of a block may have been computed by neighbor blocks too,
+ * they're merged by their lattice edge.
+ */
+static void polygonize_join_blocks(PROCESS *process)
+{
+  unsigned int totvertex = 0, totindex = 0;
+
+  for (uint b = 0; b < process->curblock; b++) {
+    totvertex += process->blocks[b]->curvertex;
+    totindex += process->blocks[b]->curindex;
+  }
+
+  if (totindex == 0) {
+    return;
+  }
+
+  GHash *edges_hash = BLI_ghash_new(
+      BLI_ghashutil_inthash_v4_p, BLI_ghashutil_inthash_v4_cmp, __func__);
+  int(*edge_keys)[4] = MEM_mallocN(sizeof(int[4]) * totvertex, __func__);
+  int *vert_map = MEM_mallocN(sizeof(int) * totvertex, __func__);
+  unsigned int edge_keys_len = 0;
+
+  process->co = MEM_mallocN(sizeof(float[3]) * totvertex, "mball co");
+  process->no = MEM_mallocN(sizeof(float[3]) * totvertex, "mball no");
+  process->indices = MEM_mallocN(sizeof(int[4]) * totindex, "mball indices");
+
+  for (uint b = 0; b < process->curblock; b++) {
+    MetaballBlock *block = process->blocks[b];
+
+    for (uint v = 0; v < block->curvertex; v++) {
+      const int edge = block->vert_edges[v];
+      const int axis = edge % 3;
+      const int corner_index = edge / 3;
+      const int co[3] = {
+          corner_index / (MB_BLOCK_CORNERS * MB_BLOCK_CORNERS),
+          (corner_index / MB_BLOCK_CORNERS) % MB_BLOCK_CORNERS,
+          corner_index % MB_BLOCK_CORNERS,
+      };
+      bool is_shared = false;
+
+      for (int i = 0; i < 3; i++) {
+        if (i != axis && ELEM(co[i], 0, MB_BLOCK_SIZE)) {
+          is_shared = true;
+        }
+      }
+
+      if (is_shared) {
+        int *key = edge_keys[edge_keys_len++];
+        void **val_p;
+
+        key[0] = block->lbn[0] + co[0];
+        key[1] = block->lbn[1] + co[1];
+        key[2] = block->lbn[2] + co[2];
+        key[3] = axis;
+
+        if (BLI_ghash_ensure_p(edges_hash, key, &val_p)) {
+          /* Computed by another block, the position is exactly the same. */
+          vert_map[v] = POINTER_AS_INT(*val_p);
+          continue;
+        }
+        *val_p = POINTER_FROM_INT(process->curvertex);
+      }
 
-  while (process->cubes != NULL) {
-    c = process->cubes->cube;
-    process->cubes = process->cubes->next;
+      vert_map[v] = (int)process->curvertex;
+      copy_v3_v3(process->co[process->curvertex], block->co[v]);
+      copy_v3_v3(process->no[process->curvertex], block->no[v]);
+      process->curvertex++;
+    }
 
-    docube(process, &c);
+    for (uint f = 0; f < block->curindex; f++) {
+      int *cur = process->indices[process->curindex++];
+      for (int i = 0; i < 4; i++) {
+        cur[i] = vert_map[block->indices[f][i]];
+      }
+    }
   }
+
+#ifdef USE_ACCUM_NORMAL
+  for (uint f = 0; f < process->curindex; f++) {
+    accumulate_face_normal(process, process->indices[f]);
+  }
+#endif
+
+  BLI_ghash_free(edges_hash, NULL, NULL);
+  MEM_freeN(edge_keys);
+  MEM_freeN(vert_map);
+}
+
+/**
+ * The main polygonization proc.
+ * Makes cubetable, finds starting surface points
+ * and processes cubes on the stacks of the blocks until none left.
+ */
+static void polygonize(PROCESS *process)
+{
+  makecubetable();
+
+  process->blocks_hash = BLI_ghash_new(
+      BLI_ghashutil_inthash_v4_p, BLI_ghashutil_inthash_v4_cmp, "Metaball blocks");
+
+  polygonize_first_points(process);
+  polygonize_blocks(process);
+  polygonize_join_blocks(process);
 }
 
 /**
@@ -381,10 +381,10 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
 
 void BKE_mesh_ensure_normals(Mesh *mesh)
 {
-  if (mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) {
+  if (mesh->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY) {
     BKE_mesh_calc_normals(mesh);
   }
-  BLI_assert((mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) == 0);
+  BLI_assert((mesh->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY) == 0);
 }
 
 /**
@@ -408,7 +408,7 @@ void BKE_mesh_ensure_normals_for_display(Mesh *mesh)
   }
 
   float(*poly_nors)[3] = CustomData_get_layer(&mesh->pdata, CD_NORMAL);
-  const bool do_vert_normals = (mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) != 0;
+  const bool do_vert_normals = (mesh->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY) != 0;
   const bool do_poly_normals = (mesh->runtime.cd_dirty_poly & CD_MASK_NORMAL || poly_nors == NULL);
 
   if (do_vert_normals || do_poly_normals) {
@@ -432,7 +432,9 @@ void BKE_mesh_ensure_normals_for_display(Mesh *mesh)
       CustomData_add_layer(&mesh->pdata, CD_NORMAL, CD_ASSIGN, poly_nors, mesh->totpoly);
     }
 
-    mesh->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
+    atomic_fetch_and_and_char(
+        &mesh->runtime.cache_flag,
+        (char)~(MESH_RUNTIME_NORMALS_DIRTY | MESH_RUNTIME_VERT_NORMALS_VALID));
     mesh->runtime.cd_dirty_poly &= ~CD_MASK_NORMAL;
   }
 }
@@ -456,7 +458,9 @@ void BKE_mesh_calc_normals(Mesh *mesh)
 #ifdef DEBUG_TIME
   TIMEIT_END_AVERAGED(BKE_mesh_calc_normals);
 #endif
-  mesh->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
+  atomic_fetch_and_and_char(
+      &mesh->runtime.cache_flag,
+      (char)~(MESH_RUNTIME_NORMALS_DIRTY | MESH_RUNTIME_VERT_NORMALS_VALID));
 }
 
 void BKE_mesh_calc_normals_looptri(MVert *mverts,
@@ -775,7 +779,7 @@ void BKE_lnor_space_custom_normal_to_data(MLoopNorSpace *lnor_space,
 typedef struct LoopSplitTaskData {
   /* Specific to each instance (each task). */
 
-  /** We have to create those outside of tasks, since afaik memarena is not threadsafe. */
+  /** Allocated for all fans at once, see #loop_split_generator. */
   MLoopNorSpace *lnor_space;
   float (*lnor)[3];
   const MLoop *ml_curr;
@@ -786,7 +790,7 @@ typedef struct LoopSplitTaskData {
   const int *e2l_prev;
   int mp_index;
 
-  /** This one is special, it's owned and managed by worker tasks,
+  /** This one is special, it's owned and managed by worker threads,
    * avoid to have to create it for each fan! */
   BLI_Stack *edge_vectors;
 
@@ -927,6 +931,125 @@ static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Threaded Edge Sharpness
+ *
+ * Same result as #mesh_edges_sharp_tag without tagging edges, computed in two threaded passes:
+ * first every loop registers itself to its edge, then the sharpness of each edge is computed from
+ * its first two loops (in polygon order).
+ * \{ */
+
+typedef struct EdgesSharpCalcData {
+  const LoopSplitTaskDataCommon *common_data;
+  /* Number of loops using each edge. */
+  int *edge_users;
+  bool check_angle;
+  float split_angle_cos;
+} EdgesSharpCalcData;
+
+static void mesh_edges_sharp_calc_loops_cb(void *__restrict userdata,
+                                           const int mp_index,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const EdgesSharpCalcData *data = userdata;
+  const LoopSplitTaskDataCommon *common_data = data->common_data;
+  const MVert *mverts = common_data->mverts;
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mp = &common_data->mpolys[mp_index];
+  float(*loopnors)[3] = common_data->loopnors; /* Note: loopnors may be NULL here. */
+  int(*edge_to_loops)[2] = common_data->edge_to_loops;
+
+  const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+  for (int ml_curr_index = mp->loopstart; ml_curr_index <= ml_last_index; ml_curr_index++) {
+    const MLoop *ml_curr = &mloops[ml_curr_index];
+
+    common_data->loop_to_poly[ml_curr_index] = mp_index;
+
+    /* Pre-populate all loop normals as if their verts were all-smooth,
+     * this way we don't have to compute those later! */
+    if (loopnors) {
+      normal_short_to_float_v3(loopnors[ml_curr_index], mverts[ml_curr->v].no);
+    }
+
+    /* Only the first two loops of an edge are needed, more always makes it sharp. */
+    const int user = atomic_fetch_and_add_int32(&data->edge_users[ml_curr->e], 1);
+    if (user < 2) {
+      edge_to_loops[ml_curr->e][user] = ml_curr_index;
+    }
+  }
+}
+
+static void mesh_edges_sharp_calc_edges_cb(void *__restrict userdata,
+                                           const int me_index,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const EdgesSharpCalcData *data = userdata;
+  const LoopSplitTaskDataCommon *common_data = data->common_data;
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mpolys = common_data->mpolys;
+  const int *loop_to_poly = common_data->loop_to_poly;
+  int *e2l = common_data->edge_to_loops[me_index];
+  const int users = data->edge_users[me_index];
+
+  if (users == 0) {
+    /* Loose edge, both values are left to 0. */
+    return;
+  }
+  if (users == 1) {
+    e2l[1] = (mpolys[loop_to_poly[e2l[0]]].flag & ME_SMOOTH) ? INDEX_UNSET : INDEX_INVALID;
+    return;
+  }
+  if (users > 2) {
+    e2l[1] = INDEX_INVALID;
+    return;
+  }
+
+  /* Order both loops the way they are found when iterating over polygons. */
+  if ((loop_to_poly[e2l[0]] > loop_to_poly[e2l[1]]) ||
+      (loop_to_poly[e2l[0]] == loop_to_poly[e2l[1]] && e2l[0] > e2l[1])) {
+    SWAP(int, e2l[0], e2l[1]);
+  }
+
+  const int mp_index_first = loop_to_poly[e2l[0]];
+  const int mp_index = loop_to_poly[e2l[1]];
+
+  /* See #mesh_edges_sharp_tag for details. */
+  if (!(mpolys[mp_index_first].flag & ME_SMOOTH) || !(mpolys[mp_index].flag & ME_SMOOTH) ||
+      (common_data->medges[me_index].flag & ME_SHARP) ||
+      mloops[e2l[0]].v == mloops[e2l[1]].v ||
+      (data->check_angle && dot_v3v3(common_data->polynors[mp_index_first],
+                                     common_data->polynors[mp_index]) < data->split_angle_cos)) {
+    e2l[1] = INDEX_INVALID;
+  }
+}
+
+static void mesh_edges_sharp_calc(LoopSplitTaskDataCommon *common_data,
+                                  const bool check_angle,
+                                  const float split_angle)
+{
+  EdgesSharpCalcData data = {
+      .common_data = common_data,
+      .edge_users = MEM_calloc_arrayN(
+          (size_t)common_data->numEdges, sizeof(*data.edge_users), __func__),
+      .check_angle = check_angle,
+      .split_angle_cos = check_angle ? cosf(split_angle) : -1.0f,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (common_data->numLoops >= LOOP_SPLIT_TASK_BLOCK_SIZE * 8);
+  settings.min_iter_per_thread = LOOP_SPLIT_TASK_BLOCK_SIZE;
+
+  BLI_task_parallel_range(
+      0, common_data->numPolys, &data, mesh_edges_sharp_calc_loops_cb, &settings);
+  BLI_task_parallel_range(
+      0, common_data->numEdges, &data, mesh_edges_sharp_calc_edges_cb, &settings);
+
+  MEM_freeN(data.edge_users);
+}
+
+/** \} */
+
 /**
  * Define sharp edges as needed to mimic 'autosmooth' from angle threshold.
  *
@@ -1312,284 +1435,304 @@ static void loop_split_worker_do(LoopSplitTaskDataCommon *common_data,
   }
 }
 
-static void loop_split_worker(TaskPool *__restrict pool, void *taskdata)
+enum {
+  LOOP_SPLIT_SKIP = 0,
+  LOOP_SPLIT_SINGLE = 1,
+  LOOP_SPLIT_FAN = 2,
+};
+
+typedef struct LoopSplitGeneratorData {
+  LoopSplitTaskDataCommon *common_data;
+  /* One of the LOOP_SPLIT_ values for each loop, non-skipped loops start a new lnor space. */
+  char *loop_types;
+  /* For loops with a smooth edge, the next loop of their smooth fan, -1 where the fan ends.
+   * Used to find the entry points of cyclic smooth fans. */
+  int *fan_next;
+  /* Index of the first lnor space of each polygon, only when computing lnor spacearr. */
+  int *poly_spaces_offset;
+  MLoopNorSpace *spaces;
+} LoopSplitGeneratorData;
+
+typedef struct LoopSplitGeneratorTLS {
+  /* Temp edge vectors stack, only used when computing lnor spacearr. */
+  BLI_Stack *edge_vectors;
+} LoopSplitGeneratorTLS;
+
+/**
+ * The next loop around the vertex of \a ml_curr in its smooth fan, crossing the edge of
+ * \a ml_prev. Returns -1 when that edge is sharp, the fan ends there.
+ */
+static int loop_split_generator_fan_next(const MLoop *mloops,
+                                         const MPoly *mpolys,
+                                         const int *loop_to_poly,
+                                         const int *e2l_prev,
+                                         const MLoop *ml_curr,
+                                         const MLoop *ml_prev,
+                                         const int ml_curr_index,
+                                         const int ml_prev_index,
+                                         const int mp_curr_index)
 {
-  LoopSplitTaskDataCommon *common_data = BLI_task_pool_user_data(pool);
-  LoopSplitTaskData *data = taskdata;
+  if (IS_EDGE_SHARP(e2l_prev)) {
+    return -1;
+  }
 
-  /* Temp edge vectors stack, only used when computing lnor spacearr. */
-  BLI_Stack *edge_vectors = common_data->lnors_spacearr ?
-                                BLI_stack_new(sizeof(float[3]), __func__) :
-                                NULL;
+  const MLoop *mlfan_curr = ml_prev;
+  /* mlfan_vert_index: the loop of our current edge might not be the loop of our current vertex! */
+  int mlfan_curr_index = ml_prev_index;
+  int mlfan_vert_index = ml_curr_index;
+  int mpfan_curr_index = mp_curr_index;
+
+  BKE_mesh_loop_manifold_fan_around_vert_next(mloops,
+                                              mpolys,
+                                              loop_to_poly,
+                                              e2l_prev,
+                                              ml_curr->v,
+                                              &mlfan_curr,
+                                              &mlfan_curr_index,
+                                              &mlfan_vert_index,
+                                              &mpfan_curr_index);
+
+  /* Edges with neighbor polys of inverted winding are sharp, so after crossing a smooth edge the
+   * loop of the next edge is the one before the vertex loop again. The next step only depends on
+   * the vertex loop. */
+  BLI_assert(mlfan_curr_index == mlfan_vert_index - 1 ||
+             mlfan_curr_index == mpolys[mpfan_curr_index].loopstart +
+                                     mpolys[mpfan_curr_index].totloop - 1);
+  return mlfan_vert_index;
+}
 
-#ifdef DEBUG_TIME
-  TIMEIT_START_AVERAGED(loop_split_worker);
-#endif
+/**
+ * Find the entry points of cyclic smooth fans. They have no obvious entry point, and yet we need
+ * to walk them once, and only once.
+ *
+ * Loops are walked in ascending order and tagged, so the entry point of a cyclic fan is its loop
+ * with the lowest index, and each fan is walked once.
+ */
+static void loop_split_generator_cyclic_fans(LoopSplitGeneratorData *data)
+{
+  const int numLoops = data->common_data->numLoops;
+  const int *loop_to_poly = data->common_data->loop_to_poly;
+  int *fan_next = data->fan_next;
 
-  for (int i = 0; i < LOOP_SPLIT_TASK_BLOCK_SIZE; i++, data++) {
-    /* A NULL ml_curr is used to tag ended data! */
-    if (data->ml_curr == NULL) {
-      break;
+  for (int ml_index = 0; ml_index < numLoops; ml_index++) {
+    if (fan_next[ml_index] < 0) {
+      /* End of a fan, or walked already. */
+      continue;
     }
 
-    loop_split_worker_do(common_data, data, edge_vectors);
-  }
+    /* Walked loops are tagged with a negative value unique to the walk. */
+    const int walk_tag = -2 - ml_index;
+    int mlfan_index = ml_index;
+    int mlfan_next;
+    while ((mlfan_next = fan_next[mlfan_index]) >= 0) {
+      fan_next[mlfan_index] = walk_tag;
+      mlfan_index = mlfan_next;
+    }
 
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
+    if (mlfan_next == walk_tag) {
+      /* Back at a loop of this walk: we walked around a whole cyclic smooth fan without finding
+       * any already-processed loop. This is the initial loop, unless invalid topology made the
+       * walk enter a cycle without it. */
+      data->loop_types[mlfan_index] = LOOP_SPLIT_FAN;
+      if (data->poly_spaces_offset) {
+        data->poly_spaces_offset[loop_to_poly[mlfan_index]]++;
+      }
+    }
   }
-
-#ifdef DEBUG_TIME
-  TIMEIT_END_AVERAGED(loop_split_worker);
-#endif
 }
 
 /**
- * Check whether given loop is part of an unknown-so-far cyclic smooth fan, or not.
- * Needed because cyclic smooth fans have no obvious 'entry point',
- * and yet we need to walk them once, and only once.
+ * Find out which loops start a new lnor space (either a single loop or a fan of loops).
  */
-static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
-                                                         const MPoly *mpolys,
-                                                         const int (*edge_to_loops)[2],
-                                                         const int *loop_to_poly,
-                                                         const int *e2l_prev,
-                                                         BLI_bitmap *skip_loops,
-                                                         const MLoop *ml_curr,
-                                                         const MLoop *ml_prev,
-                                                         const int ml_curr_index,
-                                                         const int ml_prev_index,
-                                                         const int mp_curr_index)
+static void loop_split_generator_types_cb(void *__restrict userdata,
+                                          const int mp_index,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  const unsigned int mv_pivot_index = ml_curr->v; /* The vertex we are "fanning" around! */
-  const int *e2lfan_curr;
-  const MLoop *mlfan_curr;
-  /* mlfan_vert_index: the loop of our current edge might not be the loop of our current vertex! */
-  int mlfan_curr_index, mlfan_vert_index, mpfan_curr_index;
+  LoopSplitGeneratorData *data = userdata;
+  const LoopSplitTaskDataCommon *common_data = data->common_data;
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mpolys = common_data->mpolys;
+  const int(*edge_to_loops)[2] = common_data->edge_to_loops;
+  const MPoly *mp = &mpolys[mp_index];
+
+  const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+  int ml_curr_index = mp->loopstart;
+  int ml_prev_index = ml_last_index;
+  int spaces_len = 0;
+
+  for (; ml_curr_index <= ml_last_index; ml_curr_index++) {
+    const MLoop *ml_curr = &mloops[ml_curr_index];
+    const MLoop *ml_prev = &mloops[ml_prev_index];
+    const int *e2l_curr = edge_to_loops[ml_curr->e];
+    const int *e2l_prev = edge_to_loops[ml_prev->e];
+    char type;
+
+    /* A smooth edge, we have to check for cyclic smooth fan case.
+     * If this loop is the entry point of a cyclic smooth fan, it is found by
+     * #loop_split_generator_cyclic_fans, otherwise we can skip it. */
+    if (!IS_EDGE_SHARP(e2l_curr)) {
+      type = LOOP_SPLIT_SKIP;
+      data->fan_next[ml_curr_index] = loop_split_generator_fan_next(mloops,
+                                                                    mpolys,
+                                                                    common_data->loop_to_poly,
+                                                                    e2l_prev,
+                                                                    ml_curr,
+                                                                    ml_prev,
+                                                                    ml_curr_index,
+                                                                    ml_prev_index,
+                                                                    mp_index);
+    }
+    /* We *do not need* to check/tag loops as already computed!
+     * Due to the fact a loop only links to one of its two edges,
+     * a same fan *will never be walked more than once!*
+     * Since we consider edges having neighbor polys with inverted
+     * (flipped) normals as sharp, we are sure that no fan will be skipped,
+     * even only considering the case (sharp curr_edge, smooth prev_edge),
+     * and not the alternative (smooth curr_edge, sharp prev_edge).
+     * All this due/thanks to link between normals and loop ordering (i.e. winding).
+     */
+    else if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
+      type = LOOP_SPLIT_SINGLE;
+      spaces_len++;
+    }
+    else {
+      type = LOOP_SPLIT_FAN;
+      spaces_len++;
+    }
 
-  e2lfan_curr = e2l_prev;
-  if (IS_EDGE_SHARP(e2lfan_curr)) {
-    /* Sharp loop, so not a cyclic smooth fan... */
-    return false;
+    if (type != LOOP_SPLIT_SKIP) {
+      data->fan_next[ml_curr_index] = -1;
+    }
+    data->loop_types[ml_curr_index] = type;
+    ml_prev_index = ml_curr_index;
   }
 
-  mlfan_curr = ml_prev;
-  mlfan_curr_index = ml_prev_index;
-  mlfan_vert_index = ml_curr_index;
-  mpfan_curr_index = mp_curr_index;
-
-  BLI_assert(mlfan_curr_index >= 0);
-  BLI_assert(mlfan_vert_index >= 0);
-  BLI_assert(mpfan_curr_index >= 0);
-
-  BLI_assert(!BLI_BITMAP_TEST(skip_loops, mlfan_vert_index));
-  BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
-
-  while (true) {
-    /* Find next loop of the smooth fan. */
-    BKE_mesh_loop_manifold_fan_around_vert_next(mloops,
-                                                mpolys,
-                                                loop_to_poly,
-                                                e2lfan_curr,
-                                                mv_pivot_index,
-                                                &mlfan_curr,
-                                                &mlfan_curr_index,
-                                                &mlfan_vert_index,
-                                                &mpfan_curr_index);
+  if (data->poly_spaces_offset) {
+    data->poly_spaces_offset[mp_index] = spaces_len;
+  }
+}
 
-    e2lfan_curr = edge_to_loops[mlfan_curr->e];
+static void loop_split_generator_do_cb(void *__restrict userdata,
+                                       const int mp_index,
+                                       const TaskParallelTLS *__restrict tls)
+{
+  LoopSplitGeneratorData *data = userdata;
+  LoopSplitGeneratorTLS *tls_data = tls->userdata_chunk;
+  LoopSplitTaskDataCommon *common_data = data->common_data;
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mp = &common_data->mpolys[mp_index];
+  MLoopNorSpace *lnor_space = data->spaces ? &data->spaces[data->poly_spaces_offset[mp_index]] :
+                                             NULL;
+
+  const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+  int ml_curr_index = mp->loopstart;
+  int ml_prev_index = ml_last_index;
+
+  for (; ml_curr_index <= ml_last_index; ml_curr_index++) {
+    const char type = data->loop_types[ml_curr_index];
+
+    if (type != LOOP_SPLIT_SKIP) {
+      const MLoop *ml_curr = &mloops[ml_curr_index];
+      const MLoop *ml_prev = &mloops[ml_prev_index];
+      LoopSplitTaskData task_data = {
+          .ml_curr = ml_curr,
+          .ml_prev = ml_prev,
+          .ml_curr_index = ml_curr_index,
+          .mp_index = mp_index,
+      };
+
+      if (type == LOOP_SPLIT_SINGLE) {
+        task_data.lnor = &common_data->loopnors[ml_curr_index];
+      }
+      else {
+        task_data.ml_prev_index = ml_prev_index;
+        task_data.e2l_prev = common_data->edge_to_loops[ml_prev->e]; /* Also tag as 'fan' task. */
+      }
 
-    if (IS_EDGE_SHARP(e2lfan_curr)) {
-      /* Sharp loop/edge, so not a cyclic smooth fan... */
-      return false;
-    }
-    /* Smooth loop/edge... */
-    if (BLI_BITMAP_TEST(skip_loops, mlfan_vert_index)) {
-      if (mlfan_vert_index == ml_curr_index) {
-        /* We walked around a whole cyclic smooth fan without finding any already-processed loop,
-         * means we can use initial ml_curr/ml_prev edge as start for this smooth fan. */
-        return true;
+      if (lnor_space) {
+        task_data.lnor_space = lnor_space++;
+        if (tls_data->edge_vectors == NULL) {
+          tls_data->edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
+        }
       }
-      /* ... already checked in some previous looping, we can abort. */
-      return false;
+
+      loop_split_worker_do(common_data, &task_data, tls_data->edge_vectors);
     }
 
-    /* ... we can skip it in future, and keep checking the smooth fan. */
-    BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
+    ml_prev_index = ml_curr_index;
   }
 }
 
-static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common_data)
+static void loop_split_generator_free_cb(const void *__restrict UNUSED(userdata),
+                                         void *__restrict chunk)
 {
-  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
-  float(*loopnors)[3] = common_data->loopnors;
+  LoopSplitGeneratorTLS *tls_data = chunk;
+  if (tls_data->edge_vectors) {
+    BLI_stack_free(tls_data->edge_vectors);
+  }
+}
 
-  const MLoop *mloops = common_data->mloops;
-  const MPoly *mpolys = common_data->mpolys;
-  const int *loop_to_poly = common_data->loop_to_poly;
-  const int(*edge_to_loops)[2] = common_data->edge_to_loops;
+/**
+ * Compute the normals of all smooth fans and single loops, all lnor spaces are allocated at once
+ * in a flat array, in the order of the loops starting them.
+ */
+static void loop_split_generator(LoopSplitTaskDataCommon *common_data)
+{
+  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
   const int numLoops = common_data->numLoops;
   const int numPolys = common_data->numPolys;
 
-  const MPoly *mp;
-  int mp_index;
-
-  const MLoop *ml_curr;
-  const MLoop *ml_prev;
-  int ml_curr_index;
-  int ml_prev_index;
-
-  BLI_bitmap *skip_loops = BLI_BITMAP_NEW(numLoops, __func__);
-
-  LoopSplitTaskData *data_buff = NULL;
-  int data_idx = 0;
-
-  /* Temp edge vectors stack, only used when computing lnor spacearr
-   * (and we are not multi-threading). */
-  BLI_Stack *edge_vectors = NULL;
+  LoopSplitGeneratorData data = {
+      .common_data = common_data,
+      .loop_types = MEM_malloc_arrayN((size_t)numLoops, sizeof(*data.loop_types), __func__),
+      .fan_next = MEM_malloc_arrayN((size_t)numLoops, sizeof(*data.fan_next), __func__),
+      .poly_spaces_offset = lnors_spacearr ? MEM_malloc_arrayN((size_t)numPolys,
+                                                               sizeof(*data.poly_spaces_offset),
+                                                               __func__) :
+                                             NULL,
+  };
 
 #ifdef DEBUG_TIME
   TIMEIT_START_AVERAGED(loop_split_generator);
 #endif
 
-  if (!pool) {
-    if (lnors_spacearr) {
-      edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  /* Not enough loops to be worth the whole threading overhead... */
+  settings.use_threading = (numLoops >= LOOP_SPLIT_TASK_BLOCK_SIZE * 8);
+  settings.min_iter_per_thread = LOOP_SPLIT_TASK_BLOCK_SIZE;
+
+  BLI_task_parallel_range(0, numPolys, &data, loop_split_generator_types_cb, &settings);
+
+  loop_split_generator_cyclic_fans(&data);
+  MEM_freeN(data.fan_next);
+
+  if (lnors_spacearr) {
+    int spaces_len = 0;
+    for (int mp_index = 0; mp_index < numPolys; mp_index++) {
+      const int poly_spaces_len = data.poly_spaces_offset[mp_index];
+      data.poly_spaces_offset[mp_index] = spaces_len;
+      spaces_len += poly_spaces_len;
+    }
+    if (spaces_len != 0) {
+      data.spaces = BLI_memarena_calloc(lnors_spacearr->mem,
+                                        sizeof(*data.spaces) * (size_t)spaces_len);
     }
+    lnors_spacearr->num_spaces += spaces_len;
   }
 
   /* We now know edges that can be smoothed (with their vector, and their two loops),
    * and edges that will be hard! Now, time to generate the normals.
    */
-  for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-    float(*lnors)[3];
-    const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
-    ml_curr_index = mp->loopstart;
-    ml_prev_index = ml_last_index;
-
-    ml_curr = &mloops[ml_curr_index];
-    ml_prev = &mloops[ml_prev_index];
-    lnors = &loopnors[ml_curr_index];
-
-    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++, lnors++) {
-      const int *e2l_curr = edge_to_loops[ml_curr->e];
-      const int *e2l_prev = edge_to_loops[ml_prev->e];
-
-#if 0
-      printf("Checking loop %d / edge %u / vert %u (sharp edge: %d, skiploop: %d)...",
-             ml_curr_index,
-             ml_curr->e,
-             ml_curr->v,
-             IS_EDGE_SHARP(e2l_curr),
-             BLI_BITMAP_TEST_BOOL(skip_loops, ml_curr_index));
-#endif
-
-      /* A smooth edge, we have to check for cyclic smooth fan case.
-       * If we find a new, never-processed cyclic smooth fan, we can do it now using that loop/edge
-       * as 'entry point', otherwise we can skip it. */
-
-      /* Note: In theory, we could make loop_split_generator_check_cyclic_smooth_fan() store
-       * mlfan_vert_index'es and edge indexes in two stacks, to avoid having to fan again around
-       * the vert during actual computation of clnor & clnorspace. However, this would complicate
-       * the code, add more memory usage, and despite its logical complexity,
-       * loop_manifold_fan_around_vert_next() is quite cheap in term of CPU cycles,
-       * so really think it's not worth it. */
-      if (!IS_EDGE_SHARP(e2l_curr) && (BLI_BITMAP_TEST(skip_loops, ml_curr_index) ||
-                                       !loop_split_generator_check_cyclic_smooth_fan(mloops,
-                                                                                     mpolys,
-                                                                                     edge_to_loops,
-                                                                                     loop_to_poly,
-                                                                                     e2l_prev,
-                                                                                     skip_loops,
-                                                                                     ml_curr,
-                                                                                     ml_prev,
-                                                                                     ml_curr_index,
-                                                                                     ml_prev_index,
-                                                                                     mp_index))) {
-        //              printf("SKIPPING!\n");
-      }
-      else {
-        LoopSplitTaskData *data, data_local;
-
-        //              printf("PROCESSING!\n");
-
-        if (pool) {
-          if (data_idx == 0) {
-            data_buff = MEM_calloc_arrayN(
-                LOOP_SPLIT_TASK_BLOCK_SIZE, sizeof(*data_buff), __func__);
-          }
-          data = &data_buff[data_idx];
-        }
-        else {
-          data = &data_local;
-          memset(data, 0, sizeof(*data));
-        }
-
-        if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
-          data->lnor = lnors;
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-#if 0 /* Not needed for 'single' loop. */
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = NULL; /* Tag as 'single' task. */
-#endif
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
-        }
-        /* We *do not need* to check/tag loops as already computed!
-         * Due to the fact a loop only links to one of its two edges,
-         * a same fan *will never be walked more than once!*
-         * Since we consider edges having neighbor polys with inverted
-         * (flipped) normals as sharp, we are sure that no fan will be skipped,
-         * even only considering the case (sharp curr_edge, smooth prev_edge),
-         * and not the alternative (smooth curr_edge, sharp prev_edge).
-         * All this due/thanks to link between normals and loop ordering (i.e. winding).
-         */
-        else {
-#if 0 /* Not needed for 'fan' loops. */
-          data->lnor = lnors;
-#endif
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
-        }
-
-        if (pool) {
-          data_idx++;
-          if (data_idx == LOOP_SPLIT_TASK_BLOCK_SIZE) {
-            BLI_task_pool_push(pool, loop_split_worker, data_buff, true, NULL);
-            data_idx = 0;
-          }
-        }
-        else {
-          loop_split_worker_do(common_data, data, edge_vectors);
-        }
-      }
+  LoopSplitGeneratorTLS tls_data = {NULL};
+  settings.userdata_chunk = &tls_data;
+  settings.userdata_chunk_size = sizeof(tls_data);
+  settings.func_free = loop_split_generator_free_cb;
 
-      ml_prev = ml_curr;
-      ml_prev_index = ml_curr_index;
-    }
-  }
-
-  /* Last block of data... Since it is calloc'ed and we use first NULL item as stopper,
-   * everything is fine. */
-  if (pool && data_idx) {
-    BLI_task_pool_push(pool, loop_split_worker, data_buff, true, NULL);
-  }
+  BLI_task_parallel_range(0, numPolys, &data, loop_split_generator_do_cb, &settings);
 
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
-  }
-  MEM_freeN(skip_loops);
+  MEM_freeN(data.loop_types);
+  MEM_SAFE_FREE(data.poly_spaces_offset);
 
 #ifdef DEBUG_TIME
   TIMEIT_END_AVERAGED(loop_split_generator);
@@ -1708,21 +1851,9 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
   };
 
   /* This first loop check which edges are actually smooth, and compute edge vectors. */
-  mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
+  mesh_edges_sharp_calc(&common_data, check_angle, split_angle);
 
-  if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
-    /* Not enough loops to be worth the whole threading overhead... */
-    loop_split_generator(NULL, &common_data);
-  }
-  else {
-    TaskPool *task_pool = BLI_task_pool_create(&common_data, TASK_PRIORITY_HIGH);
-
-    loop_split_generator(task_pool, &common_data);
-
-    BLI_task_pool_work_and_wait(task_pool);
-
-    BLI_task_pool_free(task_pool);
-  }
+  loop_split_generator(&common_data);
 
   MEM_freeN(edge_to_loops);
   if (!r_loop_to_poly) {
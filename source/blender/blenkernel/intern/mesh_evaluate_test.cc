@@ -0,0 +1,161 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "bmesh.h"
+
+namespace blender::bke::tests {
+
+class mesh_evaluate_test : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+};
+
+/**
+ * Wavy grid of `size * size` vertices with flat and flipped faces and sharp edges, so it has
+ * single loops, cyclic fans around interior vertices and fans ending on sharp edges.
+ */
+static Mesh *split_normals_mesh_create(const int size)
+{
+  const int totpoly = (size - 1) * (size - 1);
+  Mesh *me = BKE_mesh_new_nomain(size * size, 0, 0, totpoly * 4, totpoly);
+
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      float *co = me->mvert[y * size + x].co;
+      co[0] = (float)x;
+      co[1] = (float)y;
+      co[2] = 2.0f * sinf((float)x * 0.7f) * cosf((float)y * 0.4f);
+    }
+  }
+
+  int l = 0;
+  for (int y = 0; y < size - 1; y++) {
+    for (int x = 0; x < size - 1; x++) {
+      const int i = y * (size - 1) + x;
+      const int v = y * size + x;
+      const int quad[4] = {v, v + 1, v + size + 1, v + size};
+      const bool flip = (i % 17) == 5;
+      me->mpoly[i].loopstart = l;
+      me->mpoly[i].totloop = 4;
+      me->mpoly[i].flag = ((i % 11) == 0) ? 0 : ME_SMOOTH;
+      for (int j = 0; j < 4; j++, l++) {
+        me->mloop[l].v = quad[flip ? 3 - j : j];
+      }
+    }
+  }
+
+  BKE_mesh_calc_edges(me, false, false);
+  for (int i = 0; i < me->totedge; i += 13) {
+    me->medge[i].flag |= ME_SHARP;
+  }
+  BKE_mesh_calc_normals(me);
+  return me;
+}
+
+/* Compare with the BMesh split normals, which walk the fans serially. */
+TEST_F(mesh_evaluate_test, NormalsLoopSplit)
+{
+  Mesh *me = split_normals_mesh_create(48);
+  const float split_angle = DEG2RADF(40.0f);
+
+  float(*polynors)[3] = (float(*)[3])MEM_malloc_arrayN(
+      (size_t)me->totpoly, sizeof(*polynors), __func__);
+  BKE_mesh_calc_normals_poly(me->mvert,
+                             nullptr,
+                             me->totvert,
+                             me->mloop,
+                             me->mpoly,
+                             me->totloop,
+                             me->totpoly,
+                             polynors,
+                             true);
+
+  float(*lnors)[3] = (float(*)[3])MEM_malloc_arrayN(
+      (size_t)me->totloop, sizeof(*lnors), __func__);
+  MLoopNorSpaceArray lnors_spacearr = {nullptr};
+  BKE_mesh_normals_loop_split(me->mvert,
+                              me->totvert,
+                              me->medge,
+                              me->totedge,
+                              me->mloop,
+                              lnors,
+                              me->totloop,
+                              me->mpoly,
+                              polynors,
+                              me->totpoly,
+                              true,
+                              split_angle,
+                              &lnors_spacearr,
+                              nullptr,
+                              nullptr);
+
+  BMAllocTemplate allocsize = {me->totvert, me->totedge, me->totloop, me->totpoly};
+  BMeshCreateParams create_params = {0};
+  BMesh *bm = BM_mesh_create(&allocsize, &create_params);
+  BMeshFromMeshParams from_params = {0};
+  from_params.calc_face_normal = true;
+  BM_mesh_bm_from_me(bm, me, &from_params);
+  BM_mesh_normals_update(bm);
+
+  float(*lnors_bm)[3] = (float(*)[3])MEM_malloc_arrayN(
+      (size_t)me->totloop, sizeof(*lnors_bm), __func__);
+  MLoopNorSpaceArray lnors_spacearr_bm = {nullptr};
+  BM_loops_calc_normal_vcos(bm,
+                            nullptr,
+                            nullptr,
+                            nullptr,
+                            true,
+                            split_angle,
+                            lnors_bm,
+                            &lnors_spacearr_bm,
+                            nullptr,
+                            -1,
+                            false);
+
+  EXPECT_EQ(lnors_spacearr.num_spaces, lnors_spacearr_bm.num_spaces);
+  for (int i = 0; i < me->totloop; i++) {
+    EXPECT_V3_NEAR(lnors[i], lnors_bm[i], 1e-4f);
+  }
+
+  BKE_lnor_spacearr_free(&lnors_spacearr);
+  BKE_lnor_spacearr_free(&lnors_spacearr_bm);
+  BM_mesh_free(bm);
+  MEM_freeN(lnors_bm);
+  MEM_freeN(lnors);
+  MEM_freeN(polynors);
+  BKE_id_free(nullptr, me);
+}
+
+}  // namespace blender::bke::tests
@@ -36,6 +36,7 @@
 #include "BLI_memarena.h"
 #include "BLI_polyfill_2d.h"
 #include "BLI_rand.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_bvhutils.h"
@@ -117,6 +118,118 @@ static bool mesh_remap_bvhtree_query_raycast(BVHTreeFromMesh *treedata,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Threaded BVH queries.
+ *
+ * Lookups of the destination elements are independent from each other, they are all done in
+ * parallel first, mapping items are then defined in order from their results
+ * (the memory arena of #MeshPairRemap is not thread safe).
+ * \{ */
+
+/* Minimum number of destination elements to do the queries in parallel. */
+#define MREMAP_THREADED_ITEMS_MIN 1024
+
+typedef struct MeshRemapHit {
+  /** Index of the BVH item found, -1 if none. */
+  int index;
+  float hit_dist;
+  /** The hit point, in source space. */
+  float co[3];
+} MeshRemapHit;
+
+typedef struct MeshRemapQueryData {
+  BVHTreeFromMesh *treedata;
+  const SpaceTransform *space_transform;
+  float max_dist;
+  float max_dist_sq;
+  float ray_radius;
+  /** Cast rays along the element normals instead of looking for the nearest item. */
+  bool use_raycast;
+
+  /* Destination elements, vertices, or polygons if `polys_dst` is set. */
+  const MVert *verts_dst;
+  const MLoop *loops_dst;
+  const MPoly *polys_dst;
+  const float (*poly_nors_dst)[3];
+
+  MeshRemapHit *hits;
+} MeshRemapQueryData;
+
+static void mesh_remap_query_cb(void *__restrict userdata,
+                                const int i,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const MeshRemapQueryData *data = userdata;
+  MeshRemapHit *hit = &data->hits[i];
+  float co[3], no[3];
+
+  if (data->polys_dst) {
+    const MPoly *mp = &data->polys_dst[i];
+    BKE_mesh_calc_poly_center(mp, &data->loops_dst[mp->loopstart], data->verts_dst, co);
+    if (data->use_raycast) {
+      copy_v3_v3(no, data->poly_nors_dst[i]);
+    }
+  }
+  else {
+    copy_v3_v3(co, data->verts_dst[i].co);
+    if (data->use_raycast) {
+      normal_short_to_float_v3(no, data->verts_dst[i].no);
+    }
+  }
+
+  /* Convert to tree coordinates, if needed. */
+  if (data->space_transform) {
+    BLI_space_transform_apply(data->space_transform, co);
+    if (data->use_raycast) {
+      BLI_space_transform_apply_normal(data->space_transform, no);
+    }
+  }
+
+  if (data->use_raycast) {
+    BVHTreeRayHit rayhit;
+    if (mesh_remap_bvhtree_query_raycast(
+            data->treedata, &rayhit, co, no, data->ray_radius, data->max_dist, &hit->hit_dist)) {
+      hit->index = rayhit.index;
+      copy_v3_v3(hit->co, rayhit.co);
+      return;
+    }
+  }
+  else {
+    /* Each item starts from scratch, so results don't depend on how items are split between
+     * threads (the previous nearest item would win ties). */
+    BVHTreeNearest nearest = {0};
+    nearest.index = -1;
+    if (mesh_remap_bvhtree_query_nearest(
+            data->treedata, &nearest, co, data->max_dist_sq, &hit->hit_dist)) {
+      hit->index = nearest.index;
+      copy_v3_v3(hit->co, nearest.co);
+      return;
+    }
+  }
+
+  hit->index = -1;
+  hit->hit_dist = FLT_MAX;
+}
+
+/**
+ * Query the BVH tree for all destination elements described by \a data.
+ * \return An array of \a items_num hits, to be freed by the caller.
+ */
+static MeshRemapHit *mesh_remap_query_hits(MeshRemapQueryData *data, const int items_num)
+{
+  data->hits = MEM_malloc_arrayN((size_t)items_num, sizeof(*data->hits), __func__);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (items_num >= MREMAP_THREADED_ITEMS_MIN);
+  settings.min_iter_per_thread = 256;
+  BLI_task_parallel_range(0, items_num, data, mesh_remap_query_cb, &settings);
+
+  return data->hits;
+}
+
+/** \} */
+
 /**
  * \name Auto-match.
  *
@@ -523,26 +636,24 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
   }
   else {
     BVHTreeFromMesh treedata = {NULL};
-    BVHTreeNearest nearest = {0};
-    BVHTreeRayHit rayhit = {0};
-    float hit_dist;
-    float tmp_co[3], tmp_no[3];
+    MeshRemapQueryData query_data = {
+        .space_transform = space_transform,
+        .max_dist = max_dist,
+        .max_dist_sq = max_dist_sq,
+        .ray_radius = ray_radius,
+        .verts_dst = verts_dst,
+    };
+    MeshRemapHit *hits = NULL;
+    float tmp_co[3];
 
     if (mode == MREMAP_MODE_VERT_NEAREST) {
       BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_VERTS, 2);
-      nearest.index = -1;
+      query_data.treedata = &treedata;
+      hits = mesh_remap_query_hits(&query_data, numverts_dst);
 
       for (i = 0; i < numverts_dst; i++) {
-        copy_v3_v3(tmp_co, verts_dst[i].co);
-
-        /* Convert the vertex to tree coordinates, if needed. */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, tmp_co);
-        }
-
-        if (mesh_remap_bvhtree_query_nearest(
-                &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-          mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &nearest.index, &full_weight);
+        if (hits[i].index != -1) {
+          mesh_remap_item_define(r_map, i, hits[i].hit_dist, 0, 1, &hits[i].index, &full_weight);
         }
         else {
           /* No source for this dest vertex! */
@@ -555,27 +666,27 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
       float(*vcos_src)[3] = BKE_mesh_vert_coords_alloc(me_src, NULL);
 
       BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_EDGES, 2);
-      nearest.index = -1;
+      query_data.treedata = &treedata;
+      hits = mesh_remap_query_hits(&query_data, numverts_dst);
 
       for (i = 0; i < numverts_dst; i++) {
-        copy_v3_v3(tmp_co, verts_dst[i].co);
-
-        /* Convert the vertex to tree coordinates, if needed. */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, tmp_co);
-        }
-
-        if (mesh_remap_bvhtree_query_nearest(
-                &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-          MEdge *me = &edges_src[nearest.index];
+        if (hits[i].index != -1) {
+          MEdge *me = &edges_src[hits[i].index];
           const float *v1cos = vcos_src[me->v1];
           const float *v2cos = vcos_src[me->v2];
 
+          copy_v3_v3(tmp_co, verts_dst[i].co);
+
+          /* Convert the vertex to tree coordinates, if needed. */
+          if (space_transform) {
+            BLI_space_transform_apply(space_transform, tmp_co);
+          }
+
           if (mode == MREMAP_MODE_VERT_EDGE_NEAREST) {
             const float dist_v1 = len_squared_v3v3(tmp_co, v1cos);
             const float dist_v2 = len_squared_v3v3(tmp_co, v2cos);
             const int index = (int)((dist_v1 > dist_v2) ? me->v2 : me->v1);
-            mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &index, &full_weight);
+            mesh_remap_item_define(r_map, i, hits[i].hit_dist, 0, 1, &index, &full_weight);
           }
           else if (mode == MREMAP_MODE_VERT_EDGEINTERP_NEAREST) {
             int indices[2];
@@ -589,7 +700,7 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
             CLAMP(weights[0], 0.0f, 1.0f);
             weights[1] = 1.0f - weights[0];
 
-            mesh_remap_item_define(r_map, i, hit_dist, 0, 2, indices, weights);
+            mesh_remap_item_define(r_map, i, hits[i].hit_dist, 0, 2, indices, weights);
           }
         }
         else {
@@ -614,26 +725,36 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
       float *weights = MEM_mallocN(sizeof(*weights) * tmp_buff_size, __func__);
 
       BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_LOOPTRI, 2);
+      query_data.treedata = &treedata;
+      query_data.use_raycast = (mode == MREMAP_MODE_VERT_POLYINTERP_VNORPROJ);
+      hits = mesh_remap_query_hits(&query_data, numverts_dst);
 
-      if (mode == MREMAP_MODE_VERT_POLYINTERP_VNORPROJ) {
-        for (i = 0; i < numverts_dst; i++) {
-          copy_v3_v3(tmp_co, verts_dst[i].co);
-          normal_short_to_float_v3(tmp_no, verts_dst[i].no);
-
-          /* Convert the vertex to tree coordinates, if needed. */
-          if (space_transform) {
-            BLI_space_transform_apply(space_transform, tmp_co);
-            BLI_space_transform_apply_normal(space_transform, tmp_no);
+      for (i = 0; i < numverts_dst; i++) {
+        if (hits[i].index != -1) {
+          const MLoopTri *lt = &treedata.looptri[hits[i].index];
+          MPoly *mp = &polys_src[lt->poly];
+
+          if (mode == MREMAP_MODE_VERT_POLY_NEAREST) {
+            int index;
+            mesh_remap_interp_poly_data_get(mp,
+                                            loops_src,
+                                            (const float(*)[3])vcos_src,
+                                            hits[i].co,
+                                            &tmp_buff_size,
+                                            &vcos,
+                                            false,
+                                            &indices,
+                                            &weights,
+                                            false,
+                                            &index);
+
+            mesh_remap_item_define(r_map, i, hits[i].hit_dist, 0, 1, &index, &full_weight);
           }
-
-          if (mesh_remap_bvhtree_query_raycast(
-                  &treedata, &rayhit, tmp_co, tmp_no, ray_radius, max_dist, &hit_dist)) {
-            const MLoopTri *lt = &treedata.looptri[rayhit.index];
-            MPoly *mp_src = &polys_src[lt->poly];
-            const int sources_num = mesh_remap_interp_poly_data_get(mp_src,
+          else {
+            const int sources_num = mesh_remap_interp_poly_data_get(mp,
                                                                     loops_src,
                                                                     (const float(*)[3])vcos_src,
-                                                                    rayhit.co,
+                                                                    hits[i].co,
                                                                     &tmp_buff_size,
                                                                     &vcos,
                                                                     false,
@@ -642,66 +763,12 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
                                                                     true,
                                                                     NULL);
 
-            mesh_remap_item_define(r_map, i, hit_dist, 0, sources_num, indices, weights);
-          }
-          else {
-            /* No source for this dest vertex! */
-            BKE_mesh_remap_item_define_invalid(r_map, i);
+            mesh_remap_item_define(r_map, i, hits[i].hit_dist, 0, sources_num, indices, weights);
           }
         }
-      }
-      else {
-        nearest.index = -1;
-
-        for (i = 0; i < numverts_dst; i++) {
-          copy_v3_v3(tmp_co, verts_dst[i].co);
-
-          /* Convert the vertex to tree coordinates, if needed. */
-          if (space_transform) {
-            BLI_space_transform_apply(space_transform, tmp_co);
-          }
-
-          if (mesh_remap_bvhtree_query_nearest(
-                  &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-            const MLoopTri *lt = &treedata.looptri[nearest.index];
-            MPoly *mp = &polys_src[lt->poly];
-
-            if (mode == MREMAP_MODE_VERT_POLY_NEAREST) {
-              int index;
-              mesh_remap_interp_poly_data_get(mp,
-                                              loops_src,
-                                              (const float(*)[3])vcos_src,
-                                              nearest.co,
-                                              &tmp_buff_size,
-                                              &vcos,
-                                              false,
-                                              &indices,
-                                              &weights,
-                                              false,
-                                              &index);
-
-              mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &index, &full_weight);
-            }
-            else if (mode == MREMAP_MODE_VERT_POLYINTERP_NEAREST) {
-              const int sources_num = mesh_remap_interp_poly_data_get(mp,
-                                                                      loops_src,
-                                                                      (const float(*)[3])vcos_src,
-                                                                      nearest.co,
-                                                                      &tmp_buff_size,
-                                                                      &vcos,
-                                                                      false,
-                                                                      &indices,
-                                                                      &weights,
-                                                                      true,
-                                                                      NULL);
-
-              mesh_remap_item_define(r_map, i, hit_dist, 0, sources_num, indices, weights);
-            }
-          }
-          else {
-            /* No source for this dest vertex! */
-            BKE_mesh_remap_item_define_invalid(r_map, i);
-          }
+        else {
+          /* No source for this dest vertex! */
+          BKE_mesh_remap_item_define_invalid(r_map, i);
         }
       }
 
@@ -715,6 +782,7 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
       memset(r_map->items, 0, sizeof(*r_map->items) * (size_t)numverts_dst);
     }
 
+    MEM_SAFE_FREE(hits);
     free_bvhtree_from_mesh(&treedata);
   }
 }
@@ -1249,6 +1317,275 @@ static float mesh_remap_calc_loops_astar_f_cost(BLI_AStarGraph *as_graph,
          len_v3v3(co_next, co_dest);
 }
 
+/* Upper bound of island results computed at once, the number of source islands can be high. */
+#define MREMAP_LOOPS_BLOCK_RESULTS_MAX (1 << 16)
+
+typedef struct MeshRemapLoopsQueryData {
+  int mode;
+  const SpaceTransform *space_transform;
+  float max_dist;
+  float max_dist_sq;
+  float ray_radius;
+
+  BVHTreeFromMesh *treedata;
+  int num_trees;
+  const int *items_to_islands;
+
+  const MVert *verts_dst;
+  const MLoop *loops_dst;
+  const MPoly *polys_dst;
+  const float (*poly_nors_dst)[3];
+  const float (*loop_nors_dst)[3];
+
+  const MLoop *loops_src;
+  const MPoly *polys_src;
+  const float (*poly_nors_src)[3];
+  const float (*loop_nors_src)[3];
+  const float (*poly_cents_src)[3];
+  const MeshElemMap *vert_to_loop_map_src;
+  const MeshElemMap *vert_to_poly_map_src;
+  const int *loop_to_poly_map_src;
+
+  /* Current block of destination polygons, results of each island are stored contiguously,
+   * `islands_res_offsets` giving the offset of each polygon's loops. */
+  int block_start;
+  int block_loops_num;
+  const int *islands_res_offsets;
+  IslandResult *islands_res;
+} MeshRemapLoopsQueryData;
+
+static void mesh_remap_loops_query_poly_cb(void *__restrict userdata,
+                                           const int block_index,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const MeshRemapLoopsQueryData *data = userdata;
+  const int mode = data->mode;
+  const SpaceTransform *space_transform = data->space_transform;
+  const bool use_from_vert = (mode & MREMAP_USE_VERT);
+  const int pidx_dst = data->block_start + block_index;
+  const MPoly *mp_dst = &data->polys_dst[pidx_dst];
+
+  BVHTreeNearest nearest = {0};
+  BVHTreeRayHit rayhit = {0};
+  float hit_dist;
+  float tmp_co[3], tmp_no[3];
+  float pnor_dst[3];
+
+  /* Only in use_from_vert case, we may need polys' centers as fallback
+   * in case we cannot decide which corner to use from normals only. */
+  float pcent_dst[3];
+  bool pcent_dst_valid = false;
+
+  if (mode == MREMAP_MODE_LOOP_NEAREST_POLYNOR) {
+    copy_v3_v3(pnor_dst, data->poly_nors_dst[pidx_dst]);
+    if (space_transform) {
+      BLI_space_transform_apply_normal(space_transform, pnor_dst);
+    }
+  }
+
+  for (int tindex = 0; tindex < data->num_trees; tindex++) {
+    BVHTreeFromMesh *tdata = &data->treedata[tindex];
+    IslandResult *islands_res = &data->islands_res[tindex * data->block_loops_num +
+                                                   data->islands_res_offsets[block_index]];
+
+    const MLoop *ml_dst = &data->loops_dst[mp_dst->loopstart];
+    for (int plidx_dst = 0; plidx_dst < mp_dst->totloop; plidx_dst++, ml_dst++) {
+      IslandResult *isld_res = &islands_res[plidx_dst];
+
+      if (use_from_vert) {
+        const MeshElemMap *vert_to_refelem_map_src = NULL;
+
+        copy_v3_v3(tmp_co, data->verts_dst[ml_dst->v].co);
+        nearest.index = -1;
+
+        /* Convert the vertex to tree coordinates, if needed. */
+        if (space_transform) {
+          BLI_space_transform_apply(space_transform, tmp_co);
+        }
+
+        if (mesh_remap_bvhtree_query_nearest(
+                tdata, &nearest, tmp_co, data->max_dist_sq, &hit_dist)) {
+          const float(*nor_dst)[3];
+          const float(*nors_src)[3];
+          float best_nor_dot = -2.0f;
+          float best_sqdist_fallback = FLT_MAX;
+          int best_index_src = -1;
+
+          if (mode == MREMAP_MODE_LOOP_NEAREST_LOOPNOR) {
+            copy_v3_v3(tmp_no, data->loop_nors_dst[plidx_dst + mp_dst->loopstart]);
+            if (space_transform) {
+              BLI_space_transform_apply_normal(space_transform, tmp_no);
+            }
+            nor_dst = (const float(*)[3])&tmp_no;
+            nors_src = data->loop_nors_src;
+            vert_to_refelem_map_src = data->vert_to_loop_map_src;
+          }
+          else { /* if (mode == MREMAP_MODE_LOOP_NEAREST_POLYNOR) { */
+            nor_dst = (const float(*)[3])&pnor_dst;
+            nors_src = data->poly_nors_src;
+            vert_to_refelem_map_src = data->vert_to_poly_map_src;
+          }
+
+          for (int i = vert_to_refelem_map_src[nearest.index].count; i--;) {
+            const int index_src = vert_to_refelem_map_src[nearest.index].indices[i];
+            BLI_assert(index_src != -1);
+            const float dot = dot_v3v3(nors_src[index_src], *nor_dst);
+
+            const int pidx_src = ((mode == MREMAP_MODE_LOOP_NEAREST_LOOPNOR) ?
+                                      data->loop_to_poly_map_src[index_src] :
+                                      index_src);
+            /* WARNING! This is not the *real* lidx_src in case of POLYNOR, we only use it
+             *          to check we stay on current island (all loops from a given poly are
+             *          on same island!). */
+            const int lidx_src = ((mode == MREMAP_MODE_LOOP_NEAREST_LOOPNOR) ?
+                                      index_src :
+                                      data->polys_src[pidx_src].loopstart);
+
+            /* A same vert may be at the boundary of several islands! Hence, we have to ensure
+             * poly/loop we are currently considering *belongs* to current island! */
+            if (data->items_to_islands && data->items_to_islands[lidx_src] != tindex) {
+              continue;
+            }
+
+            if (dot > best_nor_dot - 1e-6f) {
+              /* We need something as fallback decision in case dest normal matches several
+               * source normals (see T44522), using distance between polys' centers here. */
+              const float *pcent_src;
+              float sqdist;
+
+              if (!pcent_dst_valid) {
+                BKE_mesh_calc_poly_center(
+                    mp_dst, &data->loops_dst[mp_dst->loopstart], data->verts_dst, pcent_dst);
+                pcent_dst_valid = true;
+              }
+              pcent_src = data->poly_cents_src[pidx_src];
+              sqdist = len_squared_v3v3(pcent_dst, pcent_src);
+
+              if ((dot > best_nor_dot + 1e-6f) || (sqdist < best_sqdist_fallback)) {
+                best_nor_dot = dot;
+                best_sqdist_fallback = sqdist;
+                best_index_src = index_src;
+              }
+            }
+          }
+          if (best_index_src == -1) {
+            /* We found no item to map back from closest vertex... */
+            best_nor_dot = -1.0f;
+            hit_dist = FLT_MAX;
+          }
+          else if (mode == MREMAP_MODE_LOOP_NEAREST_POLYNOR) {
+            /* Our best_index_src is a poly one for now!
+             * Have to find its loop matching our closest vertex. */
+            const MPoly *mp_src = &data->polys_src[best_index_src];
+            const MLoop *ml_src = &data->loops_src[mp_src->loopstart];
+            for (int plidx_src = 0; plidx_src < mp_src->totloop; plidx_src++, ml_src++) {
+              if ((int)ml_src->v == nearest.index) {
+                best_index_src = plidx_src + mp_src->loopstart;
+                break;
+              }
+            }
+          }
+          best_nor_dot = (best_nor_dot + 1.0f) * 0.5f;
+          isld_res->factor = hit_dist ? (best_nor_dot / hit_dist) : 1e18f;
+          isld_res->hit_dist = hit_dist;
+          isld_res->index_src = best_index_src;
+        }
+        else {
+          /* No source for this dest loop! */
+          isld_res->factor = 0.0f;
+          isld_res->hit_dist = FLT_MAX;
+          isld_res->index_src = -1;
+        }
+      }
+      else if (mode & MREMAP_USE_NORPROJ) {
+        int n = (data->ray_radius > 0.0f) ? MREMAP_RAYCAST_APPROXIMATE_NR : 1;
+        float w = 1.0f;
+
+        copy_v3_v3(tmp_co, data->verts_dst[ml_dst->v].co);
+        copy_v3_v3(tmp_no, data->loop_nors_dst[plidx_dst + mp_dst->loopstart]);
+
+        /* We do our transform here, since we may do several raycast/nearest queries. */
+        if (space_transform) {
+          BLI_space_transform_apply(space_transform, tmp_co);
+          BLI_space_transform_apply_normal(space_transform, tmp_no);
+        }
+
+        while (n--) {
+          if (mesh_remap_bvhtree_query_raycast(tdata,
+                                               &rayhit,
+                                               tmp_co,
+                                               tmp_no,
+                                               data->ray_radius / w,
+                                               data->max_dist,
+                                               &hit_dist)) {
+            isld_res->factor = (hit_dist ? (1.0f / hit_dist) : 1e18f) * w;
+            isld_res->hit_dist = hit_dist;
+            isld_res->index_src = (int)tdata->looptri[rayhit.index].poly;
+            copy_v3_v3(isld_res->hit_point, rayhit.co);
+            break;
+          }
+          /* Next iteration will get bigger radius but smaller weight! */
+          w /= MREMAP_RAYCAST_APPROXIMATE_FAC;
+        }
+        if (n == -1) {
+          /* Fallback to 'nearest' hit here, loops usually comes in 'face group', not good to
+           * have only part of one dest face's loops to map to source.
+           * Note that since we give this a null weight, if whole weight for a given face
+           * is null, it means none of its loop mapped to this source island,
+           * hence we can skip it later.
+           */
+          copy_v3_v3(tmp_co, data->verts_dst[ml_dst->v].co);
+          nearest.index = -1;
+
+          /* Convert the vertex to tree coordinates, if needed. */
+          if (space_transform) {
+            BLI_space_transform_apply(space_transform, tmp_co);
+          }
+
+          /* In any case, this fallback nearest hit should have no weight at all
+           * in 'best island' decision! */
+          isld_res->factor = 0.0f;
+
+          if (mesh_remap_bvhtree_query_nearest(
+                  tdata, &nearest, tmp_co, data->max_dist_sq, &hit_dist)) {
+            isld_res->hit_dist = hit_dist;
+            isld_res->index_src = (int)tdata->looptri[nearest.index].poly;
+            copy_v3_v3(isld_res->hit_point, nearest.co);
+          }
+          else {
+            /* No source for this dest loop! */
+            isld_res->hit_dist = FLT_MAX;
+            isld_res->index_src = -1;
+          }
+        }
+      }
+      else { /* Nearest poly either to use all its loops/verts or just closest one. */
+        copy_v3_v3(tmp_co, data->verts_dst[ml_dst->v].co);
+        nearest.index = -1;
+
+        /* Convert the vertex to tree coordinates, if needed. */
+        if (space_transform) {
+          BLI_space_transform_apply(space_transform, tmp_co);
+        }
+
+        if (mesh_remap_bvhtree_query_nearest(
+                tdata, &nearest, tmp_co, data->max_dist_sq, &hit_dist)) {
+          isld_res->factor = hit_dist ? (1.0f / hit_dist) : 1e18f;
+          isld_res->hit_dist = hit_dist;
+          isld_res->index_src = (int)tdata->looptri[nearest.index].poly;
+          copy_v3_v3(isld_res->hit_point, nearest.co);
+        }
+        else {
+          /* No source for this dest loop! */
+          isld_res->factor = 0.0f;
+          isld_res->hit_dist = FLT_MAX;
+          isld_res->index_src = -1;
+        }
+      }
+    }
+  }
+}
+
 #define ASTAR_STEPS_MAX 64
 
 void BKE_mesh_remap_calc_loops_from_mesh(const int mode,
@@ -1292,11 +1629,8 @@ void BKE_mesh_remap_calc_loops_from_mesh(const int mode,
   }
   else {
     BVHTreeFromMesh *treedata = NULL;
-    BVHTreeNearest nearest = {0};
-    BVHTreeRayHit rayhit = {0};
     int num_trees = 0;
-    float hit_dist;
-    float tmp_co[3], tmp_no[3];
+    float tmp_co[3];
 
     const bool use_from_vert = (mode & MREMAP_USE_VERT);
 
@@ -1350,8 +1684,12 @@ void BKE_mesh_remap_calc_loops_from_mesh(const int mode,
     MPoly *mp_src, *mp_dst;
     int tindex, pidx_dst, lidx_dst, plidx_dst, pidx_src, lidx_src, plidx_src;
 
+    /* Pointers to the results of each source island for the current dest poly. */
     IslandResult **islands_res;
-    size_t islands_res_buff_size = MREMAP_DEFAULT_BUFSIZE;
+    IslandResult *islands_res_block;
+    size_t islands_res_block_size = MREMAP_DEFAULT_BUFSIZE;
+    int *islands_res_offsets;
+    int block_end = 0;
 
     if (!use_from_vert) {
       vcos_src = BKE_mesh_vert_coords_alloc(me_src, NULL);
@@ -1617,227 +1955,76 @@ void BKE_mesh_remap_calc_loops_from_mesh(const int mode,
 
     /* And check each dest poly! */
     islands_res = MEM_mallocN(sizeof(*islands_res) * (size_t)num_trees, __func__);
-    for (tindex = 0; tindex < num_trees; tindex++) {
-      islands_res[tindex] = MEM_mallocN(sizeof(**islands_res) * islands_res_buff_size, __func__);
-    }
+    islands_res_offsets = MEM_malloc_arrayN(
+        (size_t)numpolys_dst, sizeof(*islands_res_offsets), __func__);
+    islands_res_block = MEM_malloc_arrayN(
+        islands_res_block_size, sizeof(*islands_res_block), __func__);
+
+    MeshRemapLoopsQueryData query_data = {
+        .mode = mode,
+        .space_transform = space_transform,
+        .max_dist = max_dist,
+        .max_dist_sq = max_dist_sq,
+        .ray_radius = ray_radius,
+        .treedata = treedata,
+        .num_trees = num_trees,
+        .items_to_islands = use_islands ? island_store.items_to_islands : NULL,
+        .verts_dst = verts_dst,
+        .loops_dst = loops_dst,
+        .polys_dst = polys_dst,
+        .poly_nors_dst = (const float(*)[3])poly_nors_dst,
+        .loop_nors_dst = (const float(*)[3])loop_nors_dst,
+        .loops_src = loops_src,
+        .polys_src = polys_src,
+        .poly_nors_src = (const float(*)[3])poly_nors_src,
+        .loop_nors_src = (const float(*)[3])loop_nors_src,
+        .poly_cents_src = (const float(*)[3])poly_cents_src,
+        .vert_to_loop_map_src = vert_to_loop_map_src,
+        .vert_to_poly_map_src = vert_to_poly_map_src,
+        .loop_to_poly_map_src = loop_to_poly_map_src,
+        .islands_res_offsets = islands_res_offsets,
+    };
 
     for (pidx_dst = 0, mp_dst = polys_dst; pidx_dst < numpolys_dst; pidx_dst++, mp_dst++) {
-      float pnor_dst[3];
-
-      /* Only in use_from_vert case, we may need polys' centers as fallback
-       * in case we cannot decide which corner to use from normals only. */
-      float pcent_dst[3];
-      bool pcent_dst_valid = false;
-
-      if (mode == MREMAP_MODE_LOOP_NEAREST_POLYNOR) {
-        copy_v3_v3(pnor_dst, poly_nors_dst[pidx_dst]);
-        if (space_transform) {
-          BLI_space_transform_apply_normal(space_transform, pnor_dst);
+      /* Queries of a block of dest polys are done in parallel, the results (one per dest loop and
+       * source island) are then used in order below. */
+      if (pidx_dst == block_end) {
+        int block_loops_num = 0;
+        for (block_end = pidx_dst; block_end < numpolys_dst; block_end++) {
+          const int totloop = polys_dst[block_end].totloop;
+          if ((block_end != pidx_dst) &&
+              ((size_t)(block_loops_num + totloop) * (size_t)num_trees >
+               MREMAP_LOOPS_BLOCK_RESULTS_MAX)) {
+            break;
+          }
+          islands_res_offsets[block_end - pidx_dst] = block_loops_num;
+          block_loops_num += totloop;
         }
-      }
 
-      if ((size_t)mp_dst->totloop > islands_res_buff_size) {
-        islands_res_buff_size = (size_t)mp_dst->totloop + MREMAP_DEFAULT_BUFSIZE;
-        for (tindex = 0; tindex < num_trees; tindex++) {
-          islands_res[tindex] = MEM_reallocN(islands_res[tindex],
-                                             sizeof(**islands_res) * islands_res_buff_size);
+        if ((size_t)block_loops_num * (size_t)num_trees > islands_res_block_size) {
+          islands_res_block_size = (size_t)block_loops_num * (size_t)num_trees;
+          MEM_freeN(islands_res_block);
+          islands_res_block = MEM_malloc_arrayN(
+              islands_res_block_size, sizeof(*islands_res_block), __func__);
         }
+
+        query_data.block_start = pidx_dst;
+        query_data.block_loops_num = block_loops_num;
+        query_data.islands_res = islands_res_block;
+
+        TaskParallelSettings settings;
+        BLI_parallel_range_settings_defaults(&settings);
+        settings.use_threading = ((size_t)block_loops_num * (size_t)num_trees >=
+                                  MREMAP_THREADED_ITEMS_MIN);
+        settings.min_iter_per_thread = 16;
+        BLI_task_parallel_range(
+            0, block_end - pidx_dst, &query_data, mesh_remap_loops_query_poly_cb, &settings);
       }
 
       for (tindex = 0; tindex < num_trees; tindex++) {
-        BVHTreeFromMesh *tdata = &treedata[tindex];
-
-        ml_dst = &loops_dst[mp_dst->loopstart];
-        for (plidx_dst = 0; plidx_dst < mp_dst->totloop; plidx_dst++, ml_dst++) {
-          if (use_from_vert) {
-            MeshElemMap *vert_to_refelem_map_src = NULL;
-
-            copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
-            nearest.index = -1;
-
-            /* Convert the vertex to tree coordinates, if needed. */
-            if (space_transform) {
-              BLI_space_transform_apply(space_transform, tmp_co);
-            }
-
-            if (mesh_remap_bvhtree_query_nearest(
-                    tdata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-              float(*nor_dst)[3];
-              float(*nors_src)[3];
-              float best_nor_dot = -2.0f;
-              float best_sqdist_fallback = FLT_MAX;
-              int best_index_src = -1;
-
-              if (mode == MREMAP_MODE_LOOP_NEAREST_LOOPNOR) {
-                copy_v3_v3(tmp_no, loop_nors_dst[plidx_dst + mp_dst->loopstart]);
-                if (space_transform) {
-                  BLI_space_transform_apply_normal(space_transform, tmp_no);
-                }
-                nor_dst = &tmp_no;
-                nors_src = loop_nors_src;
-                vert_to_refelem_map_src = vert_to_loop_map_src;
-              }
-              else { /* if (mode == MREMAP_MODE_LOOP_NEAREST_POLYNOR) { */
-                nor_dst = &pnor_dst;
-                nors_src = poly_nors_src;
-                vert_to_refelem_map_src = vert_to_poly_map_src;
-              }
-
-              for (i = vert_to_refelem_map_src[nearest.index].count; i--;) {
-                const int index_src = vert_to_refelem_map_src[nearest.index].indices[i];
-                BLI_assert(index_src != -1);
-                const float dot = dot_v3v3(nors_src[index_src], *nor_dst);
-
-                pidx_src = ((mode == MREMAP_MODE_LOOP_NEAREST_LOOPNOR) ?
-                                loop_to_poly_map_src[index_src] :
-                                index_src);
-                /* WARNING! This is not the *real* lidx_src in case of POLYNOR, we only use it
-                 *          to check we stay on current island (all loops from a given poly are
-                 *          on same island!). */
-                lidx_src = ((mode == MREMAP_MODE_LOOP_NEAREST_LOOPNOR) ?
-                                index_src :
-                                polys_src[pidx_src].loopstart);
-
-                /* A same vert may be at the boundary of several islands! Hence, we have to ensure
-                 * poly/loop we are currently considering *belongs* to current island! */
-                if (use_islands && island_store.items_to_islands[lidx_src] != tindex) {
-                  continue;
-                }
-
-                if (dot > best_nor_dot - 1e-6f) {
-                  /* We need something as fallback decision in case dest normal matches several
-                   * source normals (see T44522), using distance between polys' centers here. */
-                  float *pcent_src;
-                  float sqdist;
-
-                  mp_src = &polys_src[pidx_src];
-                  ml_src = &loops_src[mp_src->loopstart];
-
-                  if (!pcent_dst_valid) {
-                    BKE_mesh_calc_poly_center(
-                        mp_dst, &loops_dst[mp_dst->loopstart], verts_dst, pcent_dst);
-                    pcent_dst_valid = true;
-                  }
-                  pcent_src = poly_cents_src[pidx_src];
-                  sqdist = len_squared_v3v3(pcent_dst, pcent_src);
-
-                  if ((dot > best_nor_dot + 1e-6f) || (sqdist < best_sqdist_fallback)) {
-                    best_nor_dot = dot;
-                    best_sqdist_fallback = sqdist;
-                    best_index_src = index_src;
-                  }
-                }
-              }
-              if (best_index_src == -1) {
-                /* We found no item to map back from closest vertex... */
-                best_nor_dot = -1.0f;
-                hit_dist = FLT_MAX;
-              }
-              else if (mode == MREMAP_MODE_LOOP_NEAREST_POLYNOR) {
-                /* Our best_index_src is a poly one for now!
-                 * Have to find its loop matching our closest vertex. */
-                mp_src = &polys_src[best_index_src];
-                ml_src = &loops_src[mp_src->loopstart];
-                for (plidx_src = 0; plidx_src < mp_src->totloop; plidx_src++, ml_src++) {
-                  if ((int)ml_src->v == nearest.index) {
-                    best_index_src = plidx_src + mp_src->loopstart;
-                    break;
-                  }
-                }
-              }
-              best_nor_dot = (best_nor_dot + 1.0f) * 0.5f;
-              islands_res[tindex][plidx_dst].factor = hit_dist ? (best_nor_dot / hit_dist) : 1e18f;
-              islands_res[tindex][plidx_dst].hit_dist = hit_dist;
-              islands_res[tindex][plidx_dst].index_src = best_index_src;
-            }
-            else {
-              /* No source for this dest loop! */
-              islands_res[tindex][plidx_dst].factor = 0.0f;
-              islands_res[tindex][plidx_dst].hit_dist = FLT_MAX;
-              islands_res[tindex][plidx_dst].index_src = -1;
-            }
-          }
-          else if (mode & MREMAP_USE_NORPROJ) {
-            int n = (ray_radius > 0.0f) ? MREMAP_RAYCAST_APPROXIMATE_NR : 1;
-            float w = 1.0f;
-
-            copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
-            copy_v3_v3(tmp_no, loop_nors_dst[plidx_dst + mp_dst->loopstart]);
-
-            /* We do our transform here, since we may do several raycast/nearest queries. */
-            if (space_transform) {
-              BLI_space_transform_apply(space_transform, tmp_co);
-              BLI_space_transform_apply_normal(space_transform, tmp_no);
-            }
-
-            while (n--) {
-              if (mesh_remap_bvhtree_query_raycast(
-                      tdata, &rayhit, tmp_co, tmp_no, ray_radius / w, max_dist, &hit_dist)) {
-                islands_res[tindex][plidx_dst].factor = (hit_dist ? (1.0f / hit_dist) : 1e18f) * w;
-                islands_res[tindex][plidx_dst].hit_dist = hit_dist;
-                islands_res[tindex][plidx_dst].index_src = (int)tdata->looptri[rayhit.index].poly;
-                copy_v3_v3(islands_res[tindex][plidx_dst].hit_point, rayhit.co);
-                break;
-              }
-              /* Next iteration will get bigger radius but smaller weight! */
-              w /= MREMAP_RAYCAST_APPROXIMATE_FAC;
-            }
-            if (n == -1) {
-              /* Fallback to 'nearest' hit here, loops usually comes in 'face group', not good to
-               * have only part of one dest face's loops to map to source.
-               * Note that since we give this a null weight, if whole weight for a given face
-               * is null, it means none of its loop mapped to this source island,
-               * hence we can skip it later.
-               */
-              copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
-              nearest.index = -1;
-
-              /* Convert the vertex to tree coordinates, if needed. */
-              if (space_transform) {
-                BLI_space_transform_apply(space_transform, tmp_co);
-              }
-
-              /* In any case, this fallback nearest hit should have no weight at all
-               * in 'best island' decision! */
-              islands_res[tindex][plidx_dst].factor = 0.0f;
-
-              if (mesh_remap_bvhtree_query_nearest(
-                      tdata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-                islands_res[tindex][plidx_dst].hit_dist = hit_dist;
-                islands_res[tindex][plidx_dst].index_src = (int)tdata->looptri[nearest.index].poly;
-                copy_v3_v3(islands_res[tindex][plidx_dst].hit_point, nearest.co);
-              }
-              else {
-                /* No source for this dest loop! */
-                islands_res[tindex][plidx_dst].hit_dist = FLT_MAX;
-                islands_res[tindex][plidx_dst].index_src = -1;
-              }
-            }
-          }
-          else { /* Nearest poly either to use all its loops/verts or just closest one. */
-            copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
-            nearest.index = -1;
-
-            /* Convert the vertex to tree coordinates, if needed. */
-            if (space_transform) {
-              BLI_space_transform_apply(space_transform, tmp_co);
-            }
-
-            if (mesh_remap_bvhtree_query_nearest(
-                    tdata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-              islands_res[tindex][plidx_dst].factor = hit_dist ? (1.0f / hit_dist) : 1e18f;
-              islands_res[tindex][plidx_dst].hit_dist = hit_dist;
-              islands_res[tindex][plidx_dst].index_src = (int)tdata->looptri[nearest.index].poly;
-              copy_v3_v3(islands_res[tindex][plidx_dst].hit_point, nearest.co);
-            }
-            else {
-              /* No source for this dest loop! */
-              islands_res[tindex][plidx_dst].factor = 0.0f;
-              islands_res[tindex][plidx_dst].hit_dist = FLT_MAX;
-              islands_res[tindex][plidx_dst].index_src = -1;
-            }
-          }
-        }
+        islands_res[tindex] = &islands_res_block[tindex * query_data.block_loops_num +
+                                                 islands_res_offsets[pidx_dst -
+                                                                     query_data.block_start]];
       }
 
       /* And now, find best island to use! */
@@ -2140,13 +2327,14 @@ void BKE_mesh_remap_calc_loops_from_mesh(const int mode,
     }
 
     for (tindex = 0; tindex < num_trees; tindex++) {
-      MEM_freeN(islands_res[tindex]);
       free_bvhtree_from_mesh(&treedata[tindex]);
       if (isld_steps_src) {
         BLI_astar_graph_free(&as_graphdata[tindex]);
       }
     }
     MEM_freeN(islands_res);
+    MEM_freeN(islands_res_offsets);
+    MEM_freeN(islands_res_block);
     BKE_mesh_loop_islands_free(&island_store);
     MEM_freeN(treedata);
     if (isld_steps_src) {
@@ -2252,64 +2440,42 @@ void BKE_mesh_remap_calc_polys_from_mesh(const int mode,
   }
   else {
     BVHTreeFromMesh treedata = {NULL};
-    BVHTreeNearest nearest = {0};
     BVHTreeRayHit rayhit = {0};
     float hit_dist;
 
     BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_LOOPTRI, 2);
 
-    if (mode == MREMAP_MODE_POLY_NEAREST) {
-      nearest.index = -1;
+    if (ELEM(mode, MREMAP_MODE_POLY_NEAREST, MREMAP_MODE_POLY_NOR)) {
+      MeshRemapQueryData query_data = {
+          .treedata = &treedata,
+          .space_transform = space_transform,
+          .max_dist = max_dist,
+          .max_dist_sq = max_dist_sq,
+          .ray_radius = ray_radius,
+          .use_raycast = (mode == MREMAP_MODE_POLY_NOR),
+          .verts_dst = verts_dst,
+          .loops_dst = loops_dst,
+          .polys_dst = polys_dst,
+          .poly_nors_dst = (const float(*)[3])poly_nors_dst,
+      };
 
-      for (i = 0; i < numpolys_dst; i++) {
-        MPoly *mp = &polys_dst[i];
+      BLI_assert(!query_data.use_raycast || poly_nors_dst);
 
-        BKE_mesh_calc_poly_center(mp, &loops_dst[mp->loopstart], verts_dst, tmp_co);
-
-        /* Convert the vertex to tree coordinates, if needed. */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, tmp_co);
-        }
-
-        if (mesh_remap_bvhtree_query_nearest(
-                &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-          const MLoopTri *lt = &treedata.looptri[nearest.index];
-          const int poly_index = (int)lt->poly;
-          mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &poly_index, &full_weight);
-        }
-        else {
-          /* No source for this dest poly! */
-          BKE_mesh_remap_item_define_invalid(r_map, i);
-        }
-      }
-    }
-    else if (mode == MREMAP_MODE_POLY_NOR) {
-      BLI_assert(poly_nors_dst);
+      MeshRemapHit *hits = mesh_remap_query_hits(&query_data, numpolys_dst);
 
       for (i = 0; i < numpolys_dst; i++) {
-        MPoly *mp = &polys_dst[i];
-
-        BKE_mesh_calc_poly_center(mp, &loops_dst[mp->loopstart], verts_dst, tmp_co);
-        copy_v3_v3(tmp_no, poly_nors_dst[i]);
-
-        /* Convert the vertex to tree coordinates, if needed. */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, tmp_co);
-          BLI_space_transform_apply_normal(space_transform, tmp_no);
-        }
-
-        if (mesh_remap_bvhtree_query_raycast(
-                &treedata, &rayhit, tmp_co, tmp_no, ray_radius, max_dist, &hit_dist)) {
-          const MLoopTri *lt = &treedata.looptri[rayhit.index];
+        if (hits[i].index != -1) {
+          const MLoopTri *lt = &treedata.looptri[hits[i].index];
           const int poly_index = (int)lt->poly;
-
-          mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &poly_index, &full_weight);
+          mesh_remap_item_define(r_map, i, hits[i].hit_dist, 0, 1, &poly_index, &full_weight);
         }
         else {
           /* No source for this dest poly! */
           BKE_mesh_remap_item_define_invalid(r_map, i);
         }
       }
+
+      MEM_freeN(hits);
     }
     else if (mode == MREMAP_MODE_POLY_POLYINTERP_PNORPROJ) {
       /* We cast our rays randomly, with a pseudo-even distribution
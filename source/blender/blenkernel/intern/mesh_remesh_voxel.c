@@ -32,6 +32,7 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_mesh_types.h"
@@ -56,9 +57,26 @@
 #  include "quadriflow_capi.hpp"
 #endif
 
+/**
+ * Result of the conversion of a mesh to a level set, kept around so meshing the same input again
+ * with a different adaptivity or isovalue doesn't have to rebuild the volume.
+ * The OpenVDB input arrays are stored to detect changes of the input mesh.
+ */
+typedef struct MeshRemeshVoxelCache {
+  float voxel_size;
+  float *verts;
+  unsigned int *faces;
+  unsigned int totverts;
+  unsigned int totfaces;
+  struct OpenVDBLevelSet *level_set;
+} MeshRemeshVoxelCache;
+
 #ifdef WITH_OPENVDB
-struct OpenVDBLevelSet *BKE_mesh_remesh_voxel_ovdb_mesh_to_level_set_create(
-    Mesh *mesh, struct OpenVDBTransform *transform)
+static void remesh_voxel_input_create(Mesh *mesh,
+                                      float **r_verts,
+                                      unsigned int *r_totverts,
+                                      unsigned int **r_faces,
+                                      unsigned int *r_totfaces)
 {
   BKE_mesh_runtime_looptri_recalc(mesh);
   const MLoopTri *looptri = BKE_mesh_runtime_looptri_ensure(mesh);
@@ -87,12 +105,27 @@ struct OpenVDBLevelSet *BKE_mesh_remesh_voxel_ovdb_mesh_to_level_set_create(
     faces[i * 3 + 2] = vt->tri[2];
   }
 
+  MEM_freeN(verttri);
+
+  *r_verts = verts;
+  *r_totverts = totverts;
+  *r_faces = faces;
+  *r_totfaces = totfaces;
+}
+
+struct OpenVDBLevelSet *BKE_mesh_remesh_voxel_ovdb_mesh_to_level_set_create(
+    Mesh *mesh, struct OpenVDBTransform *transform)
+{
+  float *verts;
+  unsigned int *faces;
+  unsigned int totverts, totfaces;
+  remesh_voxel_input_create(mesh, &verts, &totverts, &faces, &totfaces);
+
   struct OpenVDBLevelSet *level_set = OpenVDBLevelSet_create(false, NULL);
   OpenVDBLevelSet_mesh_to_level_set(level_set, verts, faces, totverts, totfaces, transform);
 
   MEM_freeN(verts);
   MEM_freeN(faces);
-  MEM_freeN(verttri);
 
   return level_set;
 }
@@ -293,6 +326,74 @@ Mesh *BKE_mesh_remesh_quadriflow_to_mesh_nomain(Mesh *mesh,
   return new_mesh;
 }
 
+MeshRemeshVoxelCache *BKE_mesh_remesh_voxel_cache_create(void)
+{
+  return MEM_callocN(sizeof(MeshRemeshVoxelCache), __func__);
+}
+
+static void remesh_voxel_cache_clear(MeshRemeshVoxelCache *cache)
+{
+#ifdef WITH_OPENVDB
+  if (cache->level_set) {
+    OpenVDBLevelSet_free(cache->level_set);
+  }
+#endif
+  MEM_SAFE_FREE(cache->verts);
+  MEM_SAFE_FREE(cache->faces);
+  memset(cache, 0, sizeof(*cache));
+}
+
+void BKE_mesh_remesh_voxel_cache_free(MeshRemeshVoxelCache *cache)
+{
+  remesh_voxel_cache_clear(cache);
+  MEM_freeN(cache);
+}
+
+Mesh *BKE_mesh_remesh_voxel_to_mesh_nomain_cached(Mesh *mesh,
+                                                  float voxel_size,
+                                                  float adaptivity,
+                                                  float isovalue,
+                                                  MeshRemeshVoxelCache *cache)
+{
+  Mesh *new_mesh = NULL;
+#ifdef WITH_OPENVDB
+  float *verts;
+  unsigned int *faces;
+  unsigned int totverts, totfaces;
+  remesh_voxel_input_create(mesh, &verts, &totverts, &faces, &totfaces);
+
+  /* Reuse the level set when only the meshing settings changed. */
+  if (cache->level_set == NULL || cache->voxel_size != voxel_size ||
+      cache->totverts != totverts || cache->totfaces != totfaces ||
+      memcmp(cache->verts, verts, sizeof(float[3]) * totverts) != 0 ||
+      memcmp(cache->faces, faces, sizeof(unsigned int[3]) * totfaces) != 0) {
+    remesh_voxel_cache_clear(cache);
+
+    struct OpenVDBTransform *xform = OpenVDBTransform_create();
+    OpenVDBTransform_create_linear_transform(xform, (double)voxel_size);
+    cache->level_set = OpenVDBLevelSet_create(false, NULL);
+    OpenVDBLevelSet_mesh_to_level_set(cache->level_set, verts, faces, totverts, totfaces, xform);
+    OpenVDBTransform_free(xform);
+
+    cache->voxel_size = voxel_size;
+    cache->verts = verts;
+    cache->faces = faces;
+    cache->totverts = totverts;
+    cache->totfaces = totfaces;
+  }
+  else {
+    MEM_freeN(verts);
+    MEM_freeN(faces);
+  }
+
+  new_mesh = BKE_mesh_remesh_voxel_ovdb_volume_to_mesh_nomain(
+      cache->level_set, (double)isovalue, (double)adaptivity, false);
+#else
+  UNUSED_VARS(mesh, voxel_size, adaptivity, isovalue, cache);
+#endif
+  return new_mesh;
+}
+
 Mesh *BKE_mesh_remesh_voxel_to_mesh_nomain(Mesh *mesh,
                                            float voxel_size,
                                            float adaptivity,
@@ -314,13 +415,72 @@ Mesh *BKE_mesh_remesh_voxel_to_mesh_nomain(Mesh *mesh,
   return new_mesh;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Data Reprojection
+ *
+ * Nearest source elements are found once for all target elements in parallel,
+ * every reprojected layer then only copies values.
+ * \{ */
+
+typedef struct RemeshNearestData {
+  BVHTreeFromMesh *bvhtree;
+  const MVert *mvert;
+  /* When set, queries are done from the center of the polygons instead of the vertices. */
+  const MPoly *mpoly;
+  const MLoop *mloop;
+  int *r_nearest;
+} RemeshNearestData;
+
+static void remesh_nearest_cb(void *__restrict userdata,
+                              const int i,
+                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  RemeshNearestData *data = userdata;
+  BVHTreeFromMesh *bvhtree = data->bvhtree;
+  float from_co[3];
+  BVHTreeNearest nearest;
+  nearest.index = -1;
+  nearest.dist_sq = FLT_MAX;
+  if (data->mpoly) {
+    const MPoly *mpoly = &data->mpoly[i];
+    BKE_mesh_calc_poly_center(mpoly, &data->mloop[mpoly->loopstart], data->mvert, from_co);
+  }
+  else {
+    copy_v3_v3(from_co, data->mvert[i].co);
+  }
+  BLI_bvhtree_find_nearest(bvhtree->tree, from_co, &nearest, bvhtree->nearest_callback, bvhtree);
+  data->r_nearest[i] = nearest.index;
+}
+
+/**
+ * \return Index of the nearest element of \a bvhtree for every vertex of \a target,
+ * or for every polygon when \a use_polys is set. -1 when nothing was found.
+ */
+static int *remesh_nearest_indices(BVHTreeFromMesh *bvhtree, Mesh *target, const bool use_polys)
+{
+  const int len = use_polys ? target->totpoly : target->totvert;
+  RemeshNearestData data = {
+      .bvhtree = bvhtree,
+      .mvert = CustomData_get_layer(&target->vdata, CD_MVERT),
+      .mpoly = use_polys ? CustomData_get_layer(&target->pdata, CD_MPOLY) : NULL,
+      .mloop = use_polys ? CustomData_get_layer(&target->ldata, CD_MLOOP) : NULL,
+      .r_nearest = MEM_malloc_arrayN((size_t)len, sizeof(int), __func__),
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, len, &data, remesh_nearest_cb, &settings);
+
+  return data.r_nearest;
+}
+
 void BKE_mesh_remesh_reproject_paint_mask(Mesh *target, Mesh *source)
 {
   BVHTreeFromMesh bvhtree = {
       .nearest_callback = NULL,
   };
   BKE_bvhtree_from_mesh_get(&bvhtree, source, BVHTREE_FROM_VERTS, 2);
-  MVert *target_verts = CustomData_get_layer(&target->vdata, CD_MVERT);
 
   float *target_mask;
   if (CustomData_has_layer(&target->vdata, CD_PAINT_MASK)) {
@@ -340,17 +500,13 @@ void BKE_mesh_remesh_reproject_paint_mask(Mesh *target, Mesh *source)
         &source->vdata, CD_PAINT_MASK, CD_CALLOC, NULL, source->totvert);
   }
 
+  int *nearest = remesh_nearest_indices(&bvhtree, target, false);
   for (int i = 0; i < target->totvert; i++) {
-    float from_co[3];
-    BVHTreeNearest nearest;
-    nearest.index = -1;
-    nearest.dist_sq = FLT_MAX;
-    copy_v3_v3(from_co, target_verts[i].co);
-    BLI_bvhtree_find_nearest(bvhtree.tree, from_co, &nearest, bvhtree.nearest_callback, &bvhtree);
-    if (nearest.index != -1) {
-      target_mask[i] = source_mask[nearest.index];
+    if (nearest[i] != -1) {
+      target_mask[i] = source_mask[nearest[i]];
     }
   }
+  MEM_freeN(nearest);
   free_bvhtree_from_mesh(&bvhtree);
 }
 
@@ -360,10 +516,6 @@ void BKE_remesh_reproject_sculpt_face_sets(Mesh *target, Mesh *source)
       .nearest_callback = NULL,
   };
 
-  const MPoly *target_polys = CustomData_get_layer(&target->pdata, CD_MPOLY);
-  const MVert *target_verts = CustomData_get_layer(&target->vdata, CD_MVERT);
-  const MLoop *target_loops = CustomData_get_layer(&target->ldata, CD_MLOOP);
-
   int *target_face_sets;
   if (CustomData_has_layer(&target->pdata, CD_SCULPT_FACE_SETS)) {
     target_face_sets = CustomData_get_layer(&target->pdata, CD_SCULPT_FACE_SETS);
@@ -385,32 +537,33 @@ void BKE_remesh_reproject_sculpt_face_sets(Mesh *target, Mesh *source)
   const MLoopTri *looptri = BKE_mesh_runtime_looptri_ensure(source);
   BKE_bvhtree_from_mesh_get(&bvhtree, source, BVHTREE_FROM_LOOPTRI, 2);
 
+  int *nearest = remesh_nearest_indices(&bvhtree, target, true);
   for (int i = 0; i < target->totpoly; i++) {
-    float from_co[3];
-    BVHTreeNearest nearest;
-    nearest.index = -1;
-    nearest.dist_sq = FLT_MAX;
-    const MPoly *mpoly = &target_polys[i];
-    BKE_mesh_calc_poly_center(mpoly, &target_loops[mpoly->loopstart], target_verts, from_co);
-    BLI_bvhtree_find_nearest(bvhtree.tree, from_co, &nearest, bvhtree.nearest_callback, &bvhtree);
-    if (nearest.index != -1) {
-      target_face_sets[i] = source_face_sets[looptri[nearest.index].poly];
+    if (nearest[i] != -1) {
+      target_face_sets[i] = source_face_sets[looptri[nearest[i]].poly];
     }
     else {
       target_face_sets[i] = 1;
     }
   }
+  MEM_freeN(nearest);
   free_bvhtree_from_mesh(&bvhtree);
 }
 
 void BKE_remesh_reproject_vertex_paint(Mesh *target, Mesh *source)
 {
+  int tot_color_layer = CustomData_number_of_layers(&source->vdata, CD_PROP_COLOR);
+  if (tot_color_layer == 0) {
+    return;
+  }
+
   BVHTreeFromMesh bvhtree = {
       .nearest_callback = NULL,
   };
   BKE_bvhtree_from_mesh_get(&bvhtree, source, BVHTREE_FROM_VERTS, 2);
 
-  int tot_color_layer = CustomData_number_of_layers(&source->vdata, CD_PROP_COLOR);
+  /* Same nearest vertex for all layers. */
+  int *nearest = remesh_nearest_indices(&bvhtree, target, false);
 
   for (int layer_n = 0; layer_n < tot_color_layer; layer_n++) {
     const char *layer_name = CustomData_get_layer_name(&source->vdata, CD_PROP_COLOR, layer_n);
@@ -418,22 +571,19 @@ void BKE_remesh_reproject_vertex_paint(Mesh *target, Mesh *source)
         &target->vdata, CD_PROP_COLOR, CD_CALLOC, NULL, target->totvert, layer_name);
 
     MPropCol *target_color = CustomData_get_layer_n(&target->vdata, CD_PROP_COLOR, layer_n);
-    MVert *target_verts = CustomData_get_layer(&target->vdata, CD_MVERT);
     MPropCol *source_color = CustomData_get_layer_n(&source->vdata, CD_PROP_COLOR, layer_n);
     for (int i = 0; i < target->totvert; i++) {
-      BVHTreeNearest nearest;
-      nearest.index = -1;
-      nearest.dist_sq = FLT_MAX;
-      BLI_bvhtree_find_nearest(
-          bvhtree.tree, target_verts[i].co, &nearest, bvhtree.nearest_callback, &bvhtree);
-      if (nearest.index != -1) {
-        copy_v4_v4(target_color[i].color, source_color[nearest.index].color);
+      if (nearest[i] != -1) {
+        copy_v4_v4(target_color[i].color, source_color[nearest[i]].color);
       }
     }
   }
+  MEM_freeN(nearest);
   free_bvhtree_from_mesh(&bvhtree);
 }
 
+/** \} */
+
 struct Mesh *BKE_mesh_remesh_voxel_fix_poles(struct Mesh *mesh)
 {
   const BMAllocTemplate allocsize = BMALLOC_TEMPLATE_FROM_ME(mesh);
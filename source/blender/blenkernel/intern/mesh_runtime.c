@@ -30,9 +30,11 @@
 #include "DNA_object_types.h"
 
 #include "BLI_math_geom.h"
+#include "BLI_math_vector.h"
 #include "BLI_threads.h"
 
 #include "BKE_bvhutils.h"
+#include "BKE_customdata.h"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
 #include "BKE_mesh_runtime.h"
@@ -46,11 +48,20 @@
 /**
  * Default values defined at read time.
  */
+/* Source of #Mesh_Runtime.deform_verts_edit_count values. */
+static uint mesh_deform_verts_edit_count = 0;
+
+static int mesh_deform_verts_edit_count_next(void)
+{
+  return (int)atomic_add_and_fetch_u(&mesh_deform_verts_edit_count, 1);
+}
+
 void BKE_mesh_runtime_reset(Mesh *mesh)
 {
   memset(&mesh->runtime, 0, sizeof(mesh->runtime));
   mesh->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime eval_mutex");
   BLI_mutex_init(mesh->runtime.eval_mutex);
+  mesh->runtime.deform_verts_edit_count = mesh_deform_verts_edit_count_next();
 }
 
 /* Clear all pointers which we don't want to be shared on copying the datablock.
@@ -67,6 +78,11 @@ void BKE_mesh_runtime_reset_on_copy(Mesh *mesh, const int UNUSED(flag))
   memset(&runtime->looptris, 0, sizeof(runtime->looptris));
   runtime->bvh_cache = NULL;
   runtime->shrinkwrap_data = NULL;
+  runtime->vert_normals = NULL;
+  /* Normals are copied with the vertices, only keep whether they are up to date. */
+  runtime->cache_flag &= MESH_RUNTIME_NORMALS_DIRTY;
+  /* The copy may be edited independently of the source. */
+  runtime->deform_verts_edit_count = mesh_deform_verts_edit_count_next();
 
   mesh->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime eval_mutex");
   BLI_mutex_init(mesh->runtime.eval_mutex);
@@ -105,8 +121,9 @@ static void mesh_ensure_looptri_data(Mesh *mesh)
 
   SWAP(MLoopTri *, mesh->runtime.looptris.array, mesh->runtime.looptris.array_wip);
 
+  /* Reuse the allocation unless it is too small or more than twice as large as needed. */
   if ((looptris_len > mesh->runtime.looptris.len_alloc) ||
-      (looptris_len < mesh->runtime.looptris.len_alloc * 2) || (totpoly == 0)) {
+      (looptris_len * 2 < mesh->runtime.looptris.len_alloc) || (totpoly == 0)) {
     MEM_SAFE_FREE(mesh->runtime.looptris.array_wip);
     mesh->runtime.looptris.len_alloc = 0;
     mesh->runtime.looptris.len = 0;
@@ -141,6 +158,7 @@ void BKE_mesh_runtime_looptri_recalc(Mesh *mesh)
                  mesh->runtime.looptris.array,
                  mesh->runtime.looptris.array_wip);
   mesh->runtime.looptris.array_wip = NULL;
+  atomic_fetch_and_and_char(&mesh->runtime.cache_flag, (char)~MESH_RUNTIME_LOOPTRIS_DIRTY);
 }
 
 /* This is a ported copy of dm_getNumLoopTri(dm). */
@@ -154,20 +172,24 @@ int BKE_mesh_runtime_looptri_len(const Mesh *mesh)
 /* This is a ported copy of dm_getLoopTriArray(dm). */
 const MLoopTri *BKE_mesh_runtime_looptri_ensure(Mesh *mesh)
 {
-  MLoopTri *looptri;
+  MLoopTri *looptri = mesh->runtime.looptris.array;
+
+  /* The array is only published once it is fully computed, so there is no need to lock
+   * for the common case of an up to date cache. */
+  if (looptri != NULL && !(mesh->runtime.cache_flag & MESH_RUNTIME_LOOPTRIS_DIRTY)) {
+    BLI_assert(BKE_mesh_runtime_looptri_len(mesh) == mesh->runtime.looptris.len);
+    return looptri;
+  }
 
   ThreadMutex *mesh_eval_mutex = (ThreadMutex *)mesh->runtime.eval_mutex;
   BLI_mutex_lock(mesh_eval_mutex);
 
-  looptri = mesh->runtime.looptris.array;
-
-  if (looptri != NULL) {
-    BLI_assert(BKE_mesh_runtime_looptri_len(mesh) == mesh->runtime.looptris.len);
-  }
-  else {
+  /* Another thread may have computed the looptris while we were waiting for the lock. */
+  if (mesh->runtime.looptris.array == NULL ||
+      (mesh->runtime.cache_flag & MESH_RUNTIME_LOOPTRIS_DIRTY)) {
     BKE_mesh_runtime_looptri_recalc(mesh);
-    looptri = mesh->runtime.looptris.array;
   }
+  looptri = mesh->runtime.looptris.array;
 
   BLI_mutex_unlock(mesh_eval_mutex);
 
@@ -233,6 +255,10 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
     mesh->runtime.bvh_cache = NULL;
   }
   MEM_SAFE_FREE(mesh->runtime.looptris.array);
+  mesh->runtime.looptris.len = 0;
+  mesh->runtime.looptris.len_alloc = 0;
+  MEM_SAFE_FREE(mesh->runtime.vert_normals);
+  mesh->runtime.cache_flag &= MESH_RUNTIME_NORMALS_DIRTY;
   /* TODO(sergey): Does this really belong here? */
   if (mesh->runtime.subdiv_ccg != NULL) {
     BKE_subdiv_ccg_destroy(mesh->runtime.subdiv_ccg);
@@ -241,6 +267,133 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
   BKE_shrinkwrap_discard_boundary_data(mesh);
 }
 
+/**
+ * Invalidate caches which depend on vertex positions only, to be called after changing
+ * #MVert.co without changing topology.
+ *
+ * Unlike #BKE_mesh_runtime_clear_geometry the looptris allocation is kept and filled in again
+ * on next access (triangulation of quads and ngons depends on positions).
+ */
+void BKE_mesh_runtime_tag_coords_changed(Mesh *mesh)
+{
+  mesh->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
+
+  if (mesh->runtime.looptris.array != NULL) {
+    mesh->runtime.cache_flag |= MESH_RUNTIME_LOOPTRIS_DIRTY;
+  }
+  mesh->runtime.cache_flag &= ~(MESH_RUNTIME_BOUNDS_VALID | MESH_RUNTIME_VERT_NORMALS_VALID);
+
+  if (mesh->runtime.bvh_cache) {
+    bvhcache_free(mesh->runtime.bvh_cache);
+    mesh->runtime.bvh_cache = NULL;
+  }
+  BKE_shrinkwrap_discard_boundary_data(mesh);
+}
+
+/**
+ * Invalidate data derived from the deform-verts, to be called after editing #Mesh.dvert in
+ * place (weight painting), see #Mesh_Runtime.deform_verts_edit_count.
+ */
+void BKE_mesh_runtime_tag_deform_verts_changed(Mesh *mesh)
+{
+  mesh->runtime.deform_verts_edit_count = mesh_deform_verts_edit_count_next();
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Mesh Bounds & Normals Cache
+ * \{ */
+
+/**
+ * Only cache bounds and normals of meshes which own their positions and are outside of #Main,
+ * original meshes and referenced layers may be edited in place without any tagging
+ * (edit-mode, sculpt mode).
+ */
+static bool mesh_runtime_use_cache(const Mesh *mesh)
+{
+  return (mesh->id.tag & (LIB_TAG_NO_MAIN | LIB_TAG_COPIED_ON_WRITE)) &&
+         !CustomData_is_referenced_layer((CustomData *)&mesh->vdata, CD_MVERT);
+}
+
+/**
+ * Same as #BKE_mesh_minmax, using bounds cached in the runtime data when possible.
+ */
+bool BKE_mesh_runtime_minmax(const Mesh *mesh, float r_min[3], float r_max[3])
+{
+  if (mesh->totvert == 0) {
+    return false;
+  }
+  if (!mesh_runtime_use_cache(mesh)) {
+    return BKE_mesh_minmax(mesh, r_min, r_max);
+  }
+
+  Mesh_Runtime *runtime = (Mesh_Runtime *)&mesh->runtime;
+
+  if (!(runtime->cache_flag & MESH_RUNTIME_BOUNDS_VALID)) {
+    ThreadMutex *mesh_eval_mutex = (ThreadMutex *)runtime->eval_mutex;
+    BLI_mutex_lock(mesh_eval_mutex);
+    if (!(runtime->cache_flag & MESH_RUNTIME_BOUNDS_VALID)) {
+      INIT_MINMAX(runtime->bounds_min, runtime->bounds_max);
+      BKE_mesh_minmax(mesh, runtime->bounds_min, runtime->bounds_max);
+      atomic_fetch_and_or_char(&runtime->cache_flag, (char)MESH_RUNTIME_BOUNDS_VALID);
+    }
+    BLI_mutex_unlock(mesh_eval_mutex);
+  }
+
+  minmax_v3v3_v3(r_min, r_max, runtime->bounds_min);
+  minmax_v3v3_v3(r_min, r_max, runtime->bounds_max);
+  return true;
+}
+
+static void mesh_vert_normals_to_float(const Mesh *mesh, float (*r_vert_normals)[3])
+{
+  const MVert *mv = mesh->mvert;
+  for (int i = 0; i < mesh->totvert; i++, mv++) {
+    normal_short_to_float_v3(r_vert_normals[i], mv->no);
+  }
+}
+
+/**
+ * Vertex normals as a contiguous float array, so loops over vertices don't have to stride over
+ * #MVert and convert from shorts for every access. Normals are only converted when requested
+ * and cached until positions or normals change.
+ *
+ * \param r_vert_normals_free: Set to the returned array when it could not be cached
+ * (see #mesh_runtime_use_cache, or normals tagged dirty), the caller must free it then.
+ */
+const float (*BKE_mesh_runtime_vert_normals_ensure(const Mesh *mesh,
+                                                    float (**r_vert_normals_free)[3]))[3]
+{
+  *r_vert_normals_free = NULL;
+
+  if (!mesh_runtime_use_cache(mesh) || (mesh->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY)) {
+    float(*vert_normals)[3] = MEM_malloc_arrayN(mesh->totvert, sizeof(float[3]), __func__);
+    mesh_vert_normals_to_float(mesh, vert_normals);
+    *r_vert_normals_free = vert_normals;
+    return (const float(*)[3])vert_normals;
+  }
+
+  Mesh_Runtime *runtime = (Mesh_Runtime *)&mesh->runtime;
+
+  if (!(runtime->cache_flag & MESH_RUNTIME_VERT_NORMALS_VALID)) {
+    ThreadMutex *mesh_eval_mutex = (ThreadMutex *)runtime->eval_mutex;
+    BLI_mutex_lock(mesh_eval_mutex);
+    if (!(runtime->cache_flag & MESH_RUNTIME_VERT_NORMALS_VALID)) {
+      /* Topology changes free the array, see #BKE_mesh_runtime_clear_geometry. */
+      if (runtime->vert_normals == NULL) {
+        runtime->vert_normals = MEM_malloc_arrayN(
+            mesh->totvert, sizeof(float[3]), "mesh runtime vert_normals");
+      }
+      mesh_vert_normals_to_float(mesh, runtime->vert_normals);
+      atomic_fetch_and_or_char(&runtime->cache_flag, (char)MESH_RUNTIME_VERT_NORMALS_VALID);
+    }
+    BLI_mutex_unlock(mesh_eval_mutex);
+  }
+
+  return (const float(*)[3])runtime->vert_normals;
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
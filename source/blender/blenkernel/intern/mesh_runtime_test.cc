@@ -0,0 +1,234 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_bvhutils.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
+
+namespace blender::bke::tests {
+
+class mesh_runtime_test : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+
+  Mesh *me_ = nullptr;
+
+  /* Strip of `len` quads along X, with normals and looptris computed. */
+  void SetUp() override
+  {
+    const int len = 4;
+    me_ = BKE_mesh_new_nomain((len + 1) * 2, 0, 0, len * 4, len);
+    for (int i = 0; i <= len; i++) {
+      copy_v3_fl3(me_->mvert[i * 2].co, (float)i, 0.0f, 0.0f);
+      copy_v3_fl3(me_->mvert[i * 2 + 1].co, (float)i, 1.0f, 0.0f);
+    }
+    for (int i = 0; i < len; i++) {
+      const int quad[4] = {i * 2, i * 2 + 2, i * 2 + 3, i * 2 + 1};
+      me_->mpoly[i].loopstart = i * 4;
+      me_->mpoly[i].totloop = 4;
+      for (int j = 0; j < 4; j++) {
+        me_->mloop[i * 4 + j].v = quad[j];
+      }
+    }
+    BKE_mesh_calc_edges(me_, false, false);
+    BKE_mesh_calc_normals(me_);
+    BKE_mesh_runtime_looptri_ensure(me_);
+  }
+
+  void TearDown() override
+  {
+    BKE_id_free(nullptr, me_);
+  }
+
+  /* Move all vertices up, without tagging. */
+  void translate_untagged(const float z)
+  {
+    for (int i = 0; i < me_->totvert; i++) {
+      me_->mvert[i].co[2] += z;
+    }
+  }
+
+  void bvh_cache_ensure()
+  {
+    BVHTreeFromMesh treedata = {nullptr};
+    BKE_bvhtree_from_mesh_get(&treedata, me_, BVHTREE_FROM_LOOPTRI, 2);
+    EXPECT_NE(treedata.tree, nullptr);
+    free_bvhtree_from_mesh(&treedata);
+  }
+};
+
+TEST_F(mesh_runtime_test, LooptriFastPath)
+{
+  const MLoopTri *looptri = me_->runtime.looptris.array;
+  ASSERT_NE(looptri, nullptr);
+  EXPECT_FALSE(me_->runtime.cache_flag & MESH_RUNTIME_LOOPTRIS_DIRTY);
+  EXPECT_EQ(me_->runtime.looptris.len, BKE_mesh_runtime_looptri_len(me_));
+
+  /* An up to date cache is returned as is, without touching the work in progress array. */
+  EXPECT_EQ(BKE_mesh_runtime_looptri_ensure(me_), looptri);
+  EXPECT_EQ(me_->runtime.looptris.array_wip, nullptr);
+}
+
+TEST_F(mesh_runtime_test, CoordsChanged)
+{
+  const MLoopTri *looptri = me_->runtime.looptris.array;
+  bvh_cache_ensure();
+  ASSERT_NE(me_->runtime.bvh_cache, nullptr);
+  EXPECT_FALSE(me_->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY);
+
+  float(*coords)[3] = BKE_mesh_vert_coords_alloc(me_, nullptr);
+  coords[0][2] = 1.0f;
+  BKE_mesh_vert_coords_apply(me_, coords);
+  MEM_freeN(coords);
+
+  /* Position dependent caches are invalidated. */
+  EXPECT_TRUE(me_->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY);
+  EXPECT_TRUE(me_->runtime.cache_flag & MESH_RUNTIME_LOOPTRIS_DIRTY);
+  EXPECT_EQ(me_->runtime.bvh_cache, nullptr);
+
+  /* The looptris allocation survives and is filled in again. */
+  EXPECT_EQ(me_->runtime.looptris.array, looptri);
+  EXPECT_EQ(BKE_mesh_runtime_looptri_ensure(me_), looptri);
+  EXPECT_FALSE(me_->runtime.cache_flag & MESH_RUNTIME_LOOPTRIS_DIRTY);
+
+  BKE_mesh_ensure_normals(me_);
+  EXPECT_FALSE(me_->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY);
+}
+
+TEST_F(mesh_runtime_test, TopologyChanged)
+{
+  bvh_cache_ensure();
+  float min[3], max[3];
+  INIT_MINMAX(min, max);
+  EXPECT_TRUE(BKE_mesh_runtime_minmax(me_, min, max));
+  me_->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
+
+  BKE_mesh_runtime_clear_geometry(me_);
+
+  /* All geometry caches are freed, not only tagged. */
+  EXPECT_EQ(me_->runtime.looptris.array, nullptr);
+  EXPECT_EQ(me_->runtime.looptris.len, 0);
+  EXPECT_FALSE(me_->runtime.cache_flag & MESH_RUNTIME_LOOPTRIS_DIRTY);
+  EXPECT_FALSE(me_->runtime.cache_flag & MESH_RUNTIME_BOUNDS_VALID);
+  EXPECT_EQ(me_->runtime.bvh_cache, nullptr);
+
+  /* Normals are stored in the vertices, whether they need an update is kept. */
+  EXPECT_TRUE(me_->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY);
+
+  EXPECT_NE(BKE_mesh_runtime_looptri_ensure(me_), nullptr);
+}
+
+TEST_F(mesh_runtime_test, MinMaxCache)
+{
+  float min[3], max[3];
+  INIT_MINMAX(min, max);
+  EXPECT_TRUE(BKE_mesh_runtime_minmax(me_, min, max));
+  EXPECT_TRUE(me_->runtime.cache_flag & MESH_RUNTIME_BOUNDS_VALID);
+  const float min_expect[3] = {0.0f, 0.0f, 0.0f}, max_expect[3] = {4.0f, 1.0f, 0.0f};
+  EXPECT_V3_NEAR(min, min_expect, 1e-6f);
+  EXPECT_V3_NEAR(max, max_expect, 1e-6f);
+
+  /* Without tagging the cached bounds are used. */
+  translate_untagged(2.0f);
+  INIT_MINMAX(min, max);
+  EXPECT_TRUE(BKE_mesh_runtime_minmax(me_, min, max));
+  EXPECT_EQ(max[2], 0.0f);
+
+  /* Bounds are computed again once positions are tagged as changed. */
+  BKE_mesh_runtime_tag_coords_changed(me_);
+  EXPECT_FALSE(me_->runtime.cache_flag & MESH_RUNTIME_BOUNDS_VALID);
+  INIT_MINMAX(min, max);
+  EXPECT_TRUE(BKE_mesh_runtime_minmax(me_, min, max));
+  EXPECT_EQ(min[2], 2.0f);
+  EXPECT_EQ(max[2], 2.0f);
+
+  /* Result bounds are extended, not replaced. */
+  float min_ext[3] = {-1.0f, -1.0f, -1.0f}, max_ext[3] = {0.0f, 0.0f, 0.0f};
+  EXPECT_TRUE(BKE_mesh_runtime_minmax(me_, min_ext, max_ext));
+  EXPECT_EQ(min_ext[2], -1.0f);
+  EXPECT_EQ(max_ext[0], 4.0f);
+}
+
+TEST_F(mesh_runtime_test, VertNormalsCache)
+{
+  float(*vert_normals_free)[3];
+  const float(*vert_normals)[3] = BKE_mesh_runtime_vert_normals_ensure(me_, &vert_normals_free);
+  EXPECT_EQ(vert_normals_free, nullptr);
+  EXPECT_EQ(vert_normals, me_->runtime.vert_normals);
+  EXPECT_TRUE(me_->runtime.cache_flag & MESH_RUNTIME_VERT_NORMALS_VALID);
+  for (int i = 0; i < me_->totvert; i++) {
+    float no[3];
+    normal_short_to_float_v3(no, me_->mvert[i].no);
+    EXPECT_V3_NEAR(vert_normals[i], no, 0.0f);
+  }
+
+  /* Cached normals are returned without converting again. */
+  EXPECT_EQ(BKE_mesh_runtime_vert_normals_ensure(me_, &vert_normals_free), vert_normals);
+  EXPECT_EQ(vert_normals_free, nullptr);
+
+  /* Dirty normals are converted into a temporary array, the cache is left untouched. */
+  BKE_mesh_runtime_tag_coords_changed(me_);
+  EXPECT_FALSE(me_->runtime.cache_flag & MESH_RUNTIME_VERT_NORMALS_VALID);
+  const float(*vert_normals_dirty)[3] = BKE_mesh_runtime_vert_normals_ensure(me_,
+                                                                             &vert_normals_free);
+  EXPECT_NE(vert_normals_free, nullptr);
+  EXPECT_EQ(vert_normals_dirty, vert_normals_free);
+  EXPECT_FALSE(me_->runtime.cache_flag & MESH_RUNTIME_VERT_NORMALS_VALID);
+  MEM_freeN(vert_normals_free);
+
+  /* Recomputed normals are converted again, reusing the allocation. */
+  BKE_mesh_ensure_normals(me_);
+  EXPECT_EQ(BKE_mesh_runtime_vert_normals_ensure(me_, &vert_normals_free), vert_normals);
+  EXPECT_EQ(vert_normals_free, nullptr);
+  float no[3];
+  normal_short_to_float_v3(no, me_->mvert[0].no);
+  EXPECT_V3_NEAR(vert_normals[0], no, 0.0f);
+
+  BKE_mesh_runtime_clear_geometry(me_);
+  EXPECT_EQ(me_->runtime.vert_normals, nullptr);
+  EXPECT_FALSE(me_->runtime.cache_flag & MESH_RUNTIME_VERT_NORMALS_VALID);
+}
+
+TEST_F(mesh_runtime_test, CopyKeepsNormalsDirty)
+{
+  bvh_cache_ensure();
+  me_->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
+
+  Mesh *me_copy = BKE_mesh_copy_for_eval(me_, false);
+  EXPECT_TRUE(me_copy->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY);
+  EXPECT_FALSE(me_copy->runtime.cache_flag & MESH_RUNTIME_BOUNDS_VALID);
+  EXPECT_EQ(me_copy->runtime.looptris.array, nullptr);
+  EXPECT_EQ(me_copy->runtime.bvh_cache, nullptr);
+  BKE_id_free(nullptr, me_copy);
+}
+
+}  // namespace blender::bke::tests
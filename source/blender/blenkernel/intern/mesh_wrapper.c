@@ -146,7 +146,7 @@ bool BKE_mesh_wrapper_minmax(const Mesh *me, float min[3], float max[3])
     case ME_WRAPPER_TYPE_BMESH:
       return BKE_editmesh_cache_calc_minmax(me->edit_mesh, me->runtime.edit_data, min, max);
     case ME_WRAPPER_TYPE_MDATA:
-      return BKE_mesh_minmax(me, min, max);
+      return BKE_mesh_runtime_minmax(me, min, max);
   }
   BLI_assert(0);
   return false;
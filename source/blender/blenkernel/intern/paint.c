@@ -1654,8 +1654,9 @@ static void sculpt_update_object(Depsgraph *depsgraph,
     ss->multires.active = false;
     ss->multires.modifier = NULL;
     ss->multires.level = 0;
-    ss->vmask = CustomData_get_layer(&me->vdata, CD_PAINT_MASK);
-    ss->vcol = CustomData_get_layer(&me->vdata, CD_PROP_COLOR);
+    /* Sculpting writes in-place, get layers which aren't shared with evaluated copies. */
+    ss->vmask = CustomData_duplicate_referenced_layer(&me->vdata, CD_PAINT_MASK, me->totvert);
+    ss->vcol = CustomData_duplicate_referenced_layer(&me->vdata, CD_PROP_COLOR, me->totvert);
   }
 
   /* Sculpt Face Sets. */
@@ -1666,7 +1667,8 @@ static void sculpt_update_object(Depsgraph *depsgraph,
        * function only the first time the Face Sets data-layer needs to be created. */
       BKE_sculpt_face_sets_ensure_from_base_mesh_visibility(me);
     }
-    ss->face_sets = CustomData_get_layer(&me->pdata, CD_SCULPT_FACE_SETS);
+    ss->face_sets = CustomData_duplicate_referenced_layer(
+        &me->pdata, CD_SCULPT_FACE_SETS, me->totpoly);
   }
   else {
     ss->face_sets = NULL;
@@ -1936,8 +1938,9 @@ void BKE_sculpt_face_sets_ensure_from_base_mesh_visibility(Mesh *mesh)
   bool initialize_new_face_sets = false;
 
   if (CustomData_has_layer(&mesh->pdata, CD_SCULPT_FACE_SETS)) {
-    /* Make everything visible. */
-    int *current_face_sets = CustomData_get_layer(&mesh->pdata, CD_SCULPT_FACE_SETS);
+    /* Make everything visible. The face sets may be shared with evaluated copies. */
+    int *current_face_sets = CustomData_duplicate_referenced_layer(
+        &mesh->pdata, CD_SCULPT_FACE_SETS, mesh->totpoly);
     for (int i = 0; i < mesh->totpoly; i++) {
       current_face_sets[i] = abs(current_face_sets[i]);
     }
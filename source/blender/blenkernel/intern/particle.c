@@ -2679,10 +2679,35 @@ void psys_find_parents(ParticleSimulationData *sim, const bool use_render_params
 
   BLI_kdtree_3d_balance(tree);
 
-  for (; p < totchild; p++, cpa++) {
-    psys_particle_on_emitter(
-        sim->psmd, from, cpa->num, DMCACHE_ISCHILD, cpa->fuv, cpa->foffset, co, 0, 0, 0, orco);
-    cpa->parent = BLI_kdtree_3d_find_nearest(tree, orco, NULL);
+  if (p < totchild) {
+    /* Look up the parents of all remaining children at once, this runs threaded. */
+    const int children_len = totchild - p;
+    float(*children_orco)[3] = MEM_mallocN(sizeof(*children_orco) * children_len, __func__);
+    int *children_parent = MEM_mallocN(sizeof(*children_parent) * children_len, __func__);
+
+    for (int i = 0; i < children_len; i++) {
+      psys_particle_on_emitter(sim->psmd,
+                               from,
+                               cpa[i].num,
+                               DMCACHE_ISCHILD,
+                               cpa[i].fuv,
+                               cpa[i].foffset,
+                               co,
+                               0,
+                               0,
+                               0,
+                               children_orco[i]);
+    }
+
+    BLI_kdtree_3d_find_nearest_batch(
+        tree, (const float(*)[3])children_orco, (uint)children_len, children_parent, NULL);
+
+    for (int i = 0; i < children_len; i++) {
+      cpa[i].parent = children_parent[i];
+    }
+
+    MEM_freeN(children_orco);
+    MEM_freeN(children_parent);
   }
 
   BLI_kdtree_3d_free(tree);
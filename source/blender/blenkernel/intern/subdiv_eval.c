@@ -61,11 +61,33 @@ bool BKE_subdiv_eval_begin(Subdiv *subdiv)
   return true;
 }
 
+/* Push coordinates of a continuous range of used coarse vertices to the evaluator. */
+static void set_coarse_positions_range(Subdiv *subdiv,
+                                       const Mesh *mesh,
+                                       const float (*coarse_vertex_cos)[3],
+                                       const int vertex_index,
+                                       const int manifold_vertex_index,
+                                       const int num_vertices)
+{
+  OpenSubdiv_Evaluator *evaluator = subdiv->evaluator;
+  if (coarse_vertex_cos != NULL) {
+    evaluator->setCoarsePositions(
+        evaluator, coarse_vertex_cos[vertex_index], manifold_vertex_index, num_vertices);
+  }
+  else {
+    evaluator->setCoarsePositionsFromBuffer(evaluator,
+                                            &mesh->mvert[vertex_index],
+                                            offsetof(MVert, co),
+                                            sizeof(MVert),
+                                            manifold_vertex_index,
+                                            num_vertices);
+  }
+}
+
 static void set_coarse_positions(Subdiv *subdiv,
                                  const Mesh *mesh,
                                  const float (*coarse_vertex_cos)[3])
 {
-  const MVert *mvert = mesh->mvert;
   const MLoop *mloop = mesh->mloop;
   const MPoly *mpoly = mesh->mpoly;
   /* Mark vertices which needs new coordinates. */
@@ -80,21 +102,32 @@ static void set_coarse_positions(Subdiv *subdiv,
       BLI_BITMAP_ENABLE(vertex_used_map, loop->v);
     }
   }
-  for (int vertex_index = 0, manifold_vertex_index = 0; vertex_index < mesh->totvert;
-       vertex_index++) {
-    if (!BLI_BITMAP_TEST_BOOL(vertex_used_map, vertex_index)) {
+  /* Used vertices are pushed in runs rather than one by one, so when there are no loose
+   * vertices all coordinates are uploaded with a single call. */
+  int run_start = -1;
+  int manifold_vertex_index = 0;
+  for (int vertex_index = 0; vertex_index < mesh->totvert; vertex_index++) {
+    if (BLI_BITMAP_TEST_BOOL(vertex_used_map, vertex_index)) {
+      if (run_start == -1) {
+        run_start = vertex_index;
+      }
       continue;
     }
-    const float *vertex_co;
-    if (coarse_vertex_cos != NULL) {
-      vertex_co = coarse_vertex_cos[vertex_index];
+    if (run_start != -1) {
+      const int run_len = vertex_index - run_start;
+      set_coarse_positions_range(
+          subdiv, mesh, coarse_vertex_cos, run_start, manifold_vertex_index, run_len);
+      manifold_vertex_index += run_len;
+      run_start = -1;
     }
-    else {
-      const MVert *vertex = &mvert[vertex_index];
-      vertex_co = vertex->co;
-    }
-    subdiv->evaluator->setCoarsePositions(subdiv->evaluator, vertex_co, manifold_vertex_index, 1);
-    manifold_vertex_index++;
+  }
+  if (run_start != -1) {
+    set_coarse_positions_range(subdiv,
+                               mesh,
+                               coarse_vertex_cos,
+                               run_start,
+                               manifold_vertex_index,
+                               mesh->totvert - run_start);
   }
   MEM_freeN(vertex_used_map);
 }
@@ -101,6 +101,11 @@ enum {
   /* calculate IsectRayPrecalc data */
   BVH_RAYCAST_WATERTIGHT = (1 << 0),
 };
+enum {
+  /* Split nodes using the surface area heuristic instead of the median,
+   * slower to build but faster to query for unevenly distributed leafs (large meshes). */
+  BVH_BALANCE_SAH = (1 << 0),
+};
 #define BVH_RAYCAST_DEFAULT (BVH_RAYCAST_WATERTIGHT)
 #define BVH_RAYCAST_DIST_MAX (FLT_MAX / 2.0f)
 
@@ -148,6 +153,7 @@ void BLI_bvhtree_free(BVHTree *tree);
 /* construct: first insert points, then call balance */
 void BLI_bvhtree_insert(BVHTree *tree, int index, const float co[3], int numpoints);
 void BLI_bvhtree_balance(BVHTree *tree);
+void BLI_bvhtree_balance_ex(BVHTree *tree, const int flag);
 
 /* update: first update points/nodes, then call update_tree to refit the bounding volumes */
 bool BLI_bvhtree_update_node(
@@ -179,6 +185,11 @@ int BLI_bvhtree_get_len(const BVHTree *tree);
 int BLI_bvhtree_get_tree_type(const BVHTree *tree);
 float BLI_bvhtree_get_epsilon(const BVHTree *tree);
 
+uint BLI_bvhtree_leafs_hash(const BVHTree *tree, const bool use_bounds);
+bool BLI_bvhtree_leafs_equal(const BVHTree *tree_a, const BVHTree *tree_b, const bool use_bounds);
+void BLI_bvhtree_refit_from_leafs(BVHTree *tree, const BVHTree *tree_src);
+float BLI_bvhtree_branches_extent_ratio(const BVHTree *tree);
+
 /* find nearest node to the given coordinates
  * (if nearest is given it will only search nodes where
  * square distance is smaller than nearest->dist) */
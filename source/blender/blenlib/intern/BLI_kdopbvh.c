@@ -40,7 +40,10 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_alloca.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_heap_simple.h"
 #include "BLI_kdopbvh.h"
 #include "BLI_math.h"
@@ -70,6 +73,12 @@
 #  define KDOPBVH_THREAD_LEAF_THRESHOLD 1024
 #endif
 
+/* Number of centroid bins per axis evaluated for each split of #BVH_BALANCE_SAH. */
+#define KDOPBVH_SAH_BINS 16
+/* Depth after which #BVH_BALANCE_SAH splits at the median, so uneven splits can't make the
+ * tree (and the recursion building it) as deep as the number of leafs. */
+#define KDOPBVH_SAH_MAX_DEPTH 32
+
 /* -------------------------------------------------------------------- */
 /** \name Struct Definitions
  * \{ */
@@ -863,6 +872,469 @@ static void non_recursive_bvh_div_nodes(const BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name SAH Tree Building
+ *
+ * Used by #BVH_BALANCE_SAH as an alternative to the implicit tree.
+ *
+ * The implicit tree always splits at the median of the largest axis, which gives a perfectly
+ * balanced tree but poor bounds when leafs are unevenly distributed (dense details on otherwise
+ * sparse meshes, long thin triangles...). Here every split minimizes the surface area heuristic,
+ * evaluated for #KDOPBVH_SAH_BINS bins of leaf centroids on each of the X, Y and Z axes.
+ * A branch with N children is built by splitting its leafs N - 1 times, always splitting the
+ * largest of the ranges created so far.
+ *
+ * The tree is no longer implicit, so branches are allocated on demand. All children of
+ * a branch are allocated at once after the branch itself, which keeps brother nodes sequential
+ * in memory and children after their parent, as expected by #BLI_bvhtree_update_tree.
+ * Sub-trees are built by tasks, the bounds of branches are joined bottom-up once all tasks
+ * are done.
+ * \{ */
+
+typedef struct BVHSahBin {
+  float bv[6];
+  int count;
+} BVHSahBin;
+
+typedef struct BVHSahBinning {
+  BVHSahBin bins[3][KDOPBVH_SAH_BINS];
+} BVHSahBinning;
+
+typedef struct BVHSahBinningData {
+  BVHNode **leafs_array;
+  /** Centroid bounds of the range, used to find the bin of every leaf. */
+  const float *centroid_bv;
+  float bin_scale[3];
+} BVHSahBinningData;
+
+typedef struct BVHSahBuildData {
+  BVHTree *tree;
+  BVHNode *branches_array;
+  /** Number of branches allocated from #branches_array, accessed atomically. */
+  int branches_len;
+} BVHSahBuildData;
+
+typedef struct BVHSahBuildTask {
+  BVHNode *node;
+  int begin, end;
+  int depth;
+} BVHSahBuildTask;
+
+static void bvh_sah_bv_init(float bv[6])
+{
+  for (int axis = 0; axis < 3; axis++) {
+    bv[2 * axis] = FLT_MAX;
+    bv[2 * axis + 1] = -FLT_MAX;
+  }
+}
+
+static void bvh_sah_bv_join(float bv[6], const float bv_other[6])
+{
+  for (int axis = 0; axis < 3; axis++) {
+    bv[2 * axis] = min_ff(bv[2 * axis], bv_other[2 * axis]);
+    bv[2 * axis + 1] = max_ff(bv[2 * axis + 1], bv_other[2 * axis + 1]);
+  }
+}
+
+/* Half of the surface area of the bounds, enough to compare costs. */
+static float bvh_sah_bv_area(const float bv[6])
+{
+  const float size[3] = {bv[1] - bv[0], bv[3] - bv[2], bv[5] - bv[4]};
+  return size[0] * size[1] + size[1] * size[2] + size[2] * size[0];
+}
+
+BLI_INLINE float bvh_sah_leaf_centroid(const BVHNode *leaf, const int axis)
+{
+  return (leaf->bv[2 * axis] + leaf->bv[2 * axis + 1]) * 0.5f;
+}
+
+BLI_INLINE int bvh_sah_leaf_bin(const BVHSahBinningData *data,
+                                const BVHNode *leaf,
+                                const int axis)
+{
+  const float offset = bvh_sah_leaf_centroid(leaf, axis) - data->centroid_bv[2 * axis];
+  const int bin = (int)(offset * data->bin_scale[axis]);
+  return min_ii(max_ii(bin, 0), KDOPBVH_SAH_BINS - 1);
+}
+
+static void bvh_sah_centroid_bounds_cb(void *__restrict userdata,
+                                       const int i,
+                                       const TaskParallelTLS *__restrict tls)
+{
+  const BVHSahBinningData *data = userdata;
+  float *centroid_bv = tls->userdata_chunk;
+  const BVHNode *leaf = data->leafs_array[i];
+
+  for (int axis = 0; axis < 3; axis++) {
+    const float centroid = bvh_sah_leaf_centroid(leaf, axis);
+    centroid_bv[2 * axis] = min_ff(centroid_bv[2 * axis], centroid);
+    centroid_bv[2 * axis + 1] = max_ff(centroid_bv[2 * axis + 1], centroid);
+  }
+}
+
+static void bvh_sah_centroid_bounds_reduce(const void *__restrict UNUSED(userdata),
+                                           void *__restrict chunk_join,
+                                           void *__restrict chunk)
+{
+  bvh_sah_bv_join(chunk_join, chunk);
+}
+
+static void bvh_sah_binning_cb(void *__restrict userdata,
+                               const int i,
+                               const TaskParallelTLS *__restrict tls)
+{
+  const BVHSahBinningData *data = userdata;
+  BVHSahBinning *binning = tls->userdata_chunk;
+  const BVHNode *leaf = data->leafs_array[i];
+
+  for (int axis = 0; axis < 3; axis++) {
+    BVHSahBin *bin = &binning->bins[axis][bvh_sah_leaf_bin(data, leaf, axis)];
+    bvh_sah_bv_join(bin->bv, leaf->bv);
+    bin->count++;
+  }
+}
+
+static void bvh_sah_binning_reduce(const void *__restrict UNUSED(userdata),
+                                   void *__restrict chunk_join,
+                                   void *__restrict chunk)
+{
+  BVHSahBinning *binning_join = chunk_join;
+  const BVHSahBinning *binning = chunk;
+
+  for (int axis = 0; axis < 3; axis++) {
+    for (int i = 0; i < KDOPBVH_SAH_BINS; i++) {
+      bvh_sah_bv_join(binning_join->bins[axis][i].bv, binning->bins[axis][i].bv);
+      binning_join->bins[axis][i].count += binning->bins[axis][i].count;
+    }
+  }
+}
+
+/**
+ * Split the leafs in range [begin, end) at the median of the axis with the largest extent
+ * of \a centroid_bv.
+ */
+static int bvh_sah_split_median(BVHNode **leafs_array,
+                                const int begin,
+                                const int end,
+                                const float centroid_bv[6],
+                                char *r_axis)
+{
+  int axis = 0;
+  for (int i = 1; i < 3; i++) {
+    if (centroid_bv[2 * i + 1] - centroid_bv[2 * i] >
+        centroid_bv[2 * axis + 1] - centroid_bv[2 * axis]) {
+      axis = i;
+    }
+  }
+  const int split = (begin + end) / 2;
+  partition_nth_element(leafs_array, begin, end, split, 2 * axis + 1);
+  *r_axis = (char)axis;
+  return split;
+}
+
+/**
+ * Split the leafs in range [begin, end) into two non-empty ranges.
+ *
+ * \param use_median: Split at the median of the axis with the largest centroid extent instead
+ * of minimizing the surface area heuristic.
+ * \param r_axis: The axis of the split, in the X, Y, Z order used by #BVHNode.main_axis.
+ * \return The index of the first leaf of the second range.
+ */
+static int bvh_sah_split(BVHNode **leafs_array,
+                         const int begin,
+                         const int end,
+                         const bool use_median,
+                         char *r_axis)
+{
+  BVHSahBinningData data = {.leafs_array = leafs_array};
+  BVHSahBinning binning;
+  /* Bounds of all centroids, only the X, Y and Z axes are used. */
+  float centroid_bv[6];
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (end - begin > KDOPBVH_THREAD_LEAF_THRESHOLD);
+  settings.min_iter_per_thread = 1024;
+
+  /* Bounds of the centroids define the bins. */
+  bvh_sah_bv_init(centroid_bv);
+  settings.userdata_chunk = centroid_bv;
+  settings.userdata_chunk_size = sizeof(centroid_bv);
+  settings.func_reduce = bvh_sah_centroid_bounds_reduce;
+  BLI_task_parallel_range(begin, end, &data, bvh_sah_centroid_bounds_cb, &settings);
+
+  bool is_degenerate = true;
+  data.centroid_bv = centroid_bv;
+  for (int axis = 0; axis < 3; axis++) {
+    const float extent = centroid_bv[2 * axis + 1] - centroid_bv[2 * axis];
+    if (extent > 0.0f) {
+      data.bin_scale[axis] = (float)KDOPBVH_SAH_BINS / extent;
+      is_degenerate = false;
+    }
+    else {
+      data.bin_scale[axis] = 0.0f;
+    }
+  }
+
+  if (is_degenerate) {
+    /* All centroids are the same, any split is as good as the median. */
+    *r_axis = 0;
+    return (begin + end) / 2;
+  }
+
+  if (use_median) {
+    return bvh_sah_split_median(leafs_array, begin, end, centroid_bv, r_axis);
+  }
+
+  for (int axis = 0; axis < 3; axis++) {
+    for (int i = 0; i < KDOPBVH_SAH_BINS; i++) {
+      bvh_sah_bv_init(binning.bins[axis][i].bv);
+      binning.bins[axis][i].count = 0;
+    }
+  }
+  settings.userdata_chunk = &binning;
+  settings.userdata_chunk_size = sizeof(binning);
+  settings.func_reduce = bvh_sah_binning_reduce;
+  BLI_task_parallel_range(begin, end, &data, bvh_sah_binning_cb, &settings);
+
+  /* Sweep the bins from both sides, the cost of splitting after bin `i` is
+   * `area(left) * count(left) + area(right) * count(right)`. */
+  float best_cost = FLT_MAX;
+  int best_axis = -1, best_bin = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    if (data.bin_scale[axis] == 0.0f) {
+      continue;
+    }
+    const BVHSahBin *bins = binning.bins[axis];
+    float cost_right[KDOPBVH_SAH_BINS];
+    float bv[6];
+    int count = 0;
+
+    bvh_sah_bv_init(bv);
+    for (int i = KDOPBVH_SAH_BINS - 1; i > 0; i--) {
+      bvh_sah_bv_join(bv, bins[i].bv);
+      count += bins[i].count;
+      cost_right[i - 1] = count ? bvh_sah_bv_area(bv) * (float)count : 0.0f;
+    }
+
+    bvh_sah_bv_init(bv);
+    count = 0;
+    for (int i = 0; i < KDOPBVH_SAH_BINS - 1; i++) {
+      bvh_sah_bv_join(bv, bins[i].bv);
+      count += bins[i].count;
+      if (count == 0 || count == end - begin) {
+        continue;
+      }
+      const float cost = bvh_sah_bv_area(bv) * (float)count + cost_right[i];
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_bin = i;
+      }
+    }
+  }
+
+  /* A non-zero extent always has its first and last bin filled, so a split is found unless
+   * the costs overflow for huge bounds. */
+  if (best_axis == -1) {
+    return bvh_sah_split_median(leafs_array, begin, end, centroid_bv, r_axis);
+  }
+
+  /* Move leafs of the bins up to `best_bin` to the start of the range. */
+  int i = begin, j = end - 1;
+  while (true) {
+    while (i <= j && bvh_sah_leaf_bin(&data, leafs_array[i], best_axis) <= best_bin) {
+      i++;
+    }
+    while (i <= j && bvh_sah_leaf_bin(&data, leafs_array[j], best_axis) > best_bin) {
+      j--;
+    }
+    if (i >= j) {
+      break;
+    }
+    SWAP(BVHNode *, leafs_array[i], leafs_array[j]);
+  }
+  BLI_assert(i > begin && i < end);
+
+  *r_axis = (char)best_axis;
+  return i;
+}
+
+static void bvh_sah_build_task_cb(TaskPool *__restrict pool, void *taskdata);
+
+static void bvh_sah_build_node(TaskPool *pool,
+                               BVHSahBuildData *data,
+                               BVHNode *node,
+                               const int begin,
+                               const int end,
+                               const int depth)
+{
+  BVHTree *tree = data->tree;
+  BVHNode **leafs_array = tree->nodes;
+  /* Children take the leafs in ranges [bounds[k], bounds[k + 1]). */
+  int bounds[MAX_TREETYPE + 1];
+  int totnode = 1;
+
+  bounds[0] = begin;
+  bounds[1] = end;
+
+  while (totnode < tree->tree_type) {
+    int k_split = -1;
+    for (int k = 0; k < totnode; k++) {
+      const int len = bounds[k + 1] - bounds[k];
+      if (len > 1 && (k_split == -1 || len > bounds[k_split + 1] - bounds[k_split])) {
+        k_split = k;
+      }
+    }
+    if (k_split == -1) {
+      break;
+    }
+
+    char split_axis;
+    const int split = bvh_sah_split(leafs_array,
+                                    bounds[k_split],
+                                    bounds[k_split + 1],
+                                    depth >= KDOPBVH_SAH_MAX_DEPTH,
+                                    &split_axis);
+    if (totnode == 1) {
+      node->main_axis = split_axis;
+    }
+
+    memmove(&bounds[k_split + 2],
+            &bounds[k_split + 1],
+            sizeof(*bounds) * (size_t)(totnode - k_split));
+    bounds[k_split + 1] = split;
+    totnode++;
+  }
+
+  int branches_len = 0;
+  for (int k = 0; k < totnode; k++) {
+    if (bounds[k + 1] - bounds[k] > 1) {
+      branches_len++;
+    }
+  }
+  BVHNode *branches = &data->branches_array[atomic_fetch_and_add_int32(&data->branches_len,
+                                                                       branches_len)];
+
+  for (int k = 0; k < totnode; k++) {
+    const int child_begin = bounds[k], child_end = bounds[k + 1];
+    BVHNode *child;
+
+    if (child_end - child_begin == 1) {
+      child = leafs_array[child_begin];
+    }
+    else {
+      child = branches++;
+      if (child_end - child_begin > KDOPBVH_THREAD_LEAF_THRESHOLD) {
+        BVHSahBuildTask *task = MEM_mallocN(sizeof(*task), __func__);
+        task->node = child;
+        task->begin = child_begin;
+        task->end = child_end;
+        task->depth = depth + 1;
+        BLI_task_pool_push(pool, bvh_sah_build_task_cb, task, true, NULL);
+      }
+      else {
+        bvh_sah_build_node(pool, data, child, child_begin, child_end, depth + 1);
+      }
+    }
+
+    node->children[k] = child;
+    child->parent = node;
+  }
+  node->totnode = (char)totnode;
+}
+
+static void bvh_sah_build_task_cb(TaskPool *__restrict pool, void *taskdata)
+{
+  BVHSahBuildData *data = BLI_task_pool_user_data(pool);
+  BVHSahBuildTask *task = taskdata;
+
+  bvh_sah_build_node(pool, data, task->node, task->begin, task->end, task->depth);
+}
+
+/**
+ * The implicit tree needs less branches than a tree where branches may have less children
+ * than the tree type, ensure there is room for the worst case of `totleaf - 1` branches.
+ */
+static void bvh_sah_ensure_branches_len(BVHTree *tree, const int branches_len)
+{
+  const int numnodes_alloc = (int)(MEM_allocN_len(tree->nodearray) / sizeof(BVHNode));
+  const int numnodes = tree->totleaf + branches_len;
+
+  if (numnodes <= numnodes_alloc) {
+    return;
+  }
+
+  BVHNode *nodearray = MEM_callocN(sizeof(BVHNode) * (size_t)numnodes, "BVHNodeArray");
+  float *nodebv = MEM_callocN(sizeof(float) * (size_t)(tree->axis * numnodes), "BVHNodeBV");
+  BVHNode **nodechild = MEM_callocN(sizeof(BVHNode *) * (size_t)(tree->tree_type * numnodes),
+                                    "BVHNodeBV");
+
+  /* Leafs are not linked to anything yet, only their bounds and indices need to be kept. */
+  memcpy(nodearray, tree->nodearray, sizeof(BVHNode) * (size_t)tree->totleaf);
+  memcpy(nodebv, tree->nodebv, sizeof(float) * (size_t)(tree->axis * tree->totleaf));
+
+  for (int i = 0; i < numnodes; i++) {
+    nodearray[i].bv = &nodebv[i * tree->axis];
+    nodearray[i].children = &nodechild[i * tree->tree_type];
+  }
+
+  MEM_freeN(tree->nodes);
+  MEM_freeN(tree->nodearray);
+  MEM_freeN(tree->nodebv);
+  MEM_freeN(tree->nodechild);
+
+  tree->nodes = MEM_mallocN(sizeof(BVHNode *) * (size_t)numnodes, "BVHNodes");
+  tree->nodearray = nodearray;
+  tree->nodebv = nodebv;
+  tree->nodechild = nodechild;
+
+  for (int i = 0; i < tree->totleaf; i++) {
+    tree->nodes[i] = &nodearray[i];
+  }
+}
+
+static void bvh_sah_build(BVHTree *tree)
+{
+  const int totleaf = tree->totleaf;
+
+  BLI_assert(totleaf > 1);
+  BLI_assert(tree->start_axis == 0);
+
+#ifdef DEBUG
+  /* Leafs are still in the order they were inserted. */
+  for (int i = 0; i < totleaf; i++) {
+    BLI_assert(tree->nodes[i] == &tree->nodearray[i]);
+  }
+#endif
+
+  bvh_sah_ensure_branches_len(tree, totleaf - 1);
+
+  BVHSahBuildData data = {
+      .tree = tree,
+      .branches_array = tree->nodearray + totleaf,
+      .branches_len = 1,
+  };
+
+  BVHNode *root = data.branches_array;
+  root->parent = NULL;
+
+  TaskPool *pool = BLI_task_pool_create(&data, TASK_PRIORITY_HIGH);
+  bvh_sah_build_node(pool, &data, root, 0, totleaf, 0);
+  BLI_task_pool_work_and_wait(pool);
+  BLI_task_pool_free(pool);
+
+  tree->totbranch = data.branches_len;
+  for (int i = 0; i < tree->totbranch; i++) {
+    tree->nodes[totleaf + i] = &tree->nodearray[totleaf + i];
+  }
+
+  /* Children are always after their parent, so this joins bounds bottom-up. */
+  BLI_bvhtree_update_tree(tree);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree API
  * \{ */
@@ -953,7 +1425,11 @@ void BLI_bvhtree_free(BVHTree *tree)
   }
 }
 
-void BLI_bvhtree_balance(BVHTree *tree)
+/**
+ * \param flag: #BVH_BALANCE_SAH is only used for trees with at least 2 leafs and
+ * X, Y, Z axes (all k-DOP types except 18), otherwise the implicit tree is built.
+ */
+void BLI_bvhtree_balance_ex(BVHTree *tree, const int flag)
 {
   BVHNode **leafs_array = tree->nodes;
 
@@ -961,15 +1437,20 @@ void BLI_bvhtree_balance(BVHTree *tree)
    * (some big bug goes here if its being called more than once per tree) */
   BLI_assert(tree->totbranch == 0);
 
-  /* Build the implicit tree */
-  non_recursive_bvh_div_nodes(
-      tree, tree->nodearray + (tree->totleaf - 1), leafs_array, tree->totleaf);
+  if ((flag & BVH_BALANCE_SAH) && (tree->totleaf > 1) && (tree->start_axis == 0)) {
+    bvh_sah_build(tree);
+  }
+  else {
+    /* Build the implicit tree */
+    non_recursive_bvh_div_nodes(
+        tree, tree->nodearray + (tree->totleaf - 1), leafs_array, tree->totleaf);
 
-  /* current code expects the branches to be linked to the nodes array
-   * we perform that linkage here */
-  tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
-  for (int i = 0; i < tree->totbranch; i++) {
-    tree->nodes[tree->totleaf + i] = &tree->nodearray[tree->totleaf + i];
+    /* current code expects the branches to be linked to the nodes array
+     * we perform that linkage here */
+    tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
+    for (int i = 0; i < tree->totbranch; i++) {
+      tree->nodes[tree->totleaf + i] = &tree->nodearray[tree->totleaf + i];
+    }
   }
 
 #ifdef USE_SKIP_LINKS
@@ -985,6 +1466,11 @@ void BLI_bvhtree_balance(BVHTree *tree)
 #endif
 }
 
+void BLI_bvhtree_balance(BVHTree *tree)
+{
+  BLI_bvhtree_balance_ex(tree, 0);
+}
+
 static void bvhtree_node_inflate(const BVHTree *tree, BVHNode *node, const float dist)
 {
   axis_t axis_iter;
@@ -1076,6 +1562,100 @@ float BLI_bvhtree_get_epsilon(const BVHTree *tree)
   return tree->epsilon;
 }
 
+/**
+ * Hash of the leafs in the order they were inserted, using their indices and optionally their
+ * bounds. Equal trees have equal hashes, use #BLI_bvhtree_leafs_equal to check for collisions.
+ * Can be used before and after balancing.
+ */
+uint BLI_bvhtree_leafs_hash(const BVHTree *tree, const bool use_bounds)
+{
+  const size_t bv_size = sizeof(float) * (size_t)(2 * (tree->stop_axis - tree->start_axis));
+  BLI_HashMurmur2A mm2;
+
+  BLI_hash_mm2a_init(&mm2, (uint32_t)tree->totleaf);
+  BLI_hash_mm2a_add_int(&mm2, tree->tree_type);
+  BLI_hash_mm2a_add_int(&mm2, tree->axis);
+
+  for (int i = 0; i < tree->totleaf; i++) {
+    const BVHNode *node = &tree->nodearray[i];
+    BLI_hash_mm2a_add_int(&mm2, node->index);
+    if (use_bounds) {
+      BLI_hash_mm2a_add(&mm2, (const uchar *)&node->bv[2 * tree->start_axis], bv_size);
+    }
+  }
+  return BLI_hash_mm2a_end(&mm2);
+}
+
+/**
+ * Check both trees have the same leafs inserted in the same order,
+ * with the same bounds when \a use_bounds is set.
+ */
+bool BLI_bvhtree_leafs_equal(const BVHTree *tree_a, const BVHTree *tree_b, const bool use_bounds)
+{
+  const size_t bv_size = sizeof(float) * (size_t)(2 * (tree_a->stop_axis - tree_a->start_axis));
+
+  if ((tree_a->totleaf != tree_b->totleaf) || (tree_a->tree_type != tree_b->tree_type) ||
+      (tree_a->axis != tree_b->axis) || (tree_a->epsilon != tree_b->epsilon)) {
+    return false;
+  }
+
+  for (int i = 0; i < tree_a->totleaf; i++) {
+    const BVHNode *node_a = &tree_a->nodearray[i];
+    const BVHNode *node_b = &tree_b->nodearray[i];
+    if (node_a->index != node_b->index) {
+      return false;
+    }
+    if (use_bounds && memcmp(&node_a->bv[2 * tree_a->start_axis],
+                             &node_b->bv[2 * tree_a->start_axis],
+                             bv_size)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Refit a balanced tree to the leaf bounds of \a tree_src, which only has leafs inserted.
+ * Both trees must have the same leafs, see #BLI_bvhtree_leafs_equal.
+ *
+ * This is much faster than balancing a new tree, but the tree structure isn't adapted to the
+ * new bounds, so query performance degrades as leafs move further from where they were.
+ */
+void BLI_bvhtree_refit_from_leafs(BVHTree *tree, const BVHTree *tree_src)
+{
+  BLI_assert(BLI_bvhtree_leafs_equal(tree, tree_src, false));
+  BLI_assert(tree_src->totbranch == 0);
+
+  for (int i = 0; i < tree->totleaf; i++) {
+    memcpy(tree->nodearray[i].bv, tree_src->nodearray[i].bv, sizeof(float) * (size_t)tree->axis);
+  }
+  BLI_bvhtree_update_tree(tree);
+}
+
+/**
+ * Sum of the extents of all branches along every axis of the tree, relative to the extent of
+ * the root. Scaling the leafs doesn't change it, but it grows when leafs move so branches
+ * overlap more, which tells when a refit tree is worth balancing again.
+ */
+float BLI_bvhtree_branches_extent_ratio(const BVHTree *tree)
+{
+  float extent_root = 0.0f, extent_sum = 0.0f;
+
+  for (int i = 0; i < tree->totbranch; i++) {
+    const BVHNode *node = tree->nodes[tree->totleaf + i];
+    float extent = 0.0f;
+    for (axis_t axis = tree->start_axis; axis < tree->stop_axis; axis++) {
+      extent += node->bv[2 * axis + 1] - node->bv[2 * axis];
+    }
+    if (i == 0) {
+      /* The root is always the first branch. */
+      extent_root = extent;
+    }
+    extent_sum += extent;
+  }
+  return (extent_root > 0.0f) ? extent_sum / extent_root : 0.0f;
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
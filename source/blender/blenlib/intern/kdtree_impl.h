@@ -22,9 +22,11 @@
 
 #include "BLI_kdtree_impl.h"
 #include "BLI_math.h"
-#include "BLI_strict_flags.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
+#include "BLI_strict_flags.h"
+
 #define _CONCAT_AUX(MACRO_ARG1, MACRO_ARG2) MACRO_ARG1##MACRO_ARG2
 #define _CONCAT(MACRO_ARG1, MACRO_ARG2) _CONCAT_AUX(MACRO_ARG1, MACRO_ARG2)
 #define BLI_kdtree_nd_(id) _CONCAT(KDTREE_PREFIX_ID, _##id)
@@ -58,6 +60,10 @@ struct KDTree {
 
 #define KD_NODE_UNSET ((uint)-1)
 
+/* Ranges with less nodes are balanced (or queried) on a single thread. */
+#define KD_BALANCE_THREAD_NODES_MIN 4096
+#define KD_BATCH_THREAD_QUERIES_MIN 1024
+
 /**
  * When set we know all values are unbalanced,
  * otherwise clear them when re-balancing: see T62210.
@@ -145,19 +151,12 @@ void BLI_kdtree_nd_(insert)(KDTree *tree, int index, const float co[KD_DIMS])
 #endif
 }
 
-static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
+/* Partition the nodes around their median along `axis`, returns the median. */
+static uint kdtree_balance_partition(KDTreeNode *nodes, uint nodes_len, uint axis)
 {
-  KDTreeNode *node;
   float co;
   uint left, right, median, i, j;
 
-  if (nodes_len <= 0) {
-    return KD_NODE_UNSET;
-  }
-  else if (nodes_len == 1) {
-    return 0 + ofs;
-  }
-
   /* quicksort style sorting around median */
   left = 0;
   right = nodes_len - 1;
@@ -190,6 +189,23 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
     }
   }
 
+  return median;
+}
+
+static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
+{
+  KDTreeNode *node;
+  uint median;
+
+  if (nodes_len <= 0) {
+    return KD_NODE_UNSET;
+  }
+  else if (nodes_len == 1) {
+    return 0 + ofs;
+  }
+
+  median = kdtree_balance_partition(nodes, nodes_len, axis);
+
   /* set node and sort subnodes */
   node = &nodes[median];
   node->d = axis;
@@ -201,6 +217,75 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
   return median + ofs;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Threaded Balancing
+ *
+ * Each partition only touches the nodes of its own range, so both halves of a partitioned
+ * range are balanced as separate tasks until they are small enough to be handled recursively.
+ * The resulting tree is identical to the one built by #kdtree_balance.
+ * \{ */
+
+typedef struct KDTreeBalanceTask {
+  KDTreeNode *nodes;
+  uint nodes_len;
+  uint axis;
+  uint ofs;
+  /* Where to store the index of the root node of this range. */
+  uint *r_node;
+} KDTreeBalanceTask;
+
+static void kdtree_balance_task_cb(TaskPool *__restrict pool, void *taskdata);
+
+static void kdtree_balance_task_push(
+    TaskPool *pool, KDTreeNode *nodes, uint nodes_len, uint axis, uint ofs, uint *r_node)
+{
+  if (nodes_len < KD_BALANCE_THREAD_NODES_MIN) {
+    *r_node = kdtree_balance(nodes, nodes_len, axis, ofs);
+    return;
+  }
+
+  KDTreeBalanceTask *task = MEM_mallocN(sizeof(*task), __func__);
+  task->nodes = nodes;
+  task->nodes_len = nodes_len;
+  task->axis = axis;
+  task->ofs = ofs;
+  task->r_node = r_node;
+  BLI_task_pool_push(pool, kdtree_balance_task_cb, task, true, NULL);
+}
+
+static void kdtree_balance_task_cb(TaskPool *__restrict pool, void *taskdata)
+{
+  const KDTreeBalanceTask *task = taskdata;
+  KDTreeNode *nodes = task->nodes;
+  const uint nodes_len = task->nodes_len;
+  const uint median = kdtree_balance_partition(nodes, nodes_len, task->axis);
+  const uint axis = (task->axis + 1) % KD_DIMS;
+
+  KDTreeNode *node = &nodes[median];
+  node->d = task->axis;
+  *task->r_node = median + task->ofs;
+
+  kdtree_balance_task_push(pool, nodes, median, axis, task->ofs, &node->left);
+  kdtree_balance_task_push(pool,
+                           nodes + median + 1,
+                           nodes_len - (median + 1),
+                           axis,
+                           (median + 1) + task->ofs,
+                           &node->right);
+}
+
+static uint kdtree_balance_threaded(KDTreeNode *nodes, uint nodes_len)
+{
+  uint root = KD_NODE_UNSET;
+  TaskPool *pool = BLI_task_pool_create(NULL, TASK_PRIORITY_HIGH);
+  kdtree_balance_task_push(pool, nodes, nodes_len, 0, 0, &root);
+  BLI_task_pool_work_and_wait(pool);
+  BLI_task_pool_free(pool);
+  return root;
+}
+
+/** \} */
+
 void BLI_kdtree_nd_(balance)(KDTree *tree)
 {
   if (tree->root != KD_NODE_ROOT_IS_INIT) {
@@ -210,7 +295,12 @@ void BLI_kdtree_nd_(balance)(KDTree *tree)
     }
   }
 
-  tree->root = kdtree_balance(tree->nodes, tree->nodes_len, 0, 0);
+  if (tree->nodes_len >= KD_BALANCE_THREAD_NODES_MIN) {
+    tree->root = kdtree_balance_threaded(tree->nodes, tree->nodes_len);
+  }
+  else {
+    tree->root = kdtree_balance(tree->nodes, tree->nodes_len, 0, 0);
+  }
 
 #ifdef DEBUG
   tree->is_balanced = true;
@@ -230,6 +320,30 @@ static uint *realloc_nodes(uint *stack, uint *stack_len_capacity, const bool is_
   return stack_new;
 }
 
+/**
+ * Stack item for searches that also store a lower bound of the squared distance of the
+ * search coordinate to all nodes in the sub-tree, so sub-trees on the far side of a splitting
+ * plane can be skipped when a closer node was found since they were pushed.
+ */
+typedef struct KDTreeStackNode {
+  uint node;
+  float dist_sq;
+} KDTreeStackNode;
+
+static KDTreeStackNode *realloc_stack_nodes(KDTreeStackNode *stack,
+                                            uint *stack_len_capacity,
+                                            const bool is_alloc)
+{
+  KDTreeStackNode *stack_new = MEM_mallocN(
+      (*stack_len_capacity + KD_NEAR_ALLOC_INC) * sizeof(KDTreeStackNode), "KDTree.treestack");
+  memcpy(stack_new, stack, *stack_len_capacity * sizeof(KDTreeStackNode));
+  if (is_alloc) {
+    MEM_freeN(stack);
+  }
+  *stack_len_capacity += KD_NEAR_ALLOC_INC;
+  return stack_new;
+}
+
 /**
  * Find nearest returns index, and -1 if no node is found.
  */
@@ -238,8 +352,8 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
                                  KDTreeNearest *r_nearest)
 {
   const KDTreeNode *nodes = tree->nodes;
-  const KDTreeNode *root, *min_node;
-  uint *stack, stack_default[KD_STACK_INIT];
+  const KDTreeNode *min_node;
+  KDTreeStackNode *stack, stack_default[KD_STACK_INIT];
   float min_dist, cur_dist;
   uint stack_len_capacity, cur = 0;
 
@@ -254,68 +368,49 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
   stack = stack_default;
   stack_len_capacity = KD_STACK_INIT;
 
-  root = &nodes[tree->root];
-  min_node = root;
-  min_dist = len_squared_vnvn(root->co, co);
+  min_node = &nodes[tree->root];
+  min_dist = len_squared_vnvn(min_node->co, co);
 
-  if (co[root->d] < root->co[root->d]) {
-    if (root->right != KD_NODE_UNSET) {
-      stack[cur++] = root->right;
-    }
-    if (root->left != KD_NODE_UNSET) {
-      stack[cur++] = root->left;
-    }
-  }
-  else {
-    if (root->left != KD_NODE_UNSET) {
-      stack[cur++] = root->left;
-    }
-    if (root->right != KD_NODE_UNSET) {
-      stack[cur++] = root->right;
-    }
-  }
+  stack[cur].node = tree->root;
+  stack[cur++].dist_sq = 0.0f;
 
   while (cur--) {
-    const KDTreeNode *node = &nodes[stack[cur]];
+    const float bound_dist = stack[cur].dist_sq;
+    if (bound_dist >= min_dist) {
+      continue;
+    }
 
-    cur_dist = node->co[node->d] - co[node->d];
+    const KDTreeNode *node = &nodes[stack[cur].node];
+    uint node_near, node_far;
 
+    cur_dist = node->co[node->d] - co[node->d];
     if (cur_dist < 0.0f) {
-      cur_dist = -cur_dist * cur_dist;
-
-      if (-cur_dist < min_dist) {
-        cur_dist = len_squared_vnvn(node->co, co);
-        if (cur_dist < min_dist) {
-          min_dist = cur_dist;
-          min_node = node;
-        }
-        if (node->left != KD_NODE_UNSET) {
-          stack[cur++] = node->left;
-        }
-      }
-      if (node->right != KD_NODE_UNSET) {
-        stack[cur++] = node->right;
-      }
+      node_near = node->right;
+      node_far = node->left;
     }
     else {
-      cur_dist = cur_dist * cur_dist;
+      node_near = node->left;
+      node_far = node->right;
+    }
+    cur_dist = cur_dist * cur_dist;
 
-      if (cur_dist < min_dist) {
-        cur_dist = len_squared_vnvn(node->co, co);
-        if (cur_dist < min_dist) {
-          min_dist = cur_dist;
-          min_node = node;
-        }
-        if (node->right != KD_NODE_UNSET) {
-          stack[cur++] = node->right;
-        }
+    if (cur_dist < min_dist) {
+      const float dist = len_squared_vnvn(node->co, co);
+      if (dist < min_dist) {
+        min_dist = dist;
+        min_node = node;
       }
-      if (node->left != KD_NODE_UNSET) {
-        stack[cur++] = node->left;
+      if (node_far != KD_NODE_UNSET) {
+        stack[cur].node = node_far;
+        stack[cur++].dist_sq = max_ff(cur_dist, bound_dist);
       }
     }
+    if (node_near != KD_NODE_UNSET) {
+      stack[cur].node = node_near;
+      stack[cur++].dist_sq = bound_dist;
+    }
     if (UNLIKELY(cur + KD_DIMS > stack_len_capacity)) {
-      stack = realloc_nodes(stack, &stack_len_capacity, stack_default != stack);
+      stack = realloc_stack_nodes(stack, &stack_len_capacity, stack_default != stack);
     }
   }
 
@@ -806,6 +901,136 @@ finally:
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Batched Queries
+ *
+ * Run many independent queries on the same tree, spread over multiple threads.
+ * \{ */
+
+typedef struct KDTreeBatchData {
+  const KDTree *tree;
+  const float (*co)[KD_DIMS];
+
+  /* Find nearest. */
+  int *r_index;
+  KDTreeNearest *r_nearest;
+
+  /* Range search. */
+  float range;
+  bool (*search_cb)(
+      void *user_data, int co_index, int index, const float co[KD_DIMS], float dist_sq);
+  void *user_data;
+} KDTreeBatchData;
+
+static void kdtree_batch_settings_init(TaskParallelSettings *settings, const uint co_len)
+{
+  BLI_parallel_range_settings_defaults(settings);
+  settings->use_threading = (co_len >= KD_BATCH_THREAD_QUERIES_MIN);
+  settings->min_iter_per_thread = KD_BATCH_THREAD_QUERIES_MIN / 4;
+}
+
+static void kdtree_find_nearest_batch_cb(void *__restrict userdata,
+                                         const int i,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBatchData *data = userdata;
+  const int index = BLI_kdtree_nd_(find_nearest)(
+      data->tree, data->co[i], data->r_nearest ? &data->r_nearest[i] : NULL);
+
+  if (data->r_index) {
+    data->r_index[i] = index;
+  }
+  if (data->r_nearest && index == -1) {
+    data->r_nearest[i].index = -1;
+  }
+}
+
+/**
+ * Find the nearest node for each of the \a co_len coordinates in \a co.
+ *
+ * \param r_index: Optional array of \a co_len indices, -1 when no node is found.
+ * \param r_nearest: Optional array of \a co_len results,
+ * only the index is set (to -1) when no node is found.
+ */
+void BLI_kdtree_nd_(find_nearest_batch)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        const uint co_len,
+                                        int *r_index,
+                                        KDTreeNearest *r_nearest)
+{
+  KDTreeBatchData data = {
+      .tree = tree,
+      .co = co,
+      .r_index = r_index,
+      .r_nearest = r_nearest,
+  };
+
+  TaskParallelSettings settings;
+  kdtree_batch_settings_init(&settings, co_len);
+  BLI_task_parallel_range(0, (int)co_len, &data, kdtree_find_nearest_batch_cb, &settings);
+}
+
+typedef struct KDTreeBatchRangeSearch {
+  const KDTreeBatchData *data;
+  int co_index;
+} KDTreeBatchRangeSearch;
+
+static bool kdtree_range_search_batch_search_cb(void *user_data,
+                                                int index,
+                                                const float co[KD_DIMS],
+                                                float dist_sq)
+{
+  const KDTreeBatchRangeSearch *search = user_data;
+  return search->data->search_cb(
+      search->data->user_data, search->co_index, index, co, dist_sq);
+}
+
+static void kdtree_range_search_batch_cb(void *__restrict userdata,
+                                         const int i,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBatchData *data = userdata;
+  KDTreeBatchRangeSearch search = {
+      .data = data,
+      .co_index = i,
+  };
+  BLI_kdtree_nd_(range_search_cb)(
+      data->tree, data->co[i], data->range, kdtree_range_search_batch_search_cb, &search);
+}
+
+/**
+ * A version of #BLI_kdtree_3d_range_search_cb for \a co_len coordinates in \a co.
+ *
+ * \param search_cb: Called for every node found in \a range of the coordinate at `co_index`,
+ * false return value stops the search for this coordinate only.
+ *
+ * \note Searches run in parallel, \a search_cb must be thread-safe.
+ * Calls for the same coordinate come from a single thread.
+ */
+void BLI_kdtree_nd_(range_search_batch_cb)(
+    const KDTree *tree,
+    const float (*co)[KD_DIMS],
+    const uint co_len,
+    float range,
+    bool (*search_cb)(
+        void *user_data, int co_index, int index, const float co[KD_DIMS], float dist_sq),
+    void *user_data)
+{
+  KDTreeBatchData data = {
+      .tree = tree,
+      .co = co,
+      .range = range,
+      .search_cb = search_cb,
+      .user_data = user_data,
+  };
+
+  TaskParallelSettings settings;
+  kdtree_batch_settings_init(&settings, co_len);
+  BLI_task_parallel_range(0, (int)co_len, &data, kdtree_range_search_batch_cb, &settings);
+}
+
+/** \} */
+
 /**
  * Use when we want to loop over nodes ordered by index.
  * Requires indices to be aligned with nodes.
@@ -866,6 +1091,99 @@ static void deduplicate_recursive(const struct DeDuplicateParams *p, uint i)
   }
 }
 
+/**
+ * Candidates for merging found for every node by the threaded pre-pass of
+ * #BLI_kdtree_3d_calc_duplicates_fast: their number and the first one found.
+ * Most points have at most a single duplicate, only nodes with more candidates
+ * need to be searched again when assigning the merge targets.
+ */
+typedef struct DeDuplicateCandidates {
+  int first;
+  int len;
+} DeDuplicateCandidates;
+
+typedef struct DeDuplicateCandidatesData {
+  const KDTree *tree;
+  float range;
+  float range_sq;
+  DeDuplicateCandidates *candidates;
+} DeDuplicateCandidatesData;
+
+/* Same traversal as #deduplicate_recursive, without reading or writing the duplicates. */
+static void deduplicate_candidates_recursive(const DeDuplicateCandidatesData *data,
+                                             const float search_co[KD_DIMS],
+                                             const int search,
+                                             uint i,
+                                             DeDuplicateCandidates *r_candidates)
+{
+  const KDTreeNode *node = &data->tree->nodes[i];
+  if (search_co[node->d] + data->range <= node->co[node->d]) {
+    if (node->left != KD_NODE_UNSET) {
+      deduplicate_candidates_recursive(data, search_co, search, node->left, r_candidates);
+    }
+  }
+  else if (search_co[node->d] - data->range >= node->co[node->d]) {
+    if (node->right != KD_NODE_UNSET) {
+      deduplicate_candidates_recursive(data, search_co, search, node->right, r_candidates);
+    }
+  }
+  else {
+    if (search != node->index) {
+      if (len_squared_vnvn(node->co, search_co) <= data->range_sq) {
+        if (r_candidates->len++ == 0) {
+          r_candidates->first = node->index;
+        }
+      }
+    }
+    if (node->left != KD_NODE_UNSET) {
+      deduplicate_candidates_recursive(data, search_co, search, node->left, r_candidates);
+    }
+    if (node->right != KD_NODE_UNSET) {
+      deduplicate_candidates_recursive(data, search_co, search, node->right, r_candidates);
+    }
+  }
+}
+
+static void deduplicate_candidates_cb(void *__restrict userdata,
+                                      const int i,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const DeDuplicateCandidatesData *data = userdata;
+  const KDTreeNode *node = &data->tree->nodes[i];
+  DeDuplicateCandidates *candidates = &data->candidates[i];
+  candidates->first = -1;
+  candidates->len = 0;
+  deduplicate_candidates_recursive(data, node->co, node->index, data->tree->root, candidates);
+}
+
+/**
+ * Search the duplicates of the node at \a node_index (in #KDTree.nodes),
+ * using the result of the threaded pre-pass when there is one.
+ */
+static void deduplicate_search(struct DeDuplicateParams *p,
+                               const KDTree *tree,
+                               const DeDuplicateCandidates *candidates,
+                               const uint node_index,
+                               const int index)
+{
+  if (candidates != NULL) {
+    const DeDuplicateCandidates *node_candidates = &candidates[node_index];
+    if (node_candidates->len == 0) {
+      return;
+    }
+    if (node_candidates->len == 1) {
+      if (p->duplicates[node_candidates->first] == -1) {
+        p->duplicates[node_candidates->first] = index;
+        *p->duplicates_found += 1;
+      }
+      return;
+    }
+  }
+  p->search = index;
+  copy_vn_vn(p->search_co, tree->nodes[node_index].co);
+  deduplicate_recursive(p, tree->root);
+}
+
 /**
  * Find duplicate points in \a range.
  * Favors speed over quality since it doesn't find the best target vertex for merging.
@@ -883,6 +1201,10 @@ static void deduplicate_recursive(const struct DeDuplicateParams *p, uint i)
  * \returns The number of merges found (includes any merges already in the \a duplicates array).
  *
  * \note Merging is always a single step (target indices wont be marked for merging).
+ *
+ * \note For large trees the candidates of all nodes are searched in parallel first,
+ * merge targets are then assigned in the same order as the single threaded search,
+ * so the result doesn't change.
  */
 int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
                                          const float range,
@@ -898,16 +1220,28 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
       .duplicates_found = &found,
   };
 
+  DeDuplicateCandidates *candidates = NULL;
+  if (tree->nodes_len >= KD_BATCH_THREAD_QUERIES_MIN && tree->root != KD_NODE_UNSET) {
+    candidates = MEM_malloc_arrayN(tree->nodes_len, sizeof(*candidates), __func__);
+    DeDuplicateCandidatesData data = {
+        .tree = tree,
+        .range = range,
+        .range_sq = p.range_sq,
+        .candidates = candidates,
+    };
+    TaskParallelSettings settings;
+    kdtree_batch_settings_init(&settings, tree->nodes_len);
+    BLI_task_parallel_range(0, (int)tree->nodes_len, &data, deduplicate_candidates_cb, &settings);
+  }
+
   if (use_index_order) {
     uint *order = kdtree_order(tree);
     for (uint i = 0; i < tree->nodes_len; i++) {
       const uint node_index = order[i];
       const int index = (int)i;
       if (ELEM(duplicates[index], -1, index)) {
-        p.search = index;
-        copy_vn_vn(p.search_co, tree->nodes[node_index].co);
         int found_prev = found;
-        deduplicate_recursive(&p, tree->root);
+        deduplicate_search(&p, tree, candidates, node_index, index);
         if (found != found_prev) {
           /* Prevent chains of doubles. */
           duplicates[index] = index;
@@ -921,10 +1255,8 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
       const uint node_index = i;
       const int index = p.nodes[node_index].index;
       if (ELEM(duplicates[index], -1, index)) {
-        p.search = index;
-        copy_vn_vn(p.search_co, tree->nodes[node_index].co);
         int found_prev = found;
-        deduplicate_recursive(&p, tree->root);
+        deduplicate_search(&p, tree, candidates, node_index, index);
         if (found != found_prev) {
           /* Prevent chains of doubles. */
           duplicates[index] = index;
@@ -932,6 +1264,8 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
       }
     }
   }
+
+  MEM_SAFE_FREE(candidates);
   return found;
 }
 
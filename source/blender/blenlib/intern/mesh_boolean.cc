@@ -37,6 +37,7 @@
 #  include "BLI_set.hh"
 #  include "BLI_span.hh"
 #  include "BLI_stack.hh"
+#  include "BLI_task.h"
 #  include "BLI_vector.hh"
 #  include "BLI_vector_set.hh"
 
@@ -47,6 +48,9 @@
 // #  define PERFDEBUG
 namespace blender::meshintersect {
 
+/* Set to false to do the per-face steps of the boolean in a single thread, for debugging. */
+static constexpr bool boolean_use_threading = true;
+
 /**
  * Edge as two `const` Vert *'s, in a canonical order (lower vert id first).
  * We use the Vert id field for hashing to get algorithms
@@ -858,6 +862,44 @@ static const Vert *find_flap_vert(const Face &tri, const Edge e, bool *r_rev)
   return flapv;
 }
 
+/**
+ * Index (in the sense of Burnikel, Funke, and Seel, see the comment on the
+ * supremum functions in mesh_intersect.cc) of the orient3d determinant,
+ * assuming the input coordinates have index 1.
+ */
+constexpr int index_orient3d = 11;
+
+/**
+ * Return the orientation of \a d with respect to the plane through \a a, \a b, \a c
+ * as the exact `orient3d` of the `co_exact` coordinates would, but calculated using the
+ * double approximations of the coordinates. The answer is 0 if we are unsure, in which case
+ * the caller has to use the exact calculation.
+ */
+static int filter_orient3d(const double3 &a, const double3 &b, const double3 &c, const double3 &d)
+{
+  double3 ad = a - d;
+  double3 bd = b - d;
+  double3 cd = c - d;
+  double det = ad[2] * (bd[0] * cd[1] - cd[0] * bd[1]) +
+               bd[2] * (cd[0] * ad[1] - ad[0] * cd[1]) +
+               cd[2] * (ad[0] * bd[1] - bd[0] * ad[1]);
+  if (det == 0.0) {
+    return 0;
+  }
+  double3 abs_d = double3::abs(d);
+  double3 abs_ad = double3::abs(a) + abs_d;
+  double3 abs_bd = double3::abs(b) + abs_d;
+  double3 abs_cd = double3::abs(c) + abs_d;
+  double supremum = abs_ad[2] * (abs_bd[0] * abs_cd[1] + abs_cd[0] * abs_bd[1]) +
+                    abs_bd[2] * (abs_cd[0] * abs_ad[1] + abs_ad[0] * abs_cd[1]) +
+                    abs_cd[2] * (abs_ad[0] * abs_bd[1] + abs_bd[0] * abs_ad[1]);
+  double err_bound = supremum * index_orient3d * DBL_EPSILON;
+  if (fabs(det) > err_bound) {
+    return det > 0 ? 1 : -1;
+  }
+  return 0;
+}
+
 /**
  * Triangle \a tri and tri0 share edge e.
  * Classify \a tri with respect to tri0 as described in
@@ -878,9 +920,6 @@ static int sort_tris_class(const Face &tri, const Face &tri0, const Edge e)
   if (dbg_level > 0) {
     std::cout << "classify  e = " << e << "\n";
   }
-  mpq3 a0 = tri0[0]->co_exact;
-  mpq3 a1 = tri0[1]->co_exact;
-  mpq3 a2 = tri0[2]->co_exact;
   bool rev;
   bool rev0;
   const Vert *flapv0 = find_flap_vert(tri0, e, &rev0);
@@ -892,9 +931,12 @@ static int sort_tris_class(const Face &tri, const Face &tri0, const Edge e)
     std::cout << " rev = " << rev << " flapv = " << flapv << "\n";
   }
   BLI_assert(flapv != nullptr && flapv0 != nullptr);
-  const mpq3 flap = flapv->co_exact;
-  /* orient will be positive if flap is below oriented plane of a0,a1,a2. */
-  int orient = orient3d(a0, a1, a2, flap);
+  /* orient will be positive if flap is below oriented plane of tri0.
+   * Only fall back to exact arithmetic when the flap is (nearly) co-planar. */
+  int orient = filter_orient3d(tri0[0]->co, tri0[1]->co, tri0[2]->co, flapv->co);
+  if (orient == 0) {
+    orient = orient3d(tri0[0]->co_exact, tri0[1]->co_exact, tri0[2]->co_exact, flapv->co_exact);
+  }
   int ans;
   if (orient > 0) {
     ans = rev0 ? 4 : 3;
@@ -2626,6 +2668,50 @@ static Array<Face *> triangulate_poly(Face *f, IMeshArena *arena)
   return ans;
 }
 
+/**
+ * Data needed for parallelization of #triangulate_polymesh.
+ * Every face writes its triangles into its own slot of \a r_face_tris,
+ * so the output order doesn't depend on the scheduling of the tasks.
+ */
+struct TriangulateFaceData {
+  IMesh &imesh;
+  IMeshArena *arena;
+  Array<Vector<Face *, 2>> &r_face_tris;
+};
+
+static void triangulate_face_range_func(void *__restrict userdata,
+                                        const int iter,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  TriangulateFaceData *data = static_cast<TriangulateFaceData *>(userdata);
+  IMeshArena *arena = data->arena;
+  Face *f = data->imesh.face(iter);
+  Vector<Face *, 2> &face_tris = data->r_face_tris[iter];
+  /* Tessellate face f, following plan similar to #BM_face_calc_tesselation. */
+  int flen = f->size();
+  if (flen == 3) {
+    face_tris.append(f);
+  }
+  else if (flen == 4) {
+    const Vert *v0 = (*f)[0];
+    const Vert *v1 = (*f)[1];
+    const Vert *v2 = (*f)[2];
+    const Vert *v3 = (*f)[3];
+    int eo_01 = f->edge_orig[0];
+    int eo_12 = f->edge_orig[1];
+    int eo_23 = f->edge_orig[2];
+    int eo_30 = f->edge_orig[3];
+    Face *f0 = arena->add_face({v0, v1, v2}, f->orig, {eo_01, eo_12, -1}, {false, false, false});
+    Face *f1 = arena->add_face({v0, v2, v3}, f->orig, {-1, eo_23, eo_30}, {false, false, false});
+    face_tris.append(f0);
+    face_tris.append(f1);
+  }
+  else {
+    Array<Face *> tris = triangulate_poly(f, arena);
+    face_tris.extend(tris.as_span());
+  }
+}
+
 /**
  * Return an #IMesh that is a triangulation of a mesh with general
  * polygonal faces, #IMesh.
@@ -2634,35 +2720,19 @@ static Array<Face *> triangulate_poly(Face *f, IMeshArena *arena)
  */
 static IMesh triangulate_polymesh(IMesh &imesh, IMeshArena *arena)
 {
+  Array<Vector<Face *, 2>> tris_for_face(imesh.face_size());
+  TriangulateFaceData data = {imesh, arena, tris_for_face};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1000;
+  settings.use_threading = boolean_use_threading;
+  BLI_task_parallel_range(0, imesh.face_size(), &data, triangulate_face_range_func, &settings);
+
   Vector<Face *> face_tris;
   constexpr int estimated_tris_per_face = 3;
   face_tris.reserve(estimated_tris_per_face * imesh.face_size());
-  for (Face *f : imesh.faces()) {
-    /* Tessellate face f, following plan similar to #BM_face_calc_tesselation. */
-    int flen = f->size();
-    if (flen == 3) {
-      face_tris.append(f);
-    }
-    else if (flen == 4) {
-      const Vert *v0 = (*f)[0];
-      const Vert *v1 = (*f)[1];
-      const Vert *v2 = (*f)[2];
-      const Vert *v3 = (*f)[3];
-      int eo_01 = f->edge_orig[0];
-      int eo_12 = f->edge_orig[1];
-      int eo_23 = f->edge_orig[2];
-      int eo_30 = f->edge_orig[3];
-      Face *f0 = arena->add_face({v0, v1, v2}, f->orig, {eo_01, eo_12, -1}, {false, false, false});
-      Face *f1 = arena->add_face({v0, v2, v3}, f->orig, {-1, eo_23, eo_30}, {false, false, false});
-      face_tris.append(f0);
-      face_tris.append(f1);
-    }
-    else {
-      Array<Face *> tris = triangulate_poly(f, arena);
-      for (Face *tri : tris) {
-        face_tris.append(tri);
-      }
-    }
+  for (const Vector<Face *, 2> &tris : tris_for_face) {
+    face_tris.extend(tris.as_span());
   }
   return IMesh(face_tris);
 }
@@ -3114,6 +3184,39 @@ static Vector<Face *> merge_tris_for_face(Vector<int> tris,
   return ans;
 }
 
+/**
+ * Data needed for parallelization of the per input face steps of
+ * #polymesh_from_trimesh_with_dissolve.
+ */
+struct MergeTrisData {
+  const IMesh &tm_out;
+  const IMesh &imesh_in;
+  IMeshArena *arena;
+  const Array<Vector<int>> &face_output_tris;
+  Array<Vector<Face *>> &r_face_output_face;
+};
+
+static void populate_plane_range_func(void *__restrict userdata,
+                                      const int iter,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const IMesh *tm = static_cast<const IMesh *>(userdata);
+  tm->face(iter)->populate_plane(false);
+}
+
+static void merge_tris_for_face_range_func(void *__restrict userdata,
+                                           const int iter,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MergeTrisData *data = static_cast<MergeTrisData *>(userdata);
+  const Vector<int> &tris = data->face_output_tris[iter];
+  if (tris.size() == 0) {
+    return;
+  }
+  data->r_face_output_face[iter] = merge_tris_for_face(
+      tris, data->tm_out, data->imesh_in, data->arena);
+}
+
 /**
  * Return an array, paralleling imesh_out.vert, saying which vertices can be dissolved.
  * A vertex v can be dissolved if (a) it is not an input vertex; (b) it has valence 2;
@@ -3232,9 +3335,15 @@ static IMesh polymesh_from_trimesh_with_dissolve(const IMesh &tm_out,
     std::cout << "\nPOLYMESH_FROM_TRIMESH_WITH_DISSOLVE\n";
   }
   /* For now: need plane normals for all triangles. */
-  for (Face *tri : tm_out.faces()) {
-    tri->populate_plane(false);
-  }
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1000;
+  settings.use_threading = boolean_use_threading;
+  BLI_task_parallel_range(0,
+                          tm_out.face_size(),
+                          const_cast<IMesh *>(&tm_out),
+                          populate_plane_range_func,
+                          &settings);
   /* Gather all output triangles that are part of each input face.
    * face_output_tris[f] will be indices of triangles in tm_out
    * that have f as their original face. */
@@ -3256,17 +3365,16 @@ static IMesh polymesh_from_trimesh_with_dissolve(const IMesh &tm_out,
    * face_output_face[f] will be new original const Face *'s that
    * make up whatever part of the boolean output remains of input face f. */
   Array<Vector<Face *>> face_output_face(tot_in_face);
+  MergeTrisData merge_data = {tm_out, imesh_in, arena, face_output_tris, face_output_face};
+  TaskParallelSettings merge_settings;
+  BLI_parallel_range_settings_defaults(&merge_settings);
+  merge_settings.min_iter_per_thread = 100;
+  merge_settings.use_threading = boolean_use_threading;
+  BLI_task_parallel_range(
+      0, tot_in_face, &merge_data, merge_tris_for_face_range_func, &merge_settings);
   int tot_out_face = 0;
-  for (int in_f : imesh_in.face_index_range()) {
-    if (dbg_level > 1) {
-      std::cout << "merge tris for face " << in_f << "\n";
-    }
-    int num_out_tris_for_face = face_output_tris.size();
-    if (num_out_tris_for_face == 0) {
-      continue;
-    }
-    face_output_face[in_f] = merge_tris_for_face(face_output_tris[in_f], tm_out, imesh_in, arena);
-    tot_out_face += face_output_face[in_f].size();
+  for (const Vector<Face *> &f_faces : face_output_face) {
+    tot_out_face += f_faces.size();
   }
   Array<Face *> face(tot_out_face);
   int out_f_index = 0;
@@ -407,7 +407,6 @@ class IMeshArena::IMeshArenaImpl : NonCopyable, NonMovable {
 
   Face *add_face(Span<const Vert *> verts, int orig, Span<int> edge_origs, Span<bool> is_intersect)
   {
-    Face *f = new Face(verts, next_face_id_++, orig, edge_origs, is_intersect);
     if (intersect_use_threading) {
 #  ifdef USE_SPINLOCK
       BLI_spin_lock(&lock_);
@@ -415,6 +414,8 @@ class IMeshArena::IMeshArenaImpl : NonCopyable, NonMovable {
       BLI_mutex_lock(mutex_);
 #  endif
     }
+    /* Faces are added from multiple threads, the id has to be taken under the lock too. */
+    Face *f = new Face(verts, next_face_id_++, orig, edge_origs, is_intersect);
     allocated_faces_.append(std::unique_ptr<Face>(f));
     if (intersect_use_threading) {
 #  ifdef USE_SPINLOCK
@@ -2384,6 +2385,74 @@ static CDT_data calc_cluster_subdivided(const CoplanarClusterInfo &clinfo,
   return cd_data;
 }
 
+/**
+ * Data needed for parallelization of #calc_cluster_subdivided over all clusters.
+ */
+struct SubdivideClustersData {
+  Array<CDT_data> &r_cluster_subdivided;
+  const CoplanarClusterInfo &clinfo;
+  const IMesh &tm;
+  const TriOverlaps &ov;
+  const Map<std::pair<int, int>, ITT_value> &itt_map;
+  IMeshArena *arena;
+};
+
+static void calc_cluster_subdivided_range_func(void *__restrict userdata,
+                                               const int iter,
+                                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SubdivideClustersData *data = static_cast<SubdivideClustersData *>(userdata);
+  data->r_cluster_subdivided[iter] = calc_cluster_subdivided(
+      data->clinfo, iter, data->tm, data->ov, data->itt_map, data->arena);
+}
+
+/**
+ * Each cluster is subdivided with its own CDT, which is independent of the other clusters.
+ */
+static void calc_cluster_subdivides(Array<CDT_data> &r_cluster_subdivided,
+                                    const CoplanarClusterInfo &clinfo,
+                                    const IMesh &tm,
+                                    const TriOverlaps &ov,
+                                    const Map<std::pair<int, int>, ITT_value> &itt_map,
+                                    IMeshArena *arena)
+{
+  SubdivideClustersData data = {r_cluster_subdivided, clinfo, tm, ov, itt_map, arena};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = intersect_use_threading;
+  BLI_task_parallel_range(
+      0, clinfo.tot_cluster(), &data, calc_cluster_subdivided_range_func, &settings);
+}
+
+/**
+ * Data needed for parallelization of extracting the sub-triangles of triangles
+ * that are not subdivided yet: the ones in clusters and the ones without intersections.
+ */
+struct ExtractTrisData {
+  Array<IMesh> &r_tri_subdivided;
+  const IMesh &tm;
+  const CoplanarClusterInfo &clinfo;
+  const Array<CDT_data> &cluster_subdivided;
+  IMeshArena *arena;
+};
+
+static void extract_tri_range_func(void *__restrict userdata,
+                                   const int iter,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ExtractTrisData *data = static_cast<ExtractTrisData *>(userdata);
+  const int t = iter;
+  const int c = data->clinfo.tri_cluster(t);
+  if (c != NO_INDEX) {
+    BLI_assert(data->r_tri_subdivided[t].face_size() == 0);
+    data->r_tri_subdivided[t] = extract_subdivided_tri(
+        data->cluster_subdivided[c], data->tm, t, data->arena);
+  }
+  else if (data->r_tri_subdivided[t].face_size() == 0) {
+    data->r_tri_subdivided[t] = extract_single_tri(data->tm, t);
+  }
+}
+
 static IMesh union_tri_subdivides(const blender::Array<IMesh> &tri_subdivided)
 {
   int tot_tri = 0;
@@ -2596,6 +2665,32 @@ static bool has_degenerate_tris(const IMesh &tm)
   return degen_chunk_data.has_degenerate_tri;
 }
 
+/* Data and functions to calculate exact planes of triangles with overlaps in parallel. */
+struct PopulatePlaneData {
+  const IMesh &tm;
+  const TriOverlaps &tri_ov;
+};
+
+static void populate_plane_range_func(void *__restrict userdata,
+                                      const int iter,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PopulatePlaneData *data = static_cast<PopulatePlaneData *>(userdata);
+  if (data->tri_ov.first_overlap_index(iter) != -1) {
+    data->tm.face(iter)->populate_plane(true);
+  }
+}
+
+static void populate_overlapping_planes(const IMesh &tm, const TriOverlaps &tri_ov)
+{
+  PopulatePlaneData data = {tm, tri_ov};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1000;
+  settings.use_threading = intersect_use_threading;
+  BLI_task_parallel_range(0, tm.face_size(), &data, populate_plane_range_func, &settings);
+}
+
 static IMesh remove_degenerate_tris(const IMesh &tm_in)
 {
   IMesh ans;
@@ -2672,11 +2767,7 @@ IMesh trimesh_nary_intersect(const IMesh &tm_in,
   double overlap_time = PIL_check_seconds_timer();
   std::cout << "intersect overlaps calculated, time = " << overlap_time - bb_calc_time << "\n";
 #  endif
-  for (int t : tm_clean->face_index_range()) {
-    if (tri_ov.first_overlap_index(t) != -1) {
-      tm_clean->face(t)->populate_plane(true);
-    }
-  }
+  populate_overlapping_planes(*tm_clean, tri_ov);
 #  ifdef PERFDEBUG
   double plane_populate = PIL_check_seconds_timer();
   std::cout << "planes populated, time = " << plane_populate - overlap_time << "\n";
@@ -2708,24 +2799,19 @@ IMesh trimesh_nary_intersect(const IMesh &tm_in,
   std::cout << "subdivided tris found, time = " << subdivided_tris_time - itt_time << "\n";
 #  endif
   Array<CDT_data> cluster_subdivided(clinfo.tot_cluster());
-  for (int c : clinfo.index_range()) {
-    cluster_subdivided[c] = calc_cluster_subdivided(clinfo, c, *tm_clean, tri_ov, itt_map, arena);
-  }
+  calc_cluster_subdivides(cluster_subdivided, clinfo, *tm_clean, tri_ov, itt_map, arena);
 #  ifdef PERFDEBUG
   double cluster_subdivide_time = PIL_check_seconds_timer();
   std::cout << "subdivided clusters found, time = "
             << cluster_subdivide_time - subdivided_tris_time << "\n";
 #  endif
-  for (int t : tm_clean->face_index_range()) {
-    int c = clinfo.tri_cluster(t);
-    if (c != NO_INDEX) {
-      BLI_assert(tri_subdivided[t].face_size() == 0);
-      tri_subdivided[t] = extract_subdivided_tri(cluster_subdivided[c], *tm_clean, t, arena);
-    }
-    else if (tri_subdivided[t].face_size() == 0) {
-      tri_subdivided[t] = extract_single_tri(*tm_clean, t);
-    }
-  }
+  ExtractTrisData extract_data = {tri_subdivided, *tm_clean, clinfo, cluster_subdivided, arena};
+  TaskParallelSettings extract_settings;
+  BLI_parallel_range_settings_defaults(&extract_settings);
+  extract_settings.min_iter_per_thread = 1000;
+  extract_settings.use_threading = intersect_use_threading;
+  BLI_task_parallel_range(
+      0, tm_clean->face_size(), &extract_data, extract_tri_range_func, &extract_settings);
 #  ifdef PERFDEBUG
   double extract_time = PIL_check_seconds_timer();
   std::cout << "triangles extracted, time = " << extract_time - cluster_subdivide_time << "\n";
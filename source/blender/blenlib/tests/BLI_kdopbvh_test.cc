@@ -2,15 +2,18 @@
 
 #include "testing/testing.h"
 
-/* TODO: ray intersection, overlap ... etc.*/
+/* TODO: ray intersection ... etc.*/
 
 #include "MEM_guardedalloc.h"
 
 #include "BLI_compiler_attrs.h"
 #include "BLI_kdopbvh.h"
+#include "BLI_math_geom.h"
 #include "BLI_math_vector.h"
 #include "BLI_rand.h"
 
+#include "PIL_time.h"
+
 /* -------------------------------------------------------------------- */
 /* Helper Functions */
 
@@ -66,8 +69,12 @@ static void optimal_check_callback(void *userdata,
  * Note that a small epsilon is added to the BVH nodes bounds, even if we pass in zero.
  * Use rounding to ensure very close nodes don't cause the wrong node to be found as nearest.
  */
-static void find_nearest_points_test(
-    int points_len, float scale, int round, int random_seed, bool optimal = false)
+static void find_nearest_points_test(int points_len,
+                                     float scale,
+                                     int round,
+                                     int random_seed,
+                                     bool optimal = false,
+                                     int balance_flag = 0)
 {
   struct RNG *rng = BLI_rng_new(random_seed);
   BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 8, 8);
@@ -79,7 +86,7 @@ static void find_nearest_points_test(
     rng_v3_round(points[i], 3, rng, round, scale);
     BLI_bvhtree_insert(tree, i, points[i], 1);
   }
-  BLI_bvhtree_balance(tree);
+  BLI_bvhtree_balance_ex(tree, balance_flag);
 
   /* first find each point */
   BVHTree_NearestPointCallback callback = optimal ? optimal_check_callback : nullptr;
@@ -132,3 +139,398 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+TEST(kdopbvh, FindNearestSAH_2)
+{
+  find_nearest_points_test(2, 1.0, 1000, 123, false, BVH_BALANCE_SAH);
+}
+TEST(kdopbvh, FindNearestSAH_500)
+{
+  find_nearest_points_test(500, 1.0, 1000, 12, false, BVH_BALANCE_SAH);
+}
+TEST(kdopbvh, OptimalFindNearestSAH_500)
+{
+  find_nearest_points_test(500, 1.0, 1000, 12, true, BVH_BALANCE_SAH);
+}
+/* All leafs share the same centroid. */
+TEST(kdopbvh, FindNearestSAH_Degenerate)
+{
+  find_nearest_points_test(500, 1.0, 1, 12, false, BVH_BALANCE_SAH);
+}
+
+/* Exponentially spaced leafs give uneven SAH splits, the largest bounds overflow the costs. */
+TEST(kdopbvh, FindNearestSAH_Uneven)
+{
+  const int points_len = 90;
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 2, 6);
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+
+  for (int i = 0; i < points_len; i++) {
+    zero_v3(points[i]);
+    points[i][i % 3] = ldexpf(1.0f, 4 * (i / 3));
+    BLI_bvhtree_insert(tree, i, points[i], 1);
+  }
+  BLI_bvhtree_balance_ex(tree, BVH_BALANCE_SAH);
+
+  for (int i = 0; i < points_len; i++) {
+    EXPECT_EQ(BLI_bvhtree_find_nearest(tree, points[i], nullptr, nullptr, nullptr), i);
+  }
+  BLI_bvhtree_free(tree);
+  MEM_freeN(points);
+}
+
+/* -------------------------------------------------------------------- */
+/* Ray-Cast */
+
+struct RayCastTriangles {
+  float (*tris)[3][3];
+  int tris_len;
+};
+
+/* Triangles of random size, most of them packed in a small corner of the unit cube,
+ * so the median split gives poorly fitting bounds. */
+static void rng_triangles(RayCastTriangles *data, int tris_len, int random_seed)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  data->tris = (float(*)[3][3])MEM_mallocN(sizeof(*data->tris) * tris_len, __func__);
+  data->tris_len = tris_len;
+
+  for (int i = 0; i < tris_len; i++) {
+    float center[3], size = BLI_rng_get_float(rng) * 0.05f;
+    BLI_rng_get_float_unit_v3(rng, center);
+    if (i % 8) {
+      mul_v3_fl(center, 0.1f);
+      size *= 0.1f;
+    }
+    for (int j = 0; j < 3; j++) {
+      BLI_rng_get_float_unit_v3(rng, data->tris[i][j]);
+      madd_v3_v3v3fl(data->tris[i][j], center, data->tris[i][j], size);
+    }
+  }
+  BLI_rng_free(rng);
+}
+
+static BVHTree *raycast_tree_create(const RayCastTriangles *data,
+                                    int tree_type,
+                                    int axis,
+                                    int balance_flag)
+{
+  BVHTree *tree = BLI_bvhtree_new(data->tris_len, 0.0f, tree_type, axis);
+  for (int i = 0; i < data->tris_len; i++) {
+    BLI_bvhtree_insert(tree, i, data->tris[i][0], 3);
+  }
+  BLI_bvhtree_balance_ex(tree, balance_flag);
+  return tree;
+}
+
+static void raycast_triangle_callback(void *userdata,
+                                      int index,
+                                      const BVHTreeRay *ray,
+                                      BVHTreeRayHit *hit)
+{
+  const RayCastTriangles *data = (const RayCastTriangles *)userdata;
+  const float(*tri)[3] = data->tris[index];
+  float dist;
+
+  if (isect_ray_tri_v3(ray->origin, ray->direction, tri[0], tri[1], tri[2], &dist, nullptr) &&
+      dist < hit->dist) {
+    hit->index = index;
+    hit->dist = dist;
+  }
+}
+
+static int raycast_rays(const RayCastTriangles *data,
+                        BVHTree *tree,
+                        int rays_len,
+                        int random_seed,
+                        int *r_hits)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  int hits_len = 0;
+
+  for (int i = 0; i < rays_len; i++) {
+    float co[3], dir[3];
+    BLI_rng_get_float_unit_v3(rng, co);
+    mul_v3_fl(co, 2.0f);
+    BLI_rng_get_float_unit_v3(rng, dir);
+    mul_v3_fl(dir, 0.05f);
+    sub_v3_v3(dir, co);
+    normalize_v3(dir);
+
+    BVHTreeRayHit hit;
+    hit.index = -1;
+    hit.dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(tree, co, dir, 0.0f, &hit, raycast_triangle_callback, (void *)data);
+    if (r_hits) {
+      r_hits[i] = hit.index;
+    }
+    hits_len += (hit.index != -1);
+  }
+  BLI_rng_free(rng);
+  return hits_len;
+}
+
+static void raycast_sah_test(int tris_len, int tree_type, int axis)
+{
+  const int rays_len = 1000;
+  RayCastTriangles data;
+  rng_triangles(&data, tris_len, 1234);
+
+  int *hits_median = (int *)MEM_mallocN(sizeof(int) * rays_len, __func__);
+  int *hits_sah = (int *)MEM_mallocN(sizeof(int) * rays_len, __func__);
+
+  BVHTree *tree_median = raycast_tree_create(&data, tree_type, axis, 0);
+  BVHTree *tree_sah = raycast_tree_create(&data, tree_type, axis, BVH_BALANCE_SAH);
+  EXPECT_GT(raycast_rays(&data, tree_median, rays_len, 12, hits_median), 0);
+  raycast_rays(&data, tree_sah, rays_len, 12, hits_sah);
+
+  for (int i = 0; i < rays_len; i++) {
+    EXPECT_EQ(hits_median[i], hits_sah[i]);
+  }
+
+  BLI_bvhtree_free(tree_median);
+  BLI_bvhtree_free(tree_sah);
+  MEM_freeN(hits_median);
+  MEM_freeN(hits_sah);
+  MEM_freeN(data.tris);
+}
+
+TEST(kdopbvh, RayCastSAH_Binary)
+{
+  raycast_sah_test(5000, 2, 6);
+}
+TEST(kdopbvh, RayCastSAH_Quad)
+{
+  raycast_sah_test(5000, 4, 6);
+}
+TEST(kdopbvh, RayCastSAH_Oct)
+{
+  raycast_sah_test(5000, 8, 26);
+}
+
+/* Build and query timings, not run by default because of the memory used. */
+static void raycast_benchmark(int tris_len, int tree_type, int axis, int balance_flag)
+{
+  const int rays_len = 1000000;
+  RayCastTriangles data;
+  rng_triangles(&data, tris_len, 1234);
+
+  double time_start = PIL_check_seconds_timer();
+  BVHTree *tree = raycast_tree_create(&data, tree_type, axis, balance_flag);
+  const double time_build = PIL_check_seconds_timer() - time_start;
+
+  time_start = PIL_check_seconds_timer();
+  raycast_rays(&data, tree, rays_len, 12, nullptr);
+  const double time_query = PIL_check_seconds_timer() - time_start;
+
+  printf("%s tree (%d triangles): build %.3fs, %d ray-casts %.3fs\n",
+         balance_flag & BVH_BALANCE_SAH ? "SAH" : "Median",
+         tris_len,
+         time_build,
+         rays_len,
+         time_query);
+
+  BLI_bvhtree_free(tree);
+  MEM_freeN(data.tris);
+}
+
+TEST(kdopbvh, DISABLED_RayCastBenchmark)
+{
+  const int tris_len = 10000000;
+  raycast_benchmark(tris_len, 4, 6, 0);
+  raycast_benchmark(tris_len, 4, 6, BVH_BALANCE_SAH);
+}
+
+/* -------------------------------------------------------------------- */
+/* Refit */
+
+TEST(kdopbvh, RefitFromLeafs)
+{
+  const int points_len = 500;
+  struct RNG *rng = BLI_rng_new(1234);
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 4, 6);
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+    BLI_bvhtree_insert(tree, i, points[i], 1);
+  }
+  BLI_bvhtree_balance_ex(tree, BVH_BALANCE_SAH);
+
+  /* Same leafs with moved points. */
+  BVHTree *tree_leafs = BLI_bvhtree_new(points_len, 0.0, 4, 6);
+  for (int i = 0; i < points_len; i++) {
+    points[i][0] *= 2.0f;
+    points[i][2] += points[i][1];
+    BLI_bvhtree_insert(tree_leafs, i, points[i], 1);
+  }
+
+  EXPECT_TRUE(BLI_bvhtree_leafs_equal(tree, tree_leafs, false));
+  EXPECT_FALSE(BLI_bvhtree_leafs_equal(tree, tree_leafs, true));
+  EXPECT_EQ(BLI_bvhtree_leafs_hash(tree, false), BLI_bvhtree_leafs_hash(tree_leafs, false));
+  EXPECT_NE(BLI_bvhtree_leafs_hash(tree, true), BLI_bvhtree_leafs_hash(tree_leafs, true));
+
+  BLI_bvhtree_refit_from_leafs(tree, tree_leafs);
+  EXPECT_TRUE(BLI_bvhtree_leafs_equal(tree, tree_leafs, true));
+  EXPECT_EQ(BLI_bvhtree_leafs_hash(tree, true), BLI_bvhtree_leafs_hash(tree_leafs, true));
+
+  for (int i = 0; i < points_len; i++) {
+    const int j = BLI_bvhtree_find_nearest(tree, points[i], nullptr, nullptr, nullptr);
+    EXPECT_GE(j, 0);
+    EXPECT_LT(j, points_len);
+    EXPECT_EQ_ARRAY(points[i], points[j], 3);
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_bvhtree_free(tree_leafs);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+}
+
+TEST(kdopbvh, RefitExtentRatio)
+{
+  const int points_len = 500;
+  struct RNG *rng = BLI_rng_new(1234);
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 4, 6);
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+    BLI_bvhtree_insert(tree, i, points[i], 1);
+  }
+  BLI_bvhtree_balance(tree);
+  const float ratio = BLI_bvhtree_branches_extent_ratio(tree);
+  EXPECT_GT(ratio, 1.0f);
+
+  /* Scaled leafs keep the same ratio. */
+  BVHTree *tree_leafs = BLI_bvhtree_new(points_len, 0.0, 4, 6);
+  for (int i = 0; i < points_len; i++) {
+    float co[3];
+    mul_v3_v3fl(co, points[i], 4.0f);
+    BLI_bvhtree_insert(tree_leafs, i, co, 1);
+  }
+  BLI_bvhtree_refit_from_leafs(tree, tree_leafs);
+  EXPECT_NEAR(BLI_bvhtree_branches_extent_ratio(tree), ratio, ratio * 1e-4f);
+  BLI_bvhtree_free(tree_leafs);
+
+  /* Shuffled leafs make every branch span most of the root. */
+  tree_leafs = BLI_bvhtree_new(points_len, 0.0, 4, 6);
+  for (int i = 0; i < points_len; i++) {
+    BLI_bvhtree_insert(tree_leafs, i, points[(i * 7) % points_len], 1);
+  }
+  BLI_bvhtree_refit_from_leafs(tree, tree_leafs);
+  EXPECT_GT(BLI_bvhtree_branches_extent_ratio(tree), ratio * 2.0f);
+  BLI_bvhtree_free(tree_leafs);
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+}
+
+/* -------------------------------------------------------------------- */
+/* Overlap */
+
+struct OverlapPointsData {
+  const float (*points)[3];
+  float dist_sq;
+};
+
+static bool overlap_points_cb(void *userdata, int index_a, int index_b, int UNUSED(thread))
+{
+  const OverlapPointsData *data = (const OverlapPointsData *)userdata;
+  return (index_a < index_b) &&
+         (len_squared_v3v3(data->points[index_a], data->points[index_b]) <= data->dist_sq);
+}
+
+/* Points on a coarse lattice, so many of them are at the same location. */
+static BVHTree *overlap_points_tree(float (*points)[3], int points_len, float dist)
+{
+  struct RNG *rng = BLI_rng_new(1234);
+  BVHTree *tree = BLI_bvhtree_new(points_len, dist / 2.0f, 2, 6);
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, 32, 1.0f);
+    BLI_bvhtree_insert(tree, i, points[i], 1);
+  }
+  BLI_bvhtree_balance(tree);
+  BLI_rng_free(rng);
+  return tree;
+}
+
+static int overlap_cmp(const void *a_v, const void *b_v)
+{
+  const BVHTreeOverlap *a = (const BVHTreeOverlap *)a_v, *b = (const BVHTreeOverlap *)b_v;
+  if (a->indexA != b->indexA) {
+    return (a->indexA < b->indexA) ? -1 : 1;
+  }
+  return (a->indexB < b->indexB) ? -1 : (a->indexB > b->indexB);
+}
+
+/* Threaded self overlap finds the same pairs as a single thread, as used by the weld modifier. */
+TEST(kdopbvh, SelfOverlapThreaded)
+{
+  const int points_len = 20000;
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  BVHTree *tree = overlap_points_tree(points, points_len, 1e-4f);
+  OverlapPointsData data = {points, 1e-8f};
+
+  for (const uint max_interactions : {0u, 1u}) {
+    uint overlap_len, overlap_threaded_len;
+    BVHTreeOverlap *overlap = BLI_bvhtree_overlap_ex(tree,
+                                                     tree,
+                                                     &overlap_len,
+                                                     overlap_points_cb,
+                                                     &data,
+                                                     max_interactions,
+                                                     BVH_OVERLAP_RETURN_PAIRS);
+    BVHTreeOverlap *overlap_threaded = BLI_bvhtree_overlap_ex(
+        tree,
+        tree,
+        &overlap_threaded_len,
+        overlap_points_cb,
+        &data,
+        max_interactions,
+        BVH_OVERLAP_USE_THREADING | BVH_OVERLAP_RETURN_PAIRS);
+
+    ASSERT_GT(overlap_len, 0u);
+    ASSERT_EQ(overlap_len, overlap_threaded_len);
+    qsort(overlap, overlap_len, sizeof(*overlap), overlap_cmp);
+    qsort(overlap_threaded, overlap_len, sizeof(*overlap), overlap_cmp);
+    for (uint i = 0; i < overlap_len; i++) {
+      EXPECT_EQ(overlap[i].indexA, overlap_threaded[i].indexA);
+      EXPECT_EQ(overlap[i].indexB, overlap_threaded[i].indexB);
+    }
+
+    MEM_freeN(overlap);
+    MEM_freeN(overlap_threaded);
+  }
+
+  BLI_bvhtree_free(tree);
+  MEM_freeN(points);
+}
+
+/* Timing of self overlap on a scan sized point cloud, not run by default. */
+TEST(kdopbvh, DISABLED_SelfOverlapBenchmark)
+{
+  const int points_len = 4000000;
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+
+  double time_start = PIL_check_seconds_timer();
+  BVHTree *tree = overlap_points_tree(points, points_len, 1e-4f);
+  printf("Build (%d points): %.3fs\n", points_len, PIL_check_seconds_timer() - time_start);
+
+  OverlapPointsData data = {points, 1e-8f};
+  for (const int flag : {0, (int)BVH_OVERLAP_USE_THREADING}) {
+    uint overlap_len;
+    time_start = PIL_check_seconds_timer();
+    BVHTreeOverlap *overlap = BLI_bvhtree_overlap_ex(
+        tree, tree, &overlap_len, overlap_points_cb, &data, 1, flag | BVH_OVERLAP_RETURN_PAIRS);
+    printf("Self overlap (%s): %.3fs, %u pairs\n",
+           flag ? "threaded" : "single thread",
+           PIL_check_seconds_timer() - time_start,
+           overlap_len);
+    MEM_freeN(overlap);
+  }
+
+  BLI_bvhtree_free(tree);
+  MEM_freeN(points);
+}
@@ -0,0 +1,292 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <iostream>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+
+#include "PIL_time.h"
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+static float(*points_random(const int points_len, const uint seed))[3]
+{
+  struct RNG *rng = BLI_rng_new(seed);
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  for (int i = 0; i < points_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, points[i]);
+    mul_v3_fl(points[i], BLI_rng_get_float(rng));
+  }
+  BLI_rng_free(rng);
+  return points;
+}
+
+static KDTree_3d *kdtree_from_points(const float (*points)[3], const int points_len)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new((uint)points_len);
+  for (int i = 0; i < points_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, points[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  return tree;
+}
+
+static int find_nearest_brute_force(const float (*points)[3],
+                                    const int points_len,
+                                    const float co[3])
+{
+  int index = -1;
+  float dist_sq_min = FLT_MAX;
+  for (int i = 0; i < points_len; i++) {
+    const float dist_sq = len_squared_v3v3(points[i], co);
+    if (dist_sq < dist_sq_min) {
+      dist_sq_min = dist_sq;
+      index = i;
+    }
+  }
+  return index;
+}
+
+/* Random points, where some have one or two duplicates close to them appended at the end. */
+static float(*points_random_with_duplicates(const int points_len,
+                                            const float offset,
+                                            const uint seed,
+                                            int *r_points_len))[3]
+{
+  /* Every third point has a duplicate, every ninth a second one. */
+  const int duplicates_len = (points_len + 2) / 3 + (points_len + 8) / 9;
+  float(*points)[3] = points_random(points_len + duplicates_len, seed);
+  struct RNG *rng = BLI_rng_new(seed);
+  int dst = points_len;
+  for (int i = 0; i < points_len; i += 3) {
+    for (int j = 0; j < ((i % 9 == 0) ? 2 : 1); j++) {
+      float dir[3];
+      BLI_rng_get_float_unit_v3(rng, dir);
+      madd_v3_v3v3fl(points[dst++], points[i], dir, offset * BLI_rng_get_float(rng));
+    }
+  }
+  BLI_rng_free(rng);
+  *r_points_len = dst;
+  return points;
+}
+
+/* Same as #BLI_kdtree_3d_calc_duplicates_fast with index order. */
+static int calc_duplicates_brute_force(const float (*points)[3],
+                                       const int points_len,
+                                       const float range,
+                                       int *duplicates)
+{
+  int found = 0;
+  for (int i = 0; i < points_len; i++) {
+    if (!ELEM(duplicates[i], -1, i)) {
+      continue;
+    }
+    const int found_prev = found;
+    for (int j = 0; j < points_len; j++) {
+      if (j != i && duplicates[j] == -1 &&
+          len_squared_v3v3(points[i], points[j]) <= square_f(range)) {
+        duplicates[j] = i;
+        found++;
+      }
+    }
+    if (found != found_prev) {
+      duplicates[i] = i;
+    }
+  }
+  return found;
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+TEST(kdtree, Empty)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(0);
+  BLI_kdtree_3d_balance(tree);
+
+  const float co[1][3] = {{0.0f, 0.0f, 0.0f}};
+  int index = 0;
+  KDTreeNearest_3d nearest;
+  BLI_kdtree_3d_find_nearest_batch(tree, co, 1, &index, &nearest);
+  EXPECT_EQ(index, -1);
+  EXPECT_EQ(nearest.index, -1);
+
+  BLI_kdtree_3d_free(tree);
+}
+
+/* Large enough for the balancing and the queries to be threaded. */
+TEST(kdtree, FindNearestBatch)
+{
+  const int points_len = 50000;
+  const int queries_len = 10000;
+  float(*points)[3] = points_random(points_len, 1);
+  float(*queries)[3] = points_random(queries_len, 2);
+  KDTree_3d *tree = kdtree_from_points(points, points_len);
+
+  int *index = (int *)MEM_mallocN(sizeof(int) * queries_len, __func__);
+  KDTreeNearest_3d *nearest = (KDTreeNearest_3d *)MEM_mallocN(
+      sizeof(KDTreeNearest_3d) * queries_len, __func__);
+  BLI_kdtree_3d_find_nearest_batch(tree, queries, queries_len, index, nearest);
+
+  for (int i = 0; i < queries_len; i++) {
+    KDTreeNearest_3d nearest_single;
+    EXPECT_EQ(index[i], BLI_kdtree_3d_find_nearest(tree, queries[i], &nearest_single));
+    EXPECT_EQ(index[i], nearest[i].index);
+    EXPECT_EQ(nearest[i].dist, nearest_single.dist);
+    EXPECT_V3_NEAR(nearest[i].co, points[index[i]], 0.0f);
+  }
+
+  for (int i = 0; i < queries_len; i += 50) {
+    const int index_expect = find_nearest_brute_force(points, points_len, queries[i]);
+    EXPECT_FLOAT_EQ(len_v3v3(points[index_expect], queries[i]), nearest[i].dist);
+  }
+
+  MEM_freeN(index);
+  MEM_freeN(nearest);
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(points);
+  MEM_freeN(queries);
+}
+
+struct RangeSearchBatchData {
+  int *found_len;
+  float range_sq;
+  bool is_valid;
+};
+
+static bool range_search_batch_cb(
+    void *user_data, int co_index, int UNUSED(index), const float UNUSED(co[3]), float dist_sq)
+{
+  RangeSearchBatchData *data = (RangeSearchBatchData *)user_data;
+  if (dist_sq > data->range_sq) {
+    data->is_valid = false;
+  }
+  data->found_len[co_index]++;
+  return true;
+}
+
+TEST(kdtree, RangeSearchBatch)
+{
+  const int points_len = 50000;
+  const int queries_len = 5000;
+  const float range = 0.05f;
+  float(*points)[3] = points_random(points_len, 3);
+  float(*queries)[3] = points_random(queries_len, 4);
+  KDTree_3d *tree = kdtree_from_points(points, points_len);
+
+  RangeSearchBatchData data;
+  data.found_len = (int *)MEM_callocN(sizeof(int) * queries_len, __func__);
+  data.range_sq = range * range;
+  data.is_valid = true;
+  BLI_kdtree_3d_range_search_batch_cb(
+      tree, queries, queries_len, range, range_search_batch_cb, &data);
+  EXPECT_TRUE(data.is_valid);
+
+  for (int i = 0; i < queries_len; i++) {
+    KDTreeNearest_3d *nearest = nullptr;
+    const int found_len = BLI_kdtree_3d_range_search(tree, queries[i], &nearest, range);
+    EXPECT_EQ(data.found_len[i], found_len);
+    if (nearest) {
+      MEM_freeN(nearest);
+    }
+  }
+
+  MEM_freeN(data.found_len);
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(points);
+  MEM_freeN(queries);
+}
+
+/* Large enough for the candidates to be searched in parallel. */
+TEST(kdtree, CalcDuplicatesFast)
+{
+  const float range = 1e-3f;
+  int points_len;
+  float(*points)[3] = points_random_with_duplicates(6000, range / 2.0f, 8, &points_len);
+  KDTree_3d *tree = kdtree_from_points(points, points_len);
+
+  int *duplicates = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+  int *duplicates_expect = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+  copy_vn_i(duplicates, points_len, -1);
+  copy_vn_i(duplicates_expect, points_len, -1);
+
+  const int found = BLI_kdtree_3d_calc_duplicates_fast(tree, range, true, duplicates);
+  const int found_expect = calc_duplicates_brute_force(
+      points, points_len, range, duplicates_expect);
+
+  EXPECT_GE(found, 2000);
+  EXPECT_EQ(found, found_expect);
+  for (int i = 0; i < points_len; i++) {
+    EXPECT_EQ(duplicates[i], duplicates_expect[i]);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(duplicates);
+  MEM_freeN(duplicates_expect);
+  MEM_freeN(points);
+}
+
+/* Re-balancing after inserting gives the same results, see T62210. */
+TEST(kdtree, Rebalance)
+{
+  const int points_len = 20000;
+  float(*points)[3] = points_random(points_len, 5);
+  KDTree_3d *tree = kdtree_from_points(points, points_len);
+  BLI_kdtree_3d_balance(tree);
+
+  for (int i = 0; i < points_len; i += 100) {
+    EXPECT_EQ(BLI_kdtree_3d_find_nearest(tree, points[i], nullptr), i);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(points);
+}
+
+/* Timing of balancing and queries on many points, not run by default. */
+TEST(kdtree, DISABLED_Benchmark)
+{
+  const int points_len = 1000000;
+  float(*points)[3] = points_random(points_len, 6);
+  float(*queries)[3] = points_random(points_len, 7);
+  int *index = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+
+  double time_start = PIL_check_seconds_timer();
+  KDTree_3d *tree = kdtree_from_points(points, points_len);
+  std::cout << "Balance: " << PIL_check_seconds_timer() - time_start << "s\n";
+
+  time_start = PIL_check_seconds_timer();
+  for (int i = 0; i < points_len; i++) {
+    index[i] = BLI_kdtree_3d_find_nearest(tree, queries[i], nullptr);
+  }
+  std::cout << "Find nearest: " << PIL_check_seconds_timer() - time_start << "s\n";
+
+  time_start = PIL_check_seconds_timer();
+  BLI_kdtree_3d_find_nearest_batch(tree, queries, points_len, index, nullptr);
+  std::cout << "Find nearest batch: " << PIL_check_seconds_timer() - time_start << "s\n";
+
+  BLI_kdtree_3d_free(tree);
+
+  /* Merge by distance on a scan sized point cloud. */
+  int points_dup_len;
+  float(*points_dup)[3] = points_random_with_duplicates(points_len, 1e-5f, 8, &points_dup_len);
+  int *duplicates = (int *)MEM_mallocN(sizeof(int) * points_dup_len, __func__);
+  copy_vn_i(duplicates, points_dup_len, -1);
+  tree = kdtree_from_points(points_dup, points_dup_len);
+
+  time_start = PIL_check_seconds_timer();
+  BLI_kdtree_3d_calc_duplicates_fast(tree, 2e-5f, false, duplicates);
+  std::cout << "Calc duplicates: " << PIL_check_seconds_timer() - time_start << "s\n";
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(duplicates);
+  MEM_freeN(points_dup);
+  MEM_freeN(index);
+  MEM_freeN(points);
+  MEM_freeN(queries);
+}
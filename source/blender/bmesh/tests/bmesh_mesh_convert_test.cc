@@ -0,0 +1,220 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <iostream>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "PIL_time.h"
+
+#include "bmesh.h"
+
+class bmesh_mesh_convert_test : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+};
+
+/* Grid of `size * size` vertices with a float layer on every domain. */
+static Mesh *grid_mesh_create(const int size)
+{
+  const int totvert = size * size;
+  const int totpoly = (size - 1) * (size - 1);
+  Mesh *me = BKE_mesh_new_nomain(totvert, 0, 0, totpoly * 4, totpoly);
+
+  float *vert_prop = (float *)CustomData_add_layer(
+      &me->vdata, CD_PROP_FLOAT, CD_CALLOC, nullptr, me->totvert);
+  float *poly_prop = (float *)CustomData_add_layer(
+      &me->pdata, CD_PROP_FLOAT, CD_CALLOC, nullptr, me->totpoly);
+  MLoopUV *mloopuv = (MLoopUV *)CustomData_add_layer(
+      &me->ldata, CD_MLOOPUV, CD_CALLOC, nullptr, me->totloop);
+
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int i = y * size + x;
+      me->mvert[i].co[0] = (float)x;
+      me->mvert[i].co[1] = (float)y;
+      me->mvert[i].co[2] = sinf((float)i);
+      vert_prop[i] = (float)i;
+    }
+  }
+
+  int l = 0;
+  for (int y = 0; y < size - 1; y++) {
+    for (int x = 0; x < size - 1; x++) {
+      const int i = y * (size - 1) + x;
+      const int v = y * size + x;
+      const int quad[4] = {v, v + 1, v + size + 1, v + size};
+      me->mpoly[i].loopstart = l;
+      me->mpoly[i].totloop = 4;
+      me->mpoly[i].mat_nr = (short)(i % 3);
+      poly_prop[i] = (float)-i;
+      for (int j = 0; j < 4; j++, l++) {
+        me->mloop[l].v = quad[j];
+        mloopuv[l].uv[0] = (float)l;
+        mloopuv[l].uv[1] = (float)j;
+      }
+    }
+  }
+
+  BKE_mesh_calc_edges(me, false, false);
+  return me;
+}
+
+static BMesh *bmesh_from_mesh(const Mesh *me)
+{
+  BMAllocTemplate allocsize = {me->totvert, me->totedge, me->totloop, me->totpoly};
+  BMeshCreateParams create_params = {0};
+  BMesh *bm = BM_mesh_create(&allocsize, &create_params);
+
+  BMeshFromMeshParams from_params = {0};
+  from_params.calc_face_normal = true;
+  from_params.cd_mask_extra = CD_MASK_MESH;
+  BM_mesh_bm_from_me(bm, me, &from_params);
+  return bm;
+}
+
+static Mesh *mesh_from_bmesh(BMesh *bm)
+{
+  Mesh *me = BKE_mesh_new_nomain(0, 0, 0, 0, 0);
+  BMeshToMeshParams to_params = {0};
+  to_params.cd_mask_extra = CD_MASK_MESH;
+  BM_mesh_bm_to_me(nullptr, bm, me, &to_params);
+  return me;
+}
+
+/* Large enough for the conversion to run threaded. */
+TEST_F(bmesh_mesh_convert_test, RoundTrip)
+{
+  Mesh *me_src = grid_mesh_create(200);
+  BMesh *bm = bmesh_from_mesh(me_src);
+
+  EXPECT_EQ(bm->totvert, me_src->totvert);
+  EXPECT_EQ(bm->totedge, me_src->totedge);
+  EXPECT_EQ(bm->totloop, me_src->totloop);
+  EXPECT_EQ(bm->totface, me_src->totpoly);
+
+  BMFace *f = BM_face_at_index_find(bm, 0);
+  ASSERT_TRUE(f != nullptr);
+  EXPECT_FLOAT_EQ(f->no[2], 1.0f);
+
+  Mesh *me_dst = mesh_from_bmesh(bm);
+  BM_mesh_free(bm);
+
+  ASSERT_EQ(me_dst->totvert, me_src->totvert);
+  ASSERT_EQ(me_dst->totedge, me_src->totedge);
+  ASSERT_EQ(me_dst->totloop, me_src->totloop);
+  ASSERT_EQ(me_dst->totpoly, me_src->totpoly);
+
+  const float *vert_prop_src = (const float *)CustomData_get_layer(&me_src->vdata,
+                                                                   CD_PROP_FLOAT);
+  const float *vert_prop_dst = (const float *)CustomData_get_layer(&me_dst->vdata,
+                                                                   CD_PROP_FLOAT);
+  ASSERT_TRUE(vert_prop_dst != nullptr);
+  for (int i = 0; i < me_src->totvert; i++) {
+    EXPECT_V3_NEAR(me_dst->mvert[i].co, me_src->mvert[i].co, 0.0f);
+    EXPECT_EQ(vert_prop_dst[i], vert_prop_src[i]);
+  }
+
+  for (int i = 0; i < me_src->totedge; i++) {
+    EXPECT_EQ(me_dst->medge[i].v1, me_src->medge[i].v1);
+    EXPECT_EQ(me_dst->medge[i].v2, me_src->medge[i].v2);
+  }
+
+  const MLoopUV *mloopuv_src = (const MLoopUV *)CustomData_get_layer(&me_src->ldata,
+                                                                     CD_MLOOPUV);
+  const MLoopUV *mloopuv_dst = (const MLoopUV *)CustomData_get_layer(&me_dst->ldata,
+                                                                     CD_MLOOPUV);
+  ASSERT_TRUE(mloopuv_dst != nullptr);
+  for (int i = 0; i < me_src->totloop; i++) {
+    EXPECT_EQ(me_dst->mloop[i].v, me_src->mloop[i].v);
+    EXPECT_EQ(me_dst->mloop[i].e, me_src->mloop[i].e);
+    EXPECT_EQ(mloopuv_dst[i].uv[0], mloopuv_src[i].uv[0]);
+    EXPECT_EQ(mloopuv_dst[i].uv[1], mloopuv_src[i].uv[1]);
+  }
+
+  const float *poly_prop_src = (const float *)CustomData_get_layer(&me_src->pdata,
+                                                                   CD_PROP_FLOAT);
+  const float *poly_prop_dst = (const float *)CustomData_get_layer(&me_dst->pdata,
+                                                                   CD_PROP_FLOAT);
+  ASSERT_TRUE(poly_prop_dst != nullptr);
+  for (int i = 0; i < me_src->totpoly; i++) {
+    EXPECT_EQ(me_dst->mpoly[i].loopstart, me_src->mpoly[i].loopstart);
+    EXPECT_EQ(me_dst->mpoly[i].totloop, me_src->mpoly[i].totloop);
+    EXPECT_EQ(me_dst->mpoly[i].mat_nr, me_src->mpoly[i].mat_nr);
+    EXPECT_EQ(poly_prop_dst[i], poly_prop_src[i]);
+  }
+
+  BKE_id_free(nullptr, me_src);
+  BKE_id_free(nullptr, me_dst);
+}
+
+/* The active face is kept when face indices are not valid, as after editing. */
+TEST_F(bmesh_mesh_convert_test, ActiveFace)
+{
+  Mesh *me_src = grid_mesh_create(200);
+  const int act_face = me_src->totpoly / 2 + 7;
+  me_src->act_face = act_face;
+
+  BMesh *bm = bmesh_from_mesh(me_src);
+  ASSERT_TRUE(bm->act_face != nullptr);
+  EXPECT_EQ(bm->act_face, BM_face_at_index_find(bm, act_face));
+
+  BMIter iter;
+  BMFace *f;
+  BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+    BM_elem_index_set(f, 0); /* set_dirty! */
+  }
+  bm->elem_index_dirty |= BM_FACE;
+
+  Mesh *me_dst = mesh_from_bmesh(bm);
+  BM_mesh_free(bm);
+
+  EXPECT_EQ(me_dst->act_face, act_face);
+
+  BKE_id_free(nullptr, me_src);
+  BKE_id_free(nullptr, me_dst);
+}
+
+/* Timing of entering and leaving edit-mode on a dense mesh, not run by default. */
+TEST_F(bmesh_mesh_convert_test, DISABLED_Performance)
+{
+  const int size = 1000;
+  const int iterations = 10;
+  Mesh *me_src = grid_mesh_create(size);
+  double time_from_me = 0.0, time_to_me = 0.0;
+
+  for (int i = 0; i < iterations; i++) {
+    double time_start = PIL_check_seconds_timer();
+    BMesh *bm = bmesh_from_mesh(me_src);
+    time_from_me += PIL_check_seconds_timer() - time_start;
+
+    time_start = PIL_check_seconds_timer();
+    Mesh *me_dst = mesh_from_bmesh(bm);
+    time_to_me += PIL_check_seconds_timer() - time_start;
+
+    BM_mesh_free(bm);
+    BKE_id_free(nullptr, me_dst);
+  }
+
+  std::cout << "Mesh to BMesh (" << me_src->totvert << " verts): "
+            << time_from_me / iterations << "s\n";
+  std::cout << "BMesh to Mesh (" << me_src->totvert << " verts): " << time_to_me / iterations
+            << "s\n";
+
+  BKE_id_free(nullptr, me_src);
+}
@@ -1329,10 +1329,14 @@ void DRW_shgroup_add_material_resources(DRWShadingGroup *grp, struct GPUMaterial
         gputex = BKE_image_get_gpu_tilemap(tex->ima, tex->iuser, NULL);
         drw_shgroup_material_texture(grp, gputex, tex->tiled_mapping_name, tex->sampler_state);
       }
-      else {
+      else if (DRW_state_is_image_render()) {
         gputex = BKE_image_get_gpu_texture(tex->ima, tex->iuser, NULL);
         drw_shgroup_material_texture(grp, gputex, tex->sampler_name, tex->sampler_state);
       }
+      else {
+        gputex = BKE_image_get_gpu_texture_async(tex->ima, tex->iuser);
+        drw_shgroup_material_texture(grp, gputex, tex->sampler_name, tex->sampler_state);
+      }
     }
     else if (tex->colorband) {
       /* Color Ramp */
@@ -233,7 +233,10 @@ void ED_mesh_uv_loop_reset_ex(struct Mesh *me, const int layernum)
   else {
     /* Collect Mesh UVs */
     BLI_assert(CustomData_has_layer(&me->ldata, CD_MLOOPUV));
-    MLoopUV *mloopuv = CustomData_get_layer_n(&me->ldata, CD_MLOOPUV, layernum);
+    /* The UVs may be shared with evaluated copies, which must not see the changes. */
+    MLoopUV *mloopuv = CustomData_duplicate_referenced_layer_n(
+        &me->ldata, CD_MLOOPUV, layernum, me->totloop);
+    BKE_mesh_update_customdata_pointers(me, false);
 
     for (int i = 0; i < me->totpoly; i++) {
       mesh_uv_reset_mface(&me->mpoly[i], mloopuv);
@@ -438,6 +441,11 @@ bool ED_mesh_color_ensure(struct Mesh *me, const char *name)
     CustomData_add_layer_named(&me->ldata, CD_MLOOPCOL, CD_DEFAULT, NULL, me->totloop, name);
     BKE_mesh_update_customdata_pointers(me, true);
   }
+  else if (me->mloopcol) {
+    /* Callers paint in-place, the colors may still be shared with evaluated copies. */
+    CustomData_duplicate_referenced_layer(&me->ldata, CD_MLOOPCOL, me->totloop);
+    BKE_mesh_update_customdata_pointers(me, false);
+  }
 
   DEG_id_tag_update(&me->id, 0);
 
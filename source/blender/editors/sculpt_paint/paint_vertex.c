@@ -49,6 +49,7 @@
 #include "BKE_main.h"
 #include "BKE_mesh.h"
 #include "BKE_mesh_mapping.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_modifier.h"
 #include "BKE_object.h"
 #include "BKE_object_deform.h"
@@ -2404,6 +2405,7 @@ static void wpaint_stroke_update_step(bContext *C, struct PaintStroke *stroke, P
   paint_last_stroke_update(scene, loc_world);
 
   BKE_mesh_batch_cache_dirty_tag(ob->data, BKE_MESH_BATCH_DIRTY_ALL);
+  BKE_mesh_runtime_tag_deform_verts_changed(ob->data);
 
   DEG_id_tag_update(ob->data, 0);
   WM_event_add_notifier(C, NC_OBJECT | ND_DRAW, ob);
@@ -3374,6 +3376,11 @@ static void vpaint_stroke_update_step(bContext *C, struct PaintStroke *stroke, P
 
   swap_m4m4(vc->rv3d->persmat, mat);
 
+  /* The update of the previous step may share the colors with the evaluated mesh again. */
+  Mesh *me = ob->data;
+  CustomData_duplicate_referenced_layer(&me->ldata, CD_MLOOPCOL, me->totloop);
+  BKE_mesh_update_customdata_pointers(me, false);
+
   vpaint_do_symmetrical_brush_actions(C, sd, vp, vpd, ob);
 
   swap_m4m4(vc->rv3d->persmat, mat);
@@ -3381,8 +3388,7 @@ static void vpaint_stroke_update_step(bContext *C, struct PaintStroke *stroke, P
   BKE_mesh_batch_cache_dirty_tag(ob->data, BKE_MESH_BATCH_DIRTY_ALL);
 
   if (vp->paint.brush->vertexpaint_tool == VPAINT_TOOL_SMEAR) {
-    memcpy(
-        vpd->smear.color_prev, vpd->smear.color_curr, sizeof(uint) * ((Mesh *)ob->data)->totloop);
+    memcpy(vpd->smear.color_prev, vpd->smear.color_curr, sizeof(uint) * me->totloop);
   }
 
   /* Calculate pivot for rotation around selection if needed.
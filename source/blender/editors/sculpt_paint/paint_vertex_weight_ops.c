@@ -523,6 +523,7 @@ static bool weight_paint_set(Object *ob, float paintweight)
 
   wpaint_prev_destroy(&wpp);
 
+  BKE_mesh_runtime_tag_deform_verts_changed(me);
   DEG_id_tag_update(&me->id, 0);
 
   return true;
@@ -745,6 +746,7 @@ static int paint_weight_gradient_modal(bContext *C, wmOperator *op, const wmEven
       MEM_freeN(vert_cache);
     }
 
+    BKE_mesh_runtime_tag_deform_verts_changed(ob->data);
     DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
     WM_event_add_notifier(C, NC_OBJECT | ND_DRAW, ob);
   }
@@ -851,6 +853,7 @@ static int paint_weight_gradient_exec(bContext *C, wmOperator *op)
     BKE_mesh_foreach_mapped_vert(me_eval, gradientVertUpdate__mapFunc, &data, MESH_FOREACH_NOP);
   }
 
+  BKE_mesh_runtime_tag_deform_verts_changed(me);
   DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
   WM_event_add_notifier(C, NC_OBJECT | ND_DRAW, ob);
 
@@ -8536,14 +8536,17 @@ static int vertex_to_loop_colors_exec(bContext *C, wmOperator *UNUSED(op))
   if (mloopcol_layer_n == -1) {
     return OPERATOR_CANCELLED;
   }
-  MLoopCol *loopcols = CustomData_get_layer_n(&mesh->ldata, CD_MLOOPCOL, mloopcol_layer_n);
-
   const int MPropCol_layer_n = CustomData_get_active_layer(&mesh->vdata, CD_PROP_COLOR);
   if (MPropCol_layer_n == -1) {
     return OPERATOR_CANCELLED;
   }
   MPropCol *vertcols = CustomData_get_layer_n(&mesh->vdata, CD_PROP_COLOR, MPropCol_layer_n);
 
+  /* Written in-place, the colors may be shared with evaluated copies. */
+  MLoopCol *loopcols = CustomData_duplicate_referenced_layer_n(
+      &mesh->ldata, CD_MLOOPCOL, mloopcol_layer_n, mesh->totloop);
+  BKE_mesh_update_customdata_pointers(mesh, false);
+
   MLoop *loops = CustomData_get_layer(&mesh->ldata, CD_MLOOP);
   MPoly *polys = CustomData_get_layer(&mesh->pdata, CD_MPOLY);
 
@@ -8605,7 +8608,9 @@ static int loop_to_vertex_colors_exec(bContext *C, wmOperator *UNUSED(op))
   if (MPropCol_layer_n == -1) {
     return OPERATOR_CANCELLED;
   }
-  MPropCol *vertcols = CustomData_get_layer_n(&mesh->vdata, CD_PROP_COLOR, MPropCol_layer_n);
+  /* Written in-place, the colors may be shared with evaluated copies. */
+  MPropCol *vertcols = CustomData_duplicate_referenced_layer_n(
+      &mesh->vdata, CD_PROP_COLOR, MPropCol_layer_n, mesh->totvert);
 
   MLoop *loops = CustomData_get_layer(&mesh->ldata, CD_MLOOP);
   MPoly *polys = CustomData_get_layer(&mesh->pdata, CD_MPOLY);
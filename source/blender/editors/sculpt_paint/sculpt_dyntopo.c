@@ -237,7 +237,8 @@ static void SCULPT_dynamic_topology_disable_ex(
     if (!CustomData_has_layer(&me->pdata, CD_SCULPT_FACE_SETS)) {
       CustomData_add_layer(&me->pdata, CD_SCULPT_FACE_SETS, CD_CALLOC, NULL, me->totpoly);
     }
-    ss->face_sets = CustomData_get_layer(&me->pdata, CD_SCULPT_FACE_SETS);
+    ss->face_sets = CustomData_duplicate_referenced_layer(
+        &me->pdata, CD_SCULPT_FACE_SETS, me->totpoly);
     for (int i = 0; i < me->totpoly; i++) {
       ss->face_sets[i] = 1;
     }
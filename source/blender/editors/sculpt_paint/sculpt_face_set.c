@@ -90,7 +90,8 @@ int ED_sculpt_face_sets_find_next_available_id(struct Mesh *mesh)
 
 void ED_sculpt_face_sets_initialize_none_to_id(struct Mesh *mesh, const int new_id)
 {
-  int *face_sets = CustomData_get_layer(&mesh->pdata, CD_SCULPT_FACE_SETS);
+  int *face_sets = CustomData_duplicate_referenced_layer(
+      &mesh->pdata, CD_SCULPT_FACE_SETS, mesh->totpoly);
   if (!face_sets) {
     return;
   }
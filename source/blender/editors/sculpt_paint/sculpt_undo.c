@@ -395,7 +395,15 @@ static bool sculpt_undo_restore_face_sets(bContext *C, SculptUndoNode *unode)
   ViewLayer *view_layer = CTX_data_view_layer(C);
   Object *ob = OBACT(view_layer);
   Mesh *me = BKE_object_get_original_mesh(ob);
-  int *face_sets = CustomData_get_layer(&me->pdata, CD_SCULPT_FACE_SETS);
+  /* The face sets may be shared with evaluated copies again since the last edit. */
+  int *face_sets = CustomData_duplicate_referenced_layer(
+      &me->pdata, CD_SCULPT_FACE_SETS, me->totpoly);
+  if (ob->sculpt) {
+    ob->sculpt->face_sets = face_sets;
+    if (ob->sculpt->pbvh) {
+      BKE_pbvh_face_sets_set(ob->sculpt->pbvh, face_sets);
+    }
+  }
   for (int i = 0; i < me->totpoly; i++) {
     face_sets[i] = unode->face_sets[i];
   }
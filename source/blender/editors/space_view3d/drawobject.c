@@ -30,6 +30,7 @@
 #include "BKE_DerivedMesh.h"
 #include "BKE_editmesh.h"
 #include "BKE_global.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_object.h"
 
 #include "DEG_depsgraph.h"
@@ -157,42 +158,21 @@ void ED_draw_object_facemap(Depsgraph *depsgraph,
     GPUVertBufRaw pos_step;
     GPU_vertbuf_attr_get_raw_data(vbo_pos, pos_id, &pos_step);
 
+    const MLoopTri *mlt = BKE_mesh_runtime_looptri_ensure(me);
     const MPoly *mp;
     int i;
-    if (me->runtime.looptris.array) {
-      MLoopTri *mlt = me->runtime.looptris.array;
-      for (mp = mpoly, i = 0; i < mpoly_len; i++, mp++) {
-        if (facemap_data[i] == facemap) {
-          for (int j = 2; j < mp->totloop; j++) {
-            copy_v3_v3(GPU_vertbuf_raw_step(&pos_step), mvert[mloop[mlt->tri[0]].v].co);
-            copy_v3_v3(GPU_vertbuf_raw_step(&pos_step), mvert[mloop[mlt->tri[1]].v].co);
-            copy_v3_v3(GPU_vertbuf_raw_step(&pos_step), mvert[mloop[mlt->tri[2]].v].co);
-            vbo_len_used += 3;
-            mlt++;
-          }
-        }
-        else {
-          mlt += mp->totloop - 2;
+    for (mp = mpoly, i = 0; i < mpoly_len; i++, mp++) {
+      if (facemap_data[i] == facemap) {
+        for (int j = 2; j < mp->totloop; j++) {
+          copy_v3_v3(GPU_vertbuf_raw_step(&pos_step), mvert[mloop[mlt->tri[0]].v].co);
+          copy_v3_v3(GPU_vertbuf_raw_step(&pos_step), mvert[mloop[mlt->tri[1]].v].co);
+          copy_v3_v3(GPU_vertbuf_raw_step(&pos_step), mvert[mloop[mlt->tri[2]].v].co);
+          vbo_len_used += 3;
+          mlt++;
         }
       }
-    }
-    else {
-      /* No tessellation data, fan-fill. */
-      for (mp = mpoly, i = 0; i < mpoly_len; i++, mp++) {
-        if (facemap_data[i] == facemap) {
-          const MLoop *ml_start = &mloop[mp->loopstart];
-          const MLoop *ml_a = ml_start + 1;
-          const MLoop *ml_b = ml_start + 2;
-          for (int j = 2; j < mp->totloop; j++) {
-            copy_v3_v3(GPU_vertbuf_raw_step(&pos_step), mvert[ml_start->v].co);
-            copy_v3_v3(GPU_vertbuf_raw_step(&pos_step), mvert[ml_a->v].co);
-            copy_v3_v3(GPU_vertbuf_raw_step(&pos_step), mvert[ml_b->v].co);
-            vbo_len_used += 3;
-
-            ml_a++;
-            ml_b++;
-          }
-        }
+      else {
+        mlt += mp->totloop - 2;
       }
     }
 
@@ -32,6 +32,9 @@ extern "C" {
 
 #define BCM_CONFIG_FILE "config.ocio"
 
+/* Maximum length of color space names, including the terminator. */
+#define MAX_COLORSPACE_NAME 64
+
 struct ColorManagedColorspaceSettings;
 struct ColorManagedDisplaySettings;
 struct ColorManagedViewSettings;
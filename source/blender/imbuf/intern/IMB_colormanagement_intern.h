@@ -31,7 +31,9 @@ extern "C" {
 #endif
 
 struct ImBuf;
-struct OCIO_ConstProcessorRcPtr;
+
+/* Same handle declaration as in ocio_capi.h, which is not in the include path of all users. */
+typedef struct OCIO_ConstProcessorRcPtr__ *OCIO_ConstProcessorRcPtr;
 
 extern float imbuf_luma_coefficients[3];
 extern float imbuf_xyz_to_rgb[3][3];
@@ -46,8 +48,8 @@ typedef struct ColorSpace {
   char name[MAX_COLORSPACE_NAME];
   char description[MAX_COLORSPACE_DESCRIPTION];
 
-  struct OCIO_ConstProcessorRcPtr *to_scene_linear;
-  struct OCIO_ConstProcessorRcPtr *from_scene_linear;
+  OCIO_ConstProcessorRcPtr *to_scene_linear;
+  OCIO_ConstProcessorRcPtr *from_scene_linear;
 
   bool is_invertible;
   bool is_data;
@@ -66,8 +68,8 @@ typedef struct ColorManagedDisplay {
   char name[MAX_COLORSPACE_NAME];
   ListBase views; /* LinkData.data -> ColorManagedView */
 
-  struct OCIO_ConstProcessorRcPtr *to_scene_linear;
-  struct OCIO_ConstProcessorRcPtr *from_scene_linear;
+  OCIO_ConstProcessorRcPtr *to_scene_linear;
+  OCIO_ConstProcessorRcPtr *from_scene_linear;
 } ColorManagedDisplay;
 
 typedef struct ColorManagedView {
@@ -86,6 +88,26 @@ typedef struct ColorManagedLook {
   bool is_noop;
 } ColorManagedLook;
 
+/* Baked display transform, see colormanagement_lut.c. */
+#define COLORMANAGE_DISPLAY_LUT_SIZE 65
+
+typedef struct ColormanageDisplayLUT {
+  struct ColormanageDisplayLUT *next, *prev;
+
+  /* Settings the LUT was baked for, the input space is always scene linear. */
+  char look[MAX_COLORSPACE_NAME];
+  char view[MAX_COLORSPACE_NAME];
+  char display[MAX_COLORSPACE_NAME];
+  float exposure, gamma;
+
+  /* Number of processors using the LUT, plus one while it is in the global cache. */
+  int users;
+
+  /* COLORMANAGE_DISPLAY_LUT_SIZE^3 RGB triplets, red varying fastest.
+   * NULL until the first buffer is transformed with the LUT. */
+  float *table;
+} ColormanageDisplayLUT;
+
 /* ** Initialization / De-initialization ** */
 
 void colormanagement_init(void);
@@ -126,6 +148,17 @@ void colorspace_set_default_role(char *colorspace, int size, int role);
 void colormanage_imbuf_set_default_spaces(struct ImBuf *ibuf);
 void colormanage_imbuf_make_linear(struct ImBuf *ibuf, const char *from_colorspace);
 
+float *colormanage_display_lut_table_bake(OCIO_ConstProcessorRcPtr *processor);
+ColormanageDisplayLUT *colormanage_display_lut_bake(OCIO_ConstProcessorRcPtr *processor);
+void colormanage_display_lut_free(ColormanageDisplayLUT *lut);
+void colormanage_display_lut_apply(const ColormanageDisplayLUT *lut,
+                                   OCIO_ConstProcessorRcPtr *processor,
+                                   float *buffer,
+                                   int width,
+                                   int height,
+                                   int channels,
+                                   bool predivide);
+
 #ifdef __cplusplus
 }
 #endif
@@ -32,6 +32,7 @@
 #include "DNA_movieclip_types.h"
 #include "DNA_scene_types.h"
 #include "DNA_space_types.h"
+#include "DNA_userdef_types.h"
 
 #include "IMB_filetype.h"
 #include "IMB_filter.h"
@@ -49,6 +50,8 @@
 #include "BLI_string.h"
 #include "BLI_threads.h"
 
+#include "atomic_ops.h"
+
 #include "BKE_appdir.h"
 #include "BKE_colortools.h"
 #include "BKE_context.h"
@@ -100,9 +103,26 @@ static float imbuf_linear_srgb_to_xyz[3][3] = {{0.0f}};
  */
 static pthread_mutex_t processor_lock = BLI_MUTEX_INITIALIZER;
 
+/* Baked display transforms, shared between processors with the same view settings. */
+static pthread_mutex_t display_lut_lock = BLI_MUTEX_INITIALIZER;
+static ListBase global_display_luts = {NULL, NULL};
+static int global_tot_display_luts = 0;
+
+/* Lock used when baking the table of a cached LUT, so it is only baked once. */
+static pthread_mutex_t display_lut_bake_lock = BLI_MUTEX_INITIALIZER;
+
+/* Each LUT takes about 3MB, only keep the most recently used ones. */
+#define DISPLAY_LUT_CACHE_MAX 4
+
+/* Baking evaluates the exact processor for every LUT entry, for small buffers (color pickers,
+ * single pixel conversions) the exact processor is used directly. */
+#define DISPLAY_LUT_MIN_PIXELS 4096
+
 typedef struct ColormanageProcessor {
   OCIO_ConstProcessorRcPtr *processor;
   CurveMapping *curve_mapping;
+  /* Optional baked approximation of the processor, used for float buffers. */
+  ColormanageDisplayLUT *display_lut;
   bool is_data_result;
 } ColormanageProcessor;
 
@@ -293,6 +313,10 @@ static struct MovieCache *colormanage_moviecache_ensure(ImBuf *ibuf)
                                        colormanage_hashhash,
                                        colormanage_hashcmp);
 
+    /* Display buffers are recomputed from the image buffer in memory, which is much cheaper
+     * than decoding frames of images and clips sharing the same memory limit. */
+    IMB_moviecache_set_cost(moviecache, 0.25f);
+
     ibuf->colormanage_cache->moviecache = moviecache;
   }
 
@@ -597,6 +621,105 @@ static void colormanage_load_config(OCIO_ConstConfigRcPtr *config)
   invert_m3_m3(imbuf_linear_srgb_to_xyz, imbuf_xyz_to_linear_srgb);
 }
 
+static void display_lut_release_locked(ColormanageDisplayLUT *lut)
+{
+  BLI_assert(lut->users > 0);
+
+  lut->users--;
+  if (lut->users == 0) {
+    colormanage_display_lut_free(lut);
+  }
+}
+
+static void display_lut_release(ColormanageDisplayLUT *lut)
+{
+  BLI_mutex_lock(&display_lut_lock);
+  display_lut_release_locked(lut);
+  BLI_mutex_unlock(&display_lut_lock);
+}
+
+/* Get display transform LUT for the given settings, adding it to the cache when it is not there
+ * yet. The table itself is baked on first use by #display_lut_table_ensure.
+ * The result is to be released with #display_lut_release. */
+static ColormanageDisplayLUT *display_lut_acquire(const ColorManagedViewSettings *view_settings,
+                                                  const char *display)
+{
+  ColormanageDisplayLUT *lut;
+
+  BLI_mutex_lock(&display_lut_lock);
+
+  for (lut = global_display_luts.first; lut; lut = lut->next) {
+    if (STREQ(lut->look, view_settings->look) && STREQ(lut->view, view_settings->view_transform) &&
+        STREQ(lut->display, display) && lut->exposure == view_settings->exposure &&
+        lut->gamma == view_settings->gamma) {
+      break;
+    }
+  }
+
+  if (lut) {
+    /* Keep most recently used LUTs at the front. */
+    BLI_remlink(&global_display_luts, lut);
+  }
+  else {
+    lut = MEM_callocN(sizeof(ColormanageDisplayLUT), __func__);
+    STRNCPY(lut->look, view_settings->look);
+    STRNCPY(lut->view, view_settings->view_transform);
+    STRNCPY(lut->display, display);
+    lut->exposure = view_settings->exposure;
+    lut->gamma = view_settings->gamma;
+    lut->users = 1;
+    global_tot_display_luts++;
+
+    while (global_tot_display_luts > DISPLAY_LUT_CACHE_MAX) {
+      ColormanageDisplayLUT *lut_last = global_display_luts.last;
+      BLI_remlink(&global_display_luts, lut_last);
+      display_lut_release_locked(lut_last);
+      global_tot_display_luts--;
+    }
+  }
+
+  BLI_addhead(&global_display_luts, lut);
+  lut->users++;
+
+  BLI_mutex_unlock(&display_lut_lock);
+
+  return lut;
+}
+
+/* The table is published atomically, so once baked it is read without taking any lock. */
+static void display_lut_table_ensure(ColormanageDisplayLUT *lut,
+                                     OCIO_ConstProcessorRcPtr *processor)
+{
+  if (atomic_load_ptr((void *const *)&lut->table) != NULL) {
+    return;
+  }
+
+  BLI_mutex_lock(&display_lut_bake_lock);
+
+  if (atomic_load_ptr((void *const *)&lut->table) == NULL) {
+    float *table = colormanage_display_lut_table_bake(processor);
+    atomic_cas_ptr((void **)&lut->table, NULL, table);
+  }
+
+  BLI_mutex_unlock(&display_lut_bake_lock);
+}
+
+static void display_lut_cache_free(void)
+{
+  BLI_mutex_lock(&display_lut_lock);
+
+  ColormanageDisplayLUT *lut = global_display_luts.first;
+  while (lut) {
+    ColormanageDisplayLUT *lut_next = lut->next;
+    display_lut_release_locked(lut);
+    lut = lut_next;
+  }
+  BLI_listbase_clear(&global_display_luts);
+  global_tot_display_luts = 0;
+
+  BLI_mutex_unlock(&display_lut_lock);
+}
+
 static void colormanage_free_config(void)
 {
   ColorSpace *colorspace;
@@ -609,11 +732,11 @@ static void colormanage_free_config(void)
 
     /* free precomputer processors */
     if (colorspace->to_scene_linear) {
-      OCIO_processorRelease((OCIO_ConstProcessorRcPtr *)colorspace->to_scene_linear);
+      OCIO_processorRelease(colorspace->to_scene_linear);
     }
 
     if (colorspace->from_scene_linear) {
-      OCIO_processorRelease((OCIO_ConstProcessorRcPtr *)colorspace->from_scene_linear);
+      OCIO_processorRelease(colorspace->from_scene_linear);
     }
 
     /* free color space itself */
@@ -631,11 +754,11 @@ static void colormanage_free_config(void)
 
     /* free precomputer processors */
     if (display->to_scene_linear) {
-      OCIO_processorRelease((OCIO_ConstProcessorRcPtr *)display->to_scene_linear);
+      OCIO_processorRelease(display->to_scene_linear);
     }
 
     if (display->from_scene_linear) {
-      OCIO_processorRelease((OCIO_ConstProcessorRcPtr *)display->from_scene_linear);
+      OCIO_processorRelease(display->from_scene_linear);
     }
 
     /* free list of views */
@@ -655,6 +778,9 @@ static void colormanage_free_config(void)
   BLI_freelistN(&global_looks);
   global_tot_looks = 0;
 
+  /* free baked display transforms */
+  display_lut_cache_free();
+
   OCIO_exit();
 }
 
@@ -965,13 +1091,13 @@ static OCIO_ConstProcessorRcPtr *colorspace_to_scene_linear_processor(ColorSpace
       OCIO_ConstProcessorRcPtr *to_scene_linear;
       to_scene_linear = create_colorspace_transform_processor(colorspace->name,
                                                               global_role_scene_linear);
-      colorspace->to_scene_linear = (struct OCIO_ConstProcessorRcPtr *)to_scene_linear;
+      colorspace->to_scene_linear = to_scene_linear;
     }
 
     BLI_mutex_unlock(&processor_lock);
   }
 
-  return (OCIO_ConstProcessorRcPtr *)colorspace->to_scene_linear;
+  return colorspace->to_scene_linear;
 }
 
 static OCIO_ConstProcessorRcPtr *colorspace_from_scene_linear_processor(ColorSpace *colorspace)
@@ -983,13 +1109,13 @@ static OCIO_ConstProcessorRcPtr *colorspace_from_scene_linear_processor(ColorSpa
       OCIO_ConstProcessorRcPtr *from_scene_linear;
       from_scene_linear = create_colorspace_transform_processor(global_role_scene_linear,
                                                                 colorspace->name);
-      colorspace->from_scene_linear = (struct OCIO_ConstProcessorRcPtr *)from_scene_linear;
+      colorspace->from_scene_linear = from_scene_linear;
     }
 
     BLI_mutex_unlock(&processor_lock);
   }
 
-  return (OCIO_ConstProcessorRcPtr *)colorspace->from_scene_linear;
+  return colorspace->from_scene_linear;
 }
 
 static OCIO_ConstProcessorRcPtr *display_from_scene_linear_processor(ColorManagedDisplay *display)
@@ -1011,13 +1137,13 @@ static OCIO_ConstProcessorRcPtr *display_from_scene_linear_processor(ColorManage
         OCIO_configRelease(config);
       }
 
-      display->from_scene_linear = (struct OCIO_ConstProcessorRcPtr *)processor;
+      display->from_scene_linear = processor;
     }
 
     BLI_mutex_unlock(&processor_lock);
   }
 
-  return (OCIO_ConstProcessorRcPtr *)display->from_scene_linear;
+  return display->from_scene_linear;
 }
 
 static OCIO_ConstProcessorRcPtr *display_to_scene_linear_processor(ColorManagedDisplay *display)
@@ -1039,13 +1165,13 @@ static OCIO_ConstProcessorRcPtr *display_to_scene_linear_processor(ColorManagedD
         OCIO_configRelease(config);
       }
 
-      display->to_scene_linear = (struct OCIO_ConstProcessorRcPtr *)processor;
+      display->to_scene_linear = processor;
     }
 
     BLI_mutex_unlock(&processor_lock);
   }
 
-  return (OCIO_ConstProcessorRcPtr *)display->to_scene_linear;
+  return display->to_scene_linear;
 }
 
 void IMB_colormanagement_init_default_view_settings(
@@ -3846,6 +3972,11 @@ ColormanageProcessor *IMB_colormanagement_display_processor_new(
     BKE_curvemapping_premultiply(cm_processor->curve_mapping, false);
   }
 
+  if (cm_processor->processor && USER_EXPERIMENTAL_TEST(&U, use_display_lut)) {
+    cm_processor->display_lut = display_lut_acquire(applied_view_settings,
+                                                    display_settings->display_device);
+  }
+
   return cm_processor;
 }
 
@@ -3940,7 +4071,18 @@ void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor,
     }
   }
 
-  if (cm_processor->processor && channels >= 3) {
+  if (cm_processor->display_lut && ELEM(channels, 3, 4) &&
+      (size_t)width * height >= DISPLAY_LUT_MIN_PIXELS) {
+    display_lut_table_ensure(cm_processor->display_lut, cm_processor->processor);
+    colormanage_display_lut_apply(cm_processor->display_lut,
+                                  cm_processor->processor,
+                                  buffer,
+                                  width,
+                                  height,
+                                  channels,
+                                  predivide);
+  }
+  else if (cm_processor->processor && channels >= 3) {
     OCIO_PackedImageDesc *img;
 
     /* apply OCIO processor */
@@ -3986,6 +4128,9 @@ void IMB_colormanagement_processor_free(ColormanageProcessor *cm_processor)
   if (cm_processor->curve_mapping) {
     BKE_curvemapping_free(cm_processor->curve_mapping);
   }
+  if (cm_processor->display_lut) {
+    display_lut_release(cm_processor->display_lut);
+  }
   if (cm_processor->processor) {
     OCIO_processorRelease(cm_processor->processor);
   }
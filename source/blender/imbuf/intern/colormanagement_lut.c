@@ -0,0 +1,317 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup imbuf
+ *
+ * Baked approximation of display transforms.
+ *
+ * The OCIO CPU processor evaluates the whole chain of transforms for every pixel, which is
+ * expensive for redraws of large float buffers. Here the processor is sampled once into a 3D LUT
+ * which is then applied with tetrahedral interpolation.
+ *
+ * Input of display transforms is scene linear, so LUT coordinates go through a 1D shaper first:
+ * a linear segment for values close to zero followed by a logarithmic segment with a fixed number
+ * of cells per stop. The log segment is aligned so that 1.0 falls exactly on a grid node, which
+ * keeps the clipping point of standard views exact. Pixels outside of the shaper domain (negative,
+ * very bright or non-finite values) are handed to the exact processor.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_vector.h"
+#include "BLI_utildefines.h"
+
+#include "IMB_colormanagement_intern.h"
+
+#include <ocio_capi.h>
+
+/* Shaper parameters, see file description. */
+#define SHAPER_LOG_MIN (-12)
+#define SHAPER_LOG_MAX 9
+#define SHAPER_CELLS_PER_STOP 3
+/* Number of cells used by the linear segment, from 0 to 2^SHAPER_LOG_MIN. */
+#define SHAPER_LINEAR_CELLS 1
+
+#define SHAPER_LOG_CELLS ((SHAPER_LOG_MAX - SHAPER_LOG_MIN) * SHAPER_CELLS_PER_STOP)
+
+BLI_STATIC_ASSERT(SHAPER_LINEAR_CELLS + SHAPER_LOG_CELLS == COLORMANAGE_DISPLAY_LUT_SIZE - 1,
+                  "Shaper does not match display LUT size");
+
+#define SHAPER_LINEAR_MAX (1.0f / (float)(1 << -SHAPER_LOG_MIN))
+#define SHAPER_DOMAIN_MAX ((float)(1 << SHAPER_LOG_MAX))
+
+/* -------------------------------------------------------------------- */
+/** \name Shaper
+ * \{ */
+
+BLI_INLINE bool shaper_in_domain(const float rgb[3])
+{
+  /* Written so NaN fails the test as well. */
+  return (rgb[0] >= 0.0f && rgb[0] <= SHAPER_DOMAIN_MAX) &&
+         (rgb[1] >= 0.0f && rgb[1] <= SHAPER_DOMAIN_MAX) &&
+         (rgb[2] >= 0.0f && rgb[2] <= SHAPER_DOMAIN_MAX);
+}
+
+/* Map scene linear value within the shaper domain to a continuous LUT grid coordinate. */
+BLI_INLINE float shaper_to_grid(const float value)
+{
+  if (value < SHAPER_LINEAR_MAX) {
+    return value * (SHAPER_LINEAR_CELLS / SHAPER_LINEAR_MAX);
+  }
+  return SHAPER_LINEAR_CELLS + (log2f(value) - SHAPER_LOG_MIN) * SHAPER_CELLS_PER_STOP;
+}
+
+/* Inverse of #shaper_to_grid for grid nodes, used when baking the LUT. */
+static float shaper_from_grid(const int index)
+{
+  if (index <= SHAPER_LINEAR_CELLS) {
+    return index * (SHAPER_LINEAR_MAX / SHAPER_LINEAR_CELLS);
+  }
+  return exp2f(SHAPER_LOG_MIN + (float)(index - SHAPER_LINEAR_CELLS) / SHAPER_CELLS_PER_STOP);
+}
+
+BLI_INLINE void shaper_grid_cell(const float value, int *r_index, float *r_fac)
+{
+  const float grid = shaper_to_grid(value);
+  int index = (int)grid;
+  CLAMP(index, 0, COLORMANAGE_DISPLAY_LUT_SIZE - 2);
+  *r_index = index;
+  *r_fac = grid - (float)index;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Baking
+ * \{ */
+
+float *colormanage_display_lut_table_bake(OCIO_ConstProcessorRcPtr *processor)
+{
+  const int size = COLORMANAGE_DISPLAY_LUT_SIZE;
+  float grid_values[COLORMANAGE_DISPLAY_LUT_SIZE];
+
+  float *table = MEM_mallocN(sizeof(float[3]) * size * size * size, "display LUT table");
+
+  for (int i = 0; i < size; i++) {
+    grid_values[i] = shaper_from_grid(i);
+  }
+
+  /* Red varies fastest, matching the strides used by #display_lut_lookup. */
+  float *rgb = table;
+  for (int b = 0; b < size; b++) {
+    for (int g = 0; g < size; g++) {
+      for (int r = 0; r < size; r++, rgb += 3) {
+        rgb[0] = grid_values[r];
+        rgb[1] = grid_values[g];
+        rgb[2] = grid_values[b];
+      }
+    }
+  }
+
+  OCIO_PackedImageDesc *img = OCIO_createOCIO_PackedImageDesc(table,
+                                                              size * size,
+                                                              size,
+                                                              3,
+                                                              sizeof(float),
+                                                              sizeof(float[3]),
+                                                              sizeof(float[3]) * size * size);
+  OCIO_processorApply(processor, img);
+  OCIO_PackedImageDescRelease(img);
+
+  return table;
+}
+
+ColormanageDisplayLUT *colormanage_display_lut_bake(OCIO_ConstProcessorRcPtr *processor)
+{
+  ColormanageDisplayLUT *lut = MEM_callocN(sizeof(ColormanageDisplayLUT), __func__);
+  lut->table = colormanage_display_lut_table_bake(processor);
+  return lut;
+}
+
+void colormanage_display_lut_free(ColormanageDisplayLUT *lut)
+{
+  MEM_SAFE_FREE(lut->table);
+  MEM_freeN(lut);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Evaluation
+ * \{ */
+
+/* Tetrahedral interpolation of the LUT, `rgb` is expected to be within the shaper domain. */
+BLI_INLINE void display_lut_lookup(const float *table, const float rgb[3], float r_rgb[3])
+{
+  const int size = COLORMANAGE_DISPLAY_LUT_SIZE;
+  const int stride_r = 3;
+  const int stride_g = 3 * size;
+  const int stride_b = 3 * size * size;
+
+  int ir, ig, ib;
+  float fr, fg, fb;
+  shaper_grid_cell(rgb[0], &ir, &fr);
+  shaper_grid_cell(rgb[1], &ig, &fg);
+  shaper_grid_cell(rgb[2], &ib, &fb);
+
+  const float *c000 = table + ir * stride_r + ig * stride_g + ib * stride_b;
+  const float *c111 = c000 + stride_r + stride_g + stride_b;
+  const float *c_a, *c_b;
+  float w0, w_a, w_b, w1;
+
+  /* Pick the tetrahedron containing the point, walking from c000 to c111 along the axes in
+   * order of decreasing fraction. */
+  if (fr > fg) {
+    if (fg > fb) {
+      c_a = c000 + stride_r;
+      c_b = c000 + stride_r + stride_g;
+      w0 = 1.0f - fr;
+      w_a = fr - fg;
+      w_b = fg - fb;
+      w1 = fb;
+    }
+    else if (fr > fb) {
+      c_a = c000 + stride_r;
+      c_b = c000 + stride_r + stride_b;
+      w0 = 1.0f - fr;
+      w_a = fr - fb;
+      w_b = fb - fg;
+      w1 = fg;
+    }
+    else {
+      c_a = c000 + stride_b;
+      c_b = c000 + stride_r + stride_b;
+      w0 = 1.0f - fb;
+      w_a = fb - fr;
+      w_b = fr - fg;
+      w1 = fg;
+    }
+  }
+  else {
+    if (fb > fg) {
+      c_a = c000 + stride_b;
+      c_b = c000 + stride_g + stride_b;
+      w0 = 1.0f - fb;
+      w_a = fb - fg;
+      w_b = fg - fr;
+      w1 = fr;
+    }
+    else if (fb > fr) {
+      c_a = c000 + stride_g;
+      c_b = c000 + stride_g + stride_b;
+      w0 = 1.0f - fg;
+      w_a = fg - fb;
+      w_b = fb - fr;
+      w1 = fr;
+    }
+    else {
+      c_a = c000 + stride_g;
+      c_b = c000 + stride_r + stride_g;
+      w0 = 1.0f - fg;
+      w_a = fg - fr;
+      w_b = fr - fb;
+      w1 = fb;
+    }
+  }
+
+  for (int i = 0; i < 3; i++) {
+    r_rgb[i] = w0 * c000[i] + w_a * c_a[i] + w_b * c_b[i] + w1 * c111[i];
+  }
+}
+
+void colormanage_display_lut_apply(const ColormanageDisplayLUT *lut,
+                                   OCIO_ConstProcessorRcPtr *processor,
+                                   float *buffer,
+                                   int width,
+                                   int height,
+                                   int channels,
+                                   bool predivide)
+{
+  BLI_assert(ELEM(channels, 3, 4));
+
+  /* Pixels outside of the LUT domain of a single row, processed with the exact processor. */
+  float *exact_buffer = MEM_mallocN(sizeof(float) * channels * width, __func__);
+  int *exact_index = MEM_mallocN(sizeof(int) * width, __func__);
+
+  predivide = predivide && (channels == 4);
+
+  for (int y = 0; y < height; y++) {
+    float *row = buffer + ((size_t)y) * width * channels;
+    int exact_len = 0;
+
+    for (int x = 0; x < width; x++) {
+      float *pixel = row + ((size_t)x) * channels;
+      float rgb[3];
+      float alpha = 1.0f;
+
+      copy_v3_v3(rgb, pixel);
+
+      /* Same logic as OCIO_processorApplyRGBA_predivide(). */
+      const bool use_alpha = predivide && !ELEM(pixel[3], 0.0f, 1.0f);
+      if (use_alpha) {
+        alpha = pixel[3];
+        mul_v3_fl(rgb, 1.0f / alpha);
+      }
+
+      if (!shaper_in_domain(rgb)) {
+        memcpy(exact_buffer + exact_len * channels, pixel, sizeof(float) * channels);
+        exact_index[exact_len++] = x;
+        continue;
+      }
+
+      display_lut_lookup(lut->table, rgb, pixel);
+
+      if (use_alpha) {
+        mul_v3_fl(pixel, alpha);
+      }
+    }
+
+    if (exact_len != 0) {
+      OCIO_PackedImageDesc *img = OCIO_createOCIO_PackedImageDesc(
+          exact_buffer,
+          exact_len,
+          1,
+          channels,
+          sizeof(float),
+          (size_t)channels * sizeof(float),
+          (size_t)channels * sizeof(float) * exact_len);
+
+      if (predivide) {
+        OCIO_processorApply_predivide(processor, img);
+      }
+      else {
+        OCIO_processorApply(processor, img);
+      }
+
+      OCIO_PackedImageDescRelease(img);
+
+      for (int i = 0; i < exact_len; i++) {
+        memcpy(row + ((size_t)exact_index[i]) * channels,
+               exact_buffer + i * channels,
+               sizeof(float) * channels);
+      }
+    }
+  }
+
+  MEM_freeN(exact_buffer);
+  MEM_freeN(exact_index);
+}
+
+/** \} */
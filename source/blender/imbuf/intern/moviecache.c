@@ -30,6 +30,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_ghash.h"
+#include "BLI_linklist.h"
 #include "BLI_mempool.h"
 #include "BLI_string.h"
 #include "BLI_threads.h"
@@ -51,7 +52,16 @@
 #endif
 
 static MEM_CacheLimiterC *limitor = NULL;
+/* Guards the limitor as well as hashes and items of all caches: items of one cache could be
+ * destroyed when another cache enforces the shared memory limit. */
 static pthread_mutex_t limitor_lock = BLI_MUTEX_INITIALIZER;
+/* Incremented on every access, used to measure how recently items were used. */
+static uint64_t access_clock = 0;
+/* Number of items managed by the limitor, bounds the recency based priority. */
+static int limitor_totitem = 0;
+/* Buffers released while the lock is held. They are freed once it is released, since freeing a
+ * buffer frees its display buffers cache, which needs the lock as well. */
+static LinkNode *ibufs_free_pending = NULL;
 
 typedef struct MovieCache {
   char name[64];
@@ -71,8 +81,14 @@ typedef struct MovieCache {
 
   int keysize;
 
+  /* Relative cost of recomputing an item, cheap items are evicted first. */
+  float cost;
+
   void *last_userkey;
 
+  /* Statistics of #IMB_moviecache_get, protected by the cache lock. */
+  size_t hits, misses;
+
   int totseg, *points, proxy, render_flags; /* for visual statistics optimization */
   int pad;
 } MovieCache;
@@ -87,8 +103,31 @@ typedef struct MovieCacheItem {
   ImBuf *ibuf;
   MEM_CacheLimiterHandleC *c_handle;
   void *priority_data;
+  /* Value of #access_clock when the item was last put or retrieved. */
+  uint64_t last_access;
 } MovieCacheItem;
 
+static void moviecache_lock(void)
+{
+  BLI_mutex_lock(&limitor_lock);
+}
+
+static void moviecache_unlock(void)
+{
+  LinkNode *ibufs = ibufs_free_pending;
+  ibufs_free_pending = NULL;
+
+  BLI_mutex_unlock(&limitor_lock);
+
+  BLI_linklist_free(ibufs, (LinkNodeFreeFP)IMB_freeImBuf);
+}
+
+/* Free the buffer after the lock is released, see #ibufs_free_pending. */
+static void moviecache_ibuf_free_deferred(ImBuf *ibuf)
+{
+  BLI_linklist_prepend(&ibufs_free_pending, ibuf);
+}
+
 static unsigned int moviecache_hashhash(const void *keyv)
 {
   const MovieCacheKey *key = keyv;
@@ -122,7 +161,8 @@ static void moviecache_valfree(void *val)
 
   if (item->ibuf) {
     MEM_CacheLimiter_unmanage(item->c_handle);
-    IMB_freeImBuf(item->ibuf);
+    moviecache_ibuf_free_deferred(item->ibuf);
+    limitor_totitem--;
   }
 
   if (item->priority_data && cache->prioritydeleterfp) {
@@ -173,7 +213,8 @@ static void IMB_moviecache_destructor(void *p)
 
     PRINT("%s: cache '%s' destroy item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
 
-    IMB_freeImBuf(item->ibuf);
+    moviecache_ibuf_free_deferred(item->ibuf);
+    limitor_totitem--;
 
     item->ibuf = NULL;
     item->c_handle = NULL;
@@ -214,13 +255,28 @@ static int get_item_priority(void *item_v, int default_priority)
   int priority;
 
   if (!cache->getitempriorityfp) {
-    PRINT("%s: cache '%s' item %p use default priority %d\n",
+    /* The limitor does not reorder its queue on access when a priority callback is used, so
+     * recency is measured here. Items which were not used for a while are evicted first, scaled
+     * by how expensive they are to recompute.
+     *
+     * Callback priorities are distances in frames, bounded by the number of cached items in
+     * practice. The age counts accesses since the item was used, clamp it to the number of items
+     * as well so both kinds of priority are in the same range, [-totitem / cost, 0]. */
+    const uint64_t age = access_clock - item->last_access;
+    const int age_clamped = (age < (uint64_t)limitor_totitem) ? (int)age : limitor_totitem;
+
+    priority = -(int)((float)age_clamped / cache->cost);
+
+    PRINT("%s: cache '%s' item %p use recency priority %d (default %d)\n",
           __func__,
           cache->name,
           item,
+          priority,
           default_priority);
 
-    return default_priority;
+    UNUSED_VARS(default_priority);
+
+    return priority;
   }
 
   priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
@@ -282,6 +338,7 @@ MovieCache *IMB_moviecache_create(const char *name,
   cache->hashfp = hashfp;
   cache->cmpfp = cmpfp;
   cache->proxy = -1;
+  cache->cost = 1.0f;
 
   return cache;
 }
@@ -303,6 +360,12 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache,
   cache->prioritydeleterfp = prioritydeleterfp;
 }
 
+void IMB_moviecache_set_cost(MovieCache *cache, float cost)
+{
+  BLI_assert(cost > 0.0f);
+  cache->cost = cost;
+}
+
 static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, bool need_lock)
 {
   MovieCacheKey *key;
@@ -314,6 +377,10 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
 
   IMB_refImBuf(ibuf);
 
+  if (need_lock) {
+    moviecache_lock();
+  }
+
   key = BLI_mempool_alloc(cache->keys_pool);
   key->cache_owner = cache;
   key->userkey = BLI_mempool_alloc(cache->userkeys_pool);
@@ -328,6 +395,8 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
   item->c_handle = NULL;
   item->priority_data = NULL;
 
+  item->last_access = ++access_clock;
+
   if (cache->getprioritydatafp) {
     item->priority_data = cache->getprioritydatafp(userkey);
   }
@@ -338,20 +407,13 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
     memcpy(cache->last_userkey, userkey, cache->keysize);
   }
 
-  if (need_lock) {
-    BLI_mutex_lock(&limitor_lock);
-  }
-
   item->c_handle = MEM_CacheLimiter_insert(limitor, item);
+  limitor_totitem++;
 
   MEM_CacheLimiter_ref(item->c_handle);
   MEM_CacheLimiter_enforce_limits(limitor);
   MEM_CacheLimiter_unref(item->c_handle);
 
-  if (need_lock) {
-    BLI_mutex_unlock(&limitor_lock);
-  }
-
   /* cache limiter can't remove unused keys which points to destroyed values */
   check_unused_keys(cache);
 
@@ -359,6 +421,10 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
     MEM_freeN(cache->points);
     cache->points = NULL;
   }
+
+  if (need_lock) {
+    moviecache_unlock();
+  }
 }
 
 void IMB_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf)
@@ -374,7 +440,7 @@ bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibu
   elem_size = get_size_in_memory(ibuf);
   mem_limit = MEM_CacheLimiter_get_maximum();
 
-  BLI_mutex_lock(&limitor_lock);
+  moviecache_lock();
   mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
 
   if (mem_in_use + elem_size <= mem_limit) {
@@ -382,7 +448,7 @@ bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibu
     result = true;
   }
 
-  BLI_mutex_unlock(&limitor_lock);
+  moviecache_unlock();
 
   return result;
 }
@@ -392,7 +458,10 @@ void IMB_moviecache_remove(MovieCache *cache, void *userkey)
   MovieCacheKey key;
   key.cache_owner = cache;
   key.userkey = userkey;
+
+  moviecache_lock();
   BLI_ghash_remove(cache->hash, &key, moviecache_keyfree, moviecache_valfree);
+  moviecache_unlock();
 }
 
 ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey)
@@ -402,20 +471,30 @@ ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey)
 
   key.cache_owner = cache;
   key.userkey = userkey;
+
+  /* Lookup under the lock, the buffer could be destroyed by another thread otherwise. */
+  moviecache_lock();
+
   item = (MovieCacheItem *)BLI_ghash_lookup(cache->hash, &key);
 
-  if (item) {
-    if (item->ibuf) {
-      BLI_mutex_lock(&limitor_lock);
-      MEM_CacheLimiter_touch(item->c_handle);
-      BLI_mutex_unlock(&limitor_lock);
+  if (item && item->ibuf) {
+    ImBuf *ibuf = item->ibuf;
 
-      IMB_refImBuf(item->ibuf);
+    MEM_CacheLimiter_touch(item->c_handle);
+    item->last_access = ++access_clock;
+    cache->hits++;
 
-      return item->ibuf;
-    }
+    IMB_refImBuf(ibuf);
+
+    moviecache_unlock();
+
+    return ibuf;
   }
 
+  cache->misses++;
+
+  moviecache_unlock();
+
   return NULL;
 }
 
@@ -426,16 +505,25 @@ bool IMB_moviecache_has_frame(MovieCache *cache, void *userkey)
 
   key.cache_owner = cache;
   key.userkey = userkey;
+
+  moviecache_lock();
   item = (MovieCacheItem *)BLI_ghash_lookup(cache->hash, &key);
+  moviecache_unlock();
 
   return item != NULL;
 }
 
 void IMB_moviecache_free(MovieCache *cache)
 {
-  PRINT("%s: cache '%s' free\n", __func__, cache->name);
+  PRINT("%s: cache '%s' free, %zu hits, %zu misses\n",
+        __func__,
+        cache->name,
+        cache->hits,
+        cache->misses);
 
+  moviecache_lock();
   BLI_ghash_free(cache->hash, moviecache_keyfree, moviecache_valfree);
+  moviecache_unlock();
 
   BLI_mempool_destroy(cache->keys_pool);
   BLI_mempool_destroy(cache->items_pool);
@@ -458,6 +546,8 @@ void IMB_moviecache_cleanup(MovieCache *cache,
 {
   GHashIterator gh_iter;
 
+  moviecache_lock();
+
   check_unused_keys(cache);
 
   BLI_ghashIterator_init(&gh_iter, cache->hash);
@@ -474,6 +564,44 @@ void IMB_moviecache_cleanup(MovieCache *cache,
       BLI_ghash_remove(cache->hash, key, moviecache_keyfree, moviecache_valfree);
     }
   }
+
+  moviecache_unlock();
+}
+
+void IMB_moviecache_get_stats(MovieCache *cache, MovieCacheStats *r_stats)
+{
+  GHashIterator gh_iter;
+
+  memset(r_stats, 0, sizeof(*r_stats));
+
+  moviecache_lock();
+
+  r_stats->hits = cache->hits;
+  r_stats->misses = cache->misses;
+
+  GHASH_ITER (gh_iter, cache->hash) {
+    const MovieCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
+
+    if (item->ibuf) {
+      r_stats->totitem++;
+      r_stats->memory += IMB_get_size_in_memory(item->ibuf);
+    }
+  }
+
+  moviecache_unlock();
+}
+
+size_t IMB_moviecache_get_memory_in_use(void)
+{
+  size_t mem_in_use = 0;
+
+  moviecache_lock();
+  if (limitor) {
+    mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
+  }
+  moviecache_unlock();
+
+  return mem_in_use;
 }
 
 /* get segments of cached frames. useful for debugging cache policies */
@@ -487,6 +615,8 @@ void IMB_moviecache_get_cache_segments(
     return;
   }
 
+  moviecache_lock();
+
   if (cache->proxy != proxy || cache->render_flags != render_flags) {
     if (cache->points) {
       MEM_freeN(cache->points);
@@ -565,41 +695,79 @@ void IMB_moviecache_get_cache_segments(
 
     MEM_freeN(frames);
   }
+
+  moviecache_unlock();
 }
 
+/* Items are collected under the lock and their buffers referenced, so iterating does not race
+ * with other threads putting or evicting items, while callers can still use movie caches from
+ * inside the loop. */
+typedef struct MovieCacheIter {
+  ImBuf **ibufs;
+  char *userkeys;
+  int keysize;
+  int totitem, index;
+} MovieCacheIter;
+
 struct MovieCacheIter *IMB_moviecacheIter_new(MovieCache *cache)
 {
-  GHashIterator *iter;
+  MovieCacheIter *iter = MEM_callocN(sizeof(MovieCacheIter), "movie cache iterator");
+  GHashIterator gh_iter;
+
+  moviecache_lock();
 
   check_unused_keys(cache);
-  iter = BLI_ghashIterator_new(cache->hash);
 
-  return (struct MovieCacheIter *)iter;
+  const int totitem = (int)BLI_ghash_len(cache->hash);
+
+  iter->keysize = cache->keysize;
+  if (totitem) {
+    iter->ibufs = MEM_malloc_arrayN(totitem, sizeof(ImBuf *), "movie cache iterator buffers");
+    iter->userkeys = MEM_malloc_arrayN(totitem, cache->keysize, "movie cache iterator keys");
+  }
+
+  GHASH_ITER (gh_iter, cache->hash) {
+    const MovieCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
+    const MovieCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
+
+    IMB_refImBuf(item->ibuf);
+    iter->ibufs[iter->totitem] = item->ibuf;
+    memcpy(iter->userkeys + (size_t)iter->totitem * cache->keysize, key->userkey, cache->keysize);
+    iter->totitem++;
+  }
+
+  moviecache_unlock();
+
+  return iter;
 }
 
 void IMB_moviecacheIter_free(struct MovieCacheIter *iter)
 {
-  BLI_ghashIterator_free((GHashIterator *)iter);
+  for (int i = 0; i < iter->totitem; i++) {
+    IMB_freeImBuf(iter->ibufs[i]);
+  }
+
+  MEM_SAFE_FREE(iter->ibufs);
+  MEM_SAFE_FREE(iter->userkeys);
+  MEM_freeN(iter);
 }
 
 bool IMB_moviecacheIter_done(struct MovieCacheIter *iter)
 {
-  return BLI_ghashIterator_done((GHashIterator *)iter);
+  return iter->index >= iter->totitem;
 }
 
 void IMB_moviecacheIter_step(struct MovieCacheIter *iter)
 {
-  BLI_ghashIterator_step((GHashIterator *)iter);
+  iter->index++;
 }
 
 ImBuf *IMB_moviecacheIter_getImBuf(struct MovieCacheIter *iter)
 {
-  MovieCacheItem *item = BLI_ghashIterator_getValue((GHashIterator *)iter);
-  return item->ibuf;
+  return iter->ibufs[iter->index];
 }
 
 void *IMB_moviecacheIter_getUserKey(struct MovieCacheIter *iter)
 {
-  MovieCacheKey *key = BLI_ghashIterator_getKey((GHashIterator *)iter);
-  return key->userkey;
+  return iter->userkeys + (size_t)iter->index * iter->keysize;
 }
@@ -1210,9 +1210,10 @@ void IMB_exrtile_write_channels(
   }
 }
 
-void IMB_exr_read_channels(void *handle)
+/* Read all channels which have a buffer assigned. With `only_assigned` channels without buffer
+ * are expected and skipped silently, as well as parts that have no assigned channels at all. */
+static void imb_exr_read_channels_ex(ExrHandle *data, const bool only_assigned)
 {
-  ExrHandle *data = (ExrHandle *)handle;
   int numparts = data->ifile->parts();
 
   /* Check if EXR was saved with previous versions of blender which flipped images. */
@@ -1231,6 +1232,19 @@ void IMB_exr_read_channels(void *handle)
       "internal_name");
 
   for (int i = 0; i < numparts; i++) {
+    if (only_assigned) {
+      bool has_assigned_channel = false;
+      LISTBASE_FOREACH (ExrChannel *, echan, &data->channels) {
+        if (echan->m->part_number == i && echan->rect) {
+          has_assigned_channel = true;
+          break;
+        }
+      }
+      if (!has_assigned_channel) {
+        continue;
+      }
+    }
+
     /* Read part header. */
     InputPart in(*data->ifile, i);
     Header header = in.header();
@@ -1244,6 +1258,9 @@ void IMB_exr_read_channels(void *handle)
       if (echan->m->part_number != i) {
         continue;
       }
+      if (only_assigned && echan->rect == nullptr) {
+        continue;
+      }
 
       exr_printf("%d %-6s %-22s \"%s\"\n",
                  echan->m->part_number,
@@ -1289,6 +1306,11 @@ void IMB_exr_read_channels(void *handle)
   }
 }
 
+void IMB_exr_read_channels(void *handle)
+{
+  imb_exr_read_channels_ex((ExrHandle *)handle, false);
+}
+
 void IMB_exr_multilayer_convert(void *handle,
                                 void *base,
                                 void *(*addview)(void *base, const char *str),
@@ -1530,43 +1552,87 @@ static ExrPass *imb_exr_get_pass(ListBase *lb, char *passname)
   return pass;
 }
 
-/* creates channels, makes a hierarchy and assigns memory to channels */
-static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
-                                         MultiPartInputFile &file,
-                                         int width,
-                                         int height)
+/* Point the channels of the pass into an interleaved buffer, or clear them when rect is null.
+ * With some heuristics, try to merge the channels in buffers. */
+static void imb_exr_pass_assign_rect(ExrPass *pass, float *rect, int width)
 {
-  ExrLayer *lay;
-  ExrPass *pass;
   ExrChannel *echan;
-  ExrHandle *data = (ExrHandle *)IMB_exr_get_handle();
   int a;
-  char layname[EXR_TOT_MAXNAME], passname[EXR_TOT_MAXNAME];
 
-  data->ifile_stream = &file_stream;
-  data->ifile = &file;
-
-  data->width = width;
-  data->height = height;
+  if (pass->totchan == 0) {
+    return;
+  }
 
-  std::vector<MultiViewChannelName> channels;
-  GetChannelsInMultiPartFile(*data->ifile, channels);
+  if (pass->totchan == 1) {
+    echan = pass->chan[0];
+    echan->rect = rect;
+    echan->xstride = 1;
+    echan->ystride = width;
+    pass->chan_id[0] = echan->chan_id;
+  }
+  else {
+    char lookup[256];
+
+    memset(lookup, 0, sizeof(lookup));
+
+    /* we can have RGB(A), XYZ(W), UVA */
+    if (ELEM(pass->totchan, 3, 4)) {
+      if (pass->chan[0]->chan_id == 'B' || pass->chan[1]->chan_id == 'B' ||
+          pass->chan[2]->chan_id == 'B') {
+        lookup[(unsigned int)'R'] = 0;
+        lookup[(unsigned int)'G'] = 1;
+        lookup[(unsigned int)'B'] = 2;
+        lookup[(unsigned int)'A'] = 3;
+      }
+      else if (pass->chan[0]->chan_id == 'Y' || pass->chan[1]->chan_id == 'Y' ||
+               pass->chan[2]->chan_id == 'Y') {
+        lookup[(unsigned int)'X'] = 0;
+        lookup[(unsigned int)'Y'] = 1;
+        lookup[(unsigned int)'Z'] = 2;
+        lookup[(unsigned int)'W'] = 3;
+      }
+      else {
+        lookup[(unsigned int)'U'] = 0;
+        lookup[(unsigned int)'V'] = 1;
+        lookup[(unsigned int)'A'] = 2;
+      }
+      for (a = 0; a < pass->totchan; a++) {
+        echan = pass->chan[a];
+        echan->rect = rect ? rect + lookup[(unsigned int)echan->chan_id] : nullptr;
+        echan->xstride = pass->totchan;
+        echan->ystride = width * pass->totchan;
+        pass->chan_id[(unsigned int)lookup[(unsigned int)echan->chan_id]] = echan->chan_id;
+      }
+    }
+    else { /* unknown */
+      for (a = 0; a < pass->totchan; a++) {
+        echan = pass->chan[a];
+        echan->rect = rect ? rect + a : nullptr;
+        echan->xstride = pass->totchan;
+        echan->ystride = width * pass->totchan;
+        pass->chan_id[a] = echan->chan_id;
+      }
+    }
+  }
+}
 
-  imb_exr_get_views(*data->ifile, *data->multiView);
+static void imb_exr_pass_alloc_rect(ExrPass *pass, int width, int height)
+{
+  if (pass->totchan == 0) {
+    return;
+  }
 
-  for (size_t i = 0; i < channels.size(); i++) {
-    IMB_exr_add_channel(
-        data, nullptr, channels[i].name.c_str(), channels[i].view.c_str(), 0, 0, nullptr, false);
+  pass->rect = (float *)MEM_callocN(
+      sizeof(float) * (size_t)width * (size_t)height * (size_t)pass->totchan, "pass rect");
+  imb_exr_pass_assign_rect(pass, pass->rect, width);
+}
 
-    echan = (ExrChannel *)data->channels.last;
-    echan->m->name = channels[i].name;
-    echan->m->view = channels[i].view;
-    echan->m->part_number = channels[i].part_number;
-    echan->m->internal_name = channels[i].internal_name;
-  }
+/* Build hierarchical layer list from the channels of the input file. */
+static bool imb_exr_build_layers(ExrHandle *data)
+{
+  ExrChannel *echan;
+  char layname[EXR_TOT_MAXNAME], passname[EXR_TOT_MAXNAME];
 
-  /* now try to sort out how to assign memory to the channels */
-  /* first build hierarchical layer list */
   for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
     if (imb_exr_split_channel_name(echan, layname, passname)) {
 
@@ -1597,68 +1663,58 @@ static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
   }
   if (echan) {
     printf("error, too many channels in one pass: %s\n", echan->m->name.c_str());
+    return false;
+  }
+
+  /* Channel order is needed even when no buffers are allocated yet. */
+  LISTBASE_FOREACH (ExrLayer *, lay, &data->layers) {
+    LISTBASE_FOREACH (ExrPass *, pass, &lay->passes) {
+      imb_exr_pass_assign_rect(pass, nullptr, data->width);
+    }
+  }
+
+  return true;
+}
+
+/* creates channels, makes a hierarchy and assigns memory to channels */
+static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
+                                         MultiPartInputFile &file,
+                                         int width,
+                                         int height)
+{
+  ExrChannel *echan;
+  ExrHandle *data = (ExrHandle *)IMB_exr_get_handle();
+
+  data->ifile_stream = &file_stream;
+  data->ifile = &file;
+
+  data->width = width;
+  data->height = height;
+
+  std::vector<MultiViewChannelName> channels;
+  GetChannelsInMultiPartFile(*data->ifile, channels);
+
+  imb_exr_get_views(*data->ifile, *data->multiView);
+
+  for (size_t i = 0; i < channels.size(); i++) {
+    IMB_exr_add_channel(
+        data, nullptr, channels[i].name.c_str(), channels[i].view.c_str(), 0, 0, nullptr, false);
+
+    echan = (ExrChannel *)data->channels.last;
+    echan->m->name = channels[i].name;
+    echan->m->view = channels[i].view;
+    echan->m->part_number = channels[i].part_number;
+    echan->m->internal_name = channels[i].internal_name;
+  }
+
+  if (!imb_exr_build_layers(data)) {
     IMB_exr_close(data);
     return nullptr;
   }
 
-  /* with some heuristics, try to merge the channels in buffers */
-  for (lay = (ExrLayer *)data->layers.first; lay; lay = lay->next) {
-    for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
-      if (pass->totchan) {
-        pass->rect = (float *)MEM_callocN(width * height * pass->totchan * sizeof(float),
-                                          "pass rect");
-        if (pass->totchan == 1) {
-          echan = pass->chan[0];
-          echan->rect = pass->rect;
-          echan->xstride = 1;
-          echan->ystride = width;
-          pass->chan_id[0] = echan->chan_id;
-        }
-        else {
-          char lookup[256];
-
-          memset(lookup, 0, sizeof(lookup));
-
-          /* we can have RGB(A), XYZ(W), UVA */
-          if (ELEM(pass->totchan, 3, 4)) {
-            if (pass->chan[0]->chan_id == 'B' || pass->chan[1]->chan_id == 'B' ||
-                pass->chan[2]->chan_id == 'B') {
-              lookup[(unsigned int)'R'] = 0;
-              lookup[(unsigned int)'G'] = 1;
-              lookup[(unsigned int)'B'] = 2;
-              lookup[(unsigned int)'A'] = 3;
-            }
-            else if (pass->chan[0]->chan_id == 'Y' || pass->chan[1]->chan_id == 'Y' ||
-                     pass->chan[2]->chan_id == 'Y') {
-              lookup[(unsigned int)'X'] = 0;
-              lookup[(unsigned int)'Y'] = 1;
-              lookup[(unsigned int)'Z'] = 2;
-              lookup[(unsigned int)'W'] = 3;
-            }
-            else {
-              lookup[(unsigned int)'U'] = 0;
-              lookup[(unsigned int)'V'] = 1;
-              lookup[(unsigned int)'A'] = 2;
-            }
-            for (a = 0; a < pass->totchan; a++) {
-              echan = pass->chan[a];
-              echan->rect = pass->rect + lookup[(unsigned int)echan->chan_id];
-              echan->xstride = pass->totchan;
-              echan->ystride = width * pass->totchan;
-              pass->chan_id[(unsigned int)lookup[(unsigned int)echan->chan_id]] = echan->chan_id;
-            }
-          }
-          else { /* unknown */
-            for (a = 0; a < pass->totchan; a++) {
-              echan = pass->chan[a];
-              echan->rect = pass->rect + a;
-              echan->xstride = pass->totchan;
-              echan->ystride = width * pass->totchan;
-              pass->chan_id[a] = echan->chan_id;
-            }
-          }
-        }
-      }
+  LISTBASE_FOREACH (ExrLayer *, lay, &data->layers) {
+    LISTBASE_FOREACH (ExrPass *, pass, &lay->passes) {
+      imb_exr_pass_alloc_rect(pass, width, height);
     }
   }
 
@@ -1894,12 +1950,140 @@ static bool imb_exr_is_multi(MultiPartInputFile &file)
   return false;
 }
 
+/* Open a multilayer file without decoding any pixels, passes are then read individually with
+ * #IMB_exr_read_pass. Returns false when the file is not a multilayer EXR. */
+bool IMB_exr_begin_read_multilayer(void *handle, const char *filename, int *width, int *height)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+
+  if (!IMB_exr_begin_read(handle, filename, width, height)) {
+    return false;
+  }
+  if (!imb_exr_is_multi(*data->ifile)) {
+    return false;
+  }
+
+  return imb_exr_build_layers(data);
+}
+
+/* Close the input file of a handle opened for reading, the layers and passes stay valid so the
+ * file can be reopened with #IMB_exr_reopen_input to read more passes later. */
+void IMB_exr_close_input(void *handle)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+
+  delete data->ifile;
+  delete data->ifile_stream;
+
+  data->ifile = nullptr;
+  data->ifile_stream = nullptr;
+}
+
+/* Reopen the input file closed by #IMB_exr_close_input. Fails when the file can not be read or
+ * its size changed since the layers were built. */
+bool IMB_exr_reopen_input(void *handle, const char *filename)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+
+  if (data->ifile) {
+    return true;
+  }
+
+  try {
+    data->ifile_stream = new IFileStream(filename);
+    data->ifile = new MultiPartInputFile(*(data->ifile_stream));
+  }
+  catch (const std::exception &) {
+    IMB_exr_close_input(handle);
+    return false;
+  }
+
+  Box2i dw = data->ifile->header(0).dataWindow();
+  if (dw.max.x - dw.min.x + 1 != data->width || dw.max.y - dw.min.y + 1 != data->height) {
+    IMB_exr_close_input(handle);
+    return false;
+  }
+
+  return true;
+}
+
+/* Decode the channels of a single pass from a file opened with #IMB_exr_begin_read_multilayer.
+ * Only parts which contain the pass are read. Returns a new interleaved buffer owned by the
+ * caller, or null if the pass does not exist. */
+float *IMB_exr_read_pass(void *handle,
+                         const char *layname,
+                         const char *passname,
+                         const char *viewname)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+  char name[EXR_PASS_MAXNAME];
+
+  if (data->ifile == nullptr) {
+    return nullptr;
+  }
+
+  /* Same naming as in #imb_exr_build_layers. */
+  if (viewname && viewname[0] != '\0') {
+    BLI_snprintf(name, sizeof(name), "%s.%s", passname, viewname);
+  }
+  else {
+    BLI_strncpy(name, passname, sizeof(name));
+  }
+
+  ExrLayer *lay = (ExrLayer *)BLI_findstring(&data->layers, layname, offsetof(ExrLayer, name));
+  ExrPass *pass = (lay) ? (ExrPass *)BLI_findstring(&lay->passes, name, offsetof(ExrPass, name)) :
+                          nullptr;
+  if (pass == nullptr || pass->totchan == 0) {
+    return nullptr;
+  }
+
+  imb_exr_pass_alloc_rect(pass, data->width, data->height);
+  imb_exr_read_channels_ex(data, true);
+
+  /* Hand over the buffer, the handle stays ready for reading other passes. */
+  float *rect = pass->rect;
+  pass->rect = nullptr;
+  imb_exr_pass_assign_rect(pass, nullptr, data->width);
+
+  return rect;
+}
+
 bool IMB_exr_has_multilayer(void *handle)
 {
   ExrHandle *data = (ExrHandle *)handle;
   return imb_exr_is_multi(*data->ifile);
 }
 
+/* Copy string attributes of the header to metadata, returns true if there were any. */
+static bool imb_exr_metadata_from_header(const Header &header, IDProperty **metadata)
+{
+  Header::ConstIterator iter;
+  bool found = false;
+
+  IMB_metadata_ensure(metadata);
+  for (iter = header.begin(); iter != header.end(); iter++) {
+    const StringAttribute *attr = header.findTypedAttribute<StringAttribute>(iter.name());
+
+    /* not all attributes are string attributes so we might get some NULLs here */
+    if (attr) {
+      IMB_metadata_set_field(*metadata, iter.name(), attr->value().c_str());
+      found = true;
+    }
+  }
+
+  return found;
+}
+
+/* Metadata of a file opened for reading, see #IMB_exr_begin_read_multilayer. */
+void IMB_exr_metadata_get(void *handle, IDProperty **metadata)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+
+  if (data->ifile) {
+    imb_exr_metadata_from_header(data->ifile->header(0), metadata);
+  }
+}
+
 struct ImBuf *imb_load_openexr(const unsigned char *mem,
                                size_t size,
                                int flags,
@@ -1955,19 +2139,8 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem,
       if (!(flags & IB_test)) {
 
         if (flags & IB_metadata) {
-          const Header &header = file->header(0);
-          Header::ConstIterator iter;
-
-          IMB_metadata_ensure(&ibuf->metadata);
-          for (iter = header.begin(); iter != header.end(); iter++) {
-            const StringAttribute *attr = file->header(0).findTypedAttribute<StringAttribute>(
-                iter.name());
-
-            /* not all attributes are string attributes so we might get some NULLs here */
-            if (attr) {
-              IMB_metadata_set_field(ibuf->metadata, iter.name(), attr->value().c_str());
-              ibuf->flags |= IB_metadata;
-            }
+          if (imb_exr_metadata_from_header(file->header(0), &ibuf->metadata)) {
+            ibuf->flags |= IB_metadata;
           }
         }
 
@@ -50,6 +50,20 @@ int IMB_exr_begin_read(void * /*handle*/,
 {
   return 0;
 }
+bool IMB_exr_begin_read_multilayer(void * /*handle*/,
+                                   const char * /*filename*/,
+                                   int * /*width*/,
+                                   int * /*height*/)
+{
+  return false;
+}
+void IMB_exr_close_input(void * /*handle*/)
+{
+}
+bool IMB_exr_reopen_input(void * /*handle*/, const char * /*filename*/)
+{
+  return false;
+}
 int IMB_exr_begin_write(void * /*handle*/,
                         const char * /*filename*/,
                         int /*width*/,
@@ -88,6 +102,16 @@ float *IMB_exr_channel_rect(void * /*handle*/,
 void IMB_exr_read_channels(void * /*handle*/)
 {
 }
+float *IMB_exr_read_pass(void * /*handle*/,
+                         const char * /*layname*/,
+                         const char * /*passname*/,
+                         const char * /*viewname*/)
+{
+  return nullptr;
+}
+void IMB_exr_metadata_get(void * /*handle*/, struct IDProperty ** /*metadata*/)
+{
+}
 void IMB_exr_write_channels(void * /*handle*/)
 {
 }
@@ -0,0 +1,142 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_base.h"
+#include "BLI_rand.h"
+
+#include "IMB_colormanagement_intern.h"
+
+#include <ocio_capi.h>
+
+class ColormanagementDisplayLUTTest : public testing::Test {
+ protected:
+  OCIO_ConstConfigRcPtr *config_ = nullptr;
+  OCIO_ConstProcessorRcPtr *processor_ = nullptr;
+
+  void SetUp() override
+  {
+    OCIO_init();
+    config_ = OCIO_configCreateFallback();
+    processor_ = OCIO_configGetProcessorWithNames(config_, "Linear", "sRGB");
+  }
+
+  void TearDown() override
+  {
+    OCIO_processorRelease(processor_);
+    OCIO_configRelease(config_);
+    OCIO_exit();
+  }
+
+  /* Compare LUT and exact processor results for a buffer of random scene linear colors. */
+  void test_random_buffer(const int channels, const bool predivide, const float max_error)
+  {
+    const int width = 512, height = 64;
+    const size_t buffer_len = (size_t)width * height * channels;
+    float *exact = (float *)MEM_mallocN(sizeof(float) * buffer_len, __func__);
+    float *baked = (float *)MEM_mallocN(sizeof(float) * buffer_len, __func__);
+
+    /* Log distributed values, from deep shadows to well above the LUT domain, with a few
+     * negative values mixed in. */
+    RNG *rng = BLI_rng_new(4242);
+    for (size_t i = 0; i < buffer_len; i++) {
+      if (channels == 4 && i % 4 == 3) {
+        exact[i] = BLI_rng_get_float(rng);
+      }
+      else {
+        exact[i] = exp2f(-16.0f + 28.0f * BLI_rng_get_float(rng));
+        if (BLI_rng_get_float(rng) < 0.01f) {
+          exact[i] = -exact[i];
+        }
+      }
+    }
+    BLI_rng_free(rng);
+    memcpy(baked, exact, sizeof(float) * buffer_len);
+
+    OCIO_PackedImageDesc *img = OCIO_createOCIO_PackedImageDesc(exact,
+                                                                width,
+                                                                height,
+                                                                channels,
+                                                                sizeof(float),
+                                                                sizeof(float) * channels,
+                                                                sizeof(float) * channels * width);
+    if (predivide) {
+      OCIO_processorApply_predivide(processor_, img);
+    }
+    else {
+      OCIO_processorApply(processor_, img);
+    }
+    OCIO_PackedImageDescRelease(img);
+
+    ColormanageDisplayLUT *lut = colormanage_display_lut_bake(processor_);
+    colormanage_display_lut_apply(lut, processor_, baked, width, height, channels, predivide);
+    colormanage_display_lut_free(lut);
+
+    for (size_t i = 0; i < buffer_len; i++) {
+      /* Relative error for values above the display range. */
+      const float tolerance = max_error * max_ff(1.0f, fabsf(exact[i]));
+      ASSERT_NEAR(exact[i], baked[i], tolerance) << "at buffer index " << i;
+    }
+
+    MEM_freeN(exact);
+    MEM_freeN(baked);
+  }
+};
+
+TEST_F(ColormanagementDisplayLUTTest, GridNodes)
+{
+  /* Nodes of the LUT grid are exact, including the clipping point at 1.0. */
+  const float values[] = {0.0f, 1.0f / 4096.0f, 0.18f, 0.5f, 1.0f, 4.0f, 512.0f};
+  for (const float value : values) {
+    float exact[3] = {value, value, value};
+    float baked[3] = {value, value, value};
+    OCIO_processorApplyRGB(processor_, exact);
+
+    ColormanageDisplayLUT *lut = colormanage_display_lut_bake(processor_);
+    colormanage_display_lut_apply(lut, processor_, baked, 1, 1, 3, false);
+    colormanage_display_lut_free(lut);
+
+    EXPECT_NEAR(exact[0], baked[0], 1e-5f);
+    EXPECT_NEAR(exact[1], baked[1], 1e-5f);
+    EXPECT_NEAR(exact[2], baked[2], 1e-5f);
+  }
+}
+
+TEST_F(ColormanagementDisplayLUTTest, OutOfDomain)
+{
+  /* Values outside of the shaper domain go through the exact processor. */
+  float exact[8] = {-1.0f, 0.5f, 0.5f, 1.0f, 1000.0f, 2.0f, -0.001f, 0.5f};
+  float baked[8];
+  memcpy(baked, exact, sizeof(exact));
+
+  OCIO_processorApplyRGBA(processor_, exact);
+  OCIO_processorApplyRGBA(processor_, exact + 4);
+
+  ColormanageDisplayLUT *lut = colormanage_display_lut_bake(processor_);
+  colormanage_display_lut_apply(lut, processor_, baked, 2, 1, 4, false);
+  colormanage_display_lut_free(lut);
+
+  for (int i = 0; i < 8; i++) {
+    EXPECT_FLOAT_EQ(exact[i], baked[i]);
+  }
+}
+
+TEST_F(ColormanagementDisplayLUTTest, RandomRGB)
+{
+  test_random_buffer(3, false, 2e-3f);
+}
+
+TEST_F(ColormanagementDisplayLUTTest, RandomRGBA)
+{
+  test_random_buffer(4, false, 2e-3f);
+}
+
+TEST_F(ColormanagementDisplayLUTTest, RandomRGBAPredivide)
+{
+  test_random_buffer(4, true, 2e-3f);
+}
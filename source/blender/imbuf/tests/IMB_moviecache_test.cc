@@ -0,0 +1,152 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_CacheLimiterC-Api.h"
+#include "MEM_guardedalloc.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+#include "IMB_moviecache.h"
+
+static unsigned int frame_hashhash(const void *key_v)
+{
+  return (unsigned int)*(const int *)key_v;
+}
+
+static bool frame_hashcmp(const void *a_v, const void *b_v)
+{
+  return *(const int *)a_v != *(const int *)b_v;
+}
+
+class MovieCacheTest : public testing::Test {
+ protected:
+  MovieCache *cache_ = nullptr;
+  size_t maximum_ = 0;
+
+  static void SetUpTestCase()
+  {
+    IMB_init();
+    IMB_moviecache_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    IMB_moviecache_destruct();
+    IMB_exit();
+  }
+
+  void SetUp() override
+  {
+    maximum_ = MEM_CacheLimiter_get_maximum();
+    cache_ = IMB_moviecache_create("test cache", sizeof(int), frame_hashhash, frame_hashcmp);
+  }
+
+  void TearDown() override
+  {
+    IMB_moviecache_free(cache_);
+    MEM_CacheLimiter_set_maximum(maximum_);
+  }
+
+  void put(int frame)
+  {
+    ImBuf *ibuf = IMB_allocImBuf(64, 64, 32, IB_rect);
+    IMB_moviecache_put(cache_, &frame, ibuf);
+    IMB_freeImBuf(ibuf);
+  }
+
+  bool get(int frame)
+  {
+    ImBuf *ibuf = IMB_moviecache_get(cache_, &frame);
+    if (ibuf == nullptr) {
+      return false;
+    }
+    IMB_freeImBuf(ibuf);
+    return true;
+  }
+
+  MovieCacheStats stats()
+  {
+    MovieCacheStats stats;
+    IMB_moviecache_get_stats(cache_, &stats);
+    return stats;
+  }
+};
+
+static bool cleanup_odd_frames(ImBuf * /*ibuf*/, void *userkey, void * /*userdata*/)
+{
+  return *(int *)userkey % 2 == 1;
+}
+
+TEST_F(MovieCacheTest, HitsAndMisses)
+{
+  MovieCacheStats s = stats();
+  EXPECT_EQ(s.hits, 0u);
+  EXPECT_EQ(s.misses, 0u);
+  EXPECT_EQ(s.totitem, 0);
+  EXPECT_EQ(s.memory, 0u);
+
+  EXPECT_FALSE(get(1));
+  put(1);
+  put(2);
+  EXPECT_TRUE(get(1));
+  EXPECT_TRUE(get(2));
+  EXPECT_TRUE(get(1));
+  EXPECT_FALSE(get(3));
+
+  s = stats();
+  EXPECT_EQ(s.hits, 3u);
+  EXPECT_EQ(s.misses, 2u);
+  EXPECT_EQ(s.totitem, 2);
+  EXPECT_GT(s.memory, 0u);
+
+  /* Checking for a frame is not a lookup. */
+  int frame = 2;
+  EXPECT_TRUE(IMB_moviecache_has_frame(cache_, &frame));
+  EXPECT_EQ(stats().hits, 3u);
+}
+
+TEST_F(MovieCacheTest, MissAfterRemove)
+{
+  for (int frame = 0; frame < 4; frame++) {
+    put(frame);
+  }
+  const size_t memory = stats().memory;
+
+  int frame = 2;
+  IMB_moviecache_remove(cache_, &frame);
+  IMB_moviecache_cleanup(cache_, cleanup_odd_frames, nullptr);
+
+  EXPECT_TRUE(get(0));
+  EXPECT_FALSE(get(1));
+  EXPECT_FALSE(get(2));
+  EXPECT_FALSE(get(3));
+
+  MovieCacheStats s = stats();
+  EXPECT_EQ(s.hits, 1u);
+  EXPECT_EQ(s.misses, 3u);
+  EXPECT_EQ(s.totitem, 1);
+  EXPECT_EQ(s.memory, memory / 4);
+}
+
+TEST_F(MovieCacheTest, MissAfterEvict)
+{
+  put(0);
+  const size_t item_size = stats().memory;
+
+  /* Room for two buffers, putting a third one evicts the least recently used. */
+  MEM_CacheLimiter_set_maximum(item_size * 5 / 2);
+  put(1);
+  EXPECT_TRUE(get(0));
+  put(2);
+
+  EXPECT_EQ(stats().totitem, 2);
+  EXPECT_TRUE(get(0));
+  EXPECT_FALSE(get(1));
+  EXPECT_TRUE(get(2));
+
+  MovieCacheStats s = stats();
+  EXPECT_EQ(s.hits, 3u);
+  EXPECT_EQ(s.misses, 1u);
+  EXPECT_EQ(s.memory, item_size * 2);
+}
@@ -53,6 +53,8 @@ typedef struct CustomDataLayer {
   char name[64];
   /** Layer data. */
   void *data;
+  /** Runtime only, user count of #data when it is shared with other layers (see #CD_SHARE). */
+  void *sharing_info;
 } CustomDataLayer;
 
 #define MAX_CUSTOMDATA_LAYER_NAME 64
@@ -156,7 +156,9 @@ typedef struct Image {
   short gpu_pass;
   short gpu_layer;
   short gpu_slot;
-  char _pad2[4];
+  /** Runtime, a background load of the image is queued, see #BKE_image_async_load_wait. */
+  char gpu_async_load;
+  char _pad2[3];
 
   /** Deprecated. */
   struct PackedFile *packedfile DNA_DEPRECATED;
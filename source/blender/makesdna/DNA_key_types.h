@@ -36,6 +36,7 @@ extern "C" {
 
 struct AnimData;
 struct Ipo;
+struct Key_Runtime;
 
 typedef struct KeyBlock {
   struct KeyBlock *next, *prev;
@@ -119,6 +120,9 @@ typedef struct Key {
    * current free UID for key-blocks.
    */
   int uidgen;
+
+  /** Runtime data of evaluated copies, NULL otherwise. */
+  struct Key_Runtime *runtime;
 } Key;
 
 /* **************** KEY ********************* */
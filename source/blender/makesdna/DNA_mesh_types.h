@@ -105,6 +105,12 @@ typedef struct Mesh_Runtime {
   /** Non-manifold boundary data for Shrinkwrap Target Project. */
   struct ShrinkwrapBoundaryData *shrinkwrap_data;
 
+  /**
+   * Vertex normals converted to floats, valid when #MESH_RUNTIME_VERT_NORMALS_VALID is set,
+   * see #BKE_mesh_runtime_vert_normals_ensure.
+   */
+  float (*vert_normals)[3];
+
   /** Set by modifier stack if only deformed from original. */
   char deformed_only;
   /**
@@ -124,11 +130,25 @@ typedef struct Mesh_Runtime {
    */
   char wrapper_type_finalize;
 
-  char _pad[4];
+  /** #eMeshRuntimeCacheFlag, state of lazily computed caches. */
+  char cache_flag;
+  char _pad[3];
 
   /** Needed in case we need to lazily initialize the mesh. */
   CustomData_MeshMasks cd_mask_extra;
 
+  /** Cached bounds, valid when #MESH_RUNTIME_BOUNDS_VALID is set. */
+  float bounds_min[3];
+  float bounds_max[3];
+
+  /**
+   * Changes whenever the deform-verts may have been edited, see
+   * #BKE_mesh_runtime_tag_deform_verts_changed. Taken from a session wide counter,
+   * different meshes never share a value.
+   */
+  int deform_verts_edit_count;
+  char _pad3[4];
+
 } Mesh_Runtime;
 
 typedef struct Mesh {
@@ -255,6 +275,21 @@ typedef enum eMeshWrapperType {
   /* ME_WRAPPER_TYPE_SUBD = 2, */ /* TODO */
 } eMeshWrapperType;
 
+/** #Mesh_Runtime.cache_flag */
+typedef enum eMeshRuntimeCacheFlag {
+  /**
+   * Positions changed since #Mesh_Runtime.looptris were computed,
+   * the array is kept and filled in again on next access.
+   */
+  MESH_RUNTIME_LOOPTRIS_DIRTY = (1 << 0),
+  /** #Mesh_Runtime.bounds_min and #Mesh_Runtime.bounds_max are up to date. */
+  MESH_RUNTIME_BOUNDS_VALID = (1 << 1),
+  /** Vertex normals (#MVert.no) need to be recalculated, see #BKE_mesh_ensure_normals. */
+  MESH_RUNTIME_NORMALS_DIRTY = (1 << 2),
+  /** #Mesh_Runtime.vert_normals match #MVert.no. */
+  MESH_RUNTIME_VERT_NORMALS_VALID = (1 << 3),
+} eMeshRuntimeCacheFlag;
+
 /* texflag */
 enum {
   ME_AUTOSPACE = 1,
@@ -637,7 +637,10 @@ typedef struct UserDef_Experimental {
   char use_switch_object_operator;
   char use_sculpt_tools_tilt;
   char use_object_add_tool;
-  char _pad[6];
+  char use_display_lut;
+  char use_async_image_loading;
+  char use_async_render_write;
+  char _pad[3];
   /** `makesdna` does not allow empty structs. */
 } UserDef_Experimental;
 
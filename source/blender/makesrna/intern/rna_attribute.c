@@ -65,6 +65,8 @@ const EnumPropertyItem rna_enum_attribute_domain_items[] = {
 
 #  include "BLI_math.h"
 
+#  include "BKE_mesh.h"
+
 #  include "DEG_depsgraph.h"
 
 #  include "BLT_translation.h"
@@ -175,6 +177,11 @@ static void rna_Attribute_data_begin(CollectionPropertyIterator *iter, PointerRN
       break;
   }
 
+  /* Mesh layers may be shared with evaluated copies, get a copy before exposing it for writing. */
+  if (CustomData_layer_ensure_unshared(layer) && (GS(id->name) == ID_ME)) {
+    BKE_mesh_update_customdata_pointers((Mesh *)id, false);
+  }
+
   rna_iterator_array_begin(iter, layer->data, struct_size, length, 0, NULL);
 }
 
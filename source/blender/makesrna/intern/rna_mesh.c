@@ -90,6 +90,15 @@ static Mesh *rna_mesh(PointerRNA *ptr)
   return me;
 }
 
+/* Layer data may be shared with evaluated copies of the mesh, get a copy before exposing it for
+ * writing. */
+static void rna_mesh_layer_ensure_unshared(Mesh *me, CustomDataLayer *layer)
+{
+  if (CustomData_layer_ensure_unshared(layer)) {
+    BKE_mesh_update_customdata_pointers(me, false);
+  }
+}
+
 static CustomData *rna_mesh_vdata_helper(Mesh *me)
 {
   return (me->edit_mesh) ? &me->edit_mesh->bm->vdata : &me->vdata;
@@ -678,6 +687,7 @@ static void rna_MeshUVLoopLayer_data_begin(CollectionPropertyIterator *iter, Poi
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_ensure_unshared(me, layer);
   rna_iterator_array_begin(
       iter, layer->data, sizeof(MLoopUV), (me->edit_mesh) ? 0 : me->totloop, 0, NULL);
 }
@@ -728,6 +738,7 @@ static void rna_MeshLoopColorLayer_data_begin(CollectionPropertyIterator *iter,
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_ensure_unshared(me, layer);
   rna_iterator_array_begin(
       iter, layer->data, sizeof(MLoopCol), (me->edit_mesh) ? 0 : me->totloop, 0, NULL);
 }
@@ -768,6 +779,7 @@ static void rna_MeshVertColorLayer_data_begin(CollectionPropertyIterator *iter,
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_ensure_unshared(me, layer);
   rna_iterator_array_begin(
       iter, layer->data, sizeof(MPropCol), (me->edit_mesh) ? 0 : me->totvert, 0, NULL);
 }
@@ -927,6 +939,7 @@ static void rna_MeshSkinVertexLayer_data_begin(CollectionPropertyIterator *iter,
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_ensure_unshared(me, layer);
   rna_iterator_array_begin(iter, layer->data, sizeof(MVertSkin), me->totvert, 0, NULL);
 }
 
@@ -958,6 +971,7 @@ static void rna_MeshPaintMaskLayer_data_begin(CollectionPropertyIterator *iter,
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_ensure_unshared(me, layer);
   rna_iterator_array_begin(iter, layer->data, sizeof(MFloatProperty), me->totvert, 0, NULL);
 }
 
@@ -987,6 +1001,7 @@ static void rna_MeshFaceMapLayer_data_begin(CollectionPropertyIterator *iter, Po
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_ensure_unshared(me, layer);
   rna_iterator_array_begin(iter, layer->data, sizeof(int), me->totpoly, 0, NULL);
 }
 
@@ -1301,6 +1316,7 @@ static void rna_MeshVertexFloatPropertyLayer_data_begin(CollectionPropertyIterat
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_ensure_unshared(me, layer);
   rna_iterator_array_begin(iter, layer->data, sizeof(MFloatProperty), me->totvert, 0, NULL);
 }
 static void rna_MeshPolygonFloatPropertyLayer_data_begin(CollectionPropertyIterator *iter,
@@ -1308,6 +1324,7 @@ static void rna_MeshPolygonFloatPropertyLayer_data_begin(CollectionPropertyItera
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_ensure_unshared(me, layer);
   rna_iterator_array_begin(iter, layer->data, sizeof(MFloatProperty), me->totpoly, 0, NULL);
 }
 
@@ -1352,6 +1369,7 @@ static void rna_MeshVertexIntPropertyLayer_data_begin(CollectionPropertyIterator
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_ensure_unshared(me, layer);
   rna_iterator_array_begin(iter, layer->data, sizeof(MIntProperty), me->totvert, 0, NULL);
 }
 static void rna_MeshPolygonIntPropertyLayer_data_begin(CollectionPropertyIterator *iter,
@@ -1359,6 +1377,7 @@ static void rna_MeshPolygonIntPropertyLayer_data_begin(CollectionPropertyIterato
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_ensure_unshared(me, layer);
   rna_iterator_array_begin(iter, layer->data, sizeof(MIntProperty), me->totpoly, 0, NULL);
 }
 
@@ -1403,6 +1422,7 @@ static void rna_MeshVertexStringPropertyLayer_data_begin(CollectionPropertyItera
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_ensure_unshared(me, layer);
   rna_iterator_array_begin(iter, layer->data, sizeof(MStringProperty), me->totvert, 0, NULL);
 }
 static void rna_MeshPolygonStringPropertyLayer_data_begin(CollectionPropertyIterator *iter,
@@ -1410,6 +1430,7 @@ static void rna_MeshPolygonStringPropertyLayer_data_begin(CollectionPropertyIter
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_ensure_unshared(me, layer);
   rna_iterator_array_begin(iter, layer->data, sizeof(MStringProperty), me->totpoly, 0, NULL);
 }
 
@@ -6191,6 +6191,28 @@ static void rna_def_userdef_experimental(BlenderRNA *brna)
   RNA_def_property_boolean_sdna(prop, NULL, "use_object_add_tool", 1);
   RNA_def_property_ui_text(
       prop, "Add Object Tool", "Show add object tool in the toolbar in Object Mode and Edit Mode");
+
+  prop = RNA_def_property(srna, "use_display_lut", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "use_display_lut", 1);
+  RNA_def_property_ui_text(prop,
+                           "Display Transform LUT",
+                           "Approximate display transforms of float images with a baked 3D LUT, "
+                           "for faster drawing in the image editor and sequencer");
+
+  prop = RNA_def_property(srna, "use_async_image_loading", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "use_async_image_loading", 1);
+  RNA_def_property_ui_text(prop,
+                           "Asynchronous Image Loading",
+                           "Load image textures for the viewport in the background, drawing a "
+                           "placeholder until they are ready");
+
+  prop = RNA_def_property(srna, "use_async_render_write", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "use_async_render_write", 1);
+  RNA_def_property_ui_text(prop,
+                           "Asynchronous Render Output",
+                           "Write image files of animation renders in the background while the "
+                           "next frame renders. Render write handlers run once the file of a "
+                           "frame is written");
 }
 
 static void rna_def_userdef_addon_collection(BlenderRNA *brna, PropertyRNA *cprop)
@@ -82,6 +82,19 @@ static void copyData(const ModifierData *md, ModifierData *target, const int fla
   tamd->vert_coords_prev = NULL;
 }
 
+static void freeRuntimeData(void *runtime_data)
+{
+  if (runtime_data != NULL) {
+    BKE_armature_deform_weights_free(runtime_data);
+  }
+}
+
+static void freeData(ModifierData *md)
+{
+  freeRuntimeData(md->runtime);
+  md->runtime = NULL;
+}
+
 static void requiredDataMask(Object *UNUSED(ob),
                              ModifierData *UNUSED(md),
                              CustomData_MeshMasks *r_cddata_masks)
@@ -151,15 +164,16 @@ static void deformVerts(ModifierData *md,
 
   MOD_previous_vcos_store(md, vertexCos); /* if next modifier needs original vertices */
 
-  BKE_armature_deform_coords_with_mesh(amd->object,
-                                       ctx->object,
-                                       vertexCos,
-                                       NULL,
-                                       numVerts,
-                                       amd->deformflag,
-                                       amd->vert_coords_prev,
-                                       amd->defgrp_name,
-                                       mesh);
+  BKE_armature_deform_coords_with_mesh_ex(amd->object,
+                                          ctx->object,
+                                          vertexCos,
+                                          NULL,
+                                          numVerts,
+                                          amd->deformflag,
+                                          amd->vert_coords_prev,
+                                          amd->defgrp_name,
+                                          mesh,
+                                          (struct ArmatureDeformWeights **)&md->runtime);
 
   /* free cache */
   MEM_SAFE_FREE(amd->vert_coords_prev);
@@ -226,15 +240,16 @@ static void deformMatrices(ModifierData *md,
   ArmatureModifierData *amd = (ArmatureModifierData *)md;
   Mesh *mesh_src = MOD_deform_mesh_eval_get(ctx->object, NULL, mesh, NULL, numVerts, false, false);
 
-  BKE_armature_deform_coords_with_mesh(amd->object,
-                                       ctx->object,
-                                       vertexCos,
-                                       defMats,
-                                       numVerts,
-                                       amd->deformflag,
-                                       NULL,
-                                       amd->defgrp_name,
-                                       mesh_src);
+  BKE_armature_deform_coords_with_mesh_ex(amd->object,
+                                          ctx->object,
+                                          vertexCos,
+                                          defMats,
+                                          numVerts,
+                                          amd->deformflag,
+                                          NULL,
+                                          amd->defgrp_name,
+                                          mesh_src,
+                                          (struct ArmatureDeformWeights **)&md->runtime);
 
   if (!ELEM(mesh_src, NULL, mesh)) {
     BKE_id_free(NULL, mesh_src);
@@ -300,14 +315,14 @@ ModifierTypeInfo modifierType_Armature = {
 
     /* initData */ initData,
     /* requiredDataMask */ requiredDataMask,
-    /* freeData */ NULL,
+    /* freeData */ freeData,
     /* isDisabled */ isDisabled,
     /* updateDepsgraph */ updateDepsgraph,
     /* dependsOnTime */ NULL,
     /* dependsOnNormals */ NULL,
     /* foreachIDLink */ foreachIDLink,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
     /* panelRegister */ panelRegister,
     /* blendWrite */ NULL,
     /* blendRead */ blendRead,
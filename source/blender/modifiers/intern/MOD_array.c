@@ -28,6 +28,7 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -151,19 +152,20 @@ static void svert_from_mvert(SortVertsElem *sv,
 }
 
 /**
- * Take as inputs two sets of verts, to be processed for detection of doubles and mapping.
+ * Take as inputs two sets of verts, to be processed for detection of doubles.
  * Each set of verts is defined by its start within mverts array and its num_verts;
- * It builds a mapping for all vertices within source,
- * to vertices within target, or -1 if no double found.
- * The int doubles_map[num_verts_source] array must have been allocated by caller.
+ * It finds the closest vertex within target for all vertices within source,
+ * or -1 if no double found.
+ * The int r_targets[num_verts_source] array must have been allocated by caller,
+ * it doesn't depend on other mappings so it can be computed for several sets in parallel.
  */
-static void dm_mvert_map_doubles(int *doubles_map,
-                                 const MVert *mverts,
-                                 const int target_start,
-                                 const int target_num_verts,
-                                 const int source_start,
-                                 const int source_num_verts,
-                                 const float dist)
+static void dm_mvert_find_doubles(int *r_targets,
+                                  const MVert *mverts,
+                                  const int target_start,
+                                  const int target_num_verts,
+                                  const int source_start,
+                                  const int source_num_verts,
+                                  const float dist)
 {
   const float dist3 = ((float)M_SQRT3 + 0.00005f) * dist; /* Just above sqrt(3) */
   int i_source, i_target, i_target_low_bound, target_end, source_end;
@@ -200,14 +202,9 @@ static void dm_mvert_map_doubles(int *doubles_map,
     float best_dist_sq = dist * dist;
     float sve_source_sumco;
 
-    /* If source has already been assigned to a target (in an earlier call, with other chunks) */
-    if (doubles_map[sve_source->vertex_num] != -1) {
-      continue;
-    }
-
     /* If target fully scanned already, then all remaining source vertices cannot have a double */
     if (target_scan_completed) {
-      doubles_map[sve_source->vertex_num] = -1;
+      r_targets[sve_source->vertex_num - source_start] = -1;
       continue;
     }
 
@@ -222,7 +219,7 @@ static void dm_mvert_map_doubles(int *doubles_map,
     }
     /* If end of target list reached, then no more possible doubles */
     if (i_target_low_bound >= target_num_verts) {
-      doubles_map[sve_source->vertex_num] = -1;
+      r_targets[sve_source->vertex_num - source_start] = -1;
       target_scan_completed = true;
       continue;
     }
@@ -242,35 +239,78 @@ static void dm_mvert_map_doubles(int *doubles_map,
         /* Potential double found */
         best_dist_sq = dist_sq;
         best_target_vertex = sve_target->vertex_num;
-
-        /* If target is already mapped, we only follow that mapping if final target remains
-         * close enough from current vert (otherwise no mapping at all).
-         * Note that if we later find another target closer than this one, then we check it.
-         * But if other potential targets are farther,
-         * then there will be no mapping at all for this source. */
-        while (best_target_vertex != -1 &&
-               !ELEM(doubles_map[best_target_vertex], -1, best_target_vertex)) {
-          if (compare_len_v3v3(mverts[sve_source->vertex_num].co,
-                               mverts[doubles_map[best_target_vertex]].co,
-                               dist)) {
-            best_target_vertex = doubles_map[best_target_vertex];
-          }
-          else {
-            best_target_vertex = -1;
-          }
-        }
       }
       i_target++;
       sve_target++;
     }
     /* End of candidate scan: if none found then no doubles */
-    doubles_map[sve_source->vertex_num] = best_target_vertex;
+    r_targets[sve_source->vertex_num - source_start] = best_target_vertex;
   }
 
   MEM_freeN(sorted_verts_source);
   MEM_freeN(sorted_verts_target);
 }
 
+/**
+ * Builds the mapping of source vertices from the doubles found by #dm_mvert_find_doubles.
+ */
+static void dm_mvert_map_doubles_from_targets(int *doubles_map,
+                                              const int *targets,
+                                              const MVert *mverts,
+                                              const int source_start,
+                                              const int source_num_verts,
+                                              const float dist)
+{
+  for (int i = 0; i < source_num_verts; i++) {
+    const int i_source = source_start + i;
+    int best_target_vertex = targets[i];
+
+    /* If source has already been assigned to a target (in an earlier call, with other chunks) */
+    if (doubles_map[i_source] != -1) {
+      continue;
+    }
+
+    /* If target is already mapped, we only follow that mapping if final target remains
+     * close enough from current vert (otherwise no mapping at all). */
+    while (best_target_vertex != -1 &&
+           !ELEM(doubles_map[best_target_vertex], -1, best_target_vertex)) {
+      if (compare_len_v3v3(
+              mverts[i_source].co, mverts[doubles_map[best_target_vertex]].co, dist)) {
+        best_target_vertex = doubles_map[best_target_vertex];
+      }
+      else {
+        best_target_vertex = -1;
+      }
+    }
+    doubles_map[i_source] = best_target_vertex;
+  }
+}
+
+/**
+ * Take as inputs two sets of verts, to be processed for detection of doubles and mapping.
+ * Each set of verts is defined by its start within mverts array and its num_verts;
+ * It builds a mapping for all vertices within source,
+ * to vertices within target, or -1 if no double found.
+ * The int doubles_map[num_verts_source] array must have been allocated by caller.
+ */
+static void dm_mvert_map_doubles(int *doubles_map,
+                                 const MVert *mverts,
+                                 const int target_start,
+                                 const int target_num_verts,
+                                 const int source_start,
+                                 const int source_num_verts,
+                                 const float dist)
+{
+  int *targets = MEM_malloc_arrayN(source_num_verts, sizeof(int), __func__);
+
+  dm_mvert_find_doubles(
+      targets, mverts, target_start, target_num_verts, source_start, source_num_verts, dist);
+  dm_mvert_map_doubles_from_targets(
+      doubles_map, targets, mverts, source_start, source_num_verts, dist);
+
+  MEM_freeN(targets);
+}
+
 static void mesh_merge_transform(Mesh *result,
                                  Mesh *cap_mesh,
                                  const float cap_offset[4][4],
@@ -353,16 +393,128 @@ static void mesh_merge_transform(Mesh *result,
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Chunks Copy
+ *
+ * All copies only depend on the original mesh and their own cumulative offset,
+ * so they are generated in parallel, each task writing to its own range of the result.
+ * \{ */
+
+typedef struct ArrayChunkData {
+  const ArrayModifierData *amd;
+  const Mesh *mesh;
+  Mesh *result;
+  /* Cumulative offset of each chunk, identity for the first one. */
+  const float (*offsets)[4][4];
+  bool use_recalc_normals;
+  bool use_uv_offset;
+} ArrayChunkData;
+
+static void array_chunk_copy_cb(void *__restrict userdata,
+                                const int c,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ArrayChunkData *data = userdata;
+  const Mesh *mesh = data->mesh;
+  Mesh *result = data->result;
+  const float(*current_offset)[4] = data->offsets[c];
+  const int chunk_nverts = mesh->totvert;
+  const int chunk_nedges = mesh->totedge;
+  const int chunk_nloops = mesh->totloop;
+  const int chunk_npolys = mesh->totpoly;
+  int i;
+
+  /* copy customdata to new geometry */
+  CustomData_copy_data(&mesh->vdata, &result->vdata, 0, c * chunk_nverts, chunk_nverts);
+  CustomData_copy_data(&mesh->edata, &result->edata, 0, c * chunk_nedges, chunk_nedges);
+  CustomData_copy_data(&mesh->ldata, &result->ldata, 0, c * chunk_nloops, chunk_nloops);
+  CustomData_copy_data(&mesh->pdata, &result->pdata, 0, c * chunk_npolys, chunk_npolys);
+
+  /* apply offset to all new verts */
+  MVert *mv = result->mvert + c * chunk_nverts;
+  for (i = 0; i < chunk_nverts; i++, mv++) {
+    mul_m4_v3(current_offset, mv->co);
+
+    /* We have to correct normals too, if we do not tag them as dirty! */
+    if (!data->use_recalc_normals) {
+      float no[3];
+      normal_short_to_float_v3(no, mv->no);
+      mul_mat3_m4_v3(current_offset, no);
+      normalize_v3(no);
+      normal_float_to_short_v3(mv->no, no);
+    }
+  }
+
+  /* adjust edge vertex indices */
+  MEdge *me = result->medge + c * chunk_nedges;
+  for (i = 0; i < chunk_nedges; i++, me++) {
+    me->v1 += c * chunk_nverts;
+    me->v2 += c * chunk_nverts;
+  }
+
+  MPoly *mp = result->mpoly + c * chunk_npolys;
+  for (i = 0; i < chunk_npolys; i++, mp++) {
+    mp->loopstart += c * chunk_nloops;
+  }
+
+  /* adjust loop vertex and edge indices */
+  MLoop *ml = result->mloop + c * chunk_nloops;
+  for (i = 0; i < chunk_nloops; i++, ml++) {
+    ml->v += c * chunk_nverts;
+    ml->e += c * chunk_nedges;
+  }
+
+  /* handle UVs */
+  if (data->use_uv_offset) {
+    const float uv_offset[2] = {
+        data->amd->uv_offset[0] * (float)c,
+        data->amd->uv_offset[1] * (float)c,
+    };
+    const int totuv = CustomData_number_of_layers(&result->ldata, CD_MLOOPUV);
+    for (i = 0; i < totuv; i++) {
+      MLoopUV *dmloopuv = CustomData_get_layer_n(&result->ldata, CD_MLOOPUV, i);
+      dmloopuv += c * chunk_nloops;
+      for (int l_index = chunk_nloops; l_index-- != 0; dmloopuv++) {
+        dmloopuv->uv[0] += uv_offset[0];
+        dmloopuv->uv[1] += uv_offset[1];
+      }
+    }
+  }
+}
+
+typedef struct ArrayChunkDoublesData {
+  const MVert *mverts;
+  int chunk_nverts;
+  float merge_dist;
+  /* Closest vertex of chunk `c - 1` for each vertex of chunk `c`, chunk 0 being unused. */
+  int *targets;
+} ArrayChunkDoublesData;
+
+static void array_chunk_find_doubles_cb(void *__restrict userdata,
+                                        const int c,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ArrayChunkDoublesData *data = userdata;
+  const int chunk_nverts = data->chunk_nverts;
+
+  dm_mvert_find_doubles(data->targets + c * chunk_nverts,
+                        data->mverts,
+                        (c - 1) * chunk_nverts,
+                        chunk_nverts,
+                        c * chunk_nverts,
+                        chunk_nverts,
+                        data->merge_dist);
+}
+
+/** \} */
+
 static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
                                    const ModifierEvalContext *ctx,
                                    Mesh *mesh)
 {
   const MVert *src_mvert;
-  MVert *mv, *mv_prev, *result_dm_verts;
+  MVert *result_dm_verts;
 
-  MEdge *me;
-  MLoop *ml;
-  MPoly *mp;
   int i, j, c, count;
   float length = amd->length;
   /* offset matrix */
@@ -375,7 +527,7 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
   int tot_doubles;
 
   const bool use_merge = (amd->flags & MOD_ARR_MERGE) != 0;
-  const bool use_recalc_normals = (mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) || use_merge;
+  const bool use_recalc_normals = (mesh->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY) || use_merge;
   const bool use_offset_ob = ((amd->offset_type & MOD_ARR_OFF_OBJ) && amd->offset_ob != NULL);
 
   int start_cap_nverts = 0, start_cap_nedges = 0, start_cap_npolys = 0, start_cap_nloops = 0;
@@ -569,56 +721,44 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
   first_chunk_start = 0;
   first_chunk_nverts = chunk_nverts;
 
-  unit_m4(current_offset);
+  /* Cumulative offsets are computed upfront so chunks can be generated independently. */
+  float(*offsets)[4][4] = MEM_malloc_arrayN(count, sizeof(*offsets), __func__);
+  unit_m4(offsets[0]);
   for (c = 1; c < count; c++) {
-    /* copy customdata to new geometry */
-    CustomData_copy_data(&mesh->vdata, &result->vdata, 0, c * chunk_nverts, chunk_nverts);
-    CustomData_copy_data(&mesh->edata, &result->edata, 0, c * chunk_nedges, chunk_nedges);
-    CustomData_copy_data(&mesh->ldata, &result->ldata, 0, c * chunk_nloops, chunk_nloops);
-    CustomData_copy_data(&mesh->pdata, &result->pdata, 0, c * chunk_npolys, chunk_npolys);
-
-    mv_prev = result_dm_verts;
-    mv = mv_prev + c * chunk_nverts;
-
-    /* recalculate cumulative offset here */
-    mul_m4_m4m4(current_offset, current_offset, offset);
-
-    /* apply offset to all new verts */
-    for (i = 0; i < chunk_nverts; i++, mv++, mv_prev++) {
-      mul_m4_v3(current_offset, mv->co);
-
-      /* We have to correct normals too, if we do not tag them as dirty! */
-      if (!use_recalc_normals) {
-        float no[3];
-        normal_short_to_float_v3(no, mv->no);
-        mul_mat3_m4_v3(current_offset, no);
-        normalize_v3(no);
-        normal_float_to_short_v3(mv->no, no);
-      }
-    }
-
-    /* adjust edge vertex indices */
-    me = result->medge + c * chunk_nedges;
-    for (i = 0; i < chunk_nedges; i++, me++) {
-      me->v1 += c * chunk_nverts;
-      me->v2 += c * chunk_nverts;
-    }
+    mul_m4_m4m4(offsets[c], offsets[c - 1], offset);
+  }
+  copy_m4_m4(current_offset, offsets[count - 1]);
+
+  if (count > 1) {
+    ArrayChunkData data = {
+        .amd = amd,
+        .mesh = mesh,
+        .result = result,
+        .offsets = (const float(*)[4][4])offsets,
+        .use_recalc_normals = use_recalc_normals,
+        .use_uv_offset = (chunk_nloops > 0 && is_zero_v2(amd->uv_offset) == false),
+    };
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (chunk_nverts + chunk_nloops) * (count - 1) > 1024;
+    settings.min_iter_per_thread = 1;
+    BLI_task_parallel_range(1, count, &data, array_chunk_copy_cb, &settings);
+  }
 
-    mp = result->mpoly + c * chunk_npolys;
-    for (i = 0; i < chunk_npolys; i++, mp++) {
-      mp->loopstart += c * chunk_nloops;
-    }
+  MEM_freeN(offsets);
 
-    /* adjust loop vertex and edge indices */
-    ml = result->mloop + c * chunk_nloops;
-    for (i = 0; i < chunk_nloops; i++, ml++) {
-      ml->v += c * chunk_nverts;
-      ml->e += c * chunk_nedges;
-    }
+  /* Handle merge between chunk n and n-1 */
+  if (use_merge && (count > 1)) {
+    if (!offset_has_scale) {
+      dm_mvert_map_doubles(full_doubles_map,
+                           result_dm_verts,
+                           0,
+                           chunk_nverts,
+                           chunk_nverts,
+                           chunk_nverts,
+                           amd->merge_dist);
 
-    /* Handle merge between chunk n and n-1 */
-    if (use_merge && (c >= 1)) {
-      if (!offset_has_scale && (c >= 2)) {
+      for (c = 2; c < count; c++) {
         /* Mapping chunk 3 to chunk 2 is a translation of mapping 2 to 1
          * ... that is except if scaling makes the distance grow */
         int k;
@@ -644,35 +784,31 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
           full_doubles_map[this_chunk_index] = target;
         }
       }
-      else {
-        dm_mvert_map_doubles(full_doubles_map,
-                             result_dm_verts,
-                             (c - 1) * chunk_nverts,
-                             chunk_nverts,
-                             c * chunk_nverts,
-                             chunk_nverts,
-                             amd->merge_dist);
-      }
     }
-  }
+    else {
+      /* The search of doubles between consecutive chunks is independent of the mapping,
+       * only following chains of doubles has to be done in order. */
+      ArrayChunkDoublesData data = {
+          .mverts = result_dm_verts,
+          .chunk_nverts = chunk_nverts,
+          .merge_dist = amd->merge_dist,
+          .targets = MEM_malloc_arrayN((size_t)count * chunk_nverts, sizeof(int), __func__),
+      };
+      TaskParallelSettings settings;
+      BLI_parallel_range_settings_defaults(&settings);
+      settings.use_threading = chunk_nverts * (count - 1) > 1024;
+      settings.min_iter_per_thread = 1;
+      BLI_task_parallel_range(1, count, &data, array_chunk_find_doubles_cb, &settings);
 
-  /* handle UVs */
-  if (chunk_nloops > 0 && is_zero_v2(amd->uv_offset) == false) {
-    const int totuv = CustomData_number_of_layers(&result->ldata, CD_MLOOPUV);
-    for (i = 0; i < totuv; i++) {
-      MLoopUV *dmloopuv = CustomData_get_layer_n(&result->ldata, CD_MLOOPUV, i);
-      dmloopuv += chunk_nloops;
       for (c = 1; c < count; c++) {
-        const float uv_offset[2] = {
-            amd->uv_offset[0] * (float)c,
-            amd->uv_offset[1] * (float)c,
-        };
-        int l_index = chunk_nloops;
-        for (; l_index-- != 0; dmloopuv++) {
-          dmloopuv->uv[0] += uv_offset[0];
-          dmloopuv->uv[1] += uv_offset[1];
-        }
+        dm_mvert_map_doubles_from_targets(full_doubles_map,
+                                          data.targets + c * chunk_nverts,
+                                          result_dm_verts,
+                                          c * chunk_nverts,
+                                          chunk_nverts,
+                                          amd->merge_dist);
       }
+      MEM_freeN(data.targets);
     }
   }
 
@@ -784,7 +920,7 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
    * TODO: we may need to set other dirty flags as well?
    */
   if (use_recalc_normals) {
-    result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+    result->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
   }
 
   if (vgroup_start_cap_remap) {
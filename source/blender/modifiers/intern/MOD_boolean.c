@@ -164,7 +164,7 @@ static Mesh *get_quick_mesh(
             mul_m4_v3(omat, mv->co);
           }
 
-          result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+          result->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
         }
 
         break;
@@ -586,7 +586,7 @@ static Mesh *collection_boolean_exact(BooleanModifierData *bmd,
 
   result = BKE_mesh_from_bmesh_for_eval_nomain(bm, NULL, mesh);
   BM_mesh_free(bm);
-  result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  result->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
 
   MEM_freeN(shape);
   MEM_freeN(shape_face_end);
@@ -648,7 +648,7 @@ static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *ctx, Mesh *
 
         result = BKE_mesh_from_bmesh_for_eval_nomain(bm, NULL, mesh);
         BM_mesh_free(bm);
-        result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+        result->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
       }
 
       /* if new mesh returned, return it; otherwise there was
@@ -698,7 +698,7 @@ static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *ctx, Mesh *
 
             result = BKE_mesh_from_bmesh_for_eval_nomain(bm, NULL, mesh);
             BM_mesh_free(bm);
-            result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+            result->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
           }
         }
       }
@@ -278,8 +278,8 @@ static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *ctx, struct
   MEM_freeN(edgeMap);
   MEM_freeN(faceMap);
 
-  if (mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) {
-    result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  if (mesh->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY) {
+    result->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
   }
 
   /* TODO(sybren): also copy flags & tags? */
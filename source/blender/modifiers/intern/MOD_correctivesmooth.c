@@ -26,6 +26,7 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -43,6 +44,7 @@
 #include "BKE_editmesh.h"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
 #include "BKE_mesh_wrapper.h"
 #include "BKE_screen.h"
 
@@ -177,13 +179,89 @@ static void mesh_get_boundaries(Mesh *mesh, float *smooth_weights)
   MEM_freeN(boundaries);
 }
 
+/* -------------------------------------------------------------------- */
+/* Smoothing Iterations
+ *
+ * Each iteration gathers from the neighbors of every vertex (found with a vertex to vertex map
+ * built from the edges) and writes the result into a second buffer. So vertices can be smoothed
+ * in parallel, and the result doesn't depend on the number of threads.
+ */
+
+typedef struct SmoothIterData {
+  const MeshElemMap *vert_neighbors;
+  const float (*vertexCos_src)[3];
+  float (*vertexCos_dst)[3];
+
+  /* Simple smoothing: lambda and weight divided by the number of neighbors. */
+  const float *vertex_edge_count_div;
+
+  /* Length weighted smoothing. */
+  const float *smooth_weights;
+  float lambda;
+} SmoothIterData;
+
+static void smooth_iter_parallel(SmoothIterData *data,
+                                 TaskParallelRangeFunc func,
+                                 const uint numVerts,
+                                 uint iterations)
+{
+  float(*vertexCos)[3] = data->vertexCos_dst;
+  float(*vertexCos_tmp)[3] = MEM_malloc_arrayN(numVerts, sizeof(float[3]), __func__);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (numVerts > 1024);
+
+  data->vertexCos_src = (const float(*)[3])vertexCos;
+  data->vertexCos_dst = vertexCos_tmp;
+
+  while (iterations--) {
+#ifdef DEBUG_TIME
+    TIMEIT_START_AVERAGED(corrective_smooth_iter);
+#endif
+
+    BLI_task_parallel_range(0, (int)numVerts, data, func, &settings);
+
+#ifdef DEBUG_TIME
+    TIMEIT_END_AVERAGED(corrective_smooth_iter);
+#endif
+
+    float(*vertexCos_swap)[3] = (float(*)[3])data->vertexCos_src;
+    data->vertexCos_src = (const float(*)[3])data->vertexCos_dst;
+    data->vertexCos_dst = vertexCos_swap;
+  }
+
+  if (data->vertexCos_src != (const float(*)[3])vertexCos) {
+    memcpy(vertexCos, data->vertexCos_src, sizeof(float[3]) * numVerts);
+  }
+  MEM_freeN(vertexCos_tmp);
+}
+
 /* -------------------------------------------------------------------- */
 /* Simple Weighted Smoothing
  *
  * (average of surrounding verts)
  */
+static void smooth_iter__simple_cb(void *__restrict userdata,
+                                   const int i,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SmoothIterData *data = userdata;
+  const MeshElemMap *neighbors = &data->vert_neighbors[i];
+  const float *co = data->vertexCos_src[i];
+  float delta[3] = {0.0f, 0.0f, 0.0f};
+
+  for (int j = 0; j < neighbors->count; j++) {
+    float edge_dir[3];
+    sub_v3_v3v3(edge_dir, data->vertexCos_src[neighbors->indices[j]], co);
+    add_v3_v3(delta, edge_dir);
+  }
+
+  madd_v3_v3v3fl(data->vertexCos_dst[i], co, delta, data->vertex_edge_count_div[i]);
+}
+
 static void smooth_iter__simple(CorrectiveSmoothModifierData *csmd,
-                                Mesh *mesh,
+                                const MeshElemMap *vert_neighbors,
                                 float (*vertexCos)[3],
                                 uint numVerts,
                                 const float *smooth_weights,
@@ -192,164 +270,96 @@ static void smooth_iter__simple(CorrectiveSmoothModifierData *csmd,
   const float lambda = csmd->lambda;
   uint i;
 
-  const uint numEdges = (uint)mesh->totedge;
-  const MEdge *edges = mesh->medge;
-  float *vertex_edge_count_div;
-
-  struct SmoothingData_Simple {
-    float delta[3];
-  } *smooth_data = MEM_calloc_arrayN(numVerts, sizeof(*smooth_data), __func__);
-
-  vertex_edge_count_div = MEM_calloc_arrayN(numVerts, sizeof(float), __func__);
-
-  /* calculate as floats to avoid int->float conversion in #smooth_iter */
-  for (i = 0; i < numEdges; i++) {
-    vertex_edge_count_div[edges[i].v1] += 1.0f;
-    vertex_edge_count_div[edges[i].v2] += 1.0f;
-  }
+  float *vertex_edge_count_div = MEM_malloc_arrayN(numVerts, sizeof(float), __func__);
 
   /* a little confusing, but we can include 'lambda' and smoothing weight
    * here to avoid multiplying for every iteration */
   if (smooth_weights == NULL) {
     for (i = 0; i < numVerts; i++) {
-      vertex_edge_count_div[i] = lambda * (vertex_edge_count_div[i] ?
-                                               (1.0f / vertex_edge_count_div[i]) :
-                                               1.0f);
+      const float count = (float)vert_neighbors[i].count;
+      vertex_edge_count_div[i] = lambda * (count != 0.0f ? (1.0f / count) : 1.0f);
     }
   }
   else {
     for (i = 0; i < numVerts; i++) {
+      const float count = (float)vert_neighbors[i].count;
       vertex_edge_count_div[i] = smooth_weights[i] * lambda *
-                                 (vertex_edge_count_div[i] ? (1.0f / vertex_edge_count_div[i]) :
-                                                             1.0f);
+                                 (count != 0.0f ? (1.0f / count) : 1.0f);
     }
   }
 
   /* -------------------------------------------------------------------- */
   /* Main Smoothing Loop */
 
-  while (iterations--) {
-    for (i = 0; i < numEdges; i++) {
-      struct SmoothingData_Simple *sd_v1;
-      struct SmoothingData_Simple *sd_v2;
-      float edge_dir[3];
-
-      sub_v3_v3v3(edge_dir, vertexCos[edges[i].v2], vertexCos[edges[i].v1]);
-
-      sd_v1 = &smooth_data[edges[i].v1];
-      sd_v2 = &smooth_data[edges[i].v2];
-
-      add_v3_v3(sd_v1->delta, edge_dir);
-      sub_v3_v3(sd_v2->delta, edge_dir);
-    }
-
-    for (i = 0; i < numVerts; i++) {
-      struct SmoothingData_Simple *sd = &smooth_data[i];
-      madd_v3_v3fl(vertexCos[i], sd->delta, vertex_edge_count_div[i]);
-      /* zero for the next iteration (saves memset on entire array) */
-      memset(sd, 0, sizeof(*sd));
-    }
-  }
+  SmoothIterData data = {
+      .vert_neighbors = vert_neighbors,
+      .vertexCos_dst = vertexCos,
+      .vertex_edge_count_div = vertex_edge_count_div,
+  };
+  smooth_iter_parallel(&data, smooth_iter__simple_cb, numVerts, iterations);
 
   MEM_freeN(vertex_edge_count_div);
-  MEM_freeN(smooth_data);
 }
 
 /* -------------------------------------------------------------------- */
 /* Edge-Length Weighted Smoothing
  */
+static void smooth_iter__length_weight_cb(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const float eps = FLT_EPSILON * 10.0f;
+  const SmoothIterData *data = userdata;
+  const MeshElemMap *neighbors = &data->vert_neighbors[i];
+  const float *co = data->vertexCos_src[i];
+  float delta[3] = {0.0f, 0.0f, 0.0f};
+  float edge_length_sum = 0.0f;
+
+  for (int j = 0; j < neighbors->count; j++) {
+    float edge_dir[3];
+    sub_v3_v3v3(edge_dir, data->vertexCos_src[neighbors->indices[j]], co);
+    const float edge_dist = len_v3(edge_dir);
+
+    /* weight by distance */
+    mul_v3_fl(edge_dir, edge_dist);
+    add_v3_v3(delta, edge_dir);
+    edge_length_sum += edge_dist;
+  }
+
+  /* Divide by sum of all neighbor distances (weighted) and amount of neighbors,
+   * (mean average). */
+  const float div = edge_length_sum * (float)neighbors->count;
+  if (div > eps) {
+    const float lambda_w = data->smooth_weights ? data->lambda * data->smooth_weights[i] :
+                                                  data->lambda;
+    madd_v3_v3v3fl(data->vertexCos_dst[i], co, delta, lambda_w / div);
+  }
+  else {
+    copy_v3_v3(data->vertexCos_dst[i], co);
+  }
+}
+
 static void smooth_iter__length_weight(CorrectiveSmoothModifierData *csmd,
-                                       Mesh *mesh,
+                                       const MeshElemMap *vert_neighbors,
                                        float (*vertexCos)[3],
                                        uint numVerts,
                                        const float *smooth_weights,
                                        uint iterations)
 {
-  const float eps = FLT_EPSILON * 10.0f;
-  const uint numEdges = (uint)mesh->totedge;
   /* note: the way this smoothing method works, its approx half as strong as the simple-smooth,
    * and 2.0 rarely spikes, double the value for consistent behavior. */
   const float lambda = csmd->lambda * 2.0f;
-  const MEdge *edges = mesh->medge;
-  float *vertex_edge_count;
-  uint i;
-
-  struct SmoothingData_Weighted {
-    float delta[3];
-    float edge_length_sum;
-  } *smooth_data = MEM_calloc_arrayN(numVerts, sizeof(*smooth_data), __func__);
-
-  /* calculate as floats to avoid int->float conversion in #smooth_iter */
-  vertex_edge_count = MEM_calloc_arrayN(numVerts, sizeof(float), __func__);
-  for (i = 0; i < numEdges; i++) {
-    vertex_edge_count[edges[i].v1] += 1.0f;
-    vertex_edge_count[edges[i].v2] += 1.0f;
-  }
 
   /* -------------------------------------------------------------------- */
   /* Main Smoothing Loop */
 
-  while (iterations--) {
-    for (i = 0; i < numEdges; i++) {
-      struct SmoothingData_Weighted *sd_v1;
-      struct SmoothingData_Weighted *sd_v2;
-      float edge_dir[3];
-      float edge_dist;
-
-      sub_v3_v3v3(edge_dir, vertexCos[edges[i].v2], vertexCos[edges[i].v1]);
-      edge_dist = len_v3(edge_dir);
-
-      /* weight by distance */
-      mul_v3_fl(edge_dir, edge_dist);
-
-      sd_v1 = &smooth_data[edges[i].v1];
-      sd_v2 = &smooth_data[edges[i].v2];
-
-      add_v3_v3(sd_v1->delta, edge_dir);
-      sub_v3_v3(sd_v2->delta, edge_dir);
-
-      sd_v1->edge_length_sum += edge_dist;
-      sd_v2->edge_length_sum += edge_dist;
-    }
-
-    if (smooth_weights == NULL) {
-      /* fast-path */
-      for (i = 0; i < numVerts; i++) {
-        struct SmoothingData_Weighted *sd = &smooth_data[i];
-        /* Divide by sum of all neighbor distances (weighted) and amount of neighbors,
-         * (mean average). */
-        const float div = sd->edge_length_sum * vertex_edge_count[i];
-        if (div > eps) {
-#if 0
-          /* first calculate the new location */
-          mul_v3_fl(sd->delta, 1.0f / div);
-          /* then interpolate */
-          madd_v3_v3fl(vertexCos[i], sd->delta, lambda);
-#else
-          /* do this in one step */
-          madd_v3_v3fl(vertexCos[i], sd->delta, lambda / div);
-#endif
-        }
-        /* zero for the next iteration (saves memset on entire array) */
-        memset(sd, 0, sizeof(*sd));
-      }
-    }
-    else {
-      for (i = 0; i < numVerts; i++) {
-        struct SmoothingData_Weighted *sd = &smooth_data[i];
-        const float div = sd->edge_length_sum * vertex_edge_count[i];
-        if (div > eps) {
-          const float lambda_w = lambda * smooth_weights[i];
-          madd_v3_v3fl(vertexCos[i], sd->delta, lambda_w / div);
-        }
-
-        memset(sd, 0, sizeof(*sd));
-      }
-    }
-  }
-
-  MEM_freeN(vertex_edge_count);
-  MEM_freeN(smooth_data);
+  SmoothIterData data = {
+      .vert_neighbors = vert_neighbors,
+      .vertexCos_dst = vertexCos,
+      .smooth_weights = smooth_weights,
+      .lambda = lambda,
+  };
+  smooth_iter_parallel(&data, smooth_iter__length_weight_cb, numVerts, iterations);
 }
 
 static void smooth_iter(CorrectiveSmoothModifierData *csmd,
@@ -359,16 +369,25 @@ static void smooth_iter(CorrectiveSmoothModifierData *csmd,
                         const float *smooth_weights,
                         uint iterations)
 {
+  MeshElemMap *vert_neighbors;
+  int *vert_neighbors_mem;
+  BKE_mesh_vert_edge_vert_map_create(
+      &vert_neighbors, &vert_neighbors_mem, mesh->medge, (int)numVerts, mesh->totedge);
+
   switch (csmd->smooth_type) {
     case MOD_CORRECTIVESMOOTH_SMOOTH_LENGTH_WEIGHT:
-      smooth_iter__length_weight(csmd, mesh, vertexCos, numVerts, smooth_weights, iterations);
+      smooth_iter__length_weight(
+          csmd, vert_neighbors, vertexCos, numVerts, smooth_weights, iterations);
       break;
 
     /* case MOD_CORRECTIVESMOOTH_SMOOTH_SIMPLE: */
     default:
-      smooth_iter__simple(csmd, mesh, vertexCos, numVerts, smooth_weights, iterations);
+      smooth_iter__simple(csmd, vert_neighbors, vertexCos, numVerts, smooth_weights, iterations);
       break;
   }
+
+  MEM_freeN(vert_neighbors);
+  MEM_freeN(vert_neighbors_mem);
 }
 
 static void smooth_verts(CorrectiveSmoothModifierData *csmd,
@@ -461,54 +480,93 @@ static void calc_tangent_loop_accum(const float v_dir_prev[3],
   }
 }
 
-static void calc_tangent_spaces(Mesh *mesh, float (*vertexCos)[3], float (*r_tangent_spaces)[3][3])
+typedef struct TangentSpacesData {
+  const MeshElemMap *vert_loops;
+  const int *loop_to_poly;
+  const MPoly *mpoly;
+  const MLoop *mloop;
+  const float (*vertexCos)[3];
+  float (*r_tangent_spaces)[3][3];
+} TangentSpacesData;
+
+/* Accumulate the tangent space of a single vertex from all its face corners. */
+static void calc_tangent_spaces_cb(void *__restrict userdata,
+                                   const int i,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  const uint mpoly_num = (uint)mesh->totpoly;
-#ifndef USE_TANGENT_CALC_INLINE
-  const uint mvert_num = (uint)dm->getNumVerts(dm);
-#endif
-  const MPoly *mpoly = mesh->mpoly;
-  const MLoop *mloop = mesh->mloop;
-  uint i;
-
-  for (i = 0; i < mpoly_num; i++) {
-    const MPoly *mp = &mpoly[i];
-    const MLoop *l_next = &mloop[mp->loopstart];
-    const MLoop *l_term = l_next + mp->totloop;
-    const MLoop *l_prev = l_term - 2;
-    const MLoop *l_curr = l_term - 1;
+  const TangentSpacesData *data = userdata;
+  const MeshElemMap *vert_loops = &data->vert_loops[i];
+  const float(*vertexCos)[3] = data->vertexCos;
+  float(*ts)[3] = data->r_tangent_spaces[i];
+
+  for (int j = 0; j < vert_loops->count; j++) {
+    const int l_curr = vert_loops->indices[j];
+    const MPoly *mp = &data->mpoly[data->loop_to_poly[l_curr]];
+    const int l_first = mp->loopstart;
+    const int l_last = l_first + mp->totloop - 1;
+    const int l_prev = (l_curr == l_first) ? l_last : l_curr - 1;
+    const int l_next = (l_curr == l_last) ? l_first : l_curr + 1;
 
     /* loop directions */
     float v_dir_prev[3], v_dir_next[3];
 
-    /* needed entering the loop */
-    sub_v3_v3v3(v_dir_prev, vertexCos[l_prev->v], vertexCos[l_curr->v]);
+    sub_v3_v3v3(v_dir_prev, vertexCos[data->mloop[l_prev].v], vertexCos[i]);
     normalize_v3(v_dir_prev);
+    sub_v3_v3v3(v_dir_next, vertexCos[i], vertexCos[data->mloop[l_next].v]);
+    normalize_v3(v_dir_next);
 
-    for (; l_next != l_term; l_prev = l_curr, l_curr = l_next, l_next++) {
-      float(*ts)[3] = r_tangent_spaces[l_curr->v];
+    calc_tangent_loop_accum(v_dir_prev, v_dir_next, ts);
+  }
 
-      /* re-use the previous value */
-#if 0
-      sub_v3_v3v3(v_dir_prev, vertexCos[l_prev->v], vertexCos[l_curr->v]);
-      normalize_v3(v_dir_prev);
+  /* do inline */
+#ifndef USE_TANGENT_CALC_INLINE
+  calc_tangent_ortho(ts);
 #endif
-      sub_v3_v3v3(v_dir_next, vertexCos[l_curr->v], vertexCos[l_next->v]);
-      normalize_v3(v_dir_next);
+}
 
-      calc_tangent_loop_accum(v_dir_prev, v_dir_next, ts);
+static void calc_tangent_spaces(Mesh *mesh,
+                                float (*vertexCos)[3],
+                                uint numVerts,
+                                float (*r_tangent_spaces)[3][3])
+{
+  const MPoly *mpoly = mesh->mpoly;
+  const MLoop *mloop = mesh->mloop;
 
-      copy_v3_v3(v_dir_prev, v_dir_next);
+  MeshElemMap *vert_loops;
+  int *vert_loops_mem;
+  BKE_mesh_vert_loop_map_create(&vert_loops,
+                                &vert_loops_mem,
+                                mpoly,
+                                mloop,
+                                (int)numVerts,
+                                mesh->totpoly,
+                                mesh->totloop);
+
+  int *loop_to_poly = MEM_malloc_arrayN((size_t)mesh->totloop, sizeof(int), __func__);
+  for (int i = 0; i < mesh->totpoly; i++) {
+    const MPoly *mp = &mpoly[i];
+    for (int j = 0; j < mp->totloop; j++) {
+      loop_to_poly[mp->loopstart + j] = i;
     }
   }
 
-  /* do inline */
-#ifndef USE_TANGENT_CALC_INLINE
-  for (i = 0; i < mvert_num; i++) {
-    float(*ts)[3] = r_tangent_spaces[i];
-    calc_tangent_ortho(ts);
-  }
-#endif
+  TangentSpacesData data = {
+      .vert_loops = vert_loops,
+      .loop_to_poly = loop_to_poly,
+      .mpoly = mpoly,
+      .mloop = mloop,
+      .vertexCos = (const float(*)[3])vertexCos,
+      .r_tangent_spaces = r_tangent_spaces,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (numVerts > 1024);
+  BLI_task_parallel_range(0, (int)numVerts, &data, calc_tangent_spaces_cb, &settings);
+
+  MEM_freeN(loop_to_poly);
+  MEM_freeN(vert_loops);
+  MEM_freeN(vert_loops_mem);
 }
 
 static void store_cache_settings(CorrectiveSmoothModifierData *csmd)
@@ -557,7 +615,7 @@ static void calc_deltas(CorrectiveSmoothModifierData *csmd,
 
   smooth_verts(csmd, mesh, dvert, defgrp_index, smooth_vertex_coords, numVerts);
 
-  calc_tangent_spaces(mesh, smooth_vertex_coords, tangent_spaces);
+  calc_tangent_spaces(mesh, smooth_vertex_coords, numVerts, tangent_spaces);
 
   for (i = 0; i < numVerts; i++) {
     float imat[3][3], delta[3];
@@ -710,7 +768,7 @@ static void correctivesmooth_modifier_do(ModifierData *md,
     /* calloc, since values are accumulated */
     tangent_spaces = MEM_calloc_arrayN(numVerts, sizeof(float[3][3]), __func__);
 
-    calc_tangent_spaces(mesh, vertexCos, tangent_spaces);
+    calc_tangent_spaces(mesh, vertexCos, numVerts, tangent_spaces);
 
     for (i = 0; i < numVerts; i++) {
       float delta[3];
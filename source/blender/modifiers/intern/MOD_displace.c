@@ -42,6 +42,7 @@
 #include "BKE_lib_id.h"
 #include "BKE_lib_query.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_mesh_wrapper.h"
 #include "BKE_modifier.h"
 #include "BKE_object.h"
@@ -174,7 +175,7 @@ typedef struct DisplaceUserdata {
   float (*tex_co)[3];
   float (*vertexCos)[3];
   float local_mat[4][4];
-  MVert *mvert;
+  const float (*vert_nors)[3];
   float (*vert_clnors)[3];
 } DisplaceUserdata;
 
@@ -192,7 +193,7 @@ static void displaceModifier_do_task(void *__restrict userdata,
   bool use_global_direction = data->use_global_direction;
   float(*tex_co)[3] = data->tex_co;
   float(*vertexCos)[3] = data->vertexCos;
-  MVert *mvert = data->mvert;
+  const float(*vert_nors)[3] = data->vert_nors;
   float(*vert_clnors)[3] = data->vert_clnors;
 
   const float delta_fixed = 1.0f -
@@ -270,9 +271,7 @@ static void displaceModifier_do_task(void *__restrict userdata,
       add_v3_v3(vertexCos[iter], local_vec);
       break;
     case MOD_DISP_DIR_NOR:
-      vertexCos[iter][0] += delta * (mvert[iter].no[0] / 32767.0f);
-      vertexCos[iter][1] += delta * (mvert[iter].no[1] / 32767.0f);
-      vertexCos[iter][2] += delta * (mvert[iter].no[2] / 32767.0f);
+      madd_v3_v3fl(vertexCos[iter], vert_nors[iter], delta);
       break;
     case MOD_DISP_DIR_CLNOR:
       madd_v3_v3fl(vertexCos[iter], vert_clnors[iter], delta);
@@ -287,12 +286,13 @@ static void displaceModifier_do(DisplaceModifierData *dmd,
                                 const int numVerts)
 {
   Object *ob = ctx->object;
-  MVert *mvert;
   MDeformVert *dvert;
   int direction = dmd->direction;
   int defgrp_index;
   float(*tex_co)[3];
   float weight = 1.0f; /* init value unused but some compilers may complain */
+  const float(*vert_nors)[3] = NULL;
+  float(*vert_nors_free)[3] = NULL;
   float(*vert_clnors)[3] = NULL;
   float local_mat[4][4] = {{0}};
   const bool use_global_direction = dmd->space == MOD_DISP_SPACE_GLOBAL;
@@ -304,7 +304,6 @@ static void displaceModifier_do(DisplaceModifierData *dmd,
     return;
   }
 
-  mvert = mesh->mvert;
   MOD_get_vgroup(ob, mesh, dmd->defgrp_name, &dvert, &defgrp_index);
 
   if (defgrp_index >= 0 && dvert == NULL) {
@@ -329,7 +328,7 @@ static void displaceModifier_do(DisplaceModifierData *dmd,
     if (CustomData_has_layer(ldata, CD_CUSTOMLOOPNORMAL)) {
       float(*clnors)[3] = NULL;
 
-      if ((mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) ||
+      if ((mesh->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY) ||
           !CustomData_has_layer(ldata, CD_NORMAL)) {
         BKE_mesh_calc_normals_split(mesh);
       }
@@ -348,6 +347,10 @@ static void displaceModifier_do(DisplaceModifierData *dmd,
     copy_m4_m4(local_mat, ob->obmat);
   }
 
+  if (direction == MOD_DISP_DIR_NOR) {
+    vert_nors = BKE_mesh_runtime_vert_normals_ensure(mesh, &vert_nors_free);
+  }
+
   DisplaceUserdata data = {NULL};
   data.scene = DEG_get_evaluated_scene(ctx->depsgraph);
   data.dmd = dmd;
@@ -360,7 +363,7 @@ static void displaceModifier_do(DisplaceModifierData *dmd,
   data.tex_co = tex_co;
   data.vertexCos = vertexCos;
   copy_m4_m4(data.local_mat, local_mat);
-  data.mvert = mvert;
+  data.vert_nors = vert_nors;
   data.vert_clnors = vert_clnors;
   if (tex_target != NULL) {
     data.pool = BKE_image_pool_new();
@@ -379,6 +382,10 @@ static void displaceModifier_do(DisplaceModifierData *dmd,
     MEM_freeN(tex_co);
   }
 
+  if (vert_nors_free) {
+    MEM_freeN(vert_nors_free);
+  }
+
   if (vert_clnors) {
     MEM_freeN(vert_clnors);
   }
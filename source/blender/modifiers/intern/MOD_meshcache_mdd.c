@@ -18,36 +18,43 @@
  * \ingroup modifiers
  */
 
-#include <errno.h>
-#include <stdio.h>
 #include <string.h>
 
+#include "MEM_guardedalloc.h"
+
 #include "BLI_utildefines.h"
 
-#include "BLI_fileops.h"
 #include "BLI_math.h"
 #ifdef __LITTLE_ENDIAN__
 #  include "BLI_endian_switch.h"
 #endif
-#ifdef WIN32
-#  include "BLI_winstuff.h"
-#endif
 
 #include "DNA_modifier_types.h"
 
 #include "MOD_meshcache_util.h" /* own include */
 
+/* MDD files are big endian. */
+#ifdef __LITTLE_ENDIAN__
+#  define MDD_USE_ENDIAN_SWITCH true
+#else
+#  define MDD_USE_ENDIAN_SWITCH false
+#endif
+
 typedef struct MDDHead {
   int frame_tot;
   int verts_tot;
 } MDDHead; /* frames, verts */
 
-static bool meshcache_read_mdd_head(FILE *fp,
+static bool meshcache_read_mdd_head(const MeshCacheFile *file,
                                     const int verts_tot,
                                     MDDHead *mdd_head,
                                     const char **err_str)
 {
-  if (!fread(mdd_head, sizeof(*mdd_head), 1, fp)) {
+  if (file->size < sizeof(*mdd_head)) {
+    *err_str = "Missing header";
+    return false;
+  }
+  if (!MOD_meshcache_file_read(file, mdd_head, 0, sizeof(*mdd_head))) {
     *err_str = "Missing header";
     return false;
   }
@@ -65,36 +72,20 @@ static bool meshcache_read_mdd_head(FILE *fp,
     *err_str = "Invalid frame total";
     return false;
   }
-  /* Intentionally don't seek back. */
 
   return true;
 }
 
 /**
- * Gets the index range and factor.
+ * Frame times follow the header, then the vertex locations of each frame.
  */
-static bool meshcache_read_mdd_range(FILE *fp,
-                                     const int verts_tot,
-                                     const float frame,
-                                     const char interp,
-                                     int r_index_range[2],
-                                     float *r_factor,
-                                     const char **err_str)
+static size_t meshcache_mdd_frame_offset(const MDDHead *mdd_head, const int index)
 {
-  MDDHead mdd_head;
-
-  /* first check interpolation and get the vert locations */
-
-  if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
-    return false;
-  }
-
-  MOD_meshcache_calc_range(frame, interp, mdd_head.frame_tot, r_index_range, r_factor);
-
-  return true;
+  return sizeof(*mdd_head) + sizeof(float) * (size_t)mdd_head->frame_tot +
+         sizeof(float[3]) * (size_t)index * (size_t)mdd_head->verts_tot;
 }
 
-static bool meshcache_read_mdd_range_from_time(FILE *fp,
+static bool meshcache_read_mdd_range_from_time(const MeshCacheFile *file,
                                                const int verts_tot,
                                                const float time,
                                                const float UNUSED(fps),
@@ -106,20 +97,31 @@ static bool meshcache_read_mdd_range_from_time(FILE *fp,
   float f_time, f_time_prev = FLT_MAX;
   float frame;
 
-  if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
+  if (meshcache_read_mdd_head(file, verts_tot, &mdd_head, err_str) == false) {
+    return false;
+  }
+
+  if (file->size < meshcache_mdd_frame_offset(&mdd_head, 0)) {
+    *err_str = "Header seek failed";
+    return false;
+  }
+
+  float *f_times = MEM_malloc_arrayN((size_t)mdd_head.frame_tot, sizeof(float), __func__);
+  if (!MOD_meshcache_read_floats(
+          file, f_times, sizeof(mdd_head), (size_t)mdd_head.frame_tot, MDD_USE_ENDIAN_SWITCH)) {
+    MEM_freeN(f_times);
+    *err_str = "Header seek failed";
     return false;
   }
 
   for (i = 0; i < mdd_head.frame_tot; i++) {
-    fread(&f_time, sizeof(float), 1, fp);
-#ifdef __LITTLE_ENDIAN__
-    BLI_endian_switch_float(&f_time);
-#endif
+    f_time = f_times[i];
     if (f_time >= time) {
       break;
     }
     f_time_prev = f_time;
   }
+  MEM_freeN(f_times);
 
   if (i == mdd_head.frame_tot) {
     frame = (float)(mdd_head.frame_tot - 1);
@@ -142,7 +144,7 @@ static bool meshcache_read_mdd_range_from_time(FILE *fp,
   return true;
 }
 
-bool MOD_meshcache_read_mdd_index(FILE *fp,
+bool MOD_meshcache_read_mdd_index(const MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const int index,
@@ -151,109 +153,77 @@ bool MOD_meshcache_read_mdd_index(FILE *fp,
 {
   MDDHead mdd_head;
 
-  if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
+  if (meshcache_read_mdd_head(file, verts_tot, &mdd_head, err_str) == false) {
     return false;
   }
 
-  if (BLI_fseek(fp, mdd_head.frame_tot * sizeof(int), SEEK_CUR) != 0) {
-    *err_str = "Header seek failed";
-    return false;
-  }
+  const size_t offset = meshcache_mdd_frame_offset(&mdd_head, index);
+  const size_t floats_tot = (size_t)mdd_head.verts_tot * 3;
 
-  if (BLI_fseek(fp, sizeof(float[3]) * index * mdd_head.verts_tot, SEEK_CUR) != 0) {
+  if (file->size < offset + sizeof(float) * floats_tot) {
     *err_str = "Failed to seek frame";
     return false;
   }
 
+  bool ok;
   if (factor >= 1.0f) {
-#if 1
-    float *vco = *vertexCos;
-    uint i;
-    for (i = mdd_head.verts_tot; i != 0; i--, vco += 3) {
-      fread(vco, sizeof(float[3]), 1, fp);
-
-#  ifdef __LITTLE_ENDIAN__
-      BLI_endian_switch_float(vco + 0);
-      BLI_endian_switch_float(vco + 1);
-      BLI_endian_switch_float(vco + 2);
-#  endif /* __LITTLE_ENDIAN__ */
-    }
-#else
-    /* no blending */
-    if (!fread(vertexCos, sizeof(float[3]), mdd_head.verts_tot, f)) {
-      *err_str = errno ? strerror(errno) : "Failed to read frame";
-      return false;
-    }
-#  ifdef __LITTLE_ENDIAN__
-    BLI_endian_switch_float_array(vertexCos[0], mdd_head.verts_tot * 3);
-#  endif
-#endif
+    ok = MOD_meshcache_read_floats(file, *vertexCos, offset, floats_tot, MDD_USE_ENDIAN_SWITCH);
   }
   else {
-    const float ifactor = 1.0f - factor;
-    float *vco = *vertexCos;
-    uint i;
-    for (i = mdd_head.verts_tot; i != 0; i--, vco += 3) {
-      float tvec[3];
-      fread(tvec, sizeof(float[3]), 1, fp);
-
-#ifdef __LITTLE_ENDIAN__
-      BLI_endian_switch_float(tvec + 0);
-      BLI_endian_switch_float(tvec + 1);
-      BLI_endian_switch_float(tvec + 2);
-#endif
-
-      vco[0] = (vco[0] * ifactor) + (tvec[0] * factor);
-      vco[1] = (vco[1] * ifactor) + (tvec[1] * factor);
-      vco[2] = (vco[2] * ifactor) + (tvec[2] * factor);
-    }
+    ok = MOD_meshcache_read_floats_interp(
+        file, *vertexCos, offset, floats_tot, factor, MDD_USE_ENDIAN_SWITCH);
+  }
+  if (!ok) {
+    *err_str = "Failed to read frame";
+    return false;
   }
 
   return true;
 }
 
-bool MOD_meshcache_read_mdd_frame(FILE *fp,
+bool MOD_meshcache_read_mdd_frame(const MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
                                   const float frame,
                                   const char **err_str)
 {
+  MDDHead mdd_head;
   int index_range[2];
   float factor;
 
-  if (meshcache_read_mdd_range(fp,
-                               verts_tot,
-                               frame,
-                               interp,
-                               index_range,
-                               &factor, /* read into these values */
-                               err_str) == false) {
+  /* first check interpolation and get the vert locations */
+  if (meshcache_read_mdd_head(file, verts_tot, &mdd_head, err_str) == false) {
     return false;
   }
 
+  MOD_meshcache_calc_range(frame, interp, mdd_head.frame_tot, index_range, &factor);
+
   if (index_range[0] == index_range[1]) {
     /* read single */
-    if ((BLI_fseek(fp, 0, SEEK_SET) == 0) &&
-        MOD_meshcache_read_mdd_index(fp, vertexCos, verts_tot, index_range[0], 1.0f, err_str)) {
-      return true;
+    if (!MOD_meshcache_read_mdd_index(file, vertexCos, verts_tot, index_range[0], 1.0f, err_str)) {
+      return false;
     }
-
-    return false;
   }
-
-  /* read both and interpolate */
-  if ((BLI_fseek(fp, 0, SEEK_SET) == 0) &&
-      MOD_meshcache_read_mdd_index(fp, vertexCos, verts_tot, index_range[0], 1.0f, err_str) &&
-      (BLI_fseek(fp, 0, SEEK_SET) == 0) &&
-      MOD_meshcache_read_mdd_index(fp, vertexCos, verts_tot, index_range[1], factor, err_str)) {
-    return true;
+  else {
+    /* read both and interpolate */
+    if (!(MOD_meshcache_read_mdd_index(
+              file, vertexCos, verts_tot, index_range[0], 1.0f, err_str) &&
+          MOD_meshcache_read_mdd_index(
+              file, vertexCos, verts_tot, index_range[1], factor, err_str))) {
+      return false;
+    }
   }
 
-  return false;
+  /* Read ahead the frame which is likely to be needed next. */
+  MOD_meshcache_file_prefetch(file,
+                              meshcache_mdd_frame_offset(&mdd_head, index_range[1] + 1),
+                              sizeof(float[3]) * (size_t)verts_tot);
+
+  return true;
 }
 
-bool MOD_meshcache_read_mdd_times(const char *filepath,
+bool MOD_meshcache_read_mdd_times(const MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
@@ -264,14 +234,6 @@ bool MOD_meshcache_read_mdd_times(const char *filepath,
 {
   float frame;
 
-  FILE *fp = BLI_fopen(filepath, "rb");
-  bool ok;
-
-  if (fp == NULL) {
-    *err_str = errno ? strerror(errno) : "Unknown error opening file";
-    return false;
-  }
-
   switch (time_mode) {
     case MOD_MESHCACHE_TIME_FRAME: {
       frame = time;
@@ -279,29 +241,23 @@ bool MOD_meshcache_read_mdd_times(const char *filepath,
     }
     case MOD_MESHCACHE_TIME_SECONDS: {
       /* we need to find the closest time */
-      if (meshcache_read_mdd_range_from_time(fp, verts_tot, time, fps, &frame, err_str) == false) {
-        fclose(fp);
+      if (meshcache_read_mdd_range_from_time(file, verts_tot, time, fps, &frame, err_str) ==
+          false) {
         return false;
       }
-      rewind(fp);
       break;
     }
     case MOD_MESHCACHE_TIME_FACTOR:
     default: {
       MDDHead mdd_head;
-      if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
-        fclose(fp);
+      if (meshcache_read_mdd_head(file, verts_tot, &mdd_head, err_str) == false) {
         return false;
       }
 
       frame = CLAMPIS(time, 0.0f, 1.0f) * (float)mdd_head.frame_tot;
-      rewind(fp);
       break;
     }
   }
 
-  ok = MOD_meshcache_read_mdd_frame(fp, vertexCos, verts_tot, interp, frame, err_str);
-
-  fclose(fp);
-  return ok;
+  return MOD_meshcache_read_mdd_frame(file, vertexCos, verts_tot, interp, frame, err_str);
 }
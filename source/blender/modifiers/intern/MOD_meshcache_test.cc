@@ -0,0 +1,296 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+
+#include "testing/testing.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_endian_switch.h"
+#include "BLI_fileops.h"
+#include "BLI_math.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+
+#include "BKE_appdir.h"
+
+#include "DNA_modifier_types.h"
+
+#include "MOD_meshcache_util.h"
+
+namespace blender::modifiers::tests {
+
+#define VERTS_NUM 4
+#define FRAMES_NUM 3
+
+/* Position of a vertex at a frame of the test files. */
+static void frame_vert_co(const int frame, const int vert, float r_co[3])
+{
+  r_co[0] = (float)(frame * 10 + vert);
+  r_co[1] = (float)frame * 0.5f;
+  r_co[2] = -(float)vert;
+}
+
+class MeshCacheTest : public testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    BKE_appdir_init();
+    BKE_tempdir_init(nullptr);
+  }
+
+  static void TearDownTestCase()
+  {
+    BKE_tempdir_session_purge();
+  }
+
+  void filepath(char *r_filepath, const char *filename)
+  {
+    BLI_join_dirfile(r_filepath, FILE_MAX, BKE_tempdir_session(), filename);
+  }
+
+  /* Write 4 byte values in the given byte order. */
+  static void write_values(FILE *file, const void *values, const int values_num, bool big_endian)
+  {
+    uint *values_copy = (uint *)MEM_mallocN(sizeof(uint) * values_num, __func__);
+    memcpy(values_copy, values, sizeof(uint) * values_num);
+#ifdef __BIG_ENDIAN__
+    big_endian = !big_endian;
+#endif
+    if (big_endian) {
+      BLI_endian_switch_uint32_array(values_copy, values_num);
+    }
+    fwrite(values_copy, sizeof(uint), values_num, file);
+    MEM_freeN(values_copy);
+  }
+
+  static void write_frames(FILE *file, const int frames_num, const bool big_endian)
+  {
+    for (int frame = 0; frame < frames_num; frame++) {
+      float cos[VERTS_NUM][3];
+      for (int vert = 0; vert < VERTS_NUM; vert++) {
+        frame_vert_co(frame, vert, cos[vert]);
+      }
+      write_values(file, cos, VERTS_NUM * 3, big_endian);
+    }
+  }
+
+  /* PC2 files are little endian, frames are numbered from zero. Less frames than in the header
+   * can be written, to make a file that's cut short. */
+  static void write_pc2(const char *filepath, const int frames_written = FRAMES_NUM)
+  {
+    const int frames_num = FRAMES_NUM;
+    FILE *file = BLI_fopen(filepath, "wb");
+    ASSERT_NE(file, nullptr);
+    const char header[12] = "POINTCACHE2";
+    fwrite(header, sizeof(header), 1, file);
+    const int head_ints[2] = {1, VERTS_NUM};
+    const float head_floats[2] = {0.0f, 1.0f};
+    write_values(file, head_ints, 2, false);
+    write_values(file, head_floats, 2, false);
+    write_values(file, &frames_num, 1, false);
+    write_frames(file, frames_written, false);
+    fclose(file);
+  }
+
+  /* MDD files are big endian, the time of each frame is stored in seconds. */
+  static void write_mdd(const char *filepath)
+  {
+    FILE *file = BLI_fopen(filepath, "wb");
+    ASSERT_NE(file, nullptr);
+    const int head[2] = {FRAMES_NUM, VERTS_NUM};
+    write_values(file, head, 2, true);
+    float times[FRAMES_NUM];
+    for (int frame = 0; frame < FRAMES_NUM; frame++) {
+      times[frame] = (float)frame * 0.25f;
+    }
+    write_values(file, times, FRAMES_NUM, true);
+    write_frames(file, FRAMES_NUM, true);
+    fclose(file);
+  }
+};
+
+static void expect_frame_cos(const float (*cos)[3], const float frame)
+{
+  for (int vert = 0; vert < VERTS_NUM; vert++) {
+    float co_a[3], co_b[3], co[3];
+    frame_vert_co((int)floorf(frame), vert, co_a);
+    frame_vert_co((int)ceilf(frame), vert, co_b);
+    interp_v3_v3v3(co, co_a, co_b, frame - floorf(frame));
+    EXPECT_V3_NEAR(cos[vert], co, 1e-5f);
+  }
+}
+
+TEST_F(MeshCacheTest, Pc2ReadFrames)
+{
+  char path[FILE_MAX];
+  filepath(path, "frames.pc2");
+  write_pc2(path);
+
+  const char *err_str = nullptr;
+  MeshCacheFile *file = MOD_meshcache_file_acquire(path, &err_str);
+  ASSERT_NE(file, nullptr);
+
+  float cos[VERTS_NUM][3];
+  for (int frame = 0; frame < FRAMES_NUM; frame++) {
+    EXPECT_TRUE(MOD_meshcache_read_pc2_frame(
+        file, cos, VERTS_NUM, MOD_MESHCACHE_INTERP_NONE, (float)frame, &err_str));
+    expect_frame_cos(cos, (float)frame);
+  }
+
+  /* Frames out of range are clamped. */
+  EXPECT_TRUE(MOD_meshcache_read_pc2_frame(
+      file, cos, VERTS_NUM, MOD_MESHCACHE_INTERP_NONE, 10.0f, &err_str));
+  expect_frame_cos(cos, (float)(FRAMES_NUM - 1));
+
+  /* Vertex count of the mesh must match the file. */
+  float cos_more[VERTS_NUM + 1][3];
+  EXPECT_FALSE(MOD_meshcache_read_pc2_frame(
+      file, cos_more, VERTS_NUM + 1, MOD_MESHCACHE_INTERP_NONE, 0.0f, &err_str));
+  EXPECT_STREQ(err_str, "Vertex count mismatch");
+
+  MOD_meshcache_file_release(file);
+  BLI_delete(path, false, false);
+}
+
+TEST_F(MeshCacheTest, Pc2InterpolateFrames)
+{
+  char path[FILE_MAX];
+  filepath(path, "interp.pc2");
+  write_pc2(path);
+
+  const char *err_str = nullptr;
+  MeshCacheFile *file = MOD_meshcache_file_acquire(path, &err_str);
+  ASSERT_NE(file, nullptr);
+
+  float cos[VERTS_NUM][3];
+  EXPECT_TRUE(MOD_meshcache_read_pc2_frame(
+      file, cos, VERTS_NUM, MOD_MESHCACHE_INTERP_LINEAR, 1.25f, &err_str));
+  expect_frame_cos(cos, 1.25f);
+
+  /* Without interpolation the closest frame is used. */
+  EXPECT_TRUE(MOD_meshcache_read_pc2_frame(
+      file, cos, VERTS_NUM, MOD_MESHCACHE_INTERP_NONE, 1.75f, &err_str));
+  expect_frame_cos(cos, 2.0f);
+
+  MOD_meshcache_file_release(file);
+  BLI_delete(path, false, false);
+}
+
+TEST_F(MeshCacheTest, MddBigEndian)
+{
+  char path[FILE_MAX];
+  filepath(path, "frames.mdd");
+  write_mdd(path);
+
+  const char *err_str = nullptr;
+  MeshCacheFile *file = MOD_meshcache_file_acquire(path, &err_str);
+  ASSERT_NE(file, nullptr);
+
+  float cos[VERTS_NUM][3];
+  EXPECT_TRUE(MOD_meshcache_read_mdd_frame(
+      file, cos, VERTS_NUM, MOD_MESHCACHE_INTERP_LINEAR, 0.5f, &err_str));
+  expect_frame_cos(cos, 0.5f);
+
+  /* Frame times are read from the file. */
+  EXPECT_TRUE(MOD_meshcache_read_mdd_times(file,
+                                           cos,
+                                           VERTS_NUM,
+                                           MOD_MESHCACHE_INTERP_LINEAR,
+                                           0.375f,
+                                           25.0f,
+                                           MOD_MESHCACHE_TIME_SECONDS,
+                                           &err_str));
+  expect_frame_cos(cos, 1.5f);
+
+  MOD_meshcache_file_release(file);
+  BLI_delete(path, false, false);
+}
+
+TEST_F(MeshCacheTest, ReadTruncatedFile)
+{
+  char path[FILE_MAX];
+  filepath(path, "truncated.pc2");
+  write_pc2(path);
+
+  const char *err_str = nullptr;
+  MeshCacheFile *file = MOD_meshcache_file_acquire(path, &err_str);
+  ASSERT_NE(file, nullptr);
+  EXPECT_TRUE(MOD_meshcache_file_is_valid(file, path));
+
+  /* Cut short in place while still in use, the header is unchanged. */
+  write_pc2(path, 1);
+  EXPECT_FALSE(MOD_meshcache_file_is_valid(file, path));
+
+  float cos[VERTS_NUM][3];
+  EXPECT_TRUE(MOD_meshcache_read_pc2_frame(
+      file, cos, VERTS_NUM, MOD_MESHCACHE_INTERP_NONE, 0.0f, &err_str));
+  EXPECT_FALSE(MOD_meshcache_read_pc2_frame(
+      file, cos, VERTS_NUM, MOD_MESHCACHE_INTERP_NONE, 2.0f, &err_str));
+  EXPECT_STREQ(err_str, "Failed to read frame");
+
+  MOD_meshcache_file_release(file);
+
+  /* Acquiring again gives the file as it is now. */
+  file = MOD_meshcache_file_acquire(path, &err_str);
+  ASSERT_NE(file, nullptr);
+  EXPECT_FALSE(MOD_meshcache_read_pc2_frame(
+      file, cos, VERTS_NUM, MOD_MESHCACHE_INTERP_NONE, 2.0f, &err_str));
+  EXPECT_STREQ(err_str, "Failed to seek frame");
+  MOD_meshcache_file_release(file);
+
+  BLI_delete(path, false, false);
+}
+
+/* More files than descriptors kept open, least recently read files are opened again. */
+TEST_F(MeshCacheTest, ManyFiles)
+{
+  const int files_num = 100;
+  char(*paths)[FILE_MAX] = (char(*)[FILE_MAX])MEM_mallocN(sizeof(*paths) * files_num, __func__);
+  MeshCacheFile **files = (MeshCacheFile **)MEM_mallocN(sizeof(*files) * files_num, __func__);
+
+  const char *err_str = nullptr;
+  for (int i = 0; i < files_num; i++) {
+    char filename[64];
+    BLI_snprintf(filename, sizeof(filename), "many_%d.pc2", i);
+    filepath(paths[i], filename);
+    write_pc2(paths[i]);
+    files[i] = MOD_meshcache_file_acquire(paths[i], &err_str);
+    ASSERT_NE(files[i], nullptr);
+  }
+
+  float cos[VERTS_NUM][3];
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 0; i < files_num; i++) {
+      EXPECT_TRUE(MOD_meshcache_read_pc2_frame(
+          files[i], cos, VERTS_NUM, MOD_MESHCACHE_INTERP_LINEAR, 1.5f, &err_str));
+      expect_frame_cos(cos, 1.5f);
+    }
+  }
+
+  for (int i = 0; i < files_num; i++) {
+    MOD_meshcache_file_release(files[i]);
+    BLI_delete(paths[i], false, false);
+  }
+  MEM_freeN(files);
+  MEM_freeN(paths);
+}
+
+}  // namespace blender::modifiers::tests
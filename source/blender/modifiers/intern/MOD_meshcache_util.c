@@ -18,9 +18,29 @@
  * \ingroup modifiers
  */
 
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+
 #include "BLI_utildefines.h"
 
+#include "BLI_endian_switch.h"
+#include "BLI_fileops.h"
+#include "BLI_ghash.h"
+#include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
 
 #include "DNA_modifier_types.h"
 
@@ -62,3 +82,375 @@ void MOD_meshcache_calc_range(const float frame,
     }
   }
 }
+
+/* -------------------------------------------------------------------- */
+/** \name Shared Files
+ *
+ * Cache files are opened once and shared by all modifiers reading them,
+ * large crowds often use a single file for many objects.
+ * Modifiers keep their file in their runtime data, so the file isn't opened on every evaluation.
+ *
+ * Frames are read into the caller's buffers, the files aren't memory mapped: accessing a mapping
+ * crashes (SIGBUS) when the file is truncated or rewritten in-place while it's used, for example
+ * by a simulation still writing the cache.
+ *
+ * At most #MESHCACHE_FILES_OPEN_MAX descriptors are kept open, scenes may use a cache file for
+ * every object. The least recently read files are closed and opened again on demand.
+ * \{ */
+
+#define MESHCACHE_FILES_OPEN_MAX 64
+
+typedef struct MeshCacheFileShared {
+  MeshCacheFile file;
+
+  /* -1 while closed. */
+  int fd;
+  /* Reads in progress, the descriptor isn't closed meanwhile. */
+  int readers;
+  /* In #meshcache_files_open while `fd` is open, `data` points back to the file. */
+  LinkData open_link;
+
+  char filepath[FILE_MAX];
+  int64_t mtime;
+  int users;
+  /* The file changed on disk, it's no longer in #meshcache_files. */
+  bool is_stale;
+#ifdef WIN32
+  /* There are no positional reads, threads reading the file share its position. */
+  ThreadMutex read_mutex;
+#endif
+} MeshCacheFileShared;
+
+/* Acquired files by path. */
+static GHash *meshcache_files = NULL;
+/* Files with an open descriptor, least recently read first. */
+static ListBase meshcache_files_open = {NULL, NULL};
+static int meshcache_files_open_len = 0;
+static ThreadMutex meshcache_files_mutex = BLI_MUTEX_INITIALIZER;
+
+static void meshcache_file_fd_close(MeshCacheFileShared *shared)
+{
+  BLI_assert(shared->fd != -1 && shared->readers == 0);
+  close(shared->fd);
+  shared->fd = -1;
+  BLI_remlink(&meshcache_files_open, &shared->open_link);
+  meshcache_files_open_len--;
+}
+
+/**
+ * Close the least recently read files not being read, until at most \a open_max are open.
+ */
+static void meshcache_files_open_limit(const int open_max)
+{
+  LISTBASE_FOREACH_MUTABLE (LinkData *, link, &meshcache_files_open) {
+    if (meshcache_files_open_len <= open_max) {
+      break;
+    }
+    MeshCacheFileShared *shared = link->data;
+    if (shared->readers == 0) {
+      meshcache_file_fd_close(shared);
+    }
+  }
+}
+
+static void meshcache_file_fd_add(MeshCacheFileShared *shared, const int fd)
+{
+  meshcache_files_open_limit(MESHCACHE_FILES_OPEN_MAX - 1);
+  shared->fd = fd;
+  shared->open_link.data = shared;
+  BLI_addtail(&meshcache_files_open, &shared->open_link);
+  meshcache_files_open_len++;
+}
+
+static void meshcache_file_free(MeshCacheFileShared *shared)
+{
+  if (shared->fd != -1) {
+    meshcache_file_fd_close(shared);
+  }
+#ifdef WIN32
+  BLI_mutex_end(&shared->read_mutex);
+#endif
+  MEM_freeN(shared);
+}
+
+static MeshCacheFileShared *meshcache_file_open(const char *filepath,
+                                                const BLI_stat_t *st,
+                                                const char **err_str)
+{
+  const int fd = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+  if (fd == -1) {
+    *err_str = errno ? strerror(errno) : "Unknown error opening file";
+    return NULL;
+  }
+
+  const size_t size = BLI_file_descriptor_size(fd);
+  if (size == 0 || size == (size_t)-1) {
+    close(fd);
+    *err_str = "Missing header";
+    return NULL;
+  }
+
+  MeshCacheFileShared *shared = MEM_callocN(sizeof(*shared), __func__);
+  shared->file.size = size;
+  BLI_strncpy(shared->filepath, filepath, sizeof(shared->filepath));
+  shared->mtime = (int64_t)st->st_mtime;
+#ifdef WIN32
+  BLI_mutex_init(&shared->read_mutex);
+#endif
+  meshcache_file_fd_add(shared, fd);
+  return shared;
+}
+
+static bool meshcache_file_matches_stat(const MeshCacheFileShared *shared, const BLI_stat_t *st)
+{
+  return (shared->mtime == (int64_t)st->st_mtime) && (shared->file.size == (size_t)st->st_size);
+}
+
+/**
+ * \return the descriptor to read the file, or -1 when it can't be opened again or the file
+ * changed on disk since it was acquired. Release with #meshcache_file_fd_release.
+ */
+static int meshcache_file_fd_acquire(MeshCacheFileShared *shared)
+{
+  BLI_mutex_lock(&meshcache_files_mutex);
+
+  if (shared->fd == -1) {
+    const int fd = BLI_open(shared->filepath, O_BINARY | O_RDONLY, 0);
+    if (fd != -1) {
+      BLI_stat_t st;
+      if ((BLI_fstat(fd, &st) == 0) && meshcache_file_matches_stat(shared, &st)) {
+        meshcache_file_fd_add(shared, fd);
+      }
+      else {
+        close(fd);
+      }
+    }
+  }
+  else {
+    BLI_remlink(&meshcache_files_open, &shared->open_link);
+    BLI_addtail(&meshcache_files_open, &shared->open_link);
+  }
+
+  const int fd = shared->fd;
+  if (fd != -1) {
+    shared->readers++;
+  }
+
+  BLI_mutex_unlock(&meshcache_files_mutex);
+  return fd;
+}
+
+static void meshcache_file_fd_release(MeshCacheFileShared *shared)
+{
+  BLI_mutex_lock(&meshcache_files_mutex);
+  BLI_assert(shared->readers > 0);
+  shared->readers--;
+  BLI_mutex_unlock(&meshcache_files_mutex);
+}
+
+/**
+ * \return the opened file, shared with other users of the same file.
+ * Release with #MOD_meshcache_file_release.
+ */
+MeshCacheFile *MOD_meshcache_file_acquire(const char *filepath, const char **err_str)
+{
+  BLI_stat_t st;
+  if (BLI_stat(filepath, &st) == -1) {
+    *err_str = errno ? strerror(errno) : "Unknown error opening file";
+    return NULL;
+  }
+
+  BLI_mutex_lock(&meshcache_files_mutex);
+
+  if (meshcache_files == NULL) {
+    meshcache_files = BLI_ghash_str_new(__func__);
+  }
+
+  MeshCacheFileShared *shared = BLI_ghash_lookup(meshcache_files, filepath);
+  if (shared && !meshcache_file_matches_stat(shared, &st)) {
+    /* Current users keep the old file until they check it. */
+    BLI_ghash_remove(meshcache_files, shared->filepath, NULL, NULL);
+    shared->is_stale = true;
+    shared = NULL;
+  }
+
+  if (shared == NULL) {
+    shared = meshcache_file_open(filepath, &st, err_str);
+    if (shared) {
+      BLI_ghash_insert(meshcache_files, shared->filepath, shared);
+    }
+  }
+
+  if (shared) {
+    shared->users++;
+  }
+
+  if (BLI_ghash_len(meshcache_files) == 0) {
+    BLI_ghash_free(meshcache_files, NULL, NULL);
+    meshcache_files = NULL;
+  }
+
+  BLI_mutex_unlock(&meshcache_files_mutex);
+
+  return shared ? &shared->file : NULL;
+}
+
+void MOD_meshcache_file_release(MeshCacheFile *file)
+{
+  MeshCacheFileShared *shared = (MeshCacheFileShared *)file;
+
+  BLI_mutex_lock(&meshcache_files_mutex);
+
+  BLI_assert(shared->users > 0);
+  shared->users--;
+  if (shared->users == 0) {
+    if (!shared->is_stale) {
+      BLI_ghash_remove(meshcache_files, shared->filepath, NULL, NULL);
+      if (BLI_ghash_len(meshcache_files) == 0) {
+        BLI_ghash_free(meshcache_files, NULL, NULL);
+        meshcache_files = NULL;
+      }
+    }
+    meshcache_file_free(shared);
+  }
+
+  BLI_mutex_unlock(&meshcache_files_mutex);
+}
+
+/**
+ * Check the file is of the given path, and it wasn't changed on disk since it was opened.
+ */
+bool MOD_meshcache_file_is_valid(const MeshCacheFile *file, const char *filepath)
+{
+  const MeshCacheFileShared *shared = (const MeshCacheFileShared *)file;
+  BLI_stat_t st;
+
+  if (!STREQ(shared->filepath, filepath)) {
+    return false;
+  }
+  if (BLI_stat(filepath, &st) == -1) {
+    return false;
+  }
+  return meshcache_file_matches_stat(shared, &st);
+}
+
+/**
+ * Read \a size bytes at \a offset into \a dst, safe to call from multiple threads.
+ * \return false when the file is shorter than expected, it may have been changed meanwhile.
+ */
+bool MOD_meshcache_file_read(const MeshCacheFile *file, void *dst, size_t offset, size_t size)
+{
+  if ((offset > file->size) || (size > file->size - offset)) {
+    return false;
+  }
+
+  MeshCacheFileShared *shared = (MeshCacheFileShared *)file;
+  const int fd = meshcache_file_fd_acquire(shared);
+  if (fd == -1) {
+    return false;
+  }
+
+#ifndef WIN32
+  bool ok = true;
+  char *dst_ch = dst;
+  while (size > 0) {
+    const ssize_t len = pread(fd, dst_ch, size, (off_t)offset);
+    if (len == -1 && errno == EINTR) {
+      continue;
+    }
+    if (len <= 0) {
+      ok = false;
+      break;
+    }
+    dst_ch += len;
+    offset += (size_t)len;
+    size -= (size_t)len;
+  }
+#else
+  BLI_mutex_lock(&shared->read_mutex);
+  const bool ok = (BLI_lseek(fd, (int64_t)offset, SEEK_SET) == (int64_t)offset) &&
+                  (read(fd, dst, (uint)size) == (int)size);
+  BLI_mutex_unlock(&shared->read_mutex);
+#endif
+
+  meshcache_file_fd_release(shared);
+  return ok;
+}
+
+/**
+ * Hint that a range of the file will be read soon (the next frame during playback),
+ * so reading it doesn't stall the next evaluation.
+ */
+void MOD_meshcache_file_prefetch(const MeshCacheFile *file, size_t offset, size_t size)
+{
+#ifdef POSIX_FADV_WILLNEED
+  if (offset >= file->size) {
+    return;
+  }
+  size = MIN2(size, file->size - offset);
+
+  MeshCacheFileShared *shared = (MeshCacheFileShared *)file;
+  const int fd = meshcache_file_fd_acquire(shared);
+  if (fd != -1) {
+    posix_fadvise(fd, (off_t)offset, (off_t)size, POSIX_FADV_WILLNEED);
+    meshcache_file_fd_release(shared);
+  }
+#else
+  UNUSED_VARS(file, offset, size);
+#endif
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Reading Coordinates
+ *
+ * Byte swapped values are only valid floats once swapped back, they are swapped as integers in
+ * the buffer they were read into (loading them as floats may change the bits of NaNs).
+ * \{ */
+
+/**
+ * Read \a tot floats at \a offset into \a dst.
+ */
+bool MOD_meshcache_read_floats(const MeshCacheFile *file,
+                               float *dst,
+                               const size_t offset,
+                               const size_t tot,
+                               const bool use_endian_switch)
+{
+  if (!MOD_meshcache_file_read(file, dst, offset, sizeof(float) * tot)) {
+    return false;
+  }
+
+  if (use_endian_switch) {
+    BLI_endian_switch_uint32_array((uint *)dst, (int)tot);
+  }
+  return true;
+}
+
+/**
+ * Read \a tot floats at \a offset and blend them into \a dst by \a factor.
+ */
+bool MOD_meshcache_read_floats_interp(const MeshCacheFile *file,
+                                      float *dst,
+                                      const size_t offset,
+                                      const size_t tot,
+                                      const float factor,
+                                      const bool use_endian_switch)
+{
+  float *values = MEM_malloc_arrayN(tot, sizeof(float), __func__);
+  if (!MOD_meshcache_read_floats(file, values, offset, tot, use_endian_switch)) {
+    MEM_freeN(values);
+    return false;
+  }
+
+  const float ifactor = 1.0f - factor;
+  for (size_t i = 0; i < tot; i++) {
+    dst[i] = (dst[i] * ifactor) + (values[i] * factor);
+  }
+
+  MEM_freeN(values);
+  return true;
+}
+
+/** \} */
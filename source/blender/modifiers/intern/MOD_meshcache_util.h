@@ -20,20 +20,26 @@
 
 #pragma once
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct MeshCacheFile;
+
 /* MOD_meshcache_mdd.c */
-bool MOD_meshcache_read_mdd_index(FILE *fp,
+bool MOD_meshcache_read_mdd_index(const struct MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int vertex_tot,
                                   const int index,
                                   const float factor,
                                   const char **err_str);
-bool MOD_meshcache_read_mdd_frame(FILE *fp,
+bool MOD_meshcache_read_mdd_frame(const struct MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
                                   const float frame,
                                   const char **err_str);
-bool MOD_meshcache_read_mdd_times(const char *filepath,
+bool MOD_meshcache_read_mdd_times(const struct MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
@@ -43,19 +49,19 @@ bool MOD_meshcache_read_mdd_times(const char *filepath,
                                   const char **err_str);
 
 /* MOD_meshcache_pc2.c */
-bool MOD_meshcache_read_pc2_index(FILE *fp,
+bool MOD_meshcache_read_pc2_index(const struct MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const int index,
                                   const float factor,
                                   const char **err_str);
-bool MOD_meshcache_read_pc2_frame(FILE *fp,
+bool MOD_meshcache_read_pc2_frame(const struct MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
                                   const float frame,
                                   const char **err_str);
-bool MOD_meshcache_read_pc2_times(const char *filepath,
+bool MOD_meshcache_read_pc2_times(const struct MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
@@ -71,4 +77,36 @@ void MOD_meshcache_calc_range(const float frame,
                               int r_index_range[2],
                               float *r_factor);
 
+/**
+ * A cache file opened for reading, shared by all modifiers reading the same file.
+ */
+typedef struct MeshCacheFile {
+  size_t size;
+} MeshCacheFile;
+
+struct MeshCacheFile *MOD_meshcache_file_acquire(const char *filepath, const char **err_str);
+void MOD_meshcache_file_release(struct MeshCacheFile *file);
+bool MOD_meshcache_file_is_valid(const struct MeshCacheFile *file, const char *filepath);
+bool MOD_meshcache_file_read(const struct MeshCacheFile *file,
+                             void *dst,
+                             size_t offset,
+                             size_t size);
+void MOD_meshcache_file_prefetch(const struct MeshCacheFile *file, size_t offset, size_t size);
+
+bool MOD_meshcache_read_floats(const struct MeshCacheFile *file,
+                               float *dst,
+                               const size_t offset,
+                               const size_t tot,
+                               const bool use_endian_switch);
+bool MOD_meshcache_read_floats_interp(const struct MeshCacheFile *file,
+                                      float *dst,
+                                      const size_t offset,
+                                      const size_t tot,
+                                      const float factor,
+                                      const bool use_endian_switch);
+
 #define FRAME_SNAP_EPS 0.0001f
+
+#ifdef __cplusplus
+}
+#endif
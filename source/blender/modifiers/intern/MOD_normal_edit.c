@@ -450,7 +450,7 @@ static void normalEditModifier_do_directional(NormalEditModifierData *enmd,
 
   if (do_polynors_fix &&
       polygons_check_flip(mloop, nos, &mesh->ldata, mpoly, polynors, num_polys)) {
-    mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+    mesh->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
   }
 
   BKE_mesh_normals_loop_custom_set(mvert,
@@ -564,9 +564,9 @@ static Mesh *normalEditModifier_do(NormalEditModifierData *enmd,
                              num_loops,
                              num_polys,
                              polynors,
-                             (result->runtime.cd_dirty_vert & CD_MASK_NORMAL) ? false : true);
+                             (result->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY) ? false : true);
 
-  result->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
+  result->runtime.cache_flag &= ~(MESH_RUNTIME_NORMALS_DIRTY | MESH_RUNTIME_VERT_NORMALS_VALID);
 
   clnors = CustomData_get_layer(ldata, CD_CUSTOMLOOPNORMAL);
   if (use_current_clnors) {
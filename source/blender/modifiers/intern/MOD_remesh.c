@@ -68,6 +68,19 @@ static void initData(ModifierData *md)
   MEMCPY_STRUCT_AFTER(rmd, DNA_struct_default_get(RemeshModifierData), modifier);
 }
 
+static void freeRuntimeData(void *runtime_data)
+{
+  if (runtime_data != NULL) {
+    BKE_mesh_remesh_voxel_cache_free(runtime_data);
+  }
+}
+
+static void freeData(ModifierData *md)
+{
+  freeRuntimeData(md->runtime);
+  md->runtime = NULL;
+}
+
 #ifdef WITH_MOD_REMESH
 
 static void init_dualcon_mesh(DualConInput *input, Mesh *mesh)
@@ -159,13 +172,21 @@ static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *UNUSED(ctx)
     if (rmd->voxel_size == 0.0f) {
       return NULL;
     }
-    result = BKE_mesh_remesh_voxel_to_mesh_nomain(mesh, rmd->voxel_size, rmd->adaptivity, 0.0f);
+    /* Level set is cached in the runtime data, so tweaking the adaptivity is fast. */
+    if (md->runtime == NULL) {
+      md->runtime = BKE_mesh_remesh_voxel_cache_create();
+    }
+    result = BKE_mesh_remesh_voxel_to_mesh_nomain_cached(
+        mesh, rmd->voxel_size, rmd->adaptivity, 0.0f, md->runtime);
     if (result == NULL) {
       return NULL;
     }
   }
   else {
     /* Dualcon modes. */
+    /* The level set and input copy of voxel mode are large, don't keep them around unused. */
+    freeData(md);
+
     init_dualcon_mesh(&input, mesh);
 
     if (rmd->flag & MOD_REMESH_FLOOD_FILL) {
@@ -220,7 +241,7 @@ static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *UNUSED(ctx)
 
   BKE_mesh_copy_settings(result, mesh);
   BKE_mesh_calc_edges(result, true, false);
-  result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  result->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
   return result;
 }
 
@@ -305,14 +326,14 @@ ModifierTypeInfo modifierType_Remesh = {
 
     /* initData */ initData,
     /* requiredDataMask */ NULL,
-    /* freeData */ NULL,
+    /* freeData */ freeData,
     /* isDisabled */ NULL,
     /* updateDepsgraph */ NULL,
     /* dependsOnTime */ NULL,
     /* dependsOnNormals */ NULL,
     /* foreachIDLink */ NULL,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
     /* panelRegister */ panelRegister,
     /* blendWrite */ NULL,
     /* blendRead */ NULL,
@@ -1138,12 +1138,12 @@ static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *ctx, Mesh *
                                          ob_axis != NULL ? mtx_tx[3] : NULL,
                                          ltmd->merge_dist);
     if (result != result_prev) {
-      result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+      result->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
     }
   }
 
   if ((ltmd->flag & MOD_SCREW_NORMAL_CALC) == 0) {
-    result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+    result->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
   }
 
   return result;
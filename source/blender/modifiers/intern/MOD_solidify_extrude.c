@@ -982,8 +982,8 @@ Mesh *MOD_solidify_extrude_modifyMesh(ModifierData *md, const ModifierEvalContex
   }
 
   /* must recalculate normals with vgroups since they can displace unevenly T26888. */
-  if ((mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) || do_rim || dvert) {
-    result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  if ((mesh->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY) || do_rim || dvert) {
+    result->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
   }
   else if (do_shell) {
     uint i;
@@ -1039,9 +1039,9 @@ Mesh *MOD_solidify_extrude_modifyMesh(ModifierData *md, const ModifierEvalContex
 #define SOLIDIFY_SIDE_NORMALS
 
 #ifdef SOLIDIFY_SIDE_NORMALS
-    /* Note that, due to the code setting cd_dirty_vert a few lines above,
+    /* Note that, due to the code tagging normals dirty a few lines above,
      * do_side_normals is always false. - Sybren */
-    const bool do_side_normals = !(result->runtime.cd_dirty_vert & CD_MASK_NORMAL);
+    const bool do_side_normals = !(result->runtime.cache_flag & MESH_RUNTIME_NORMALS_DIRTY);
     /* annoying to allocate these since we only need the edge verts, */
     float(*edge_vert_nos)[3] = do_side_normals ?
                                    MEM_calloc_arrayN(numVerts, sizeof(float[3]), __func__) :
@@ -216,7 +216,7 @@ Mesh *MOD_deform_mesh_eval_get(Object *ob,
      * we really need vertexCos here. */
     else if (vertexCos) {
       BKE_mesh_vert_coords_apply(mesh, vertexCos);
-      mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+      mesh->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
     }
 
     if (use_orco) {
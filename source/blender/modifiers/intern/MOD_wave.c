@@ -40,6 +40,7 @@
 #include "BKE_lib_id.h"
 #include "BKE_lib_query.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_mesh_wrapper.h"
 #include "BKE_scene.h"
 #include "BKE_screen.h"
@@ -149,7 +150,6 @@ static void waveModifier_do(WaveModifierData *md,
                             int numVerts)
 {
   WaveModifierData *wmd = (WaveModifierData *)md;
-  MVert *mvert = NULL;
   MDeformVert *dvert;
   int defgrp_index;
   float ctime = DEG_get_ctime(ctx->depsgraph);
@@ -160,10 +160,7 @@ static void waveModifier_do(WaveModifierData *md,
   const float falloff = wmd->falloff;
   float falloff_fac = 1.0f; /* when falloff == 0.0f this stays at 1.0f */
   const bool invert_group = (wmd->flag & MOD_WAVE_INVERT_VGROUP) != 0;
-
-  if ((wmd->flag & MOD_WAVE_NORM) && (mesh != NULL)) {
-    mvert = mesh->mvert;
-  }
+  const bool use_normals = (wmd->flag & MOD_WAVE_NORM) && (mesh != NULL);
 
   if (wmd->objectcenter != NULL) {
     float mat[4][4];
@@ -208,8 +205,14 @@ static void waveModifier_do(WaveModifierData *md,
   if (lifefac != 0.0f) {
     /* avoid divide by zero checks within the loop */
     float falloff_inv = falloff != 0.0f ? 1.0f / falloff : 1.0f;
+    const float(*vert_nors)[3] = NULL;
+    float(*vert_nors_free)[3] = NULL;
     int i;
 
+    if (use_normals && (wmd->flag & (MOD_WAVE_NORM_X | MOD_WAVE_NORM_Y | MOD_WAVE_NORM_Z))) {
+      vert_nors = BKE_mesh_runtime_vert_normals_ensure(mesh, &vert_nors_free);
+    }
+
     for (i = 0; i < numVerts; i++) {
       float *co = vertexCos[i];
       float x = co[0] - wmd->startx;
@@ -283,16 +286,16 @@ static void waveModifier_do(WaveModifierData *md,
         /*apply weight & falloff */
         amplit *= def_weight * falloff_fac;
 
-        if (mvert) {
+        if (use_normals) {
           /* move along normals */
           if (wmd->flag & MOD_WAVE_NORM_X) {
-            co[0] += (lifefac * amplit) * mvert[i].no[0] / 32767.0f;
+            co[0] += (lifefac * amplit) * vert_nors[i][0];
           }
           if (wmd->flag & MOD_WAVE_NORM_Y) {
-            co[1] += (lifefac * amplit) * mvert[i].no[1] / 32767.0f;
+            co[1] += (lifefac * amplit) * vert_nors[i][1];
           }
           if (wmd->flag & MOD_WAVE_NORM_Z) {
-            co[2] += (lifefac * amplit) * mvert[i].no[2] / 32767.0f;
+            co[2] += (lifefac * amplit) * vert_nors[i][2];
           }
         }
         else {
@@ -301,6 +304,10 @@ static void waveModifier_do(WaveModifierData *md,
         }
       }
     }
+
+    if (vert_nors_free) {
+      MEM_freeN(vert_nors_free);
+    }
   }
 
   MEM_SAFE_FREE(tex_co);
@@ -1635,10 +1635,13 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
                                                        bvhtree_weld_overlap_cb,
                                                        &data,
                                                        1,
-                                                       BVH_OVERLAP_RETURN_PAIRS);
+                                                       BVH_OVERLAP_USE_THREADING |
+                                                           BVH_OVERLAP_RETURN_PAIRS);
 
       free_bvhtree_from_mesh(&treedata);
       if (overlap) {
+        /* Threads return the pairs in any order, the clusters don't depend on it since
+         * every cluster is merged into its lowest index. */
         range_vn_u(vert_dest_map, totvert, 0);
 
         const BVHTreeOverlap *overlap_iter = &overlap[0];
@@ -1895,7 +1898,7 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
 
     /* is this needed? */
     /* recalculate normals */
-    result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+    result->runtime.cache_flag |= MESH_RUNTIME_NORMALS_DIRTY;
 
     weld_mesh_context_free(&weld_mesh);
   }
@@ -33,6 +33,7 @@ struct Main;
 struct Object;
 struct RenderData;
 struct RenderResult;
+struct RenderResultExrFile;
 struct ReportList;
 struct Scene;
 struct StampData;
@@ -155,6 +156,10 @@ typedef struct RenderResult {
   char *error;
 
   struct StampData *stamp_data;
+
+  /* Multilayer images read from disk keep the pass layout of the file until all passes are
+   * decoded, passes with no rect are only decoded on first access, see #RE_pass_ensure_loaded. */
+  struct RenderResultExrFile *exr_file;
 } RenderResult;
 
 typedef struct RenderStats {
@@ -320,6 +325,14 @@ bool RE_WriteRenderResult(struct ReportList *reports,
                           int layer);
 struct RenderResult *RE_MultilayerConvert(
     void *exrhandle, const char *colorspace, bool predivide, int rectx, int recty);
+struct RenderResult *RE_MultilayerConvertLazy(void *exrhandle,
+                                              const char *filepath,
+                                              const char *colorspace,
+                                              bool predivide,
+                                              int rectx,
+                                              int recty);
+bool RE_pass_ensure_loaded(struct RenderResult *rr, struct RenderPass *rpass);
+void RE_passes_ensure_loaded(struct RenderResult *rr);
 
 /* display and event callbacks */
 void RE_display_init_cb(struct Render *re,
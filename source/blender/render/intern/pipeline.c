@@ -47,6 +47,7 @@
 #include "BLI_path_util.h"
 #include "BLI_rect.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_timecode.h"
 
@@ -162,7 +163,8 @@ static int do_write_image_or_movie(Render *re,
                                    Scene *scene,
                                    bMovieHandle *mh,
                                    const int totvideos,
-                                   const char *name_override);
+                                   const char *name_override,
+                                   struct RenderWriteQueue *write_queue);
 
 /* default callbacks, set in each new render */
 static void result_nothing(void *UNUSED(arg), RenderResult *UNUSED(rr))
@@ -239,7 +241,7 @@ static void render_print_save_message(ReportList *reports, const char *name, int
 }
 
 static int render_imbuf_write_stamp_test(ReportList *reports,
-                                         Scene *scene,
+                                         const RenderData *rd,
                                          struct RenderResult *rr,
                                          ImBuf *ibuf,
                                          const char *name,
@@ -248,14 +250,13 @@ static int render_imbuf_write_stamp_test(ReportList *reports,
 {
   int ok;
 
-  if (stamp) {
+  if (stamp && (rd->stamp & R_STAMP_ALL)) {
     /* writes the name of the individual cameras */
-    ok = BKE_imbuf_write_stamp(scene, rr, ibuf, name, imf);
-  }
-  else {
-    ok = BKE_imbuf_write(ibuf, name, imf);
+    BKE_imbuf_stamp_info(rr, ibuf);
   }
 
+  ok = BKE_imbuf_write(ibuf, name, imf);
+
   render_print_save_message(reports, name, ok, errno);
 
   return ok;
@@ -292,6 +293,41 @@ RenderResult *RE_MultilayerConvert(
   return render_result_new_from_exr(exrhandle, colorspace, predivide, rectx, recty);
 }
 
+/**
+ * Same as #RE_MultilayerConvert for a handle opened with #IMB_exr_begin_read_multilayer, the
+ * render result takes ownership of the handle and decodes passes from \a filepath on first
+ * access. The file is only kept open while passes are read.
+ */
+RenderResult *RE_MultilayerConvertLazy(void *exrhandle,
+                                       const char *filepath,
+                                       const char *colorspace,
+                                       bool predivide,
+                                       int rectx,
+                                       int recty)
+{
+  return render_result_new_from_exr_lazy(
+      exrhandle, filepath, colorspace, predivide, rectx, recty);
+}
+
+/**
+ * Decode pixels of a pass from a lazily loaded multilayer image.
+ * Returns false if the pass has no pixels.
+ */
+bool RE_pass_ensure_loaded(RenderResult *rr, RenderPass *rpass)
+{
+  return render_result_exr_pass_ensure_loaded(rr, rpass);
+}
+
+/* Decode all passes of a lazily loaded multilayer image, for code that needs all of them. */
+void RE_passes_ensure_loaded(RenderResult *rr)
+{
+  LISTBASE_FOREACH (RenderLayer *, rl, &rr->layers) {
+    LISTBASE_FOREACH (RenderPass *, rpass, &rl->passes) {
+      render_result_exr_pass_ensure_loaded(rr, rpass);
+    }
+  }
+}
+
 RenderLayer *render_get_active_layer(Render *re, RenderResult *rr)
 {
   ViewLayer *view_layer = BLI_findlink(&re->view_layers, re->active_view_layer);
@@ -2031,7 +2067,7 @@ void RE_RenderFrame(Render *re,
                                      NULL);
 
         /* reports only used for Movie */
-        do_write_image_or_movie(re, bmain, scene, NULL, 0, name);
+        do_write_image_or_movie(re, bmain, scene, NULL, 0, name, NULL);
       }
     }
 
@@ -2094,11 +2130,16 @@ void RE_RenderFreestyleExternal(Render *re)
 }
 #endif
 
-bool RE_WriteRenderViewsImage(
-    ReportList *reports, RenderResult *rr, Scene *scene, const bool stamp, char *name)
+/* Write the views of the render result to image files, with the given settings. */
+static bool render_write_views_image(ReportList *reports,
+                                     RenderResult *rr,
+                                     RenderData *rd,
+                                     const ColorManagedViewSettings *view_settings,
+                                     const ColorManagedDisplaySettings *display_settings,
+                                     const bool stamp,
+                                     char *name)
 {
   bool ok = true;
-  RenderData *rd = &scene->r;
 
   if (!rr) {
     return false;
@@ -2123,7 +2164,7 @@ bool RE_WriteRenderViewsImage(
 
     for (view_id = 0, rv = rr->views.first; rv; rv = rv->next, view_id++) {
       if (!is_mono) {
-        BKE_scene_multiview_view_filepath_get(&scene->r, filepath, rv->name, name);
+        BKE_scene_multiview_view_filepath_get(rd, filepath, rv->name, name);
       }
 
       if (is_exr_rr) {
@@ -2143,9 +2184,9 @@ bool RE_WriteRenderViewsImage(
           ImBuf *ibuf = render_result_rect_to_ibuf(rr, rd, view_id);
           ibuf->planes = 24;
           IMB_colormanagement_imbuf_for_write(
-              ibuf, true, false, &scene->view_settings, &scene->display_settings, &imf);
+              ibuf, true, false, view_settings, display_settings, &imf);
 
-          ok = render_imbuf_write_stamp_test(reports, scene, rr, ibuf, name, &imf, stamp);
+          ok = render_imbuf_write_stamp_test(reports, rd, rr, ibuf, name, &imf, stamp);
 
           IMB_freeImBuf(ibuf);
         }
@@ -2154,9 +2195,9 @@ bool RE_WriteRenderViewsImage(
         ImBuf *ibuf = render_result_rect_to_ibuf(rr, rd, view_id);
 
         IMB_colormanagement_imbuf_for_write(
-            ibuf, true, false, &scene->view_settings, &scene->display_settings, &rd->im_format);
+            ibuf, true, false, view_settings, display_settings, &rd->im_format);
 
-        ok = render_imbuf_write_stamp_test(reports, scene, rr, ibuf, name, &rd->im_format, stamp);
+        ok = render_imbuf_write_stamp_test(reports, rd, rr, ibuf, name, &rd->im_format, stamp);
 
         /* imbuf knows which rects are not part of ibuf */
         IMB_freeImBuf(ibuf);
@@ -2164,7 +2205,7 @@ bool RE_WriteRenderViewsImage(
     }
   }
   else { /* R_IMF_VIEWS_STEREO_3D */
-    BLI_assert(scene->r.im_format.views_format == R_IMF_VIEWS_STEREO_3D);
+    BLI_assert(rd->im_format.views_format == R_IMF_VIEWS_STEREO_3D);
 
     if (rd->im_format.imtype == R_IMF_IMTYPE_MULTILAYER) {
       printf("Stereo 3D not supported for MultiLayer image: %s\n", name);
@@ -2180,16 +2221,16 @@ bool RE_WriteRenderViewsImage(
         IMB_colormanagement_imbuf_for_write(ibuf_arr[i],
                                             true,
                                             false,
-                                            &scene->view_settings,
-                                            &scene->display_settings,
-                                            &scene->r.im_format);
+                                            view_settings,
+                                            display_settings,
+                                            &rd->im_format);
         IMB_prepare_write_ImBuf(IMB_isfloat(ibuf_arr[i]), ibuf_arr[i]);
       }
 
-      ibuf_arr[2] = IMB_stereo3d_ImBuf(&scene->r.im_format, ibuf_arr[0], ibuf_arr[1]);
+      ibuf_arr[2] = IMB_stereo3d_ImBuf(&rd->im_format, ibuf_arr[0], ibuf_arr[1]);
 
       ok = render_imbuf_write_stamp_test(
-          reports, scene, rr, ibuf_arr[2], name, &rd->im_format, stamp);
+          reports, rd, rr, ibuf_arr[2], name, &rd->im_format, stamp);
 
       /* optional preview images for exr */
       if (ok && is_exr_rr && (rd->im_format.flag & R_IMF_FLAG_PREVIEW_JPG)) {
@@ -2204,7 +2245,7 @@ bool RE_WriteRenderViewsImage(
         ibuf_arr[2]->planes = 24;
 
         ok = render_imbuf_write_stamp_test(
-            reports, scene, rr, ibuf_arr[2], name, &rd->im_format, stamp);
+            reports, rd, rr, ibuf_arr[2], name, &rd->im_format, stamp);
       }
 
       /* imbuf knows which rects are not part of ibuf */
@@ -2217,6 +2258,13 @@ bool RE_WriteRenderViewsImage(
   return ok;
 }
 
+bool RE_WriteRenderViewsImage(
+    ReportList *reports, RenderResult *rr, Scene *scene, const bool stamp, char *name)
+{
+  return render_write_views_image(
+      reports, rr, &scene->r, &scene->view_settings, &scene->display_settings, stamp, name);
+}
+
 bool RE_WriteRenderViewsMovie(ReportList *reports,
                               RenderResult *rr,
                               Scene *scene,
@@ -2299,12 +2347,233 @@ bool RE_WriteRenderViewsMovie(ReportList *reports,
   return ok;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Asynchronous Image Writing
+ *
+ * During animation renders, image files can be written by a background task while the next frame
+ * renders. Each queued frame holds a copy of the render result, so the number of frames waiting
+ * to be written is limited.
+ *
+ * Reports are handled on the render thread once the file of a frame was written, which can be
+ * after rendering of the following frame started. The scene settings used for writing are copied
+ * when the frame is queued. Write callbacks need the scene evaluated for the written frame, when
+ * they are registered the render waits for each frame's file before moving on.
+ * \{ */
+
+#define RENDER_WRITE_QUEUE_MAX 2
+
+typedef struct RenderWriteQueue {
+  TaskPool *pool;
+  ThreadMutex mutex;
+  ThreadCondition condition;
+  /* Frames queued and not written yet. */
+  int frames_pending;
+  /* Tasks done writing, their reports and write callbacks are handled by the render thread. */
+  ListBase tasks_done;
+  bool is_error;
+} RenderWriteQueue;
+
+typedef struct RenderWriteTask {
+  struct RenderWriteTask *next, *prev;
+  RenderWriteQueue *queue;
+
+  /* Scene settings used for writing, copied since the scene changes while the task runs. Only
+   * data used for writing images is owned by the copy of the render data. */
+  RenderData rd;
+  ColorManagedViewSettings view_settings;
+  ColorManagedDisplaySettings display_settings;
+  int frame;
+
+  ReportList reports;
+  RenderResult *rr;
+  char name[FILE_MAX];
+  bool ok;
+} RenderWriteTask;
+
+static RenderWriteTask *render_write_task_new(
+    RenderWriteQueue *queue, Scene *scene, RenderResult *rr, const char *name)
+{
+  RenderWriteTask *task = MEM_callocN(sizeof(RenderWriteTask), __func__);
+
+  task->queue = queue;
+
+  task->rd = scene->r;
+  BLI_duplicatelist(&task->rd.views, &scene->r.views);
+  BKE_color_managed_view_settings_copy(&task->rd.im_format.view_settings,
+                                       &scene->r.im_format.view_settings);
+  BKE_color_managed_view_settings_copy(&task->view_settings, &scene->view_settings);
+  BKE_color_managed_display_settings_copy(&task->display_settings, &scene->display_settings);
+  task->frame = scene->r.cfra;
+
+  BKE_reports_init(&task->reports, RPT_STORE);
+  task->rr = RE_DuplicateRenderResult(rr);
+  BLI_strncpy(task->name, name, sizeof(task->name));
+
+  return task;
+}
+
+static void render_write_task_free(RenderWriteTask *task)
+{
+  BLI_freelistN(&task->rd.views);
+  BKE_color_managed_view_settings_free(&task->rd.im_format.view_settings);
+  BKE_color_managed_view_settings_free(&task->view_settings);
+  BKE_reports_clear(&task->reports);
+
+  if (task->rr) {
+    RE_FreeRenderResult(task->rr);
+  }
+
+  MEM_freeN(task);
+}
+
+static void render_write_task_run(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  RenderWriteTask *task = (RenderWriteTask *)taskdata;
+  RenderWriteQueue *queue = task->queue;
+
+  task->ok = render_write_views_image(&task->reports,
+                                      task->rr,
+                                      &task->rd,
+                                      &task->view_settings,
+                                      &task->display_settings,
+                                      true,
+                                      task->name);
+
+  /* Release the pixels right away, the task is kept until the render thread handled it. */
+  RE_FreeRenderResult(task->rr);
+  task->rr = NULL;
+
+  BLI_mutex_lock(&queue->mutex);
+  queue->frames_pending--;
+  if (!task->ok) {
+    queue->is_error = true;
+  }
+  BLI_addtail(&queue->tasks_done, task);
+  BLI_condition_notify_all(&queue->condition);
+  BLI_mutex_unlock(&queue->mutex);
+}
+
+RenderWriteQueue *render_write_queue_new(void)
+{
+  RenderWriteQueue *queue = MEM_callocN(sizeof(RenderWriteQueue), __func__);
+
+  queue->pool = BLI_task_pool_create_background(NULL, TASK_PRIORITY_HIGH);
+  BLI_mutex_init(&queue->mutex);
+  BLI_condition_init(&queue->condition);
+
+  return queue;
+}
+
+/* Copy the result and queue it for writing, waits when too many frames are queued already.
+ * Returns false if writing of a previous frame failed. */
+bool render_write_queue_push(RenderWriteQueue *queue,
+                             Scene *scene,
+                             RenderResult *rres,
+                             const char *name)
+{
+  const bool is_exr = ELEM(
+      scene->r.im_format.imtype, R_IMF_IMTYPE_OPENEXR, R_IMF_IMTYPE_MULTILAYER);
+
+  BLI_mutex_lock(&queue->mutex);
+  while (queue->frames_pending >= RENDER_WRITE_QUEUE_MAX) {
+    BLI_condition_wait(&queue->condition, &queue->mutex);
+  }
+  if (queue->is_error) {
+    BLI_mutex_unlock(&queue->mutex);
+    return false;
+  }
+  queue->frames_pending++;
+  BLI_mutex_unlock(&queue->mutex);
+
+  /* Only EXR files store render layers, other formats are written from the views. */
+  ListBase layers = rres->layers;
+  if (!is_exr) {
+    BLI_listbase_clear(&rres->layers);
+  }
+
+  RenderWriteTask *task = render_write_task_new(queue, scene, rres, name);
+
+  rres->layers = layers;
+
+  /* The task is freed by #render_write_queue_handle_done. */
+  BLI_task_pool_push(queue->pool, render_write_task_run, task, false, NULL);
+
+  return true;
+}
+
+static int render_write_task_cmp(const void *a, const void *b)
+{
+  const RenderWriteTask *task_a = a;
+  const RenderWriteTask *task_b = b;
+  if (task_a->frame < task_b->frame) {
+    return -1;
+  }
+  if (task_a->frame > task_b->frame) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Pass on reports of frames written so far and run write callbacks, on the render thread.
+ * Callbacks only run for the current frame, the scene is not evaluated for other frames. */
+void render_write_queue_handle_done(RenderWriteQueue *queue,
+                                    Render *re,
+                                    Scene *scene,
+                                    const bool do_callbacks)
+{
+  BLI_mutex_lock(&queue->mutex);
+  ListBase tasks_done = queue->tasks_done;
+  BLI_listbase_clear(&queue->tasks_done);
+  BLI_mutex_unlock(&queue->mutex);
+
+  /* Frames can finish out of order when more than one is written at a time. */
+  BLI_listbase_sort(&tasks_done, render_write_task_cmp);
+
+  LISTBASE_FOREACH_MUTABLE (RenderWriteTask *, task, &tasks_done) {
+    LISTBASE_FOREACH (Report *, report, &task->reports.list) {
+      BKE_report(re->reports, report->type, report->message);
+    }
+
+    if (do_callbacks && task->ok && task->frame == scene->r.cfra) {
+      render_callback_exec_id(re, re->main, &scene->id, BKE_CB_EVT_RENDER_WRITE);
+    }
+
+    render_write_task_free(task);
+  }
+}
+
+/* Wait until all queued frames are written, returns false on errors. */
+bool render_write_queue_wait(RenderWriteQueue *queue)
+{
+  BLI_task_pool_work_and_wait(queue->pool);
+
+  BLI_mutex_lock(&queue->mutex);
+  const bool ok = !queue->is_error;
+  BLI_mutex_unlock(&queue->mutex);
+
+  return ok;
+}
+
+void render_write_queue_free(RenderWriteQueue *queue)
+{
+  BLI_task_pool_free(queue->pool);
+  LISTBASE_FOREACH_MUTABLE (RenderWriteTask *, task, &queue->tasks_done) {
+    render_write_task_free(task);
+  }
+  BLI_mutex_end(&queue->mutex);
+  BLI_condition_end(&queue->condition);
+  MEM_freeN(queue);
+}
+
+/** \} */
+
 static int do_write_image_or_movie(Render *re,
                                    Main *bmain,
                                    Scene *scene,
                                    bMovieHandle *mh,
                                    const int totvideos,
-                                   const char *name_override)
+                                   const char *name_override,
+                                   RenderWriteQueue *write_queue)
 {
   char name[FILE_MAX];
   RenderResult rres;
@@ -2334,7 +2603,12 @@ static int do_write_image_or_movie(Render *re,
     }
 
     /* write images as individual images or stereo */
-    ok = RE_WriteRenderViewsImage(re->reports, &rres, scene, true, name);
+    if (write_queue) {
+      ok = render_write_queue_push(write_queue, scene, &rres, name);
+    }
+    else {
+      ok = RE_WriteRenderViewsImage(re->reports, &rres, scene, true, name);
+    }
   }
 
   RE_ReleaseResultImageViews(re, &rres);
@@ -2474,6 +2748,12 @@ void RE_RenderAnim(Render *re,
 
   re->flag |= R_ANIMATION;
 
+  /* Write image files in the background while rendering the next frame. */
+  RenderWriteQueue *write_queue = NULL;
+  if (!is_movie && USER_EXPERIMENTAL_TEST(&U, use_async_render_write)) {
+    write_queue = render_write_queue_new();
+  }
+
   {
     for (nfra = sfra, scene->r.cfra = sfra; scene->r.cfra <= efra; scene->r.cfra++) {
       char name[FILE_MAX];
@@ -2592,7 +2872,7 @@ void RE_RenderAnim(Render *re,
 
       if (re->test_break(re->tbh) == 0) {
         if (!G.is_break) {
-          if (!do_write_image_or_movie(re, bmain, scene, mh, totvideos, NULL)) {
+          if (!do_write_image_or_movie(re, bmain, scene, mh, totvideos, NULL, write_queue)) {
             G.is_break = true;
           }
         }
@@ -2602,6 +2882,11 @@ void RE_RenderAnim(Render *re,
       }
 
       if (G.is_break == true) {
+        /* Finish writing before removing touched files. */
+        if (write_queue) {
+          render_write_queue_wait(write_queue);
+        }
+
         /* remove touched file */
         if (is_movie == false) {
           if ((rd.mode & R_TOUCH)) {
@@ -2637,11 +2922,30 @@ void RE_RenderAnim(Render *re,
       if (G.is_break == false) {
         /* keep after file save */
         render_callback_exec_id(re, re->main, &scene->id, BKE_CB_EVT_RENDER_POST);
-        render_callback_exec_id(re, re->main, &scene->id, BKE_CB_EVT_RENDER_WRITE);
+        if (write_queue) {
+          /* Write handlers see the scene as evaluated for the frame that was written, with
+           * handlers the next frame only starts once this one is written. */
+          const bool do_callbacks = BKE_callback_has_handlers(BKE_CB_EVT_RENDER_WRITE);
+          if (do_callbacks) {
+            render_write_queue_wait(write_queue);
+          }
+          render_write_queue_handle_done(write_queue, re, scene, do_callbacks);
+        }
+        else {
+          render_callback_exec_id(re, re->main, &scene->id, BKE_CB_EVT_RENDER_WRITE);
+        }
       }
     }
   }
 
+  if (write_queue) {
+    if (!render_write_queue_wait(write_queue)) {
+      G.is_break = true;
+    }
+    render_write_queue_handle_done(write_queue, re, scene, false);
+    render_write_queue_free(write_queue);
+  }
+
   /* end movie */
   if (is_movie) {
     re_movie_free_all(re, mh, totvideos);
@@ -28,6 +28,8 @@ struct Render;
 struct RenderData;
 struct RenderLayer;
 struct RenderResult;
+struct RenderWriteQueue;
+struct Scene;
 
 #ifdef __cplusplus
 extern "C" {
@@ -39,6 +41,18 @@ void render_update_anim_renderdata(struct Render *re,
                                    struct ListBase *render_layers);
 void render_copy_renderdata(struct RenderData *to, struct RenderData *from);
 
+struct RenderWriteQueue *render_write_queue_new(void);
+bool render_write_queue_push(struct RenderWriteQueue *queue,
+                             struct Scene *scene,
+                             struct RenderResult *rres,
+                             const char *name);
+bool render_write_queue_wait(struct RenderWriteQueue *queue);
+void render_write_queue_handle_done(struct RenderWriteQueue *queue,
+                                    struct Render *re,
+                                    struct Scene *scene,
+                                    const bool do_callbacks);
+void render_write_queue_free(struct RenderWriteQueue *queue);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,206 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_scene_types.h"
+
+#include "BLI_fileops.h"
+#include "BLI_listbase.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+
+#include "BKE_appdir.h"
+#include "BKE_callbacks.h"
+#include "BKE_idtype.h"
+#include "BKE_main.h"
+#include "BKE_report.h"
+#include "BKE_scene.h"
+
+#include "IMB_imbuf.h"
+
+#include "RE_pipeline.h"
+
+#include "RNA_access.h"
+
+#include "pipeline.h"
+
+namespace blender::render::tests {
+
+#define WIDTH 16
+#define HEIGHT 8
+
+class RenderWriteQueueTest : public testing::Test {
+ protected:
+  Main *bmain_ = nullptr;
+  Scene *scene_ = nullptr;
+  Render *re_ = nullptr;
+  ReportList reports_;
+  RenderWriteQueue *queue_ = nullptr;
+
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+    BKE_appdir_init();
+    BKE_tempdir_init(nullptr);
+    BKE_idtype_init();
+    IMB_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BKE_callback_global_finalize();
+    IMB_exit();
+    BKE_tempdir_session_purge();
+    BLI_threadapi_exit();
+  }
+
+  void SetUp() override
+  {
+    bmain_ = BKE_main_new();
+    scene_ = BKE_scene_add(bmain_, "Scene");
+    scene_->r.im_format.imtype = R_IMF_IMTYPE_PNG;
+
+    BKE_reports_init(&reports_, RPT_STORE);
+    re_ = RE_NewRender("RenderWriteQueueTest");
+    RE_SetReports(re_, &reports_);
+
+    queue_ = render_write_queue_new();
+  }
+
+  void TearDown() override
+  {
+    render_write_queue_free(queue_);
+    RE_FreeRender(re_);
+    BKE_reports_clear(&reports_);
+    BKE_main_free(bmain_);
+  }
+
+  /* Queue a frame with a single view, at the given frame of the scene. */
+  bool push(const int frame, const char *name)
+  {
+    RenderResult rr = {nullptr};
+    rr.rectx = WIDTH;
+    rr.recty = HEIGHT;
+
+    RenderView *rv = (RenderView *)MEM_callocN(sizeof(RenderView), __func__);
+    rv->rect32 = (int *)MEM_callocN(sizeof(int) * WIDTH * HEIGHT, __func__);
+    BLI_addtail(&rr.views, rv);
+
+    scene_->r.cfra = frame;
+    const bool ok = render_write_queue_push(queue_, scene_, &rr, name);
+
+    MEM_freeN(rv->rect32);
+    BLI_freelistN(&rr.views);
+    return ok;
+  }
+
+  void filepath(char *r_filepath, const char *filename)
+  {
+    BLI_join_dirfile(r_filepath, FILE_MAX, BKE_tempdir_session(), filename);
+  }
+};
+
+static int write_callback_frame = 0;
+static int write_callback_len = 0;
+
+static void write_callback(Main * /*bmain*/,
+                           PointerRNA **pointers,
+                           const int /*num_pointers*/,
+                           void * /*arg*/)
+{
+  const Scene *scene = (const Scene *)pointers[0]->data;
+  write_callback_frame = scene->r.cfra;
+  write_callback_len++;
+}
+
+TEST_F(RenderWriteQueueTest, WritesFrames)
+{
+  char name[3][FILE_MAX];
+  for (int frame = 0; frame < 3; frame++) {
+    char filename[64];
+    BLI_snprintf(filename, sizeof(filename), "frame_%d.png", frame);
+    filepath(name[frame], filename);
+    EXPECT_TRUE(push(frame, name[frame]));
+  }
+
+  EXPECT_TRUE(render_write_queue_wait(queue_));
+  render_write_queue_handle_done(queue_, re_, scene_, false);
+
+  for (int frame = 0; frame < 3; frame++) {
+    EXPECT_TRUE(BLI_exists(name[frame]));
+    BLI_delete(name[frame], false, false);
+  }
+
+  EXPECT_TRUE(BLI_listbase_is_empty(&reports_.list));
+}
+
+TEST_F(RenderWriteQueueTest, ErrorStopsQueue)
+{
+  /* A file in place of the directory makes writing fail. */
+  char dirpath[FILE_MAX], name[FILE_MAX];
+  filepath(dirpath, "not_a_directory");
+  BLI_file_touch(dirpath);
+  BLI_join_dirfile(name, sizeof(name), dirpath, "frame.png");
+
+  EXPECT_TRUE(push(1, name));
+  EXPECT_FALSE(render_write_queue_wait(queue_));
+  EXPECT_FALSE(push(2, name));
+
+  render_write_queue_handle_done(queue_, re_, scene_, false);
+  EXPECT_TRUE(BKE_reports_contain(&reports_, RPT_ERROR));
+
+  BLI_delete(dirpath, false, false);
+}
+
+TEST_F(RenderWriteQueueTest, CallbacksAtWrittenFrame)
+{
+  static bCallbackFuncStore funcstore = {nullptr, nullptr, write_callback, nullptr, 0};
+  EXPECT_FALSE(BKE_callback_has_handlers(BKE_CB_EVT_RENDER_WRITE));
+  BKE_callback_add(&funcstore, BKE_CB_EVT_RENDER_WRITE);
+  EXPECT_TRUE(BKE_callback_has_handlers(BKE_CB_EVT_RENDER_WRITE));
+
+  char name[2][FILE_MAX];
+  filepath(name[0], "frame_5.png");
+  filepath(name[1], "frame_6.png");
+
+  /* Callbacks run while the scene is at the frame that was written. */
+  EXPECT_TRUE(push(5, name[0]));
+  EXPECT_TRUE(render_write_queue_wait(queue_));
+  render_write_queue_handle_done(queue_, re_, scene_, true);
+  EXPECT_EQ(write_callback_len, 1);
+  EXPECT_EQ(write_callback_frame, 5);
+
+  /* Frames handled once the scene moved on do not run callbacks with stale scene state. */
+  EXPECT_TRUE(push(6, name[1]));
+  EXPECT_TRUE(render_write_queue_wait(queue_));
+  scene_->r.cfra = 7;
+  render_write_queue_handle_done(queue_, re_, scene_, true);
+  EXPECT_EQ(write_callback_len, 1);
+
+  BKE_callback_global_finalize();
+  EXPECT_FALSE(BKE_callback_has_handlers(BKE_CB_EVT_RENDER_WRITE));
+
+  BLI_delete(name[0], false, false);
+  BLI_delete(name[1], false, false);
+}
+
+}  // namespace blender::render::tests
@@ -123,6 +123,8 @@ void render_result_free(RenderResult *rr)
 
   BKE_stamp_data_free(rr->stamp_data);
 
+  render_result_exr_file_free(rr);
+
   MEM_freeN(rr);
 }
 
@@ -737,6 +739,24 @@ static int order_render_passes(const void *a, const void *b)
   return (rpa->view_id < rpb->view_id);
 }
 
+static void render_result_exr_pass_to_scene_linear(RenderPass *rpass,
+                                                   const char *colorspace,
+                                                   bool predivide)
+{
+  const char *to_colorspace = IMB_colormanagement_role_colorspace_name_get(
+      COLOR_ROLE_SCENE_LINEAR);
+
+  if (rpass->channels >= 3) {
+    IMB_colormanagement_transform(rpass->rect,
+                                  rpass->rectx,
+                                  rpass->recty,
+                                  rpass->channels,
+                                  colorspace,
+                                  to_colorspace,
+                                  predivide);
+  }
+}
+
 /**
  * From imbuf, if a handle was returned and
  * it's not a single-layer multi-view we convert this to render result.
@@ -747,8 +767,6 @@ RenderResult *render_result_new_from_exr(
   RenderResult *rr = MEM_callocN(sizeof(RenderResult), __func__);
   RenderLayer *rl;
   RenderPass *rpass;
-  const char *to_colorspace = IMB_colormanagement_role_colorspace_name_get(
-      COLOR_ROLE_SCENE_LINEAR);
 
   rr->rectx = rectx;
   rr->recty = recty;
@@ -765,14 +783,8 @@ RenderResult *render_result_new_from_exr(
       rpass->rectx = rectx;
       rpass->recty = recty;
 
-      if (rpass->channels >= 3) {
-        IMB_colormanagement_transform(rpass->rect,
-                                      rpass->rectx,
-                                      rpass->recty,
-                                      rpass->channels,
-                                      colorspace,
-                                      to_colorspace,
-                                      predivide);
+      if (rpass->rect) {
+        render_result_exr_pass_to_scene_linear(rpass, colorspace, predivide);
       }
     }
   }
@@ -780,6 +792,101 @@ RenderResult *render_result_new_from_exr(
   return rr;
 }
 
+/* Multilayer file a lazily loaded render result decodes its passes from. The file itself is
+ * only open while reading passes, the handle keeps the layer and pass layout in between. */
+typedef struct RenderResultExrFile {
+  void *exrhandle;
+  char filepath[FILE_MAX];
+  char colorspace[MAX_COLORSPACE_NAME];
+  bool predivide;
+} RenderResultExrFile;
+
+/* Reading from the file handle is not thread safe, also protects pass rects and the file of
+ * lazily loaded render results. */
+static ThreadMutex exr_pass_load_lock = BLI_MUTEX_INITIALIZER;
+
+/**
+ * Render result for a multilayer file opened without reading pixels, the passes are decoded by
+ * #render_result_exr_pass_ensure_loaded. Takes ownership of the handle and closes its file, it
+ * is reopened from \a filepath when passes are decoded.
+ */
+RenderResult *render_result_new_from_exr_lazy(void *exrhandle,
+                                              const char *filepath,
+                                              const char *colorspace,
+                                              bool predivide,
+                                              int rectx,
+                                              int recty)
+{
+  RenderResult *rr = render_result_new_from_exr(exrhandle, colorspace, predivide, rectx, recty);
+
+  rr->exr_file = MEM_callocN(sizeof(RenderResultExrFile), __func__);
+  rr->exr_file->exrhandle = exrhandle;
+  STRNCPY(rr->exr_file->filepath, filepath);
+  STRNCPY(rr->exr_file->colorspace, colorspace);
+  rr->exr_file->predivide = predivide;
+
+  IMB_exr_close_input(exrhandle);
+
+  return rr;
+}
+
+void render_result_exr_file_free(RenderResult *rr)
+{
+  if (rr->exr_file) {
+    IMB_exr_close(rr->exr_file->exrhandle);
+    MEM_freeN(rr->exr_file);
+    rr->exr_file = NULL;
+  }
+}
+
+static bool render_result_exr_passes_all_loaded(const RenderResult *rr)
+{
+  LISTBASE_FOREACH (const RenderLayer *, rl, &rr->layers) {
+    LISTBASE_FOREACH (const RenderPass *, rpass, &rl->passes) {
+      if (rpass->rect == NULL) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool render_result_exr_pass_ensure_loaded(RenderResult *rr, RenderPass *rpass)
+{
+  BLI_mutex_lock(&exr_pass_load_lock);
+
+  if (rpass->rect == NULL && rr->exr_file) {
+    RenderLayer *rl;
+    for (rl = rr->layers.first; rl; rl = rl->next) {
+      if (BLI_findindex(&rl->passes, rpass) != -1) {
+        break;
+      }
+    }
+
+    RenderResultExrFile *exr_file = rr->exr_file;
+    if (rl && IMB_exr_reopen_input(exr_file->exrhandle, exr_file->filepath)) {
+      float *rect = IMB_exr_read_pass(exr_file->exrhandle, rl->name, rpass->name, rpass->view);
+      IMB_exr_close_input(exr_file->exrhandle);
+
+      if (rect) {
+        rpass->rect = rect;
+        render_result_exr_pass_to_scene_linear(rpass, exr_file->colorspace, exr_file->predivide);
+      }
+    }
+
+    /* The file is not needed anymore once every pass has been decoded. */
+    if (render_result_exr_passes_all_loaded(rr)) {
+      render_result_exr_file_free(rr);
+    }
+  }
+
+  const bool is_loaded = (rpass->rect != NULL);
+
+  BLI_mutex_unlock(&exr_pass_load_lock);
+
+  return is_loaded;
+}
+
 void render_result_view_new(RenderResult *rr, const char *viewname)
 {
   RenderView *rv = MEM_callocN(sizeof(RenderView), "new render view");
@@ -1668,9 +1775,13 @@ static RenderView *duplicate_render_view(RenderView *rview)
 
 RenderResult *RE_DuplicateRenderResult(RenderResult *rr)
 {
+  /* The file handle is not shared, so the copy needs all pixels. */
+  RE_passes_ensure_loaded(rr);
+
   RenderResult *new_rr = MEM_mallocN(sizeof(RenderResult), "new duplicated render result");
   *new_rr = *rr;
   new_rr->next = new_rr->prev = NULL;
+  new_rr->exr_file = NULL;
   new_rr->layers.first = new_rr->layers.last = NULL;
   new_rr->views.first = new_rr->views.last = NULL;
   for (RenderLayer *rl = rr->layers.first; rl != NULL; rl = rl->next) {
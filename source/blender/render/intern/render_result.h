@@ -58,6 +58,14 @@ struct RenderResult *render_result_new(struct Render *re,
 
 struct RenderResult *render_result_new_from_exr(
     void *exrhandle, const char *colorspace, bool predivide, int rectx, int recty);
+struct RenderResult *render_result_new_from_exr_lazy(void *exrhandle,
+                                                     const char *filepath,
+                                                     const char *colorspace,
+                                                     bool predivide,
+                                                     int rectx,
+                                                     int recty);
+bool render_result_exr_pass_ensure_loaded(struct RenderResult *rr, struct RenderPass *rpass);
+void render_result_exr_file_free(struct RenderResult *rr);
 
 void render_result_view_new(struct RenderResult *rr, const char *viewname);
 void render_result_views_new(struct RenderResult *rr, const struct RenderData *rd);
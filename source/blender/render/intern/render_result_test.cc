@@ -0,0 +1,205 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+
+#include "BKE_appdir.h"
+
+#include "IMB_colormanagement.h"
+#include "IMB_imbuf.h"
+
+#include "intern/openexr/openexr_multi.h"
+
+#include "RE_pipeline.h"
+
+namespace blender::render::tests {
+
+#define WIDTH 16
+#define HEIGHT 8
+
+static float pass_value(const int pixel, const int channel)
+{
+  return (float)(pixel * 4 + channel) * 0.25f;
+}
+
+class RenderResultLazyExrTest : public testing::Test {
+ protected:
+  char filepath_[FILE_MAX];
+  RenderResult *rr_ = nullptr;
+
+  static void SetUpTestCase()
+  {
+    BKE_appdir_init();
+    BKE_tempdir_init(nullptr);
+    IMB_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    IMB_exit();
+    BKE_tempdir_session_purge();
+  }
+
+  void SetUp() override
+  {
+    BLI_join_dirfile(filepath_, sizeof(filepath_), BKE_tempdir_session(), "multilayer.exr");
+    write_multilayer_file();
+    rr_ = open_lazy();
+  }
+
+  void TearDown() override
+  {
+    if (rr_) {
+      RE_FreeRenderResult(rr_);
+    }
+    BLI_delete(filepath_, false, false);
+  }
+
+  /* File with a four channel "Combined" and a single channel "Depth" pass. */
+  void write_multilayer_file()
+  {
+    float *combined = (float *)MEM_mallocN(sizeof(float[4]) * WIDTH * HEIGHT, __func__);
+    float *depth = (float *)MEM_mallocN(sizeof(float) * WIDTH * HEIGHT, __func__);
+    for (int i = 0; i < WIDTH * HEIGHT; i++) {
+      for (int c = 0; c < 4; c++) {
+        combined[i * 4 + c] = pass_value(i, c);
+      }
+      depth[i] = pass_value(i, 0) + 100.0f;
+    }
+
+    void *exrhandle = IMB_exr_get_handle();
+    const char *chan_names[4] = {"Combined.R", "Combined.G", "Combined.B", "Combined.A"};
+    for (int c = 0; c < 4; c++) {
+      IMB_exr_add_channel(
+          exrhandle, "ViewLayer", chan_names[c], "", 4, 4 * WIDTH, combined + c, false);
+    }
+    IMB_exr_add_channel(exrhandle, "ViewLayer", "Depth.Z", "", 1, WIDTH, depth, false);
+
+    ASSERT_TRUE(IMB_exr_begin_write(exrhandle, filepath_, WIDTH, HEIGHT, 0, nullptr));
+    IMB_exr_write_channels(exrhandle);
+    IMB_exr_close(exrhandle);
+
+    MEM_freeN(combined);
+    MEM_freeN(depth);
+  }
+
+  RenderResult *open_lazy()
+  {
+    void *exrhandle = IMB_exr_get_handle();
+    int width, height;
+    if (!IMB_exr_begin_read_multilayer(exrhandle, filepath_, &width, &height)) {
+      IMB_exr_close(exrhandle);
+      return nullptr;
+    }
+
+    /* Scene linear input, so decoding does not change the values. */
+    const char *colorspace = IMB_colormanagement_role_colorspace_name_get(
+        COLOR_ROLE_SCENE_LINEAR);
+    return RE_MultilayerConvertLazy(exrhandle, filepath_, colorspace, false, width, height);
+  }
+
+  RenderPass *find_pass(const char *name)
+  {
+    RenderLayer *rl = RE_GetRenderLayer(rr_, "ViewLayer");
+    return (rl) ? RE_pass_find_by_name(rl, name, "") : nullptr;
+  }
+};
+
+TEST_F(RenderResultLazyExrTest, PassesDecodedOnAccess)
+{
+  ASSERT_NE(rr_, nullptr);
+  RenderPass *combined = find_pass("Combined");
+  RenderPass *depth = find_pass("Depth");
+  ASSERT_NE(combined, nullptr);
+  ASSERT_NE(depth, nullptr);
+
+  EXPECT_EQ(combined->rect, nullptr);
+  EXPECT_EQ(depth->rect, nullptr);
+
+  EXPECT_TRUE(RE_pass_ensure_loaded(rr_, combined));
+  ASSERT_NE(combined->rect, nullptr);
+  EXPECT_EQ(combined->channels, 4);
+  for (int i = 0; i < WIDTH * HEIGHT; i++) {
+    for (int c = 0; c < 4; c++) {
+      EXPECT_EQ(combined->rect[i * 4 + c], pass_value(i, c));
+    }
+  }
+
+  /* Only the requested pass is decoded. */
+  EXPECT_EQ(depth->rect, nullptr);
+
+  /* Loading again keeps the existing buffer. */
+  float *rect = combined->rect;
+  EXPECT_TRUE(RE_pass_ensure_loaded(rr_, combined));
+  EXPECT_EQ(combined->rect, rect);
+
+  EXPECT_TRUE(RE_pass_ensure_loaded(rr_, depth));
+  ASSERT_NE(depth->rect, nullptr);
+  for (int i = 0; i < WIDTH * HEIGHT; i++) {
+    EXPECT_EQ(depth->rect[i], pass_value(i, 0) + 100.0f);
+  }
+}
+
+TEST_F(RenderResultLazyExrTest, FileReleasedOnceAllPassesLoaded)
+{
+  ASSERT_NE(rr_, nullptr);
+  EXPECT_NE(rr_->exr_file, nullptr);
+
+  RE_passes_ensure_loaded(rr_);
+  EXPECT_EQ(rr_->exr_file, nullptr);
+  EXPECT_NE(find_pass("Combined")->rect, nullptr);
+  EXPECT_NE(find_pass("Depth")->rect, nullptr);
+}
+
+TEST_F(RenderResultLazyExrTest, FileReopenedOnDemand)
+{
+  ASSERT_NE(rr_, nullptr);
+  RenderPass *combined = find_pass("Combined");
+  RenderPass *depth = find_pass("Depth");
+
+  EXPECT_TRUE(RE_pass_ensure_loaded(rr_, combined));
+
+  /* The file is not held open between reads, once removed other passes can not be loaded. */
+  BLI_delete(filepath_, false, false);
+  EXPECT_FALSE(RE_pass_ensure_loaded(rr_, depth));
+  EXPECT_EQ(depth->rect, nullptr);
+
+  /* Already decoded passes stay available. */
+  EXPECT_TRUE(RE_pass_ensure_loaded(rr_, combined));
+}
+
+TEST_F(RenderResultLazyExrTest, PassNotInResult)
+{
+  ASSERT_NE(rr_, nullptr);
+  RenderPass rpass = {nullptr};
+  STRNCPY(rpass.name, "Combined");
+  rpass.channels = 4;
+  rpass.rectx = WIDTH;
+  rpass.recty = HEIGHT;
+
+  EXPECT_FALSE(RE_pass_ensure_loaded(rr_, &rpass));
+  EXPECT_EQ(rpass.rect, nullptr);
+}
+
+}  // namespace blender::render::tests
@@ -33,6 +33,7 @@
 #include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
+#include "IMB_moviecache.h"
 
 #include "BLI_blenlib.h"
 #include "BLI_endian_switch.h"
@@ -779,9 +780,19 @@ static void seq_cache_unlock(Scene *scene)
   }
 }
 
+/* The cache limit is shared with movie caches of images, clips and display buffers. Memory they
+ * use is not available to the sequencer, except for a minimum part of the limit which is always
+ * reserved so playback keeps working when other editors hold many frames. */
 static size_t seq_cache_get_mem_total(void)
 {
-  return ((size_t)U.memcachelimit) * 1024 * 1024;
+  const size_t mem_limit = ((size_t)U.memcachelimit) * 1024 * 1024;
+  const size_t mem_reserved = mem_limit / 4;
+  const size_t mem_movie = IMB_moviecache_get_memory_in_use();
+
+  if (mem_movie >= mem_limit - mem_reserved) {
+    return mem_reserved;
+  }
+  return mem_limit - mem_movie;
 }
 
 static void seq_cache_keyfree(void *val)
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "DNA_image_types.h"
 #include "DNA_listBase.h"
 #include "DNA_scene_types.h"
 #include "DNA_screen_types.h"
@@ -51,6 +52,7 @@
 #include "BKE_customdata.h"
 #include "BKE_global.h"
 #include "BKE_idprop.h"
+#include "BKE_image.h"
 #include "BKE_main.h"
 #include "BKE_report.h"
 #include "BKE_scene.h"
@@ -407,6 +409,13 @@ static void wm_event_execute_timers(bContext *C)
   CTX_wm_window_set(C, NULL);
 }
 
+/* Callback for #BKE_image_async_load_poll. */
+static void wm_event_image_async_load_done(Image *ima, void *UNUSED(userdata))
+{
+  DEG_id_tag_update(&ima->id, 0);
+  WM_main_add_notifier(NC_IMAGE | NA_EDITED, ima);
+}
+
 /* Called in mainloop. */
 void wm_event_do_notifiers(bContext *C)
 {
@@ -418,6 +427,9 @@ void wm_event_do_notifiers(bContext *C)
     return;
   }
 
+  /* Redraw with images which finished loading in the background. */
+  BKE_image_async_load_poll(wm_event_image_async_load_done, NULL);
+
   /* Disable? - Keep for now since its used for window level notifiers. */
 #if 1
   /* Cache & catch WM level notifiers, such as frame change, scene/screen set. */
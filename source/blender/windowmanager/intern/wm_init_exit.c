@@ -54,6 +54,7 @@
 
 #include "BKE_blender.h"
 #include "BKE_blendfile.h"
+#include "BKE_bvhutils.h"
 #include "BKE_callbacks.h"
 #include "BKE_context.h"
 #include "BKE_font.h"
@@ -578,6 +579,7 @@ void WM_exit_ex(bContext *C, const bool do_python)
 #endif
 
   BKE_subdiv_exit();
+  BKE_image_async_load_exit();
 
   if (opengl_is_init) {
     BKE_image_free_unused_gpu_textures();
@@ -585,6 +587,7 @@ void WM_exit_ex(bContext *C, const bool do_python)
 
   BKE_blender_free(); /* blender.c, does entire library and spacetypes */
                       //  BKE_material_copybuf_free();
+  bvhcache_shared_exit();
   ANIM_fcurves_copybuf_free();
   ANIM_drivers_copybuf_free();
   ANIM_driver_vars_copybuf_free();